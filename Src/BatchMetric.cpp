@@ -0,0 +1,287 @@
+/**
+ * @file BatchMetric.cpp
+ *
+ * This file implements functions that calculate the scores for many whistle reports at once.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "BatchMetric.h"
+#include "Util/Angle.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+constexpr float BatchMetric::tolerance;
+
+namespace
+{
+#if defined(__AVX__)
+  /** The vector operations of AVX. */
+  struct Simd
+  {
+    using Vector = __m256;
+    static constexpr int width = 8;
+    static Vector load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Vector v) { _mm256_storeu_ps(p, v); }
+    static Vector set(float f) { return _mm256_set1_ps(f); }
+    static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+    static Vector div(Vector a, Vector b) { return _mm256_div_ps(a, b); }
+    static Vector sqrt(Vector a) { return _mm256_sqrt_ps(a); }
+    static Vector min(Vector a, Vector b) { return _mm256_min_ps(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+    static Vector bitAnd(Vector a, Vector b) { return _mm256_and_ps(a, b); }
+    static Vector bitXor(Vector a, Vector b) { return _mm256_xor_ps(a, b); }
+    static Vector less(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Vector greaterEqual(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Vector equal(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static Vector select(Vector mask, Vector a, Vector b) { return _mm256_blendv_ps(b, a, mask); }
+  };
+  constexpr const char* instructionSet = "AVX";
+#elif defined(__SSE2__)
+  /** The vector operations of SSE2. */
+  struct Simd
+  {
+    using Vector = __m128;
+    static constexpr int width = 4;
+    static Vector load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Vector v) { _mm_storeu_ps(p, v); }
+    static Vector set(float f) { return _mm_set1_ps(f); }
+    static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+    static Vector div(Vector a, Vector b) { return _mm_div_ps(a, b); }
+    static Vector sqrt(Vector a) { return _mm_sqrt_ps(a); }
+    static Vector min(Vector a, Vector b) { return _mm_min_ps(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+    static Vector bitAnd(Vector a, Vector b) { return _mm_and_ps(a, b); }
+    static Vector bitXor(Vector a, Vector b) { return _mm_xor_ps(a, b); }
+    static Vector less(Vector a, Vector b) { return _mm_cmplt_ps(a, b); }
+    static Vector greaterEqual(Vector a, Vector b) { return _mm_cmpge_ps(a, b); }
+    static Vector equal(Vector a, Vector b) { return _mm_cmpeq_ps(a, b); }
+    static Vector select(Vector mask, Vector a, Vector b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+  };
+  constexpr const char* instructionSet = "SSE2";
+#else
+  /** A scalar fallback with the same interface as the vector operations. */
+  struct Simd
+  {
+    using Vector = float;
+    static constexpr int width = 1;
+    static Vector load(const float* p) { return *p; }
+    static void store(float* p, Vector v) { *p = v; }
+    static Vector set(float f) { return f; }
+    static Vector add(Vector a, Vector b) { return a + b; }
+    static Vector sub(Vector a, Vector b) { return a - b; }
+    static Vector mul(Vector a, Vector b) { return a * b; }
+    static Vector div(Vector a, Vector b) { return a / b; }
+    static Vector sqrt(Vector a) { return std::sqrt(a); }
+    static Vector min(Vector a, Vector b) { return a < b ? a : b; }
+    static Vector max(Vector a, Vector b) { return a > b ? a : b; }
+    static Vector bitAnd(Vector a, Vector b) { return a != 0.f ? b : 0.f; }
+    static Vector bitXor(Vector a, Vector b) { return std::signbit(b) ? -a : a; }
+    static Vector less(Vector a, Vector b) { return a < b ? 1.f : 0.f; }
+    static Vector greaterEqual(Vector a, Vector b) { return a >= b ? 1.f : 0.f; }
+    static Vector equal(Vector a, Vector b) { return a == b ? 1.f : 0.f; }
+    static Vector select(Vector mask, Vector a, Vector b) { return mask != 0.f ? a : b; }
+  };
+  constexpr const char* instructionSet = "scalar";
+#endif
+
+  using Vector = Simd::Vector;
+
+  /**
+   * Returns the absolute value of each lane.
+   * @param v The input vector.
+   * @return The absolute values.
+   */
+  inline Vector abs(Vector v)
+  {
+#if defined(__AVX__) || defined(__SSE2__)
+    return Simd::max(v, Simd::sub(Simd::set(0.f), v));
+#else
+    return std::abs(v);
+#endif
+  }
+
+  /**
+   * Returns the sign bit of each lane (as a vector that can be combined with \c bitXor).
+   * @param v The input vector.
+   * @return The sign bits (-0 for negative lanes, +0 otherwise).
+   */
+  inline Vector signBit(Vector v)
+  {
+#if defined(__AVX__) || defined(__SSE2__)
+    return Simd::bitAnd(v, Simd::set(-0.f));
+#else
+    return std::copysign(0.f, v);
+#endif
+  }
+
+  /**
+   * Calculates the four-quadrant arc tangent (like \c std::atan2) with a maximum error of a few ULPs.
+   * @param y The y coordinates.
+   * @param x The x coordinates.
+   * @return The angles in [-pi, pi].
+   */
+  inline Vector atan2(Vector y, Vector x)
+  {
+    const Vector absX = abs(x);
+    const Vector absY = abs(y);
+    const Vector maxXY = Simd::max(absX, absY);
+    const Vector minXY = Simd::min(absX, absY);
+    // Avoid 0/0 (atan2(0, 0) = 0 like the standard library for positive zeros).
+    const Vector zero = Simd::equal(maxXY, Simd::set(0.f));
+    Vector t = Simd::div(minXY, Simd::select(zero, Simd::set(1.f), maxXY));
+
+    // Reduce the argument to [-tan(pi/8), tan(pi/8)] (Cephes atanf).
+    const Vector reduce = Simd::less(Simd::set(0.41421356f), t);
+    t = Simd::select(reduce, Simd::div(Simd::sub(t, Simd::set(1.f)), Simd::add(t, Simd::set(1.f))), t);
+    const Vector offset = Simd::select(reduce, Simd::set(Angle::pi / 4.f), Simd::set(0.f));
+    const Vector z = Simd::mul(t, t);
+    Vector p = Simd::set(8.05374449538e-2f);
+    p = Simd::sub(Simd::mul(p, z), Simd::set(1.38776856032e-1f));
+    p = Simd::add(Simd::mul(p, z), Simd::set(1.99777106478e-1f));
+    p = Simd::sub(Simd::mul(p, z), Simd::set(3.33329491539e-1f));
+    Vector angle = Simd::add(offset, Simd::add(Simd::mul(Simd::mul(p, z), t), t));
+
+    // Undo the octant and quadrant reductions.
+    angle = Simd::select(Simd::less(absX, absY), Simd::sub(Simd::set(Angle::pi / 2.f), angle), angle);
+    angle = Simd::select(Simd::less(x, Simd::set(0.f)), Simd::sub(Simd::set(Angle::pi), angle), angle);
+    return Simd::bitXor(angle, signBit(y));
+  }
+
+  /**
+   * Calculates the score for a deviation.
+   * @param deviation The deviation (degrees or percent).
+   * @param minDeviation The deviation up to which the score is 1.
+   * @param maxDeviation The deviation from which on the score is 0.
+   * @return A number in [0, 1].
+   */
+  inline Vector deviationScore(Vector deviation, float minDeviation, float maxDeviation)
+  {
+    const Vector ratio = Simd::div(Simd::sub(deviation, Simd::set(minDeviation)), Simd::set(maxDeviation - minDeviation));
+    return Simd::sub(Simd::set(1.f), Simd::max(Simd::set(0.f), Simd::min(ratio, Simd::set(1.f))));
+  }
+
+  /**
+   * Calculates the scores for one vector of reports.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param reportedX The x coordinates of the reported locations.
+   * @param reportedY The y coordinates of the reported locations.
+   * @param reportedOnSameField The reported field decisions (1 or 0).
+   * @param actualX The x coordinates of the ground-truth locations.
+   * @param actualY The y coordinates of the ground-truth locations.
+   * @param onSameFieldDecision The scores for the field decisions.
+   * @param direction The scores for the direction quality.
+   * @param distance The scores for the distance quality.
+   * @param total The overall scores.
+   * @param rules The thresholds and the field geometry.
+   */
+  inline void calculateVector(const QVector<Pose2D>& robotSetup, const float* reportedX, const float* reportedY, const float* reportedOnSameField,
+                              const float* actualX, const float* actualY, float* onSameFieldDecision, float* direction, float* distance, float* total,
+                              const Metric::Rules& rules)
+  {
+    const Vector rx = Simd::load(reportedX);
+    const Vector ry = Simd::load(reportedY);
+    const Vector ax = Simd::load(actualX);
+    const Vector ay = Simd::load(actualY);
+
+    // Determine the reference pose (the first robot that is closest to the actual location, like std::min_element).
+    Vector referenceX = Simd::set(robotSetup[0].translation.x);
+    Vector referenceY = Simd::set(robotSetup[0].translation.y);
+    Vector dx = Simd::sub(referenceX, ax), dy = Simd::sub(referenceY, ay);
+    Vector bestSquaredDistance = Simd::add(Simd::mul(dx, dx), Simd::mul(dy, dy));
+    for(int i = 1; i < robotSetup.size(); ++i)
+    {
+      const Vector x = Simd::set(robotSetup[i].translation.x);
+      const Vector y = Simd::set(robotSetup[i].translation.y);
+      dx = Simd::sub(x, ax);
+      dy = Simd::sub(y, ay);
+      const Vector squaredDistance = Simd::add(Simd::mul(dx, dx), Simd::mul(dy, dy));
+      const Vector closer = Simd::less(squaredDistance, bestSquaredDistance);
+      bestSquaredDistance = Simd::select(closer, squaredDistance, bestSquaredDistance);
+      referenceX = Simd::select(closer, x, referenceX);
+      referenceY = Simd::select(closer, y, referenceY);
+    }
+
+    // Field decision.
+    const Vector isActuallyOnSameField = Simd::bitAnd(Simd::less(abs(ax), Simd::set(rules.fieldHalfLength)), Simd::less(abs(ay), Simd::set(rules.fieldHalfWidth)));
+    const Vector actualFieldFlag = Simd::select(isActuallyOnSameField, Simd::set(1.f), Simd::set(0.f));
+    const Vector fieldScore = Simd::select(Simd::equal(actualFieldFlag, Simd::load(reportedOnSameField)), Simd::set(1.f), Simd::set(0.f));
+
+    const Vector actualDX = Simd::sub(ax, referenceX), actualDY = Simd::sub(ay, referenceY);
+    const Vector reportedDX = Simd::sub(rx, referenceX), reportedDY = Simd::sub(ry, referenceY);
+
+    // Direction (the difference of two angles in [-pi, pi] only needs a single wrap to be normalized).
+    Vector angleDifference = Simd::sub(atan2(actualDY, actualDX), atan2(reportedDY, reportedDX));
+    angleDifference = Simd::select(Simd::greaterEqual(angleDifference, Simd::set(Angle::pi)), Simd::sub(angleDifference, Simd::set(Angle::pi2)), angleDifference);
+    angleDifference = Simd::select(Simd::less(angleDifference, Simd::set(-Angle::pi)), Simd::add(angleDifference, Simd::set(Angle::pi2)), angleDifference);
+    const Vector directionScore = deviationScore(Simd::div(Simd::mul(abs(angleDifference), Simd::set(180.f)), Simd::set(Angle::pi)), rules.minDirectionDeviation, rules.maxDirectionDeviation);
+
+    // Distance.
+    const Vector actualDistance = Simd::sqrt(Simd::add(Simd::mul(actualDX, actualDX), Simd::mul(actualDY, actualDY)));
+    const Vector reportedDistance = Simd::sqrt(Simd::add(Simd::mul(reportedDX, reportedDX), Simd::mul(reportedDY, reportedDY)));
+    const Vector distanceScore = deviationScore(Simd::mul(Simd::div(abs(Simd::sub(reportedDistance, actualDistance)), actualDistance), Simd::set(100.f)), rules.minDistanceDeviation, rules.maxDistanceDeviation);
+
+    Simd::store(onSameFieldDecision, fieldScore);
+    Simd::store(direction, directionScore);
+    Simd::store(distance, distanceScore);
+    Simd::store(total, Simd::add(Simd::add(fieldScore, directionScore), distanceScore));
+  }
+}
+
+void BatchMetric::calculateScores(const QVector<Pose2D>& robotSetup, const Reports& reports, Scores& scores)
+{
+  calculateScores(robotSetup, reports, scores, Metric::Rules());
+}
+
+void BatchMetric::calculateScores(const QVector<Pose2D>& robotSetup, const Reports& reports, Scores& scores, const Metric::Rules& rules)
+{
+  Q_ASSERT(!robotSetup.isEmpty() && rules.minDirectionDeviation < rules.maxDirectionDeviation && rules.minDistanceDeviation < rules.maxDistanceDeviation);
+
+  const std::size_t size = reports.size();
+  scores.onSameFieldDecision.resize(size);
+  scores.direction.resize(size);
+  scores.distance.resize(size);
+  scores.total.resize(size);
+
+  float fieldFlags[Simd::width];
+  std::size_t i = 0;
+  for(; i + Simd::width <= size; i += Simd::width)
+  {
+    for(int j = 0; j < Simd::width; ++j)
+      fieldFlags[j] = reports.reportedOnSameField[i + j] ? 1.f : 0.f;
+    calculateVector(robotSetup, &reports.reportedX[i], &reports.reportedY[i], fieldFlags, &reports.actualX[i], &reports.actualY[i],
+                    &scores.onSameFieldDecision[i], &scores.direction[i], &scores.distance[i], &scores.total[i], rules);
+  }
+
+  // The remaining reports are padded to a full vector so that they are calculated exactly like the others.
+  if(i < size)
+  {
+    const std::size_t remaining = size - i;
+    float input[5][Simd::width] = {}, output[4][Simd::width];
+    for(std::size_t j = 0; j < remaining; ++j)
+    {
+      input[0][j] = reports.reportedX[i + j];
+      input[1][j] = reports.reportedY[i + j];
+      input[2][j] = reports.reportedOnSameField[i + j] ? 1.f : 0.f;
+      input[3][j] = reports.actualX[i + j];
+      input[4][j] = reports.actualY[i + j];
+    }
+    calculateVector(robotSetup, input[0], input[1], input[2], input[3], input[4], output[0], output[1], output[2], output[3], rules);
+    std::copy(output[0], output[0] + remaining, &scores.onSameFieldDecision[i]);
+    std::copy(output[1], output[1] + remaining, &scores.direction[i]);
+    std::copy(output[2], output[2] + remaining, &scores.distance[i]);
+    std::copy(output[3], output[3] + remaining, &scores.total[i]);
+  }
+}
+
+const char* BatchMetric::getInstructionSet()
+{
+  return instructionSet;
+}
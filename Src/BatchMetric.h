@@ -0,0 +1,89 @@
+/**
+ * @file BatchMetric.h
+ *
+ * This file declares functions that calculate the scores for many whistle reports at once.
+ * The inputs and outputs are structures of arrays, which are processed with SSE or AVX kernels
+ * (depending on the instruction sets that the compiler targets) and match \c Metric up to \c BatchMetric::tolerance.
+ * The thresholds of the metric can be changed, e.g. to find out how other rules would have scored recorded attempts.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Metric.h"
+#include "Util/Pose2D.h"
+#include <QVector>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BatchMetric
+{
+public:
+  static constexpr float tolerance = 1e-4f; /**< The maximum absolute difference of each score component to the scalar \c Metric. */
+
+  /** A batch of whistle reports together with the ground-truth locations. */
+  struct Reports
+  {
+    std::vector<float> reportedX; /**< The x coordinates of the reported locations. */
+    std::vector<float> reportedY; /**< The y coordinates of the reported locations. */
+    std::vector<std::uint8_t> reportedOnSameField; /**< Whether the robots reported the whistle to be on the same field (0 or 1). */
+    std::vector<float> actualX; /**< The x coordinates of the ground-truth locations. */
+    std::vector<float> actualY; /**< The y coordinates of the ground-truth locations. */
+
+    /**
+     * Resizes all arrays.
+     * @param size The number of reports.
+     */
+    void resize(std::size_t size)
+    {
+      reportedX.resize(size);
+      reportedY.resize(size);
+      reportedOnSameField.resize(size);
+      actualX.resize(size);
+      actualY.resize(size);
+    }
+
+    /**
+     * Returns the number of reports.
+     * @return The number of reports.
+     */
+    std::size_t size() const
+    {
+      return reportedX.size();
+    }
+  };
+
+  /** The scores for a batch of whistle reports. */
+  struct Scores
+  {
+    std::vector<float> onSameFieldDecision; /**< The scores for the "same field"/"other field" decisions. */
+    std::vector<float> direction; /**< The scores for the direction quality. */
+    std::vector<float> distance; /**< The scores for the distance quality. */
+    std::vector<float> total; /**< The overall scores. */
+  };
+
+  /**
+   * This function calculates the scores for a batch of whistle reports.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param reports The reports and their ground-truth locations.
+   * @param scores The scores, which are resized to the number of reports.
+   */
+  static void calculateScores(const QVector<Pose2D>& robotSetup, const Reports& reports, Scores& scores);
+
+  /**
+   * This function calculates the scores for a batch of whistle reports with other rules than the official ones.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param reports The reports and their ground-truth locations.
+   * @param scores The scores, which are resized to the number of reports.
+   * @param rules The thresholds and the field geometry.
+   */
+  static void calculateScores(const QVector<Pose2D>& robotSetup, const Reports& reports, Scores& scores, const Metric::Rules& rules);
+
+  /**
+   * Returns the name of the instruction set that the kernels use.
+   * @return "AVX", "SSE2" or "scalar".
+   */
+  static const char* getInstructionSet();
+};
@@ -0,0 +1,111 @@
+/**
+ * @file BatchedDatagramReceiver.cpp
+ *
+ * This file implements a class that receives batches of SPL standard messages via recvmmsg (Linux only).
+ *
+ * @author Arne Hasselbring
+ */
+
+#ifdef __linux__
+
+#include "BatchedDatagramReceiver.h"
+#include "Util/Clock.h"
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <unistd.h>
+
+BatchedDatagramReceiver::BatchedDatagramReceiver()
+{
+  for(unsigned int i = 0; i < batchSize; ++i)
+  {
+    vectors[i].iov_base = &messages[i];
+    vectors[i].iov_len = sizeof(SPLStandardMessage);
+    std::memset(&headers[i], 0, sizeof(mmsghdr));
+    headers[i].msg_hdr.msg_iov = &vectors[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+  timestamps.fill(0);
+}
+
+BatchedDatagramReceiver::BatchedDatagramReceiver(std::uint16_t port) :
+  BatchedDatagramReceiver()
+{
+  socket = openSocket(port);
+}
+
+int BatchedDatagramReceiver::openSocket(std::uint16_t port)
+{
+  const int socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(socket < 0)
+    return -1;
+
+  const int reuse = 1;
+  setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  // A larger receive buffer allows the kernel to queue the flood of messages right after a whistle.
+  const int receiveBufferSize = 1 << 20;
+  setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+  // The kernel stamps each datagram when it arrives, independent of when this process gets to read it.
+  const int timestamping = 1;
+  setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &timestamping, sizeof(timestamping));
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if(bind(socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    close(socket);
+    return -1;
+  }
+  return socket;
+}
+
+BatchedDatagramReceiver::~BatchedDatagramReceiver()
+{
+  if(socket >= 0)
+    close(socket);
+}
+
+unsigned int BatchedDatagramReceiver::receiveBatch()
+{
+  return receiveBatch(socket);
+}
+
+unsigned int BatchedDatagramReceiver::receiveBatch(int socketDescriptor)
+{
+  if(socketDescriptor < 0)
+    return 0;
+
+  // The control buffer lengths are overwritten by each call.
+  for(unsigned int i = 0; i < batchSize; ++i)
+  {
+    headers[i].msg_hdr.msg_control = controls[i].data();
+    headers[i].msg_hdr.msg_controllen = controls[i].size();
+  }
+
+  int received;
+  do
+    received = recvmmsg(socketDescriptor, headers.data(), batchSize, MSG_DONTWAIT, nullptr);
+  while(received < 0 && errno == EINTR);
+  if(received <= 0)
+    return 0;
+
+  // SO_TIMESTAMPNS reports CLOCK_REALTIME, so the timestamps are converted to the monotonic clock with the current offset.
+  const std::int64_t offset = Clock::getRealtimeToMonotonicOffset();
+  for(int i = 0; i < received; ++i)
+  {
+    timestamps[i] = 0;
+    for(cmsghdr* control = CMSG_FIRSTHDR(&headers[i].msg_hdr); control; control = CMSG_NXTHDR(&headers[i].msg_hdr, control))
+      if(control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS)
+      {
+        timespec time;
+        std::memcpy(&time, CMSG_DATA(control), sizeof(time));
+        timestamps[i] = static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec + offset;
+      }
+  }
+  return static_cast<unsigned int>(received);
+}
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file BatchedDatagramReceiver.h
+ *
+ * This file declares a class that receives batches of SPL standard messages via recvmmsg (Linux only).
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#ifdef __linux__
+
+#include "SPLStandardMessage.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+
+class BatchedDatagramReceiver
+{
+public:
+  static constexpr unsigned int batchSize = 64; /**< The maximum number of datagrams that are received with a single system call. */
+
+  /** Constructor. Only prepares the buffers (e.g. to receive from sockets that are opened with \c openSocket). */
+  BatchedDatagramReceiver();
+
+  /**
+   * Constructor. Creates a non-blocking UDP socket with kernel receive timestamps and binds it to a port.
+   * @param port The port to which the socket is bound.
+   */
+  explicit BatchedDatagramReceiver(std::uint16_t port);
+
+  /**
+   * Creates a non-blocking UDP socket with kernel receive timestamps and binds it to a port (shared with other sockets that do the same).
+   * @param port The port to which the socket is bound.
+   * @return The native descriptor of the socket (-1 if it could not be created or bound).
+   */
+  static int openSocket(std::uint16_t port);
+
+  /** Destructor. Closes the socket. */
+  ~BatchedDatagramReceiver();
+
+  BatchedDatagramReceiver(const BatchedDatagramReceiver&) = delete;
+  void operator=(const BatchedDatagramReceiver&) = delete;
+
+  /**
+   * Returns whether the socket could be created and bound.
+   * @return Whether the socket could be created and bound.
+   */
+  bool isOpen() const
+  {
+    return socket >= 0;
+  }
+
+  /**
+   * Returns the native descriptor of the socket (e.g. for a socket notifier).
+   * @return The native descriptor of the socket.
+   */
+  int getSocketDescriptor() const
+  {
+    return socket;
+  }
+
+  /**
+   * Receives as many pending datagrams as fit into the buffer ring without blocking.
+   * The previous contents of the buffer ring are overwritten.
+   * @return The number of datagrams that have been received.
+   */
+  unsigned int receiveBatch();
+
+  /**
+   * Receives as many pending datagrams from another socket as fit into the buffer ring without blocking.
+   * @param socketDescriptor A socket that has been opened with \c openSocket.
+   * @return The number of datagrams that have been received.
+   */
+  unsigned int receiveBatch(int socketDescriptor);
+
+  /**
+   * Returns a received message.
+   * @param i The index of the message in the last batch.
+   * @return The buffer into which the message has been received (only the first \c getSize(i) bytes are valid).
+   */
+  const SPLStandardMessage& getMessage(unsigned int i) const
+  {
+    return messages[i];
+  }
+
+  /**
+   * Returns the time at which the kernel received a message.
+   * @param i The index of the message in the last batch.
+   * @return The arrival time in nanoseconds of the monotonic clock (see \c Clock::getTime) or 0 if the kernel did not provide it.
+   */
+  std::int64_t getTimestamp(unsigned int i) const
+  {
+    return timestamps[i];
+  }
+
+  /**
+   * Returns the size of a received message.
+   * @param i The index of the message in the last batch.
+   * @return The number of bytes received (0 if the datagram did not fit into the buffer).
+   */
+  std::size_t getSize(unsigned int i) const
+  {
+    return (headers[i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : headers[i].msg_len;
+  }
+
+private:
+  int socket = -1; /**< The native socket descriptor (-1 if it could not be opened). */
+  std::array<SPLStandardMessage, batchSize> messages; /**< The preallocated buffers into which datagrams are received. */
+  std::array<iovec, batchSize> vectors; /**< The I/O vectors that point to the message buffers. */
+  std::array<mmsghdr, batchSize> headers; /**< The message headers that are passed to recvmmsg. */
+  std::array<std::array<char, CMSG_SPACE(sizeof(timespec))>, batchSize> controls; /**< The buffers for the ancillary data that contain the kernel timestamps. */
+  std::array<std::int64_t, batchSize> timestamps; /**< The kernel arrival times of the messages in the last batch. */
+};
+
+#else
+
+/** A placeholder on platforms without recvmmsg (it is never instantiated there). */
+class BatchedDatagramReceiver {};
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file BatchMetricBenchmark.cpp
+ *
+ * This file implements a benchmark that compares the batch score calculation to the scalar one, component by component.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "BatchMetric.h"
+#include "DetectedWhistle.h"
+#include "Metric.h"
+#include "Util/Angle.h"
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+  constexpr std::size_t numOfSamples = 10007; /**< The number of reports per batch (not a multiple of the vector width, so that the tail is covered). */
+}
+
+BENCHMARK(batchMetric)
+{
+  std::mt19937 random(0);
+  std::uniform_real_distribution<float> xDistribution(-7.f, 7.f), yDistribution(-13.f, 13.f), rotationDistribution(-Angle::pi, Angle::pi);
+
+  QVector<Pose2D> robotPoses;
+  for(int i = 0; i < 5; ++i)
+    robotPoses.append(Pose2D(rotationDistribution(random), xDistribution(random) * 0.6f, yDistribution(random) * 0.25f));
+  BatchMetric::Reports reports;
+  reports.resize(numOfSamples);
+  for(std::size_t i = 0; i < numOfSamples; ++i)
+  {
+    reports.actualX[i] = xDistribution(random);
+    reports.actualY[i] = yDistribution(random);
+    reports.reportedOnSameField[i] = random() % 2;
+    // Some reports are exact, so that scores of 1 are covered as well.
+    reports.reportedX[i] = i % 16 ? xDistribution(random) : reports.actualX[i];
+    reports.reportedY[i] = i % 16 ? yDistribution(random) : reports.actualY[i];
+  }
+
+  for(int numOfRobots = 1; numOfRobots <= 5; ++numOfRobots)
+  {
+    const QVector<Pose2D> robotSetup = robotPoses.mid(0, numOfRobots);
+    const QString suffix = ".robots" + QString::number(numOfRobots);
+
+    QVector<float> expected(static_cast<int>(numOfSamples));
+    const double scalarDuration = Benchmark::measure([&]
+    {
+      DetectedWhistle whistle;
+      for(std::size_t i = 0; i < numOfSamples; ++i)
+      {
+        whistle.onSameField = reports.reportedOnSameField[i] != 0;
+        whistle.location = Vector2D(reports.reportedX[i], reports.reportedY[i]);
+        expected[static_cast<int>(i)] = Metric::calculateScore(robotSetup, Vector2D(reports.actualX[i], reports.actualY[i]), whistle);
+      }
+      Benchmark::doNotOptimize(expected.data());
+    });
+
+    BatchMetric::Scores scores;
+    const double batchDuration = Benchmark::measure([&]
+    {
+      BatchMetric::calculateScores(robotSetup, reports, scores);
+      Benchmark::doNotOptimize(scores.total.data());
+    });
+
+    // Each component is compared on its own, so that errors in different components cannot cancel each other out in the total.
+    QVector<Vector2D> actualLocations;
+    for(std::size_t i = 0; i < numOfSamples; ++i)
+      actualLocations.append(Vector2D(reports.actualX[i], reports.actualY[i]));
+    const QVector<Metric::ReferenceGeometry> geometries = Metric::calculateReferenceGeometries(robotSetup, actualLocations);
+    float maxDeviation = 0.f;
+    for(std::size_t i = 0; i < numOfSamples; ++i)
+    {
+      DetectedWhistle whistle;
+      whistle.onSameField = reports.reportedOnSameField[i] != 0;
+      whistle.location = Vector2D(reports.reportedX[i], reports.reportedY[i]);
+      const Metric::ScoreComponents components = Metric::calculateScoreComponents(geometries[static_cast<int>(i)], whistle);
+      const float deviations[] = {std::abs(scores.onSameFieldDecision[i] - components.onSameFieldDecision), std::abs(scores.direction[i] - components.direction),
+                                  std::abs(scores.distance[i] - components.distance), std::abs(scores.total[i] - expected[static_cast<int>(i)])};
+      const char* names[] = {"onSameFieldDecision", "direction", "distance", "total"};
+      const float batchScores[] = {scores.onSameFieldDecision[i], scores.direction[i], scores.distance[i], scores.total[i]};
+      const float scalarScores[] = {components.onSameFieldDecision, components.direction, components.distance, expected[static_cast<int>(i)]};
+      int mismatch = 0;
+      while(mismatch < 4 && deviations[mismatch] <= BatchMetric::tolerance)
+        ++mismatch;
+      if(mismatch < 4)
+      {
+        Benchmark::fail(QString("The batch score ") + names[mismatch] + " " + QString::number(batchScores[mismatch]) + " differs from the scalar score " +
+                        QString::number(scalarScores[mismatch]) + suffix + " for the report (" + QString::number(whistle.location.x) + ", " +
+                        QString::number(whistle.location.y) + (whistle.onSameField ? ", same field" : ", other field") + ") of the whistle at (" +
+                        QString::number(reports.actualX[i]) + ", " + QString::number(reports.actualY[i]) + ").");
+        break;
+      }
+      for(float deviation : deviations)
+        maxDeviation = std::max(maxDeviation, deviation);
+    }
+
+    Benchmark::report(QString("scalar") + suffix, numOfSamples / scalarDuration * 1e9, "reports/s");
+    Benchmark::report(QString(BatchMetric::getInstructionSet()) + suffix, numOfSamples / batchDuration * 1e9, "reports/s");
+    Benchmark::report("maxDeviation" + suffix, maxDeviation, "points");
+  }
+}
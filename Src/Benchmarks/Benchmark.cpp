@@ -0,0 +1,65 @@
+/**
+ * @file Benchmark.cpp
+ *
+ * This file implements a minimal registry for benchmarks and a function to report their results.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <utility>
+
+namespace Benchmark
+{
+  /**
+   * Returns the list of all registered benchmarks.
+   * @return The list of all registered benchmarks.
+   */
+  static QVector<std::pair<QString, Function>>& getBenchmarks()
+  {
+    static QVector<std::pair<QString, Function>> benchmarks;
+    return benchmarks;
+  }
+
+  static QString currentBenchmark; /**< The name of the benchmark that is currently running. */
+  static bool failed = false; /**< Whether a benchmark has reported a failure. */
+
+  Registration::Registration(const char* name, Function function)
+  {
+    getBenchmarks().append(std::make_pair(QString(name), function));
+  }
+
+  bool runAll(const QStringList& filters)
+  {
+    for(const auto& benchmark : getBenchmarks())
+    {
+      if(!filters.isEmpty() && std::none_of(filters.begin(), filters.end(), [&benchmark](const QString& filter){ return benchmark.first.contains(filter); }))
+        continue;
+      currentBenchmark = benchmark.first;
+      benchmark.second();
+    }
+    return !failed;
+  }
+
+  void report(const QString& metric, double value, const QString& unit)
+  {
+    QJsonObject result;
+    result["benchmark"] = currentBenchmark;
+    result["metric"] = metric;
+    result["value"] = value;
+    result["unit"] = unit;
+    QTextStream(stdout) << QJsonDocument(result).toJson(QJsonDocument::Compact) << endl;
+  }
+
+  void fail(const QString& message)
+  {
+    failed = true;
+    QTextStream(stderr) << currentBenchmark << ": " << message << endl;
+  }
+}
@@ -0,0 +1,92 @@
+/**
+ * @file Benchmark.h
+ *
+ * This file declares a minimal registry for benchmarks and functions to measure and report their results.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+
+namespace Benchmark
+{
+  using Function = void (*)(); /**< The type of a function that runs a benchmark and reports its results. */
+
+  /** Registers a benchmark at static initialization time (use the macro \c BENCHMARK instead). */
+  struct Registration
+  {
+    /**
+     * Constructor.
+     * @param name The name of the benchmark.
+     * @param function The function that runs the benchmark.
+     */
+    Registration(const char* name, Function function);
+  };
+
+  /**
+   * Runs all registered benchmarks whose names contain one of the given filters.
+   * @param filters A list of substrings of benchmark names (all benchmarks are run if it is empty).
+   * @return Whether no benchmark has reported a failure.
+   */
+  bool runAll(const QStringList& filters);
+
+  /**
+   * Reports a result of the currently running benchmark.
+   * @param metric The name of the measured quantity.
+   * @param value The measured value.
+   * @param unit The unit of the measured value.
+   */
+  void report(const QString& metric, double value, const QString& unit);
+
+  /**
+   * Reports that a check of the currently running benchmark has failed (e.g. because a result is inaccurate).
+   * @param message A description of the failure.
+   */
+  void fail(const QString& message);
+
+  /**
+   * Prevents the compiler from optimizing away the computation of a value.
+   * @param value The value that must be computed.
+   */
+  template<typename T>
+  inline void doNotOptimize(const T& value)
+  {
+#ifdef __GNUC__
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+  }
+
+  /**
+   * Measures the average duration of a function by calling it repeatedly for a minimum amount of time.
+   * @param function The function to measure.
+   * @param minDuration The minimum duration of the measurement (ms).
+   * @return The average duration of one call (ns).
+   */
+  template<typename Function>
+  double measure(Function function, qint64 minDuration = 200)
+  {
+    // Warm up caches and branch predictors.
+    for(int i = 0; i < 100; ++i)
+      function();
+
+    QElapsedTimer timer;
+    timer.start();
+    long long calls = 0;
+    for(long long batch = 64; timer.elapsed() < minDuration; batch *= 2)
+      for(long long i = 0; i < batch; ++i, ++calls)
+        function();
+    return static_cast<double>(timer.nsecsElapsed()) / calls;
+  }
+}
+
+/** Defines and registers a benchmark function with the given name. */
+#define BENCHMARK(name) \
+  static void name(); \
+  static Benchmark::Registration name##Registration(#name, &name); \
+  static void name()
@@ -0,0 +1,20 @@
+/**
+ * @file BenchmarkMain.cpp
+ *
+ * This file defines the main procedure of the benchmark program.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include <QCoreApplication>
+#include <QStringList>
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QStringList filters = app.arguments();
+  filters.removeFirst();
+  return Benchmark::runAll(filters) ? 0 : 1;
+}
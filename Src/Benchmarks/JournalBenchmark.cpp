@@ -0,0 +1,230 @@
+/**
+ * @file JournalBenchmark.cpp
+ *
+ * This file implements a benchmark that checks that result journals are read back as they have been written
+ * and measures how fast attempts are scanned, both by decoding whole records and by reading single columns,
+ * and how long it takes to resume an interrupted pass from its journal.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "Challenge.h"
+#include "ChallengeLog.h"
+#include "Journal.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace
+{
+  constexpr std::size_t numOfPasses = 100000; /**< The number of passes in the generated journal. */
+  constexpr std::size_t numOfAttempts = 10; /**< The number of attempts per pass. */
+
+  /**
+   * Generates a journal in memory in which every attempt has a result.
+   * @param totalScore The sum of the scores of all attempts.
+   * @return The contents of the journal file.
+   */
+  QByteArray generateJournal(double& totalScore)
+  {
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> componentDistribution(0.f, 1.f);
+    const std::size_t numOfRecords = numOfPasses * (2 + 2 * numOfAttempts);
+    QByteArray data(static_cast<int>(Journal::headerSize + numOfRecords * Journal::recordSize), '\0');
+    auto* bytes = reinterpret_cast<uchar*>(data.data());
+    std::memcpy(bytes, Journal::magic, sizeof(Journal::magic));
+    qToLittleEndian<quint32>(Journal::version, bytes + 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(Journal::recordSize), bytes + 8);
+    bytes += Journal::headerSize;
+
+    totalScore = 0.0;
+    Journal::Record record;
+    for(std::size_t pass = 0; pass < numOfPasses; ++pass)
+    {
+      record = Journal::Record();
+      record.type = Journal::RecordType::passStart;
+      record.team = static_cast<std::uint16_t>(pass % 40);
+      record.robots = 0xb;
+      Journal::encode(record, bytes);
+      bytes += Journal::recordSize;
+      float passScore = 0.f;
+      for(std::size_t attempt = 0; attempt < numOfAttempts; ++attempt)
+      {
+        record = Journal::Record();
+        record.type = Journal::RecordType::attemptStart;
+        record.attempt = static_cast<std::uint16_t>(attempt);
+        record.location = static_cast<std::uint16_t>(attempt);
+        Journal::encode(record, bytes);
+        bytes += Journal::recordSize;
+
+        record.type = Journal::RecordType::attemptResult;
+        record.remainingTime = 1234567;
+        record.components.onSameFieldDecision = 1.f;
+        record.components.direction = componentDistribution(random);
+        record.components.distance = componentDistribution(random);
+        record.score = record.components.getTotal();
+        Journal::encode(record, bytes);
+        bytes += Journal::recordSize;
+        passScore += record.score;
+      }
+      record = Journal::Record();
+      record.type = Journal::RecordType::passEnd;
+      record.score = passScore;
+      Journal::encode(record, bytes);
+      bytes += Journal::recordSize;
+      totalScore += passScore;
+    }
+    return data;
+  }
+
+  /** Interrupts a pass after some attempts and measures how long it takes to restore it from its journal. */
+  void resume()
+  {
+    ChallengeLog::setEnabled(false);
+    const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(4.85f, 12.95f),
+                                                Vector2D(0.f, 7.2f), Vector2D(-4.85f, 12.95f), Vector2D(2.f, 10.f), Vector2D(-2.f, 5.f)};
+    const QVector<Pose2D> robotSetup = {Pose2D(0.f, -4.2f, 0.f), Pose2D(0.f, -0.3f, 0.f), Pose2D(0.f, 2.3f, 1.7f)};
+    const QVector<int> locationOrder = Challenge::createLocationOrder(whistleLocations.size(), 7);
+    constexpr int numOfFinishedAttempts = 5;
+
+    QTemporaryDir directory;
+    const QString path = directory.filePath("journal.dwj");
+    const QVector<Metric::ReferenceGeometry> referenceGeometries = Metric::calculateReferenceGeometries(robotSetup, whistleLocations);
+    float expectedTotalScore = 0.f;
+    {
+      JournalWriter writer(path);
+      // A finished pass before the interrupted one must not be confused with it.
+      writer.writePassStart(0, 5, {1, 2}, locationOrder);
+      writer.writePassEnd(0, 0.f, false);
+      writer.writePassStart(1, 5, {1, 2, 3}, locationOrder);
+      for(int i = 0; i < numOfFinishedAttempts; ++i)
+      {
+        DetectedWhistle whistle;
+        whistle.onSameField = true;
+        whistle.location = Vector2D(whistleLocations[locationOrder[i]].x + 0.1f * i, whistleLocations[locationOrder[i]].y - 0.2f);
+        const Metric::ScoreComponents components = Metric::calculateScoreComponents(referenceGeometries[locationOrder[i]], whistle);
+        writer.writeAttemptStart(2 + i, i, locationOrder[i]);
+        writer.writeAttemptResult(3 + i, i, locationOrder[i], i == 2 ? -1 : 1000000, whistle, components);
+        expectedTotalScore += i == 2 ? 0.f : components.getTotal();
+      }
+      // The pass has been interrupted while the next attempt was running.
+      writer.writeAttemptStart(10, numOfFinishedAttempts, locationOrder[numOfFinishedAttempts]);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    Journal::UnfinishedPass pass;
+    const bool found = JournalReader(path).findUnfinishedPass(pass) && pass.fits(3, whistleLocations.size());
+    Challenge challenge(whistleLocations, robotSetup, pass.locationOrder);
+    if(found)
+      challenge.resume(pass.results);
+    Benchmark::report("resume", timer.nsecsElapsed() / 1e6, "ms");
+
+    if(!found || pass.teamNumber != 5 || pass.robotNumbers != QVector<unsigned int>({1, 2, 3}) || pass.locationOrder != locationOrder)
+      Benchmark::fail("The interrupted pass has not been found.");
+    else if(challenge.getNumOfFinishedAttempts() != numOfFinishedAttempts || challenge.isAttemptRunning() ||
+            challenge.getAggregates().numOfTimeouts != 1 || std::abs(challenge.getTotalScore() - expectedTotalScore) > 1e-5f)
+      Benchmark::fail("The resumed pass differs from the interrupted one.");
+  }
+}
+
+BENCHMARK(journal)
+{
+  // A pass that is written through the real writer must be read back exactly.
+  QTemporaryDir directory;
+  const QString path = directory.filePath("journal.dwj");
+  DetectedWhistle whistle;
+  whistle.onSameField = true;
+  whistle.location = Vector2D(4.1234f, -11.0987f);
+  whistle.timestamp = 123456789;
+  Metric::ScoreComponents components;
+  components.onSameFieldDecision = 1.f;
+  components.direction = 0.75f;
+  components.distance = 0.5f;
+  {
+    JournalWriter writer(path);
+    writer.writePassStart(1, 42, {1, 2, 4}, {5, 2}, 3);
+    writer.writeAttemptStart(2, 0, 5);
+    writer.writeAttemptResult(3, 0, 5, 1234567, whistle, components);
+    writer.writeAttemptStart(4, 1, 2);
+    writer.writeAttemptResult(5, 1, 2, -1, whistle, components);
+    writer.writePassEnd(6, 2.25f, true);
+  }
+  const JournalReader fileReader(path);
+  Journal::Record passStart, result, timeout, passEnd;
+  Journal::UnfinishedPass unfinishedPass;
+  if(!fileReader.isValid() || fileReader.getNumOfRecords() != 8)
+    Benchmark::fail("The written journal could not be read.");
+  else if(fileReader.findUnfinishedPass(unfinishedPass))
+    Benchmark::fail("An aborted pass is considered unfinished.");
+  else
+  {
+    fileReader.readRecord(0, passStart);
+    fileReader.readRecord(4, result);
+    fileReader.readRecord(6, timeout);
+    fileReader.readRecord(7, passEnd);
+    if(passStart.type != Journal::RecordType::passStart || passStart.team != 42 || passStart.robots != 0xb || passStart.field != 3 ||
+       result.location != 5 || result.remainingTime != 1234567 || !result.whistle.onSameField || result.whistle.location.y != -11.0987f ||
+       result.whistle.timestamp != 123456789 || result.score != 2.25f || result.components.direction != 0.75f ||
+       timeout.flags != Journal::timedOut || timeout.score != 0.f || timeout.remainingTime != -1 ||
+       passEnd.type != Journal::RecordType::passEnd || passEnd.flags != Journal::aborted || passEnd.score != 2.25f)
+      Benchmark::fail("The read records differ from the written ones.");
+  }
+
+  resume();
+
+  double expectedTotalScore;
+  const QByteArray data = generateJournal(expectedTotalScore);
+  const JournalReader reader(reinterpret_cast<const uchar*>(data.constData()), static_cast<std::size_t>(data.size()));
+  const std::size_t numOfRecords = reader.getNumOfRecords();
+
+  double decodedScore = 0.0;
+  const double decodeDuration = Benchmark::measure([&reader, numOfRecords, &decodedScore]
+  {
+    Journal::Record record;
+    double totalScore = 0.0;
+    for(std::size_t i = 0; i < numOfRecords; ++i)
+    {
+      reader.readRecord(i, record);
+      if(record.type == Journal::RecordType::attemptResult)
+        totalScore += record.score;
+    }
+    decodedScore = totalScore;
+    Benchmark::doNotOptimize(totalScore);
+  });
+
+  // Reading only the type and score columns touches two values per record and needs no decoding on little endian machines.
+  double scannedScore = 0.0;
+  const double scanDuration = Benchmark::measure([&reader, numOfRecords, &scannedScore]
+  {
+    double totalScore = 0.0;
+    for(std::size_t i = 0; i < numOfRecords; ++i)
+    {
+      const uchar* record = reader.getRecordData(i);
+      if(record[0] == static_cast<uchar>(Journal::RecordType::attemptResult))
+      {
+        const quint32 bits = qFromLittleEndian<quint32>(record + 56);
+        float score;
+        std::memcpy(&score, &bits, sizeof(score));
+        totalScore += score;
+      }
+    }
+    scannedScore = totalScore;
+    Benchmark::doNotOptimize(totalScore);
+  });
+
+  if(numOfRecords != numOfPasses * (2 + 2 * numOfAttempts))
+    Benchmark::fail("Not all records have been found.");
+  else if(std::abs(decodedScore - expectedTotalScore) > 1e-6 * expectedTotalScore || scannedScore != decodedScore)
+    Benchmark::fail("The scanned scores differ from the written ones.");
+
+  const double numOfResults = static_cast<double>(numOfPasses * numOfAttempts);
+  Benchmark::report("decode.attempts", numOfResults / decodeDuration * 1e9 / 1e6, "M/s");
+  Benchmark::report("scan.attempts", numOfResults / scanDuration * 1e9 / 1e6, "M/s");
+  Benchmark::report("scan", data.size() / scanDuration * 1000.0, "MB/s");
+}
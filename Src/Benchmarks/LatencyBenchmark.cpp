@@ -0,0 +1,56 @@
+/**
+ * @file LatencyBenchmark.cpp
+ *
+ * This file implements benchmarks for the latency histograms that instrument the processing of whistle messages.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "Util/LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+BENCHMARK(latencyHistogram)
+{
+  // Latencies span several orders of magnitude, which a log-normal distribution mimics.
+  std::mt19937 random(0);
+  std::lognormal_distribution<double> distribution(10.0, 2.0);
+  std::vector<std::int64_t> values(100000);
+  for(std::int64_t& value : values)
+    value = static_cast<std::int64_t>(distribution(random));
+
+  std::unique_ptr<LatencyHistogram> histogram(new LatencyHistogram);
+  for(std::int64_t value : values)
+    histogram->record(value);
+  std::sort(values.begin(), values.end());
+
+  double maxRelativeError = 0.0;
+  for(double percentile : {50.0, 90.0, 99.0, 99.9, 100.0})
+  {
+    const std::size_t rank = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(percentile / 100.0 * values.size())));
+    const double exact = static_cast<double>(values[rank - 1]);
+    maxRelativeError = std::max(maxRelativeError, std::abs(histogram->getPercentile(percentile) - exact) / std::max(exact, 1.0));
+  }
+  Benchmark::report("maxRelativeError", maxRelativeError * 100.0, "%");
+  if(maxRelativeError > 1.0 / 64.0)
+    Benchmark::fail("The percentiles of the latency histogram deviate by " + QString::number(maxRelativeError * 100.0) + "% from the exact ones.");
+
+  std::size_t i = 0;
+  const double duration = Benchmark::measure([&]
+  {
+    histogram->record(values[i]);
+    i = (i + 1) % values.size();
+  });
+  Benchmark::report("record", duration, "ns");
+
+  const double percentileDuration = Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(histogram->getPercentile(99.0));
+  });
+  Benchmark::report("getPercentile", percentileDuration, "ns");
+}
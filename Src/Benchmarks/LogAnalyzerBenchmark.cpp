@@ -0,0 +1,119 @@
+/**
+ * @file LogAnalyzerBenchmark.cpp
+ *
+ * This file implements a benchmark that measures how fast passes are rebuilt from logs and checks that they are rebuilt correctly.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "LogAnalyzer.h"
+#include <QByteArray>
+#include <QString>
+#include <QTextStream>
+#include <random>
+
+namespace
+{
+  constexpr int numOfPasses = 2000; /**< The number of passes in the generated log (more than a tournament has). */
+  constexpr int numOfAttempts = 8; /**< The number of attempts per pass. */
+
+  /**
+   * Generates a log in the format of \c ChallengeLog with finished passes whose attempts alternately time out.
+   * @param totalScore The sum of the final scores of all passes.
+   * @return The log.
+   */
+  QByteArray generateLog(double& totalScore)
+  {
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> scoreDistribution(0.f, 3.f);
+    QString text;
+    QTextStream stream(&text);
+    const QString prefix = "2019-07-04T10:00:00: ";
+    totalScore = 0.0;
+    for(int pass = 0; pass < numOfPasses; ++pass)
+    {
+      stream << prefix << "Started challenge pass of team Team " << (pass % 40) << " with robots {1, 2, 4}\n";
+      float passScore = 0.f;
+      for(int attempt = 1; attempt <= numOfAttempts; ++attempt)
+      {
+        stream << prefix << "Started attempt " << attempt << " from location " << attempt << '\n';
+        stream << prefix << "Ingress: received=10, valid=10\n";
+        if(attempt % 2)
+        {
+          stream << prefix << "Finished attempt " << attempt << " from location " << attempt << " (timed out)\n";
+          continue;
+        }
+        const float score = scoreDistribution(random);
+        passScore += score;
+        stream << prefix << "Finished attempt " << attempt << " from location " << attempt << ":\n";
+        stream << prefix << "  Remaining time: " << QString::number(1234.567, 'f', 3) << "ms\n";
+        stream << prefix << "  Actual location: " << 4.85f << ", " << -12.5f << '\n';
+        stream << prefix << "  Reported location: " << 4.1234f << ", " << -11.0987f << '\n';
+        stream << prefix << "  Reported field: other\n";
+        stream << prefix << "  Score: " << score << '\n';
+      }
+      stream << prefix << "Finished challenge pass of team Team " << (pass % 40) << " with final score " << passScore << '\n';
+      totalScore += passScore;
+    }
+    stream.flush();
+    return text.toUtf8();
+  }
+}
+
+BENCHMARK(logAnalyzer)
+{
+  double expectedTotalScore;
+  const QByteArray log = generateLog(expectedTotalScore);
+
+  QVector<LogAnalyzer::Pass> passes;
+  LogAnalyzer::parse(log.constData(), log.constData() + log.size(), "log.txt", passes);
+  double totalScore = 0.0;
+  int timeouts = 0;
+  for(const LogAnalyzer::Pass& pass : passes)
+  {
+    totalScore += pass.totalScore;
+    for(const LogAnalyzer::Attempt& attempt : pass.attempts)
+      timeouts += attempt.timedOut ? 1 : 0;
+  }
+  if(passes.size() != numOfPasses || passes.last().status != LogAnalyzer::Pass::finished || passes.last().attempts.size() != numOfAttempts)
+    Benchmark::fail("Not all passes have been rebuilt.");
+  else if(std::abs(totalScore - expectedTotalScore) > 0.01 * numOfPasses || timeouts != numOfPasses * numOfAttempts / 2)
+    Benchmark::fail("The rebuilt scores differ from the logged ones.");
+  else if(passes[0].attempts[1].remainingTime != 1234.567 || passes[0].attempts[1].reportedLocation.y != -11.0987f)
+    Benchmark::fail("The rebuilt attempts differ from the logged ones.");
+
+  // A resumed pass replaces the interrupted one, whose finished attempts it logs again, and keeps the rules with which it has been scored.
+  const QByteArray resumedLog =
+    "2019-07-04T10:00:00: Started challenge pass of team Team A with robots {1, 2}\n"
+    "2019-07-04T10:00:01: Finished attempt 1 from location 3 (timed out)\n"
+    "2019-07-04T10:00:02: Started challenge pass of team Team B with robots {1, 2}\n"
+    "2019-07-04T10:00:03: Started challenge pass of team Team A with robots {1, 2}\n"
+    "2019-07-04T10:00:03: Finished attempt 1 from location 3 (timed out)\n"
+    "2019-07-04T10:00:04: Finished attempt 2 from location 1 (timed out)\n"
+    "2019-07-04T10:05:00: Started challenge pass of team Team A with robots {1, 2}\n"
+    "2019-07-04T10:05:00: Scoring rules: {\"field\":{\"halfLength\":4.5,\"halfWidth\":3},\"referenceRobot\":\"best\"}\n"
+    "2019-07-04T10:05:00: Resumed 2 attempts of the interrupted pass\n"
+    "2019-07-04T10:05:00: Finished attempt 1 from location 3 (timed out)\n"
+    "2019-07-04T10:05:00: Finished attempt 2 from location 1 (timed out)\n"
+    "2019-07-04T10:05:01: Finished attempt 3 from location 2 (timed out)\n"
+    "2019-07-04T10:05:02: Finished challenge pass of team Team A with final score 0\n";
+  QVector<LogAnalyzer::Pass> resumedPasses;
+  LogAnalyzer::parse(resumedLog.constData(), resumedLog.constData() + resumedLog.size(), "log.txt", resumedPasses);
+  LogAnalyzer::removeInterruptedPasses(resumedPasses);
+  if(resumedPasses.size() != 3 || resumedPasses[0].team != "Team A" || resumedPasses[0].attempts.size() != 1 || resumedPasses[1].team != "Team B" ||
+     resumedPasses[2].status != LogAnalyzer::Pass::finished || resumedPasses[2].resumedAttempts != 2 || resumedPasses[2].attempts.size() != 3)
+    Benchmark::fail("An interrupted pass has not been replaced by the resumed one.");
+  else if(passes[0].hasRules || !resumedPasses[2].hasRules || resumedPasses[2].rules.fieldHalfLength != 4.5f || resumedPasses[2].rules.fieldHalfWidth != 3.f ||
+          resumedPasses[2].rules.referencePolicy != ScoringRules::ReferencePolicy::bestRobot)
+    Benchmark::fail("The logged scoring rules have not been read correctly.");
+
+  const double duration = Benchmark::measure([&log]
+  {
+    QVector<LogAnalyzer::Pass> passes;
+    LogAnalyzer::parse(log.constData(), log.constData() + log.size(), "log.txt", passes);
+    Benchmark::doNotOptimize(passes);
+  });
+  Benchmark::report("parse", log.size() / duration * 1000.0, "MB/s");
+  Benchmark::report("parse.passes", numOfPasses / duration * 1e9, "1/s");
+}
@@ -0,0 +1,198 @@
+/**
+ * @file LogBenchmark.cpp
+ *
+ * This file implements benchmarks that measure how long writing the log stalls the GUI thread.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "ChallengeLog.h"
+#include "LogWriter.h"
+#include "Util/Clock.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+namespace
+{
+  constexpr int numOfAttempts = 50; /**< The number of simulated attempts. */
+  constexpr int linesPerAttempt = 6; /**< The number of lines that are logged when an attempt is finished. */
+
+  /**
+   * Builds a line like the ones that are logged when an attempt is finished.
+   * @param stream The stream to which the line is written.
+   * @param line The index of the line within the attempt.
+   */
+  void writeLine(QTextStream& stream, int line)
+  {
+    stream << QDateTime::currentDateTime().toString(Qt::ISODate) << ": " << "  Reported location: " << 1.25f * line << ", " << -0.5f * line << '\n';
+  }
+
+  /**
+   * Reports the mean and the maximum of a set of stall times.
+   * @param name The name under which the results are reported.
+   * @param stalls The stall times (ns) of all attempts.
+   */
+  void reportStalls(const QString& name, const QVector<qint64>& stalls)
+  {
+    qint64 sum = 0;
+    for(qint64 stall : stalls)
+      sum += stall;
+    Benchmark::report(name + ".meanStallPerAttempt", sum / 1000.0 / stalls.size(), "us");
+    Benchmark::report(name + ".maxStallPerAttempt", *std::max_element(stalls.begin(), stalls.end()) / 1000.0, "us");
+  }
+}
+
+BENCHMARK(logStall)
+{
+  QTemporaryDir directory;
+
+  // Before: Every line was flushed and synced to the device in the GUI thread.
+  {
+    QFile file(directory.path() + "/synchronous.txt");
+    file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Unbuffered);
+    QVector<qint64> stalls;
+    for(int attempt = 0; attempt < numOfAttempts; ++attempt)
+    {
+      QElapsedTimer timer;
+      timer.start();
+      for(int line = 0; line < linesPerAttempt; ++line)
+      {
+        QTextStream stream(&file);
+        writeLine(stream, line);
+        stream.flush();
+#ifdef __unix__
+        fsync(file.handle());
+#endif
+      }
+      stalls.append(timer.nsecsElapsed());
+    }
+    reportStalls("synchronous", stalls);
+  }
+
+  // After: Lines are handed over to the log writer and committed as a group at the attempt boundary.
+  {
+    LogWriter writer(directory.path() + "/groupCommit.txt");
+    QVector<qint64> stalls;
+    for(int attempt = 0; attempt < numOfAttempts; ++attempt)
+    {
+      QElapsedTimer timer;
+      timer.start();
+      for(int line = 0; line < linesPerAttempt; ++line)
+      {
+        QString text;
+        QTextStream stream(&text);
+        writeLine(stream, line);
+        stream.flush();
+        writer.append(text.toUtf8());
+      }
+      writer.commit();
+      stalls.append(timer.nsecsElapsed());
+
+      // Attempts are seconds apart, so the previous group has always been committed when the next attempt finishes.
+      writer.sync();
+    }
+    reportStalls("groupCommit", stalls);
+  }
+}
+
+BENCHMARK(logCommitNotification)
+{
+  // The challenge waits for the notification of the writer thread instead of a sync, so requesting the commit must not stall it.
+  QTemporaryDir directory;
+  const QString path = directory.path() + "/notified.txt";
+  LogWriter writer(path);
+  const QByteArray line = "2019-07-04T12:34:56:   Reported location: 1.25, -0.5\n";
+  std::mutex mutex;
+  std::condition_variable notified;
+  std::vector<qint64> fileSizes;
+  std::vector<std::int64_t> latencies;
+  QVector<qint64> stalls;
+  const auto waitForNotifications = [&](std::size_t count)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    notified.wait(lock, [&]{ return fileSizes.size() >= count; });
+  };
+  for(int attempt = 0; attempt < numOfAttempts; ++attempt)
+  {
+    for(int i = 0; i < linesPerAttempt; ++i)
+      writer.append(line);
+    const std::int64_t requestTime = Clock::getTime();
+    QElapsedTimer timer;
+    timer.start();
+    writer.commit([&, requestTime]
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      fileSizes.push_back(QFileInfo(path).size());
+      latencies.push_back(Clock::getTime() - requestTime);
+      notified.notify_one();
+    });
+    stalls.append(timer.nsecsElapsed());
+    waitForNotifications(attempt + 1);
+  }
+  reportStalls("notifiedCommit", stalls);
+  std::int64_t sum = 0;
+  for(std::int64_t latency : latencies)
+    sum += latency;
+  Benchmark::report("notifiedCommit.meanNotificationLatency", sum / 1000.0 / latencies.size(), "us");
+
+  for(int attempt = 0; attempt < numOfAttempts; ++attempt)
+    if(fileSizes[attempt] < static_cast<qint64>(attempt + 1) * linesPerAttempt * line.size())
+    {
+      Benchmark::fail("A commit has been reported before its records were written.");
+      break;
+    }
+
+  // A commit without new records must be reported as well.
+  writer.commit([&]
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    fileSizes.push_back(QFileInfo(path).size());
+    notified.notify_one();
+  });
+  waitForNotifications(numOfAttempts + 1);
+}
+
+BENCHMARK(logLine)
+{
+  // Without a log file, this only measures building a line (timestamp and formatting).
+  ChallengeLog::setEnabled(false);
+  int i = 0;
+  Benchmark::report("challengeLogLine", Benchmark::measure([&]
+  {
+    ChallengeLog() << "  Reported location: " << 1.25f * i << ", " << -0.5f * i;
+    ++i;
+  }), "ns");
+  ChallengeLog::setEnabled(true);
+
+  // Appends are measured in bursts that fit into the ring, so the result does not include waiting for commits.
+  QTemporaryDir directory;
+  LogWriter writer(directory.path() + "/append.txt");
+  const QByteArray line = "2019-07-04T12:34:56:   Reported location: 1.25, -0.5\n";
+  constexpr int burstSize = 512, numOfBursts = 50;
+  qint64 duration = 0;
+  for(int burst = 0; burst < numOfBursts; ++burst)
+  {
+    QElapsedTimer timer;
+    timer.start();
+    for(int j = 0; j < burstSize; ++j)
+      writer.append(line);
+    duration += timer.nsecsElapsed();
+    writer.sync();
+  }
+  Benchmark::report("logWriterAppend", static_cast<double>(duration) / (burstSize * numOfBursts), "ns");
+}
@@ -0,0 +1,94 @@
+/**
+ * @file MetricBenchmark.cpp
+ *
+ * This file implements benchmarks for the score calculation and angle normalization.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "DetectedWhistle.h"
+#include "Metric.h"
+#include "Util/Angle.h"
+#include <QVector>
+#include <random>
+
+namespace
+{
+  constexpr int numOfSamples = 1024; /**< The number of different inputs that are cycled through. */
+  constexpr int kdTreeRobots = Metric::kdTreeThreshold; /**< The smallest number of robots for which a k-d tree is used. */
+}
+
+BENCHMARK(metric)
+{
+  std::mt19937 random(0);
+  std::uniform_real_distribution<float> xDistribution(-7.f, 7.f), yDistribution(-13.f, 13.f), rotationDistribution(-Angle::pi, Angle::pi);
+
+  QVector<Pose2D> robotPoses;
+  for(int i = 0; i < 5; ++i)
+    robotPoses.append(Pose2D(rotationDistribution(random), xDistribution(random) * 0.6f, yDistribution(random) * 0.25f));
+  QVector<Vector2D> actualLocations;
+  QVector<DetectedWhistle> whistles(numOfSamples);
+  for(int i = 0; i < numOfSamples; ++i)
+  {
+    actualLocations.append(Vector2D(xDistribution(random), yDistribution(random)));
+    whistles[i].onSameField = random() % 2 == 0;
+    whistles[i].location = Vector2D(xDistribution(random), yDistribution(random));
+  }
+
+  // The reference pose is determined over all robots, so this shows its cost for every possible team size.
+  for(int numOfRobots = 1; numOfRobots <= 5; ++numOfRobots)
+  {
+    const QVector<Pose2D> robotSetup = robotPoses.mid(0, numOfRobots);
+    int i = 0;
+    const double duration = Benchmark::measure([&]
+    {
+      Benchmark::doNotOptimize(Metric::calculateScore(robotSetup, actualLocations[i], whistles[i]));
+      i = (i + 1) % numOfSamples;
+    });
+    Benchmark::report("calculateScore.robots" + QString::number(numOfRobots), duration, "ns");
+
+    const QVector<Metric::ReferenceGeometry> geometries = Metric::calculateReferenceGeometries(robotSetup, actualLocations);
+    const double cachedDuration = Benchmark::measure([&]
+    {
+      Benchmark::doNotOptimize(Metric::calculateScore(geometries[i], whistles[i]));
+      i = (i + 1) % numOfSamples;
+    });
+    Benchmark::report("calculateScore.cached.robots" + QString::number(numOfRobots), cachedDuration, "ns");
+  }
+
+  // Large synthetic setups, for which the reference poses are determined with a k-d tree.
+  for(int numOfRobots : {kdTreeRobots, 16 * kdTreeRobots})
+  {
+    QVector<Pose2D> robotSetup;
+    for(int i = 0; i < numOfRobots; ++i)
+      robotSetup.append(Pose2D(rotationDistribution(random), xDistribution(random), yDistribution(random)));
+    Benchmark::report("calculateReferenceGeometries.robots" + QString::number(numOfRobots), Benchmark::measure([&]
+    {
+      Benchmark::doNotOptimize(Metric::calculateReferenceGeometries(robotSetup, actualLocations).constData());
+    }) / numOfSamples, "ns");
+  }
+}
+
+BENCHMARK(angle)
+{
+  std::mt19937 random(0);
+  QVector<float> inRange, outOfRange;
+  for(int i = 0; i < numOfSamples; ++i)
+  {
+    inRange.append(std::uniform_real_distribution<float>(-Angle::pi, Angle::pi)(random));
+    outOfRange.append(std::uniform_real_distribution<float>(Angle::pi, 10.f * Angle::pi)(random) * (i % 2 ? 1.f : -1.f));
+  }
+
+  int i = 0;
+  Benchmark::report("normalize.inRange", Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(Angle::normalize(inRange[i]));
+    i = (i + 1) % numOfSamples;
+  }), "ns");
+  Benchmark::report("normalize.outOfRange", Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(Angle::normalize(outOfRange[i]));
+    i = (i + 1) % numOfSamples;
+  }), "ns");
+}
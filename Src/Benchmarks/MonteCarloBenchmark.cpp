@@ -0,0 +1,80 @@
+/**
+ * @file MonteCarloBenchmark.cpp
+ *
+ * This file implements benchmarks that measure the trial rate of the Monte Carlo score estimation on one and on all cores
+ * (checking that the estimates do not depend on the number of threads) and the time to rate all robot subsets.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "MonteCarlo.h"
+#include "SubsetPlanner.h"
+#include "Util/ThreadPool.h"
+#include <QElapsedTimer>
+
+BENCHMARK(monteCarlo)
+{
+  const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(4.85f, 12.95f)};
+  const QVector<Pose2D> robotSetup = {Pose2D(0.f, -4.2f, 0.f), Pose2D(0.f, -0.3f, 0.f), Pose2D(0.f, 2.3f, 1.7f)};
+  constexpr std::uint64_t trialsPerLocation = 2000000;
+
+  MonteCarlo::NoiseModel exact;
+  exact.bearingError = exact.rangeError = exact.falseSameFieldRate = exact.dropoutRate = 0.f;
+  ThreadPool singleThread(1), allThreads;
+  for(const MonteCarlo::LocationResult& result : MonteCarlo(whistleLocations, exact, ScoringRules::Definition()).run(robotSetup, 1000, 0, allThreads))
+    if(result.meanScore != 3.0 || result.scorePercentiles[0] != 3.f)
+    {
+      Benchmark::fail("Exact reports do not get the full score.");
+      break;
+    }
+  ScoringRules::Definition weighted;
+  weighted.onSameFieldDecisionWeight = 2.f;
+  weighted.distanceWeight = 0.5f;
+  for(const MonteCarlo::LocationResult& result : MonteCarlo(whistleLocations, exact, weighted).run(robotSetup, 1000, 0, allThreads))
+    if(result.meanScore != 3.5 || result.scorePercentiles[0] != 3.5f)
+    {
+      Benchmark::fail("Exact reports do not get the full score under weighted rules.");
+      break;
+    }
+
+  const MonteCarlo monteCarlo(whistleLocations, MonteCarlo::NoiseModel(), ScoringRules::Definition());
+  QElapsedTimer timer;
+  timer.start();
+  const QVector<MonteCarlo::LocationResult> sequential = monteCarlo.run(robotSetup, trialsPerLocation, 1, singleThread);
+  const double sequentialSeconds = timer.nsecsElapsed() / 1e9;
+  timer.restart();
+  const QVector<MonteCarlo::LocationResult> parallel = monteCarlo.run(robotSetup, trialsPerLocation, 1, allThreads);
+  const double parallelSeconds = timer.nsecsElapsed() / 1e9;
+
+  for(int i = 0; i < sequential.size(); ++i)
+    if(sequential[i].meanScore != parallel[i].meanScore || sequential[i].scorePercentiles != parallel[i].scorePercentiles)
+    {
+      Benchmark::fail("The estimates depend on the number of threads.");
+      break;
+    }
+
+  const double numOfTrials = static_cast<double>(trialsPerLocation) * whistleLocations.size();
+  Benchmark::report("trials.1thread", numOfTrials / sequentialSeconds / 1e6, "M/s");
+  Benchmark::report("trials." + QString::number(allThreads.getNumOfThreads()) + "threads", numOfTrials / parallelSeconds / 1e6, "M/s");
+}
+
+BENCHMARK(subsetPlanner)
+{
+  const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(2.25f, -2.5f),
+                                              Vector2D(4.85f, 12.95f), Vector2D(7.3f, 5.9f), Vector2D(0.f, -8.05f), Vector2D(4.85f, -12.5f)};
+  const QVector<Pose2D> robotPoses = {Pose2D(0.f, -4.2f, 0.f), Pose2D(0.f, -0.3f, 0.f), Pose2D(0.f, 2.3f, 1.7f), Pose2D(0.f, 2.3f, -1.7f), Pose2D(0.f, -2.f, 3.f)};
+
+  QElapsedTimer timer;
+  timer.start();
+  const QVector<SubsetPlanner::Rating> ratings = SubsetPlanner::calculate(robotPoses, whistleLocations, ScoringRules::Definition());
+  Benchmark::report("calculate", timer.nsecsElapsed() / 1e6, "ms");
+  if(ratings.size() != (1 << robotPoses.size()) - 1)
+    Benchmark::fail("Not all subsets have been rated.");
+  for(int i = 1; i < ratings.size(); ++i)
+    if(ratings[i - 1].expectedScore < ratings[i].expectedScore)
+    {
+      Benchmark::fail("The subsets are not ranked by their expected score.");
+      break;
+    }
+}
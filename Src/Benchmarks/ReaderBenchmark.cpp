@@ -0,0 +1,40 @@
+/**
+ * @file ReaderBenchmark.cpp
+ *
+ * This file implements benchmarks for reading the configuration files.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "Util/Reader.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+BENCHMARK(reader)
+{
+  QTemporaryDir directory;
+
+  for(int numOfPoses : {5, 500})
+  {
+    const QString path = directory.path() + "/robotPoses" + QString::number(numOfPoses) + ".json";
+    {
+      QFile file(path);
+      file.open(QIODevice::WriteOnly | QIODevice::Text);
+      QTextStream stream(&file);
+      stream << "[\n";
+      for(int i = 0; i < numOfPoses; ++i)
+        stream << (i ? ",\n" : "") << "  {\n    \"x\": " << (i % 9 - 4.5) << ",\n    \"y\": " << (i % 7 - 3.) << ",\n    \"rotation\": " << (i * 13 % 360 - 180) << "\n  }";
+      stream << "\n]\n";
+    }
+
+    QVector<Pose2D> poses;
+    const double duration = Benchmark::measure([&]
+    {
+      Reader::readPose2DList(path, poses);
+      Benchmark::doNotOptimize(poses.size());
+    });
+    Benchmark::report("readPose2DList.poses" + QString::number(numOfPoses), duration, "ns");
+  }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file ReceiverBenchmark.cpp
+ *
+ * This file implements benchmarks that compare the receive backends of the SPL standard message receiver.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "SPLStandardMessage.h"
+#include "SPLStandardMessageReceiver.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QUdpSocket>
+#include <cstddef>
+
+namespace
+{
+  constexpr unsigned int teamNumber = 99; /**< The team number that is used for the benchmark (it should not collide with a running tester). */
+  constexpr int burstSize = 50; /**< The number of messages that are sent before waiting for them to be received (similar to five robots flooding the port). */
+  constexpr int numOfBursts = 2000; /**< The number of bursts per backend. */
+
+  /**
+   * Measures the number of messages per second that a receiver backend handles.
+   * @param backend The backend to measure.
+   * @param name The name under which the result is reported.
+   */
+  void measureBackend(SPLStandardMessageReceiver::Backend backend, const QString& name)
+  {
+    SPLStandardMessageReceiver receiver(teamNumber, nullptr, backend);
+    int received = 0;
+    QObject::connect(&receiver, &SPLStandardMessageReceiver::whistleLocationsReceived, [&receiver, &received]
+    {
+      DetectedWhistle whistle;
+      while(receiver.getWhistleQueue().pop(whistle))
+        ++received;
+    });
+
+    SPLStandardMessage message;
+    message.version = 255;
+    message.playerNum = 1;
+    message.teamNum = teamNumber;
+    message.fallen = 1;
+
+    QUdpSocket sender;
+    QElapsedTimer timer;
+    timer.start();
+    int sent = 0;
+    for(int burst = 0; burst < numOfBursts; ++burst)
+    {
+      for(int i = 0; i < burstSize; ++i)
+        sent += sender.writeDatagram(reinterpret_cast<const char*>(&message), offsetof(SPLStandardMessage, data), QHostAddress::LocalHost, static_cast<quint16>(10000 + teamNumber)) > 0 ? 1 : 0;
+      QElapsedTimer burstTimer;
+      burstTimer.start();
+      while(received < sent && burstTimer.elapsed() < 100)
+        QCoreApplication::processEvents();
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    Benchmark::report(name + ".packetsPerSecond", received / seconds, "1/s");
+    Benchmark::report(name + ".lost", sent - received, "packets");
+  }
+}
+
+BENCHMARK(receiveBackends)
+{
+  measureBackend(SPLStandardMessageReceiver::Backend::qt, "qt");
+
+  bool batchedAvailable;
+  {
+    SPLStandardMessageReceiver probe(teamNumber, nullptr, SPLStandardMessageReceiver::Backend::batched);
+    batchedAvailable = probe.getBackend() == SPLStandardMessageReceiver::Backend::batched;
+  }
+  if(batchedAvailable)
+    measureBackend(SPLStandardMessageReceiver::Backend::batched, "batched");
+}
@@ -0,0 +1,163 @@
+/**
+ * @file ReplayBenchmark.cpp
+ *
+ * This file implements a benchmark that checks that a replay applies the records of a capture in the order of their timestamps
+ * (the capture writer may commit a datagram before the marker of the attempt to which it belongs) and measures how fast captures are replayed.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "Capture.h"
+#include "ChallengeLog.h"
+#include "ReplayEngine.h"
+#include "SPLStandardMessage.h"
+#include "SPLStandardMessageReceiver.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+  constexpr int numOfPasses = 2000; /**< The number of passes in the generated capture. */
+  constexpr unsigned int teamNumber = 5; /**< The number of the team that does the passes. */
+  constexpr std::int64_t attemptDuration = 10000000000; /**< The time (ns) between the starts of two attempts. */
+
+  /**
+   * Appends a record to a capture in memory.
+   * @param data The contents of the capture file.
+   * @param type The type of the record.
+   * @param timestamp The time of the event (in nanoseconds).
+   * @param payload The payload of the record.
+   * @param size The size of the payload.
+   */
+  void appendRecord(QByteArray& data, Capture::RecordType type, std::int64_t timestamp, const void* payload, std::size_t size)
+  {
+    uchar header[Capture::recordHeaderSize];
+    header[0] = static_cast<uchar>(type);
+    header[1] = 0;
+    qToLittleEndian<quint16>(static_cast<quint16>(size), header + 2);
+    qToLittleEndian<qint64>(timestamp, header + 4);
+    data.append(reinterpret_cast<const char*>(header), sizeof(header));
+    data.append(static_cast<const char*>(payload), static_cast<int>(size));
+  }
+
+  /**
+   * Appends a whistle message to a capture in memory.
+   * @param data The contents of the capture file.
+   * @param timestamp The arrival time of the message.
+   * @param location The reported whistle location.
+   */
+  void appendWhistle(QByteArray& data, std::int64_t timestamp, const Vector2D& location)
+  {
+    SPLStandardMessage message;
+    std::memset(&message, 0, sizeof(message));
+    std::memcpy(message.header, SPL_STANDARD_MESSAGE_STRUCT_HEADER, sizeof(message.header));
+    message.version = SPLStandardMessageReceiver::specialSPLStandardMessageVersion;
+    message.playerNum = 1;
+    message.teamNum = teamNumber;
+    message.fallen = 1;
+    message.pose[0] = location.x * 1000.f;
+    message.pose[1] = location.y * 1000.f;
+    appendRecord(data, Capture::RecordType::datagram, timestamp, &message, offsetof(SPLStandardMessage, data));
+  }
+
+  /**
+   * Generates a capture in which the whistle of every attempt has been written before the marker of the attempt start,
+   * and a whistle that arrived before the start has been written after it.
+   * @param numOfLocations The number of whistle locations (one attempt per location).
+   * @param reportedLocation The location that is reported for every attempt.
+   * @return The contents of the capture file.
+   */
+  QByteArray generateCapture(int numOfLocations, const Vector2D& reportedLocation)
+  {
+    QByteArray data;
+    char header[8];
+    std::memcpy(header, Capture::magic, sizeof(Capture::magic));
+    qToLittleEndian<quint32>(Capture::version, reinterpret_cast<uchar*>(header + 4));
+    data.append(header, sizeof(header));
+
+    std::int64_t time = 1000000000;
+    for(int pass = 0; pass < numOfPasses; ++pass)
+    {
+      QByteArray passStart;
+      passStart.append(static_cast<char>(teamNumber));
+      passStart.append(static_cast<char>(1));
+      passStart.append(static_cast<char>(1));
+      passStart.append(static_cast<char>(numOfLocations));
+      for(int locationIndex = 0; locationIndex < numOfLocations; ++locationIndex)
+        passStart.append(static_cast<char>(locationIndex));
+      appendRecord(data, Capture::RecordType::passStart, time, passStart.constData(), static_cast<std::size_t>(passStart.size()));
+
+      for(int attempt = 0; attempt < numOfLocations; ++attempt)
+      {
+        time += attemptDuration;
+        uchar attemptStart[4];
+        qToLittleEndian<quint16>(static_cast<quint16>(attempt), attemptStart);
+        qToLittleEndian<quint16>(static_cast<quint16>(attempt), attemptStart + 2);
+        uchar attemptStop[2];
+        qToLittleEndian<quint16>(static_cast<quint16>(attempt), attemptStop);
+
+        appendWhistle(data, time + 1000000, reportedLocation);
+        appendRecord(data, Capture::RecordType::attemptStart, time, attemptStart, sizeof(attemptStart));
+        appendWhistle(data, time - 1000000, Vector2D(-reportedLocation.x, -reportedLocation.y));
+        appendRecord(data, Capture::RecordType::attemptStop, time + 2000000, attemptStop, sizeof(attemptStop));
+      }
+      time += attemptDuration;
+    }
+    return data;
+  }
+}
+
+BENCHMARK(replay)
+{
+  ChallengeLog::setEnabled(false);
+  const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(0.f, 7.2f)};
+  const QVector<Pose2D> robotPoses = {Pose2D(0.f, -4.2f, 0.f)};
+  const Vector2D reportedLocation(1.f, 2.f);
+
+  QTemporaryDir directory;
+  const QString path = directory.filePath("replay.dwc");
+  const QByteArray capture = generateCapture(whistleLocations.size(), reportedLocation);
+  QFile file(path);
+  if(!file.open(QIODevice::WriteOnly) || file.write(capture) != capture.size())
+  {
+    Benchmark::fail("The capture could not be written.");
+    return;
+  }
+  file.close();
+
+  ReplayEngine engine(whistleLocations, robotPoses);
+  engine.setSpeed(0.0);
+  QVector<ReplayEngine::PassResult> results;
+  QElapsedTimer timer;
+  timer.start();
+  const bool valid = engine.replay(path, results);
+  const double seconds = timer.nsecsElapsed() / 1e9;
+
+  if(!valid || results.size() != numOfPasses)
+  {
+    Benchmark::fail("The capture has not been replayed completely.");
+    return;
+  }
+  for(const ReplayEngine::PassResult& result : results)
+  {
+    bool inOrder = result.numOfFinishedAttempts == whistleLocations.size();
+    for(const Challenge::Attempt& attempt : result.attempts)
+      inOrder &= attempt.remainingTime == static_cast<std::int64_t>(Challenge::attemptTimeLimit) * 1000 - 1000 &&
+                 attempt.whistle.location.x == reportedLocation.x && attempt.whistle.location.y == reportedLocation.y;
+    if(!inOrder)
+    {
+      Benchmark::fail("A whistle that was written before the start of its attempt has not been assigned to it.");
+      return;
+    }
+  }
+
+  const int numOfRecords = numOfPasses * (1 + 4 * whistleLocations.size());
+  Benchmark::report("records", numOfRecords / seconds, "1/s");
+  Benchmark::report("passes", numOfPasses / seconds, "1/s");
+}
@@ -0,0 +1,136 @@
+/**
+ * @file RescorerBenchmark.cpp
+ *
+ * This file implements a benchmark that checks that rescoring with the thresholds of the rules ranks the teams like the metric
+ * and measures how fast a tournament is rescored with a grid of other thresholds.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "DetectedWhistle.h"
+#include "Metric.h"
+#include "Rescorer.h"
+#include "ScoringRules.h"
+#include "Util/Angle.h"
+#include "Util/ThreadPool.h"
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace
+{
+  constexpr int numOfTeams = 48; /**< The number of teams in the generated tournament. */
+  constexpr int passesPerTeam = 3; /**< The number of finished passes per team. */
+  constexpr int numOfAttempts = 10; /**< The number of attempts per pass. */
+}
+
+BENCHMARK(rescorer)
+{
+  std::mt19937 random(0);
+  std::uniform_real_distribution<float> uniform;
+  std::normal_distribution<float> normal;
+
+  const QVector<Pose2D> robotPoses = {Pose2D(0.f, -4.2f, 0.f), Pose2D(0.f, -0.3f, 0.f), Pose2D(1.7f, 0.f, 2.3f), Pose2D(-1.7f, 2.5f, -2.f), Pose2D(3.1f, 3.f, 0.f)};
+  const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(4.85f, 12.95f), Vector2D(0.f, 7.2f),
+                                              Vector2D(-4.85f, 12.95f), Vector2D(2.f, 10.f), Vector2D(-2.f, 5.f), Vector2D(-3.f, -2.f), Vector2D(3.f, -9.f)};
+  const QVector<QVector<unsigned int>> robotSubsets = {{1, 2, 3}, {1, 2, 4}, {2, 4, 5}, {1, 3, 5}, {1, 2, 3, 4, 5}};
+
+  // Each team has its own accuracy, so that the standings are spread out but close enough to change with the thresholds.
+  Rescorer rescorer(robotPoses);
+  QVector<float> expectedBestScores(numOfTeams, std::numeric_limits<float>::lowest());
+  for(int team = 0; team < numOfTeams; ++team)
+  {
+    const float bearingError = (2.f + 20.f * uniform(random)) * Angle::pi / 180.f, rangeError = 0.05f + 0.3f * uniform(random);
+    for(int pass = 0; pass < passesPerTeam; ++pass)
+    {
+      const QVector<unsigned int>& robotNumbers = robotSubsets[(team + pass) % robotSubsets.size()];
+      QVector<Pose2D> robotSetup;
+      for(unsigned int jerseyNumber : robotNumbers)
+        robotSetup.append(robotPoses[jerseyNumber - 1]);
+      const QVector<Metric::ReferenceGeometry> geometries = Metric::calculateReferenceGeometries(robotSetup, whistleLocations);
+
+      QVector<Rescorer::Attempt> attempts;
+      float passScore = 0.f;
+      for(int i = 0; i < numOfAttempts; ++i)
+      {
+        Rescorer::Attempt attempt;
+        attempt.actualLocation = whistleLocations[i];
+        attempt.timedOut = uniform(random) < 0.05f;
+        if(!attempt.timedOut)
+        {
+          const Metric::ReferenceGeometry& geometry = geometries[i];
+          const float bearing = geometry.actualAngle + normal(random) * bearingError;
+          const float distance = geometry.actualDistance * std::max(0.f, 1.f + normal(random) * rangeError);
+          DetectedWhistle whistle;
+          whistle.location = Vector2D(geometry.referenceLocation.x + distance * std::cos(bearing), geometry.referenceLocation.y + distance * std::sin(bearing));
+          whistle.onSameField = geometry.isActuallyOnSameField != (uniform(random) < 0.1f);
+          attempt.reportedLocation = whistle.location;
+          attempt.reportedOnSameField = whistle.onSameField;
+          passScore += Metric::calculateScore(geometry, whistle);
+        }
+        attempts.append(attempt);
+      }
+      rescorer.addPass("Team" + QString::number(team), robotNumbers, attempts);
+      expectedBestScores[team] = std::max(expectedBestScores[team], passScore);
+    }
+  }
+
+  // The thresholds of the rules must reproduce the scores of the metric.
+  const Rescorer::Result baseline = rescorer.score(ScoringRules::Definition());
+  float maxDeviation = 0.f;
+  for(int team = 0; team < numOfTeams; ++team)
+    maxDeviation = std::max(maxDeviation, std::abs(baseline.bestScores[team] - expectedBestScores[team]));
+  Benchmark::report("maxDeviation", maxDeviation, "points");
+  if(rescorer.getTeams().size() != numOfTeams || !(maxDeviation <= BatchMetric::tolerance * numOfAttempts))
+    Benchmark::fail("The rescored passes deviate by " + QString::number(maxDeviation) + " from the metric.");
+
+  // Judging each report from the robot from which it scores best cannot lower the best pass of a team.
+  ScoringRules::Definition bestRobotRules;
+  bestRobotRules.referencePolicy = ScoringRules::ReferencePolicy::bestRobot;
+  const Rescorer::Result bestRobot = rescorer.score(bestRobotRules);
+  for(int team = 0; team < numOfTeams; ++team)
+    if(!(bestRobot.bestScores[team] >= baseline.bestScores[team] - BatchMetric::tolerance * numOfAttempts))
+    {
+      Benchmark::fail("Rescoring with the best robot lowers the score of a team.");
+      break;
+    }
+
+  const QVector<ScoringRules::Definition> grid = Rescorer::createGrid(ScoringRules::Definition(), {0.f, 2.5f, 5.f, 7.5f, 10.f, 12.5f, 15.f, 17.5f},
+                                                                      {20.f, 25.f, 30.f, 35.f, 40.f, 45.f}, {4.8f, 5.f, 5.2f, 5.4f}, {3.5f, 3.7f, 3.9f});
+  ThreadPool pool;
+  QVector<Rescorer::Result> results;
+  const double sweepDuration = Benchmark::measure([&]
+  {
+    results = rescorer.sweep(grid, pool);
+    Benchmark::doNotOptimize(results.constData());
+  });
+
+  // Each set of thresholds must be scored exactly as on a single thread, and the grid must contain the thresholds of the rules.
+  const ScoringRules::Definition official;
+  int numOfChangedSets = 0;
+  bool baselineFound = false;
+  for(const Rescorer::Result& result : results)
+  {
+    const Rescorer::Result expected = rescorer.score(result.rules);
+    if(result.bestScores != expected.bestScores || result.ranks != expected.ranks)
+      Benchmark::fail("The sweep differs from scoring each set of thresholds on its own.");
+    if(Rescorer::countRankChanges(result, baseline))
+      ++numOfChangedSets;
+    else if(result.rules.minDirectionDeviation == official.minDirectionDeviation && result.rules.maxDirectionDeviation == official.maxDirectionDeviation &&
+            result.rules.fieldHalfLength == official.fieldHalfLength && result.rules.fieldHalfWidth == official.fieldHalfWidth)
+      baselineFound = true;
+  }
+  if(!baselineFound)
+    Benchmark::fail("The thresholds of the rules do not reproduce the standings.");
+  if(!numOfChangedSets)
+    Benchmark::fail("No set of thresholds changes the standings.");
+
+  const double numOfReports = static_cast<double>(grid.size()) * rescorer.getNumOfAttempts();
+  Benchmark::report("sweep", sweepDuration / 1e6, "ms");
+  Benchmark::report("sweep.parameterSets", grid.size() / sweepDuration * 1e9, "1/s");
+  Benchmark::report("sweep.attempts", numOfReports / sweepDuration * 1e9 / 1e6, "M/s");
+  Benchmark::report("changedParameterSets", numOfChangedSets, "");
+}
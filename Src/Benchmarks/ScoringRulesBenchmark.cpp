@@ -0,0 +1,143 @@
+/**
+ * @file ScoringRulesBenchmark.cpp
+ *
+ * This file implements a benchmark that checks that configured scoring rules are read and applied correctly
+ * and compares the speed of the compiled rules to the built-in metric.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "DetectedWhistle.h"
+#include "Metric.h"
+#include "ScoringRules.h"
+#include "Util/Angle.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QVector>
+#include <random>
+
+namespace
+{
+  constexpr int numOfSamples = 1024; /**< The number of different inputs that are cycled through. */
+
+  /**
+   * Writes rules into a file and reads them.
+   * @param directory The directory in which the file is created.
+   * @param json The contents of the file.
+   * @param definition The read rules.
+   * @return Whether the rules are valid.
+   */
+  bool readRules(const QTemporaryDir& directory, const QByteArray& json, ScoringRules::Definition& definition)
+  {
+    const QString path = directory.filePath("scoringRules.json");
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+      return false;
+    file.close();
+    QString error;
+    return ScoringRules::read(path, definition, error);
+  }
+}
+
+BENCHMARK(scoringRules)
+{
+  std::mt19937 random(0);
+  std::uniform_real_distribution<float> xDistribution(-7.f, 7.f), yDistribution(-13.f, 13.f), rotationDistribution(-Angle::pi, Angle::pi);
+
+  QVector<Pose2D> robotSetup;
+  for(int i = 0; i < 5; ++i)
+    robotSetup.append(Pose2D(rotationDistribution(random), xDistribution(random) * 0.6f, yDistribution(random) * 0.25f));
+  QVector<Vector2D> actualLocations;
+  QVector<DetectedWhistle> whistles(numOfSamples);
+  for(int i = 0; i < numOfSamples; ++i)
+  {
+    actualLocations.append(Vector2D(xDistribution(random), yDistribution(random)));
+    whistles[i].onSameField = random() % 2 == 0;
+    // Some reports are close to the actual location, so that all parts of the deviation scores are covered.
+    whistles[i].location = i % 4 ? Vector2D(xDistribution(random), yDistribution(random))
+                                 : Vector2D(actualLocations[i].x + xDistribution(random) * 0.05f, actualLocations[i].y + yDistribution(random) * 0.05f);
+  }
+
+  // Partial rules keep the official values, invalid rules are rejected.
+  QTemporaryDir directory;
+  ScoringRules::Definition weightedDefinition, invalidDefinition;
+  if(!readRules(directory, "{\"weights\": {\"onSameFieldDecision\": 2, \"distance\": 0.5}, \"field\": {\"halfLength\": 4.5}, \"referenceRobot\": \"best\"}", weightedDefinition) ||
+     weightedDefinition.onSameFieldDecisionWeight != 2.f || weightedDefinition.directionWeight != 1.f || weightedDefinition.distanceWeight != 0.5f ||
+     weightedDefinition.fieldHalfLength != 4.5f || weightedDefinition.fieldHalfWidth != 3.7f || weightedDefinition.maxDirectionDeviation != 30.f ||
+     weightedDefinition.referencePolicy != ScoringRules::ReferencePolicy::bestRobot)
+    Benchmark::fail("Valid rules have not been read correctly.");
+  if(readRules(directory, "{\"direction\": {\"minDeviation\": 30, \"maxDeviation\": 5}}", invalidDefinition) ||
+     readRules(directory, "{\"referenceRobot\": \"nearest\"}", invalidDefinition) || readRules(directory, "{\"weights\": {\"distance\": \"1\"}}", invalidDefinition) ||
+     readRules(directory, "{\"weights\": {\"direction\": -1}}", invalidDefinition) || readRules(directory, "{\"weights\": 2}", invalidDefinition) ||
+     readRules(directory, "{\"field\": [4.5, 3]}", invalidDefinition) || readRules(directory, "{\"referenceRobot\": 1}", invalidDefinition))
+    Benchmark::fail("Invalid rules have been accepted.");
+
+  // The rules that are written to the log must be read back exactly (the log analyzer judges each pass with them).
+  ScoringRules::Definition loggedDefinition;
+  QString error;
+  if(!ScoringRules::fromJson(ScoringRules::toJson(weightedDefinition), loggedDefinition, error) ||
+     ScoringRules::toJson(loggedDefinition) != ScoringRules::toJson(weightedDefinition))
+    Benchmark::fail("Logged rules have not been read correctly.");
+  weightedDefinition.referencePolicy = ScoringRules::ReferencePolicy::closestRobot;
+  weightedDefinition.fieldHalfLength = 5.2f;
+  ScoringRules::Definition bestRobotDefinition;
+  bestRobotDefinition.referencePolicy = ScoringRules::ReferencePolicy::bestRobot;
+
+  const QVector<Metric::ReferenceGeometry> geometries = Metric::calculateReferenceGeometries(robotSetup, actualLocations);
+  const ScoringRules officialRules(ScoringRules::Definition(), robotSetup, actualLocations);
+  const ScoringRules weightedRules(weightedDefinition, robotSetup, actualLocations);
+  const ScoringRules bestRobotRules(bestRobotDefinition, robotSetup, actualLocations);
+  const ScoringRules singleRobotRules(bestRobotDefinition, robotSetup.mid(0, 1), actualLocations);
+  const ScoringRules closestSingleRobotRules(ScoringRules::Definition(), robotSetup.mid(0, 1), actualLocations);
+
+  // The official rules must give exactly the results of the metric, the others must be consistent with them.
+  bool official = true, weighted = true, bestRobot = true;
+  for(int i = 0; i < numOfSamples; ++i)
+  {
+    const Metric::ScoreComponents expected = Metric::calculateScoreComponents(geometries[i], whistles[i]);
+    const Metric::ScoreComponents officialComponents = officialRules.calculateScoreComponents(i, whistles[i]);
+    const Metric::ScoreComponents weightedComponents = weightedRules.calculateScoreComponents(i, whistles[i]);
+    official &= officialComponents.onSameFieldDecision == expected.onSameFieldDecision && officialComponents.direction == expected.direction &&
+                officialComponents.distance == expected.distance;
+    weighted &= weightedComponents.onSameFieldDecision == 2.f * expected.onSameFieldDecision && weightedComponents.direction == expected.direction &&
+                weightedComponents.distance == 0.5f * expected.distance;
+    bestRobot &= bestRobotRules.calculateScoreComponents(i, whistles[i]).getTotal() >= expected.getTotal() &&
+                 singleRobotRules.calculateScoreComponents(i, whistles[i]).getTotal() == closestSingleRobotRules.calculateScoreComponents(i, whistles[i]).getTotal();
+  }
+  if(!official)
+    Benchmark::fail("The official rules score differently than the metric.");
+  if(!weighted)
+    Benchmark::fail("The weights are not applied correctly.");
+  if(!bestRobot)
+    Benchmark::fail("The best robot does not give the highest score.");
+
+  int i = 0;
+  const double metricDuration = Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(Metric::calculateScoreComponents(geometries[i], whistles[i]));
+    i = (i + 1) % numOfSamples;
+  });
+  const double officialDuration = Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(officialRules.calculateScoreComponents(i, whistles[i]));
+    i = (i + 1) % numOfSamples;
+  });
+  const double weightedDuration = Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(weightedRules.calculateScoreComponents(i, whistles[i]));
+    i = (i + 1) % numOfSamples;
+  });
+  const double bestRobotDuration = Benchmark::measure([&]
+  {
+    Benchmark::doNotOptimize(bestRobotRules.calculateScoreComponents(i, whistles[i]));
+    i = (i + 1) % numOfSamples;
+  });
+
+  Benchmark::report("metric", metricDuration, "ns");
+  Benchmark::report("official", officialDuration, "ns");
+  Benchmark::report("weighted", weightedDuration, "ns");
+  Benchmark::report("bestRobot.robots5", bestRobotDuration, "ns");
+  Benchmark::report("official.relative", officialDuration / metricDuration, "x");
+  Benchmark::report("weighted.relative", weightedDuration / metricDuration, "x");
+}
@@ -0,0 +1,162 @@
+/**
+ * @file SessionBenchmark.cpp
+ *
+ * This file implements a benchmark that measures the scoring latency of simultaneous passes on several fields, with and without a flood on one of them
+ * and with and without recording logs, captures and journals.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "Challenge.h"
+#include "ChallengeLog.h"
+#include "MessageFactory.h"
+#include "SPLStandardMessageReceiver.h"
+#include "SessionManager.h"
+#include "Util/Clock.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QTemporaryDir>
+#include <QUdpSocket>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  constexpr int numOfFields = 8; /**< The number of simultaneous passes. */
+  constexpr unsigned int firstTeamNumber = 90; /**< The team number of the first field (they should not collide with a running tester). */
+  constexpr int numOfRounds = 200; /**< The number of attempts per field and measurement. */
+
+  /**
+   * Runs attempts on all fields at once and measures the time from sending each whistle until its attempt has been scored.
+   * @param sessionManager The session with a pass on each field.
+   * @param firstField The first field on which attempts are measured.
+   * @param latencies The latencies (ns) of all scored attempts.
+   * @return Whether all attempts were scored.
+   */
+  bool measureLatencies(SessionManager& sessionManager, int firstField, std::vector<std::int64_t>& latencies)
+  {
+    std::mt19937 random(0);
+    QUdpSocket sender;
+    std::vector<std::int64_t> sendTimes(numOfFields);
+    int pending = 0;
+    const QMetaObject::Connection connection = QObject::connect(&sessionManager, &SessionManager::attemptFinished, [&](int field)
+    {
+      latencies.push_back(Clock::getTime() - sendTimes[field]);
+      --pending;
+    });
+
+    const QVector<unsigned int> robotNumbers = {1, 2, 3};
+    QString error;
+    bool complete = true;
+    for(int round = 0; round < numOfRounds && complete; ++round)
+    {
+      for(int field = firstField; field < numOfFields; ++field)
+      {
+        Challenge* challenge = sessionManager.getChallenge(field);
+        if(challenge && challenge->isFinished())
+        {
+          sessionManager.stopPass(field);
+          challenge = nullptr;
+        }
+        if(!challenge)
+        {
+          if(!sessionManager.startPass(field, firstTeamNumber + field, robotNumbers, error))
+          {
+            Benchmark::fail(error);
+            QObject::disconnect(connection);
+            return false;
+          }
+          challenge = sessionManager.getChallenge(field);
+        }
+        challenge->startAttempt();
+      }
+      pending = numOfFields - firstField;
+      for(int field = firstField; field < numOfFields; ++field)
+      {
+        const QByteArray message = MessageFactory::create(MessageFactory::valid, firstTeamNumber + field, random);
+        sendTimes[field] = Clock::getTime();
+        sender.writeDatagram(message, QHostAddress::LocalHost, static_cast<quint16>(10000 + firstTeamNumber + field));
+      }
+      QElapsedTimer timer;
+      timer.start();
+      while(pending > 0 && timer.elapsed() < 1000)
+        QCoreApplication::processEvents();
+      complete = pending == 0;
+    }
+    QObject::disconnect(connection);
+    return complete;
+  }
+
+  /**
+   * Reports percentiles of latencies.
+   * @param name The prefix of the metrics.
+   * @param latencies The latencies (ns).
+   */
+  void reportLatencies(const QString& name, std::vector<std::int64_t>& latencies)
+  {
+    std::sort(latencies.begin(), latencies.end());
+    if(latencies.empty())
+      return;
+    Benchmark::report(name + ".p50", latencies[latencies.size() / 2] / 1000.0, "us");
+    Benchmark::report(name + ".p99", latencies[latencies.size() * 99 / 100] / 1000.0, "us");
+    Benchmark::report(name + ".max", latencies.back() / 1000.0, "us");
+  }
+
+  /**
+   * Measures the latencies of a session without and with a flood on the first field.
+   * @param name The prefix of the metrics.
+   * @param logPath The directory in which the fields record (empty to record nothing).
+   */
+  void measureSession(const QString& name, const QString& logPath)
+  {
+    const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(4.85f, 12.95f)};
+    const QVector<Pose2D> robotPoses = {Pose2D(0.f, -4.2f, 0.f), Pose2D(0.f, -0.3f, 0.f), Pose2D(0.f, 2.3f, 1.7f)};
+    SessionManager sessionManager(numOfFields, whistleLocations, robotPoses, logPath);
+
+    std::vector<std::int64_t> latencies;
+    if(!measureLatencies(sessionManager, 0, latencies))
+      Benchmark::fail("Not all attempts were scored without load (" + name + ").");
+    reportLatencies(name + ".idle", latencies);
+
+    // Field 1 is flooded with messages that must be checked but are not meant for the tester.
+    std::atomic<bool> flooding(true);
+    std::atomic<long long> floodMessages(0);
+    std::thread flood([&]
+    {
+      std::mt19937 random(1);
+      const QByteArray message = MessageFactory::create(MessageFactory::otherVersion, firstTeamNumber, random);
+      QUdpSocket socket;
+      while(flooding)
+        if(socket.writeDatagram(message, QHostAddress::LocalHost, static_cast<quint16>(10000 + firstTeamNumber)) > 0)
+          ++floodMessages;
+    });
+    QElapsedTimer timer;
+    timer.start();
+    latencies.clear();
+    const bool complete = measureLatencies(sessionManager, 1, latencies);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    flooding = false;
+    flood.join();
+    if(!complete)
+      Benchmark::fail("Not all attempts were scored while another field was flooded (" + name + ").");
+    reportLatencies(name + ".flooded", latencies);
+    Benchmark::report(name + ".flood.rate", floodMessages / seconds, "1/s");
+    if(const SPLStandardMessageReceiver* receiver = sessionManager.getReceiver(0))
+      Benchmark::report(name + ".flood.captureDropped", static_cast<double>(receiver->getCounters().getCaptureDropped()), "datagrams");
+  }
+}
+
+BENCHMARK(multiField)
+{
+  ChallengeLog::setEnabled(false);
+  measureSession("unrecorded", QString());
+
+  // Recording must not slow down the receiving thread, even if a flood has to be written to the capture.
+  QTemporaryDir directory;
+  measureSession("recorded", directory.path());
+}
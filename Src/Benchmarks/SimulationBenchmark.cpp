@@ -0,0 +1,56 @@
+/**
+ * @file SimulationBenchmark.cpp
+ *
+ * This file implements a benchmark that measures how many challenge passes can be simulated in virtual time per second
+ * and checks that a seed always results in the same pass.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "ChallengeLog.h"
+#include "PassSimulator.h"
+#include <QElapsedTimer>
+
+BENCHMARK(simulation)
+{
+  ChallengeLog::setEnabled(false);
+  const QVector<Vector2D> whistleLocations = {Vector2D(0.f, 3.35f), Vector2D(4.85f, 1.1f), Vector2D(-4.85f, 3.35f), Vector2D(4.85f, 12.95f),
+                                              Vector2D(0.f, 7.2f), Vector2D(-4.85f, 12.95f), Vector2D(2.f, 10.f), Vector2D(-2.f, 5.f)};
+  const QVector<Pose2D> robotPoses = {Pose2D(0.f, -4.2f, 0.f), Pose2D(0.f, -0.3f, 0.f), Pose2D(0.f, 2.3f, 1.7f)};
+  PassSimulator::TeamModel model;
+  model.meanResponseTime = 4000.f;
+  const PassSimulator simulator(whistleLocations, robotPoses, model);
+
+  const PassSimulator::PassResult first = simulator.simulate(42);
+  const PassSimulator::PassResult second = simulator.simulate(42);
+  if(first.attempts.size() != whistleLocations.size() || first.aggregates.numOfFinishedAttempts != whistleLocations.size())
+    Benchmark::fail("The simulated pass did not finish all attempts.");
+  if(first.duration != second.duration || first.aggregates.totalScore != second.aggregates.totalScore ||
+     first.aggregates.numOfTimeouts != second.aggregates.numOfTimeouts)
+    Benchmark::fail("Two simulations with the same seed differ.");
+  for(int i = 0; i < first.attempts.size() && i < second.attempts.size(); ++i)
+    if(first.attempts[i].locationIndex != second.attempts[i].locationIndex || first.attempts[i].remainingTime != second.attempts[i].remainingTime)
+    {
+      Benchmark::fail("Two simulations with the same seed differ.");
+      break;
+    }
+
+  unsigned int seed = 0;
+  int timeouts = 0;
+  double virtualTime = 0.0;
+  QElapsedTimer timer;
+  timer.start();
+  int passes = 0;
+  for(; passes < 1000 || timer.elapsed() < 200; ++passes)
+  {
+    const PassSimulator::PassResult result = simulator.simulate(seed++);
+    timeouts += result.aggregates.numOfTimeouts;
+    virtualTime += result.duration / 1e9;
+  }
+  const double seconds = timer.nsecsElapsed() / 1e9;
+  if(!timeouts)
+    Benchmark::fail("No attempt timed out although the model responds late.");
+  Benchmark::report("passes", passes / seconds, "1/s");
+  Benchmark::report("speedup", virtualTime / seconds, "x");
+}
@@ -0,0 +1,52 @@
+/**
+ * @file ValidationBenchmark.cpp
+ *
+ * This file implements benchmarks for the checks that the receiver applies to each SPL standard message.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Benchmark.h"
+#include "MessageFactory.h"
+#include "SPLStandardMessage.h"
+#include "SPLStandardMessageReceiver.h"
+#include <QVector>
+#include <cstring>
+#include <random>
+#include <utility>
+
+namespace
+{
+  constexpr unsigned int teamNumber = 5; /**< The team number that the receiver expects. */
+  constexpr int numOfSamples = 256; /**< The number of different messages per kind that are cycled through. */
+}
+
+BENCHMARK(validation)
+{
+  std::mt19937 random(0);
+  for(int kind = 0; kind < MessageFactory::numOfKinds; ++kind)
+  {
+    QVector<std::pair<SPLStandardMessage, std::size_t>> messages(numOfSamples);
+    for(auto& message : messages)
+    {
+      const QByteArray datagram = MessageFactory::create(static_cast<MessageFactory::Kind>(kind), teamNumber, random);
+      std::memcpy(&message.first, datagram.constData(), static_cast<std::size_t>(datagram.size()));
+      message.second = static_cast<std::size_t>(datagram.size());
+
+      // Each kind of message must be rejected by the check that is meant to catch it, otherwise the counters are wrong.
+      DetectedWhistle whistle;
+      const char* verdict = SPLStandardMessageReceiver::getName(SPLStandardMessageReceiver::decodeMessage(message.first, message.second, teamNumber, whistle));
+      if(std::strcmp(verdict, MessageFactory::getName(static_cast<MessageFactory::Kind>(kind))) != 0)
+        Benchmark::fail(QString("decodeMessage: A message of kind ") + MessageFactory::getName(static_cast<MessageFactory::Kind>(kind)) + " has the verdict " + verdict + ".");
+    }
+
+    int i = 0;
+    const double duration = Benchmark::measure([&]
+    {
+      DetectedWhistle whistle;
+      Benchmark::doNotOptimize(SPLStandardMessageReceiver::decodeMessage(messages[i].first, messages[i].second, teamNumber, whistle));
+      i = (i + 1) % numOfSamples;
+    });
+    Benchmark::report(QString("decodeMessage.") + MessageFactory::getName(static_cast<MessageFactory::Kind>(kind)), duration, "ns");
+  }
+}
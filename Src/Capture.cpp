@@ -0,0 +1,176 @@
+/**
+ * @file Capture.cpp
+ *
+ * This file implements classes that write and read captures of received datagrams and challenge events.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Capture.h"
+#include "SPLStandardMessage.h"
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+static_assert(sizeof(SPLStandardMessage) <= Capture::maxDatagramSize, "Received datagrams must fit into the datagram ring of the capture.");
+
+bool Capture::decodePassStart(const Record& record, PassStart& passStart)
+{
+  const auto* bytes = reinterpret_cast<const std::uint8_t*>(record.payload);
+  if(record.type != RecordType::passStart || record.size < 2)
+    return false;
+  const std::size_t numOfRobots = bytes[1];
+  if(record.size < 3 + numOfRobots)
+    return false;
+  const std::size_t numOfLocations = bytes[2 + numOfRobots];
+  if(record.size != 3 + numOfRobots + numOfLocations)
+    return false;
+
+  passStart.teamNumber = bytes[0];
+  passStart.robotNumbers.clear();
+  for(std::size_t i = 0; i < numOfRobots; ++i)
+    passStart.robotNumbers.append(bytes[2 + i]);
+  passStart.locationOrder.clear();
+  for(std::size_t i = 0; i < numOfLocations; ++i)
+    passStart.locationOrder.append(bytes[3 + numOfRobots + i]);
+  return true;
+}
+
+bool Capture::decodeAttempt(const Record& record, int& attemptIndex, int* locationIndex)
+{
+  const auto* bytes = reinterpret_cast<const uchar*>(record.payload);
+  if(record.type == RecordType::attemptStart && record.size == 4)
+  {
+    attemptIndex = qFromLittleEndian<quint16>(bytes);
+    if(locationIndex)
+      *locationIndex = qFromLittleEndian<quint16>(bytes + 2);
+    return true;
+  }
+  else if(record.type == RecordType::attemptStop && record.size == 2)
+  {
+    attemptIndex = qFromLittleEndian<quint16>(bytes);
+    return true;
+  }
+  return false;
+}
+
+CaptureWriter::CaptureWriter(const QString& path) :
+  writer(path, nullptr, [this](std::vector<QByteArray>& group){ drainDatagrams(group); })
+{
+  char header[8];
+  std::memcpy(header, Capture::magic, sizeof(Capture::magic));
+  qToLittleEndian<quint32>(Capture::version, reinterpret_cast<uchar*>(header + 4));
+  writer.append(QByteArray(header, sizeof(header)));
+}
+
+void CaptureWriter::writePassStart(std::int64_t timestamp, const Capture::PassStart& passStart)
+{
+  Q_ASSERT(passStart.teamNumber < 256 && passStart.robotNumbers.size() < 256 && passStart.locationOrder.size() < 256);
+
+  QByteArray payload;
+  payload.append(static_cast<char>(passStart.teamNumber));
+  payload.append(static_cast<char>(passStart.robotNumbers.size()));
+  for(unsigned int robotNumber : passStart.robotNumbers)
+    payload.append(static_cast<char>(robotNumber));
+  payload.append(static_cast<char>(passStart.locationOrder.size()));
+  for(int locationIndex : passStart.locationOrder)
+    payload.append(static_cast<char>(locationIndex));
+  writeRecord(Capture::RecordType::passStart, timestamp, payload.constData(), static_cast<std::size_t>(payload.size()));
+  writer.commit();
+}
+
+void CaptureWriter::writeAttemptStart(std::int64_t timestamp, int attemptIndex, int locationIndex)
+{
+  uchar payload[4];
+  qToLittleEndian<quint16>(static_cast<quint16>(attemptIndex), payload);
+  qToLittleEndian<quint16>(static_cast<quint16>(locationIndex), payload + 2);
+  writeRecord(Capture::RecordType::attemptStart, timestamp, reinterpret_cast<const char*>(payload), sizeof(payload));
+}
+
+void CaptureWriter::writeAttemptStop(std::int64_t timestamp, int attemptIndex)
+{
+  uchar payload[2];
+  qToLittleEndian<quint16>(static_cast<quint16>(attemptIndex), payload);
+  writeRecord(Capture::RecordType::attemptStop, timestamp, reinterpret_cast<const char*>(payload), sizeof(payload));
+  writer.commit();
+}
+
+bool CaptureWriter::writeDatagram(std::int64_t timestamp, const char* data, std::size_t size)
+{
+  Q_ASSERT(size <= Capture::maxDatagramSize);
+
+  PendingDatagram datagram;
+  datagram.timestamp = timestamp;
+  datagram.size = size;
+  std::memcpy(datagram.data, data, size);
+  const bool first = datagrams.empty();
+  if(!datagrams.push(datagram))
+    return false;
+
+  // The writer thread is woken up for the first datagram after it has drained the ring and is urged to commit before the ring is full.
+  datagramsSinceNotification = first ? 1 : datagramsSinceNotification + 1;
+  if(first || datagramsSinceNotification == datagramRingSize / 2)
+    writer.notifySource(!first);
+  return true;
+}
+
+QByteArray CaptureWriter::createRecord(Capture::RecordType type, std::int64_t timestamp, const char* payload, std::size_t size)
+{
+  Q_ASSERT(size <= 0xffff);
+
+  QByteArray record(static_cast<int>(Capture::recordHeaderSize + size), Qt::Uninitialized);
+  auto* bytes = reinterpret_cast<uchar*>(record.data());
+  bytes[0] = static_cast<uchar>(type);
+  bytes[1] = 0;
+  qToLittleEndian<quint16>(static_cast<quint16>(size), bytes + 2);
+  qToLittleEndian<qint64>(timestamp, bytes + 4);
+  if(size)
+    std::memcpy(bytes + Capture::recordHeaderSize, payload, size);
+  return record;
+}
+
+void CaptureWriter::drainDatagrams(std::vector<QByteArray>& group)
+{
+  PendingDatagram datagram;
+  while(datagrams.pop(datagram))
+    group.emplace_back(createRecord(Capture::RecordType::datagram, datagram.timestamp, datagram.data, datagram.size));
+}
+
+void CaptureWriter::writeRecord(Capture::RecordType type, std::int64_t timestamp, const char* payload, std::size_t size)
+{
+  writer.append(createRecord(type, timestamp, payload, size));
+}
+
+CaptureReader::CaptureReader(const QString& path)
+{
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly))
+    return;
+  data = file.readAll();
+  valid = data.size() >= 8 && std::memcmp(data.constData(), Capture::magic, sizeof(Capture::magic)) == 0 &&
+          qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(data.constData() + 4)) == Capture::version;
+  position = 8;
+}
+
+bool CaptureReader::isValid() const
+{
+  return valid;
+}
+
+bool CaptureReader::readRecord(Capture::Record& record)
+{
+  if(!valid || position + Capture::recordHeaderSize > static_cast<std::size_t>(data.size()))
+    return false;
+
+  const auto* bytes = reinterpret_cast<const uchar*>(data.constData() + position);
+  const std::size_t size = qFromLittleEndian<quint16>(bytes + 2);
+  if(position + Capture::recordHeaderSize + size > static_cast<std::size_t>(data.size()))
+    return false;
+
+  record.type = static_cast<Capture::RecordType>(bytes[0]);
+  record.timestamp = qFromLittleEndian<qint64>(bytes + 4);
+  record.payload = data.constData() + position + Capture::recordHeaderSize;
+  record.size = size;
+  position += Capture::recordHeaderSize + size;
+  return true;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file Capture.h
+ *
+ * This file declares classes that write and read captures, i.e. compact binary recordings of all received
+ * datagrams together with their arrival times and markers for the start of passes and attempts.
+ *
+ * A capture file starts with the magic bytes "DWTC" and a 32 bit version number, followed by records.
+ * Each record consists of a type (8 bit), a reserved byte, the payload size (16 bit), a timestamp
+ * (64 bit, nanoseconds of the monotonic clock) and the payload. All numbers are little endian.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "LogWriter.h"
+#include "Util/SPSCQueue.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Capture
+{
+  constexpr char magic[4] = {'D', 'W', 'T', 'C'}; /**< The bytes at the start of every capture file. */
+  constexpr std::uint32_t version = 1; /**< The version of the format that is written. */
+  constexpr std::size_t recordHeaderSize = 12; /**< The number of bytes before the payload of a record. */
+  constexpr std::size_t maxDatagramSize = 512; /**< The maximum size of a recorded datagram (the receivers never read more than an SPL standard message). */
+
+  /** The types of records in a capture. */
+  enum class RecordType : std::uint8_t
+  {
+    passStart = 1, /**< A challenge pass has been started (payload: team number, robots and location order). */
+    attemptStart = 2, /**< An attempt has been started (payload: attempt index and location index). */
+    attemptStop = 3, /**< An attempt has been finished, either by a whistle or by timeout (payload: attempt index). */
+    datagram = 4 /**< A datagram has been received (payload: the raw datagram). */
+  };
+
+  /** A record as it is read from a capture. */
+  struct Record
+  {
+    RecordType type = RecordType::datagram; /**< The type of the record. */
+    std::int64_t timestamp = 0; /**< The time of the event (in nanoseconds of the monotonic clock). */
+    const char* payload = nullptr; /**< The payload of the record (points into the data of the reader). */
+    std::size_t size = 0; /**< The size of the payload. */
+  };
+
+  /** The payload of a pass start record. */
+  struct PassStart
+  {
+    unsigned int teamNumber = 0; /**< The number of the team that does the pass. */
+    QVector<unsigned int> robotNumbers; /**< The jersey numbers of the participating robots. */
+    QVector<int> locationOrder; /**< The (zero-based) location indices in the order of the attempts. */
+  };
+
+  /**
+   * Decodes the payload of a pass start record.
+   * @param record The record to decode.
+   * @param passStart The decoded payload.
+   * @return Whether the payload is well-formed.
+   */
+  bool decodePassStart(const Record& record, PassStart& passStart);
+
+  /**
+   * Decodes the payload of an attempt start or stop record.
+   * @param record The record to decode.
+   * @param attemptIndex The index of the attempt within the pass.
+   * @param locationIndex The (zero-based) location index of the attempt (only for start records).
+   * @return Whether the payload is well-formed.
+   */
+  bool decodeAttempt(const Record& record, int& attemptIndex, int* locationIndex = nullptr);
+}
+
+class CaptureWriter
+{
+public:
+  /**
+   * Constructor. Creates the capture file and writes its header.
+   * @param path The path of the capture file.
+   */
+  explicit CaptureWriter(const QString& path);
+
+  /**
+   * Records the start of a challenge pass.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param passStart The parameters of the pass.
+   */
+  void writePassStart(std::int64_t timestamp, const Capture::PassStart& passStart);
+
+  /**
+   * Records the start of an attempt.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param attemptIndex The index of the attempt within the pass.
+   * @param locationIndex The (zero-based) location index of the attempt.
+   */
+  void writeAttemptStart(std::int64_t timestamp, int attemptIndex, int locationIndex);
+
+  /**
+   * Records the end of an attempt.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param attemptIndex The index of the attempt within the pass.
+   */
+  void writeAttemptStop(std::int64_t timestamp, int attemptIndex);
+
+  /**
+   * Records a received datagram. This may be called from another thread than the other methods (but always from the same one).
+   * It never blocks: The datagram is handed over to the writer thread through a lock-free ring and dropped if the ring is full.
+   * @param timestamp The arrival time of the datagram (in nanoseconds of the monotonic clock).
+   * @param data The raw datagram.
+   * @param size The size of the datagram (at most \c Capture::maxDatagramSize).
+   * @return Whether the datagram will be recorded (false if it has been dropped).
+   */
+  bool writeDatagram(std::int64_t timestamp, const char* data, std::size_t size);
+
+private:
+  /** A received datagram that waits for the writer thread. */
+  struct PendingDatagram
+  {
+    std::int64_t timestamp; /**< The arrival time of the datagram. */
+    std::size_t size; /**< The size of the datagram. */
+    char data[Capture::maxDatagramSize]; /**< The raw datagram. */
+  };
+
+  static constexpr std::size_t datagramRingSize = 2048; /**< The maximum number of datagrams that can wait for the writer thread. */
+
+  /**
+   * Creates a record.
+   * @param type The type of the record.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param payload The payload of the record.
+   * @param size The size of the payload.
+   * @return The bytes of the record.
+   */
+  static QByteArray createRecord(Capture::RecordType type, std::int64_t timestamp, const char* payload, std::size_t size);
+
+  /**
+   * Moves the pending datagrams into the group that the writer thread is about to commit (called by the writer thread).
+   * @param group The group to which the records of the datagrams are appended.
+   */
+  void drainDatagrams(std::vector<QByteArray>& group);
+
+  /**
+   * Appends a record to the capture.
+   * @param type The type of the record.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param payload The payload of the record.
+   * @param size The size of the payload.
+   */
+  void writeRecord(Capture::RecordType type, std::int64_t timestamp, const char* payload, std::size_t size);
+
+  SPSCQueue<PendingDatagram, datagramRingSize> datagrams; /**< The datagrams that wait for the writer thread (the receiver thread is the producer). */
+  std::size_t datagramsSinceNotification = 0; /**< The number of datagrams since the writer thread has last been notified (only used by the receiver thread). */
+  LogWriter writer; /**< The writer that appends the records to the file in the background (constructed last because its thread drains \c datagrams). */
+};
+
+class CaptureReader
+{
+public:
+  /**
+   * Constructor. Reads a capture file into memory.
+   * @param path The path of the capture file.
+   */
+  explicit CaptureReader(const QString& path);
+
+  /**
+   * Returns whether the file could be read and has a valid header.
+   * @return Whether the file could be read and has a valid header.
+   */
+  bool isValid() const;
+
+  /**
+   * Reads the next record. A truncated record at the end (e.g. after a crash) is treated like the end of the file.
+   * @param record The record that is filled (its payload stays valid as long as this reader exists).
+   * @return Whether a record has been read.
+   */
+  bool readRecord(Capture::Record& record);
+
+private:
+  QByteArray data; /**< The contents of the capture file. */
+  bool valid = false; /**< Whether the file could be read and has a valid header. */
+  std::size_t position = 0; /**< The offset of the next record in the data. */
+};
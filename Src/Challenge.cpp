@@ -7,29 +7,97 @@
  */
 
 #include "Challenge.h"
+#include "Capture.h"
 #include "ChallengeLog.h"
 #include "DetectedWhistle.h"
-#include "Metric.h"
+#include "Journal.h"
+#include "LatencyProfile.h"
+#include "TimeSource.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include <QMetaObject>
 #include <QTime>
-#include <QTimer>
 #include <algorithm>
+#include <mutex>
 #include <random>
 
+/** The link from the callbacks of the writer threads to a challenge, which is cut when the challenge is destroyed. */
+struct Challenge::CommitNotifier
+{
+  std::mutex mutex; /**< The mutex that protects the pointer to the challenge. */
+  Challenge* challenge; /**< The challenge that is notified (nullptr after it has been destroyed). */
+
+  /**
+   * Constructor.
+   * @param challenge The challenge that is notified.
+   */
+  explicit CommitNotifier(Challenge* challenge) :
+    challenge(challenge)
+  {}
+
+  /** Reports a completed commit to the thread of the challenge (called on a writer thread). */
+  void notify()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(challenge)
+      QMetaObject::invokeMethod(challenge, "handleAttemptCommitted", Qt::QueuedConnection);
+  }
+};
+
 Challenge::Challenge(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotSetup, QObject* parent) :
+  Challenge(whistleLocations, robotSetup, createLocationOrder(whistleLocations.size(), static_cast<unsigned int>(QTime::currentTime().msecsSinceStartOfDay())), parent)
+{}
+
+Challenge::Challenge(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotSetup, const QVector<int>& locationOrder, QObject* parent) :
   QAbstractTableModel(parent),
+  timeSource(&SystemTimeSource::getInstance()),
   whistleLocations(whistleLocations),
-  robotSetup(robotSetup)
+  robotSetup(robotSetup),
+  scoringRules(ScoringRules::getConfiguredDefinition(), robotSetup, whistleLocations),
+  commitNotifier(std::make_shared<CommitNotifier>(this)),
+  traceField(Tracer::getField())
 {
-  timer = new QTimer(this);
-  timer->setSingleShot(true);
-  connect(timer, &QTimer::timeout, this, &Challenge::finishAttempt);
+  createTimers();
 
-  attempts.resize(whistleLocations.size());
+  attempts.resize(locationOrder.size());
   for(int i = 0; i < attempts.size(); ++i)
-    attempts[i].locationIndex = i;
+  {
+    Q_ASSERT(locationOrder[i] >= 0 && locationOrder[i] < whistleLocations.size());
+    attempts[i].locationIndex = locationOrder[i];
+  }
+}
 
+Challenge::~Challenge()
+{
+  std::lock_guard<std::mutex> lock(commitNotifier->mutex);
+  commitNotifier->challenge = nullptr;
+}
+
+QVector<int> Challenge::createLocationOrder(int numOfLocations, unsigned int seed)
+{
+  QVector<int> locationOrder(numOfLocations);
+  for(int i = 0; i < numOfLocations; ++i)
+    locationOrder[i] = i;
+
+  // The result of std::shuffle depends on the standard library, so a Fisher-Yates shuffle is done explicitly.
   if(shuffleWhistleLocations)
-    std::shuffle(attempts.begin(), attempts.end(), std::default_random_engine(QTime::currentTime().msecsSinceStartOfDay()));
+  {
+    std::mt19937 random(seed);
+    for(int i = numOfLocations - 1; i > 0; --i)
+      std::swap(locationOrder[i], locationOrder[static_cast<int>((static_cast<std::uint64_t>(random()) * static_cast<std::uint64_t>(i + 1)) >> 32)]);
+  }
+  return locationOrder;
+}
+
+void Challenge::createTimers()
+{
+  delete timer;
+  timer = timeSource->createTimer(this);
+  connect(timer, &Timer::timeout, this, &Challenge::handleTimeout);
+
+  delete changeTimer;
+  changeTimer = timeSource->createTimer(this);
+  connect(changeTimer, &Timer::timeout, this, &Challenge::emitPendingChanges);
 }
 
 bool Challenge::isFinished() const
@@ -39,56 +107,259 @@ bool Challenge::isFinished() const
 
 float Challenge::getTotalScore() const
 {
-  return std::accumulate(attempts.begin(), attempts.end(), 0.f, [](float score, const Attempt& attempt){ return score + attempt.score; });
+  return aggregates.totalScore;
 }
 
-void Challenge::startAttempt()
+const Challenge::Aggregates& Challenge::getAggregates() const
+{
+  return aggregates;
+}
+
+const QVector<Challenge::Attempt>& Challenge::getAttempts() const
+{
+  return attempts;
+}
+
+int Challenge::getNumOfFinishedAttempts() const
+{
+  return nextAttempt;
+}
+
+bool Challenge::isAttemptRunning() const
+{
+  return attemptRunning || pendingCommits;
+}
+
+void Challenge::setWhistleQueue(SPLStandardMessageReceiver::WhistleQueue* queue)
+{
+  whistleQueue = queue;
+}
+
+void Challenge::setCaptureWriter(CaptureWriter* writer)
+{
+  captureWriter = writer;
+}
+
+void Challenge::setJournalWriter(JournalWriter* writer)
+{
+  journalWriter = writer;
+}
+
+void Challenge::setLogWriter(LogWriter* writer)
+{
+  logWriter = writer;
+}
+
+void Challenge::setTimeSource(TimeSource& source)
 {
   Q_ASSERT(!attemptRunning);
+  timeSource = &source;
+  createTimers();
+}
+
+void Challenge::startAttempt()
+{
+  startAttemptAt(timeSource->getTime());
+}
+
+void Challenge::startAttemptAt(std::int64_t startTime)
+{
+  TRACE_FIELD(traceField);
+  Q_ASSERT(!isAttemptRunning());
   Q_ASSERT(nextAttempt < attempts.size());
 
-  ChallengeLog() << "Started attempt " << (nextAttempt + 1) << " from location " << (attempts[nextAttempt].locationIndex + 1);
+  TRACE_INSTANT("attemptStart", "attempt", nextAttempt + 1);
+  ChallengeLog(logWriter) << "Started attempt " << (nextAttempt + 1) << " from location " << (attempts[nextAttempt].locationIndex + 1);
+  ChallengeLog::commit(logWriter);
 
-  timer->start(attemptTimeLimit);
+  attemptStartTime = startTime;
+  attemptDeadline = attemptStartTime + static_cast<std::int64_t>(attemptTimeLimit) * 1000000;
+  timer->start(attemptTimeLimit + timeoutGracePeriod);
   attemptRunning = true;
+
+  if(captureWriter)
+    captureWriter->writeAttemptStart(attemptStartTime, nextAttempt, attempts[nextAttempt].locationIndex);
+  if(journalWriter)
+    journalWriter->writeAttemptStart(attemptStartTime, nextAttempt, attempts[nextAttempt].locationIndex);
+
+  // The queue is not drained here: Whistles that are still in it are handled when their notification arrives. Those that arrived before the
+  // start time are discarded because of their timestamps, while those that arrived after it belong to this attempt (as in the replay).
 }
 
 void Challenge::handleWhistleLocation(const DetectedWhistle& whistle)
 {
+  TRACE_FIELD(traceField);
   if(!attemptRunning)
     return;
 
-  attempts[nextAttempt].remainingTime = timer->remainingTime();
+  // The time is measured from the arrival of the message, not from the moment in which it is handled.
+  if(whistle.timestamp < attemptStartTime || whistle.timestamp >= attemptDeadline)
+    return;
+
+  attempts[nextAttempt].remainingTime = (attemptDeadline - whistle.timestamp) / 1000;
   timer->stop();
   attempts[nextAttempt].whistle = whistle;
-  attempts[nextAttempt].score = Metric::calculateScore(robotSetup, whistleLocations[attempts[nextAttempt].locationIndex], whistle);
+  const std::int64_t scoringStart = Clock::getTime();
+  attempts[nextAttempt].components = scoringRules.calculateScoreComponents(attempts[nextAttempt].locationIndex, whistle);
+  const std::int64_t scoringEnd = Clock::getTime();
+  LatencyProfile::getInstance().record(LatencyProfile::scoring, scoringEnd - scoringStart);
+  TRACE_SPAN("scoring", scoringStart, scoringEnd);
+  attempts[nextAttempt].score = attempts[nextAttempt].components.getTotal();
+
+  finishAttempt();
+}
+
+void Challenge::handleReceivedWhistles()
+{
+  TRACE_FIELD(traceField);
+  if(!whistleQueue)
+    return;
+
+  DetectedWhistle whistle;
+  while(whistleQueue->pop(whistle))
+  {
+    const std::int64_t deliveryTime = Clock::getTime();
+    LatencyProfile::getInstance().record(LatencyProfile::delivery, deliveryTime - whistle.queueTimestamp);
+    TRACE_INSTANT("delivery", "queuedFor", deliveryTime - whistle.queueTimestamp);
+    handleWhistleLocation(whistle);
+  }
+}
 
+void Challenge::expireAttempt()
+{
+  handleReceivedWhistles();
   finishAttempt();
 }
 
+void Challenge::handleTimeout()
+{
+  TRACE_FIELD(traceField);
+  TRACE_INSTANT("attemptTimeout", "attempt", nextAttempt + 1);
+  expireAttempt();
+}
+
 void Challenge::finishAttempt()
 {
+  TRACE_FIELD(traceField);
   if(!attemptRunning)
     return;
 
-  const bool timedOut = attempts[nextAttempt].remainingTime == -1;
-  ChallengeLog() << "Finished attempt " << (nextAttempt + 1) << " from location " << (attempts[nextAttempt].locationIndex + 1) << (timedOut ? " (timed out)" : ":");
-  if(!timedOut)
+  TRACE_SCOPE("finishAttempt", "attempt", nextAttempt + 1);
+  attemptRunning = false;
+  if(captureWriter)
+    captureWriter->writeAttemptStop(timeSource->getTime(), nextAttempt);
+
+  // The result is only published when it is on the device. The writer threads report this, so the event loop does not wait for it.
+  // The count starts at 1 so that the result cannot be published before all commits have been requested.
+  pendingCommits = 1;
+  const std::shared_ptr<CommitNotifier> notifier = commitNotifier;
+  const LogWriter::Callback committed = [notifier]{ notifier->notify(); };
+  logResult(nextAttempt);
+  if(ChallengeLog::commit(logWriter, committed))
+    ++pendingCommits;
+  const Attempt& attempt = attempts[nextAttempt];
+  if(journalWriter)
   {
-    ChallengeLog() << "  Remaining time: " << attempts[nextAttempt].remainingTime << "ms";
-    ChallengeLog() << "  Actual location: " << whistleLocations[attempts[nextAttempt].locationIndex].x << ", " << whistleLocations[attempts[nextAttempt].locationIndex].y;
-    ChallengeLog() << "  Reported location: " << attempts[nextAttempt].whistle.location.x << ", " << attempts[nextAttempt].whistle.location.y;
-    ChallengeLog() << "  Reported field: " << (attempts[nextAttempt].whistle.onSameField ? "same" : "other");
-    ChallengeLog() << "  Score: " << attempts[nextAttempt].score;
+    journalWriter->writeAttemptResult(timeSource->getTime(), nextAttempt, attempt.locationIndex, attempt.remainingTime, attempt.whistle, attempt.components, committed);
+    ++pendingCommits;
   }
+  handleAttemptCommitted();
+}
 
-  attemptRunning = false;
-  emit dataChanged(index(nextAttempt, firstDynamicColumn), index(nextAttempt, numOfColumns - 1), {Qt::DisplayRole});
-  emit dataChanged(index(attempts.size(), score), index(attempts.size(), score), {Qt::DisplayRole});
+void Challenge::handleAttemptCommitted()
+{
+  TRACE_FIELD(traceField);
+  Q_ASSERT(pendingCommits > 0);
+  if(--pendingCommits > 0)
+    return;
+
+  TRACE_INSTANT("attemptCommitted", "attempt", nextAttempt + 1);
+  addToAggregates(nextAttempt);
+  scheduleChange(nextAttempt, attempts.size());
   ++nextAttempt;
+  if(journalWriter && isFinished())
+    journalWriter->writePassEnd(timeSource->getTime(), getTotalScore(), false);
   emit attemptFinished();
 }
 
+void Challenge::resume(const QVector<Journal::Record>& results)
+{
+  Q_ASSERT(!attemptRunning && nextAttempt == 0);
+  Q_ASSERT(results.size() <= attempts.size());
+
+  for(const Journal::Record& result : results)
+  {
+    Attempt& attempt = attempts[nextAttempt];
+    Q_ASSERT(result.location == attempt.locationIndex);
+    attempt.remainingTime = result.remainingTime;
+    if(attempt.remainingTime != -1)
+    {
+      attempt.whistle = result.whistle;
+      attempt.components = result.components;
+      attempt.score = result.score;
+    }
+    logResult(nextAttempt);
+    if(journalWriter)
+      journalWriter->writeAttemptResult(result.timestamp, nextAttempt, attempt.locationIndex, attempt.remainingTime, attempt.whistle, attempt.components);
+    addToAggregates(nextAttempt);
+    ++nextAttempt;
+  }
+  ChallengeLog::commit(logWriter);
+  if(nextAttempt)
+    scheduleChange(0, attempts.size());
+}
+
+void Challenge::logResult(int index)
+{
+  const Attempt& attempt = attempts[index];
+  const bool timedOut = attempt.remainingTime == -1;
+  ChallengeLog(logWriter) << "Finished attempt " << (index + 1) << " from location " << (attempt.locationIndex + 1) << (timedOut ? " (timed out)" : ":");
+  if(!timedOut)
+  {
+    ChallengeLog(logWriter) << "  Remaining time: " << QString::number(attempt.remainingTime / 1000.0, 'f', 3) << "ms";
+    ChallengeLog(logWriter) << "  Actual location: " << whistleLocations[attempt.locationIndex].x << ", " << whistleLocations[attempt.locationIndex].y;
+    ChallengeLog(logWriter) << "  Reported location: " << attempt.whistle.location.x << ", " << attempt.whistle.location.y;
+    ChallengeLog(logWriter) << "  Reported field: " << (attempt.whistle.onSameField ? "same" : "other");
+    ChallengeLog(logWriter) << "  Score: " << attempt.score;
+  }
+}
+
+void Challenge::addToAggregates(int index)
+{
+  const Attempt& attempt = attempts[index];
+  ++aggregates.numOfFinishedAttempts;
+  if(attempt.remainingTime == -1)
+    ++aggregates.numOfTimeouts;
+  aggregates.totalScore += attempt.score;
+  aggregates.componentSums.onSameFieldDecision += attempt.components.onSameFieldDecision;
+  aggregates.componentSums.direction += attempt.components.direction;
+  aggregates.componentSums.distance += attempt.components.distance;
+  if(aggregates.bestAttempt == -1 || attempt.score > attempts[aggregates.bestAttempt].score)
+    aggregates.bestAttempt = index;
+  if(aggregates.worstAttempt == -1 || attempt.score < attempts[aggregates.worstAttempt].score)
+    aggregates.worstAttempt = index;
+}
+
+void Challenge::scheduleChange(int firstRow, int lastRow)
+{
+  firstChangedRow = firstChangedRow == -1 ? firstRow : std::min(firstChangedRow, firstRow);
+  lastChangedRow = std::max(lastChangedRow, lastRow);
+  if(!changeTimer->isActive())
+    changeTimer->start(changeInterval);
+}
+
+void Challenge::emitPendingChanges()
+{
+  TRACE_FIELD(traceField);
+  if(firstChangedRow == -1)
+    return;
+
+  TRACE_SCOPE("emitPendingChanges");
+  const int firstRow = firstChangedRow, lastRow = lastChangedRow;
+  firstChangedRow = lastChangedRow = -1;
+  emit dataChanged(index(firstRow, firstDynamicColumn), index(lastRow, numOfColumns - 1), {Qt::DisplayRole, Qt::ToolTipRole});
+}
+
 int Challenge::rowCount(const QModelIndex&) const
 {
   return attempts.size() + 1;
@@ -101,6 +372,18 @@ int Challenge::columnCount(const QModelIndex&) const
 
 QVariant Challenge::data(const QModelIndex& index, int role) const
 {
+  if(role == Qt::ToolTipRole && index.row() == attempts.size() && index.column() == score && aggregates.numOfFinishedAttempts)
+    return QString("Mean: %1\nSame field decisions: %2\nDirections: %3\nDistances: %4\nTimeouts: %5\nBest: attempt %6 (%7)\nWorst: attempt %8 (%9)")
+           .arg(aggregates.getMeanScore())
+           .arg(aggregates.componentSums.onSameFieldDecision)
+           .arg(aggregates.componentSums.direction)
+           .arg(aggregates.componentSums.distance)
+           .arg(aggregates.numOfTimeouts)
+           .arg(aggregates.bestAttempt + 1)
+           .arg(attempts[aggregates.bestAttempt].score)
+           .arg(aggregates.worstAttempt + 1)
+           .arg(attempts[aggregates.worstAttempt].score);
+
   if(role != Qt::DisplayRole)
     return QVariant();
 
@@ -129,7 +412,7 @@ QVariant Challenge::data(const QModelIndex& index, int role) const
     switch(index.column())
     {
       case remainingTime:
-        return attempts[index.row()].remainingTime;
+        return QString::number(attempts[index.row()].remainingTime / 1000.0, 'f', 3);
       case score:
         return attempts[index.row()].score;
     }
@@ -9,21 +9,61 @@
 #pragma once
 
 #include "DetectedWhistle.h"
+#include "Metric.h"
+#include "SPLStandardMessageReceiver.h"
+#include "ScoringRules.h"
 #include "Util/Pose2D.h"
 #include "Util/Vector2D.h"
 #include <QAbstractTableModel>
 #include <QModelIndex>
 #include <QVariant>
 #include <QVector>
+#include <cstdint>
+#include <memory>
 
+class CaptureWriter;
+class JournalWriter;
+class LogWriter;
 struct DetectedWhistle;
 class QObject;
-class QTimer;
+class TimeSource;
+class Timer;
+namespace Journal { struct Record; }
 
 class Challenge : public QAbstractTableModel
 {
   Q_OBJECT
 public:
+  /** The state and result of a single attempt. */
+  struct Attempt
+  {
+    int locationIndex = -1; /**< The index in the whistle location array that this attempt corresponds to. */
+    std::int64_t remainingTime = -1; /**< The time (µs) that was remaining when the whistle message arrived (-1=timeout). */
+    DetectedWhistle whistle; /**< The whistle response that the team gave. */
+    float score = 0.f; /**< The overall score for this attempt. */
+    Metric::ScoreComponents components; /**< The parts of the score for this attempt. */
+  };
+
+  /** Running aggregates over the finished attempts of a pass (updated whenever an attempt is finished). */
+  struct Aggregates
+  {
+    int numOfFinishedAttempts = 0; /**< The number of finished attempts. */
+    int numOfTimeouts = 0; /**< The number of attempts that timed out. */
+    float totalScore = 0.f; /**< The sum of the scores of the finished attempts. */
+    Metric::ScoreComponents componentSums; /**< The sums of the score components of the finished attempts. */
+    int bestAttempt = -1; /**< The index of the first attempt with the highest score (-1 if there is none). */
+    int worstAttempt = -1; /**< The index of the first attempt with the lowest score (-1 if there is none). */
+
+    /**
+     * Returns the mean score of the finished attempts.
+     * @return The mean score (0 if no attempt has been finished).
+     */
+    float getMeanScore() const
+    {
+      return numOfFinishedAttempts ? totalScore / numOfFinishedAttempts : 0.f;
+    }
+  };
+
   /**
    * Constructor.
    * @param whistleLocations The set of locations from which the whistle is blown.
@@ -32,6 +72,18 @@ public:
    */
   Challenge(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotSetup, QObject* parent = nullptr);
 
+  /**
+   * Constructor with a given order of whistle locations (e.g. to replay a recorded pass).
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param robotSetup The set of poses of the robots that participate in this challenge.
+   * @param locationOrder The indices of the whistle locations in the order of the attempts.
+   * @param parent The Qt parent object.
+   */
+  Challenge(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotSetup, const QVector<int>& locationOrder, QObject* parent = nullptr);
+
+  /** Destructor. Results that are committed after this are not reported anymore. */
+  ~Challenge() override;
+
   /**
    * Returns whether the challenge pass is finished (i.e. all whistle locations have been done).
    * @return Whether the challenge pass is finished (i.e. all whistle locations have been done).
@@ -44,8 +96,92 @@ public:
    */
   float getTotalScore() const;
 
+  /**
+   * Returns the running aggregates over the finished attempts of this challenge pass.
+   * @return The running aggregates.
+   */
+  const Aggregates& getAggregates() const;
+
+  /**
+   * Returns the list of all attempts in this challenge pass in the order in which they are done.
+   * @return The list of all attempts in this challenge pass.
+   */
+  const QVector<Attempt>& getAttempts() const;
+
+  /**
+   * Returns the number of attempts that have been finished so far.
+   * @return The number of attempts that have been finished so far.
+   */
+  int getNumOfFinishedAttempts() const;
+
+  /**
+   * Returns whether an attempt is currently running. An attempt whose result is still being committed to the log and the journal counts as running.
+   * @return Whether an attempt is currently running.
+   */
+  bool isAttemptRunning() const;
+
+  /**
+   * Sets the queue from which received whistles are taken.
+   * @param queue The queue of received whistles (this challenge must be its only consumer).
+   */
+  void setWhistleQueue(SPLStandardMessageReceiver::WhistleQueue* queue);
+
+  /**
+   * Sets the capture into which the start and end of attempts are recorded.
+   * @param writer The capture writer (nullptr to disable recording).
+   */
+  void setCaptureWriter(CaptureWriter* writer);
+
+  /**
+   * Sets the journal into which the start and result of attempts and the end of the pass are recorded.
+   * @param writer The journal writer (nullptr to disable recording).
+   */
+  void setJournalWriter(JournalWriter* writer);
+
+  /**
+   * Sets the log file into which the attempts are logged (e.g. one per field if several passes run at once).
+   * @param writer The writer of the log file (nullptr for the log file of the process).
+   */
+  void setLogWriter(LogWriter* writer);
+
+  /**
+   * Sets the clock and the timers of this challenge pass (e.g. a virtual time source to simulate passes). This must be done before the first attempt.
+   * @param source The time source (which must outlive this challenge pass).
+   */
+  void setTimeSource(TimeSource& source);
+
+  /**
+   * Creates the order of whistle locations for a new challenge pass. The order only depends on the seed (on all platforms).
+   * @param numOfLocations The number of whistle locations.
+   * @param seed The seed of the shuffle.
+   * @return The indices of the whistle locations in the order of the attempts (shuffled if \c shuffleWhistleLocations is set).
+   */
+  static QVector<int> createLocationOrder(int numOfLocations, unsigned int seed);
+
+  static constexpr int attemptTimeLimit = 5000; /**< The amount of time (ms) that the team has to react to the whistle. */
+  static constexpr int timeoutGracePeriod = 50; /**< The additional time (ms) to wait for whistles that arrived in time but have not been handed over yet. */
+
+  /**
+   * This method starts the next attempt at a given time (assuming that the challenge is not finished yet).
+   * @param startTime The time at which the attempt started (in nanoseconds of the monotonic clock).
+   */
+  void startAttemptAt(std::int64_t startTime);
+
+  /** This method finishes the running attempt (if there is one) as if its time limit had expired (e.g. when replaying a recorded pass). */
+  void expireAttempt();
+
+  /**
+   * Restores the results of the first attempts of a pass that has been interrupted (e.g. by a crash), so that the pass continues
+   * with the next attempt. The restored attempts are logged and journaled again like finished ones. This must be done before the first attempt.
+   * @param results The attempt results as read from the journal of the interrupted pass (for the locations of the first attempts of this pass).
+   */
+  void resume(const QVector<Journal::Record>& results);
+
 signals:
-  /** This signal is emitted when an attempt is finished (whether it is by a received message or timeout). */
+  /**
+   * This signal is emitted when an attempt is finished (whether it is by a received message or timeout) and its result is on the device.
+   * If neither the log nor the journal is written, it is emitted right away.
+   */
   void attemptFinished();
 
 public slots:
@@ -58,21 +194,49 @@ public slots:
    */
   void handleWhistleLocation(const DetectedWhistle& whistle);
 
+  /** This method takes all whistles from the whistle queue and handles them in the order in which they arrived. */
+  void handleReceivedWhistles();
+
 private slots:
+  /** This method handles the expiry of the attempt timer, i.e. it finishes the attempt unless a whistle that arrived in time is still queued. */
+  void handleTimeout();
+
   /** This method finishes a currently running attempt (if there is one). */
   void finishAttempt();
 
+  /** This method emits a single notification for all rows that have changed since the last one. */
+  void emitPendingChanges();
+
+  /** This method is called whenever a commit of the result of the current attempt has completed. After the last one, the result is published. */
+  void handleAttemptCommitted();
+
 private:
+  struct CommitNotifier;
+
   static constexpr bool shuffleWhistleLocations = true; /**< Whether the order of whistle locations should be shuffled for each challenge pass. */
-  static constexpr int attemptTimeLimit = 5000; /**< The amount of time (ms) that the team has to react to the whistle. */
+  static constexpr int changeInterval = 16; /**< The time (ms) during which model changes are collected into a single notification (about one frame). */
 
-  struct Attempt
-  {
-    int locationIndex = -1; /**< The index in the whistle location array that this attempt corresponds to. */
-    int remainingTime = -1; /**< The time that was remaining when the whistle message arrived (-1=timeout). */
-    DetectedWhistle whistle; /**< The whistle response that the team gave. */
-    float score = 0.f; /**< The overall score for this attempt. */
-  };
+  /**
+   * Marks rows as changed. The views are notified about all changed rows at once after \c changeInterval.
+   * @param firstRow The first changed row.
+   * @param lastRow The last changed row.
+   */
+  void scheduleChange(int firstRow, int lastRow);
+
+  /**
+   * Writes the result of an attempt to the log.
+   * @param index The index of the attempt.
+   */
+  void logResult(int index);
+
+  /**
+   * Adds the result of an attempt to the running aggregates.
+   * @param index The index of the attempt.
+   */
+  void addToAggregates(int index);
+
+  /** Creates the timers of this challenge pass from its time source. */
+  void createTimers();
 
   enum Column
   {
@@ -114,10 +278,25 @@ private:
    */
   QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
 
-  QTimer* timer = nullptr; /**< The timer that handles the time limit per attempt. */
+  TimeSource* timeSource; /**< The clock and the timers of this challenge pass. */
+  Timer* timer = nullptr; /**< The timer that handles the time limit per attempt. */
+  Timer* changeTimer = nullptr; /**< The timer after which pending model changes are emitted. */
+  int firstChangedRow = -1; /**< The first row that has changed since the last notification (-1 if none). */
+  int lastChangedRow = -1; /**< The last row that has changed since the last notification (-1 if none). */
   int nextAttempt = 0; /**< The index of the next/current attempt. */
   bool attemptRunning = false; /**< Whether an attempt is currently running (if it is, it has the index \c nextAttempt). */
+  int pendingCommits = 0; /**< The number of commits of the result of the attempt \c nextAttempt that have not completed yet (0 if there is no such result). */
+  std::shared_ptr<CommitNotifier> commitNotifier; /**< The link through which the writer threads report completed commits (shared with their callbacks). */
+  std::int64_t attemptStartTime = 0; /**< The time at which the current attempt has been started (in nanoseconds of the monotonic clock). */
+  std::int64_t attemptDeadline = 0; /**< The time until which whistles are accepted for the current attempt (in nanoseconds of the monotonic clock). */
+  SPLStandardMessageReceiver::WhistleQueue* whistleQueue = nullptr; /**< The queue from which received whistles are taken. */
+  CaptureWriter* captureWriter = nullptr; /**< The capture into which the start and end of attempts are recorded (if any). */
+  JournalWriter* journalWriter = nullptr; /**< The journal into which the attempts and the end of the pass are recorded (if any). */
+  LogWriter* logWriter = nullptr; /**< The log file into which the attempts are logged (nullptr for the log file of the process). */
   const QVector<Vector2D>& whistleLocations; /**< The set of locations from which the whistle is blown. */
   QVector<Pose2D> robotSetup; /**< The set of poses of the robots that participate in this challenge. */
+  ScoringRules scoringRules; /**< The configured scoring rules, compiled for the robot setup and the whistle locations (so that scoring a report only involves the reported location). */
   QVector<Attempt> attempts; /**< The list of all attempts in this challenge pass (one per whistle location). */
+  int traceField; /**< The field with which the trace events of this pass are tagged (the one that was set when it was created). */
+  Aggregates aggregates; /**< The running aggregates over the finished attempts. */
 };
@@ -8,46 +8,95 @@
 
 #pragma once
 
+#include "LatencyProfile.h"
+#include "LogWriter.h"
 #include "Util/Paths.h"
-#include <QFile>
 #include <QDateTime>
+#include <QString>
 #include <QTextStream>
-#ifdef __unix__
-#include <unistd.h>
-#endif
+#include <QVector>
+#include <utility>
 
 class ChallengeLog : public QTextStream
 {
 public:
-  /** Constructor. Writes a timestamp to the stream. */
-  ChallengeLog() :
-    QTextStream(getLogFile())
+  /**
+   * Constructor. Writes a timestamp to the stream.
+   * @param writer The writer of the log file to which the line is appended (nullptr for the log file of the process).
+   */
+  explicit ChallengeLog(LogWriter* writer = nullptr) :
+    writer(writer)
   {
+    setString(&line);
     *this << QDateTime::currentDateTime().toString(Qt::ISODate)  << ": ";
   }
 
-  /** Destructor. Ends the line, flushes the stream and (on Unices) syncs the file to the device (in case of power loss). */
+  /** Destructor. Ends the line and hands it over to the log writer, which commits it to the device in the background. */
   ~ChallengeLog() override
   {
-    *this << endl;
+    *this << '\n';
     flush();
-#ifdef __unix__
-    fsync(getLogFile()->handle());
-#endif
+    if(isEnabled())
+      (writer ? *writer : getLogWriter()).append(line.toUtf8());
+  }
+
+  /**
+   * Requests that all lines written so far are synced to the device right away instead of after the commit interval.
+   * This should be called at attempt and pass boundaries so that no finished attempt is lost in case of power loss.
+   * @param writer The writer of the log file to commit (nullptr for the log file of the process).
+   */
+  static void commit(LogWriter* writer = nullptr)
+  {
+    if(isEnabled())
+      (writer ? *writer : getLogWriter()).commit();
+  }
+
+  /**
+   * Requests that all lines written so far are synced to the device right away and reports when they are.
+   * @param writer The writer of the log file to commit (nullptr for the log file of the process).
+   * @param committed The function that is called on the writer thread once the lines are on the device.
+   * @return Whether the log is enabled (if it is not, \c committed is never called).
+   */
+  static bool commit(LogWriter* writer, LogWriter::Callback committed)
+  {
+    if(!isEnabled())
+      return false;
+    (writer ? *writer : getLogWriter()).commit(std::move(committed));
+    return true;
+  }
+
+  /**
+   * Enables or disables the log for this process (e.g. for tools that replay or simulate passes, which must not produce log files).
+   * @param enabled Whether lines should be written to the log file.
+   */
+  static void setEnabled(bool enabled)
+  {
+    isEnabled() = enabled;
   }
 
 private:
   /**
-   * Returns a pointer to the log file handle.
-   * @return A pointer to the log file handle.
+   * Returns a reference to the flag that determines whether the log is enabled.
+   * @return A reference to the flag that determines whether the log is enabled.
    */
-  static QFile* getLogFile()
+  static bool& isEnabled()
   {
-    static QFile f(Paths::getLogPath() + "/log_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".txt");
-    if(!f.isOpen())
-      f.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Unbuffered);
-    return &f;
+    static bool enabled = true;
+    return enabled;
   }
+
+  /**
+   * Returns the writer of the log file.
+   * @return The writer of the log file.
+   */
+  static LogWriter& getLogWriter()
+  {
+    static LogWriter writer(Paths::getLogPath() + "/log_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".txt", &LatencyProfile::getInstance().getHistogram(LatencyProfile::logging));
+    return writer;
+  }
+
+  LogWriter* writer; /**< The writer of the log file to which the line is appended (nullptr for the log file of the process). */
+  QString line; /**< The line that is built by this stream. */
 };
 
 static inline QTextStream& operator<<(QTextStream& stream, const QVector<unsigned int>& vector)
@@ -11,12 +11,16 @@
 #include <QCheckBox>
 #include <QComboBox>
 #include <QLabel>
+#include <QListWidget>
 #include <QPushButton>
+#include <QSignalBlocker>
 #include <QString>
+#include <QStringList>
 #include <QVBoxLayout>
 
-ChallengeStartDialog::ChallengeStartDialog(int numOfRobots, QWidget* parent) :
-  QDialog(parent)
+ChallengeStartDialog::ChallengeStartDialog(int numOfRobots, const QVector<SubsetPlanner::Rating>& ratings, QWidget* parent) :
+  QDialog(parent),
+  ratings(ratings)
 {
   auto* layout = new QVBoxLayout(this);
 
@@ -38,6 +42,7 @@ ChallengeStartDialog::ChallengeStartDialog(int numOfRobots, QWidget* parent) :
   auto checkSelectedRobots = [this, startButton]
   {
     startButton->setEnabled(std::any_of(robotCheckBoxes.begin(), robotCheckBoxes.end(), [](QCheckBox* checkBox){ return checkBox->isChecked(); }));
+    updateSuggestions();
   };
 
   for(int i = 0; i < numOfRobots; ++i)
@@ -47,6 +52,42 @@ ChallengeStartDialog::ChallengeStartDialog(int numOfRobots, QWidget* parent) :
     layout->addWidget(robotCheckBoxes.last());
   }
 
+  if(!ratings.isEmpty())
+  {
+    selectionLabel = new QLabel(this);
+    layout->addWidget(selectionLabel);
+
+    auto* suggestionsLabel = new QLabel("Suggested &Subsets (expected score, share of robots used as reference, mean reference distance):", this);
+    layout->addWidget(suggestionsLabel);
+
+    // All subsets are added once and only hidden when they do not contain the selected robots, so that ticking a box is instant.
+    suggestionList = new QListWidget(this);
+    for(int i = 0; i < ratings.size(); ++i)
+    {
+      QStringList robotNames;
+      for(unsigned int jerseyNumber : SubsetPlanner::getRobotNumbers(ratings[i].robots))
+        robotNames.append(QString::number(jerseyNumber));
+      auto* item = new QListWidgetItem(QString("%1. Robots %2: %3, %4%, %5 m").arg(i + 1).arg(robotNames.join(", "))
+                                       .arg(ratings[i].expectedScore, 0, 'f', 2).arg(qRound(ratings[i].coverage * 100.f))
+                                       .arg(ratings[i].meanReferenceDistance, 0, 'f', 2), suggestionList);
+      item->setData(Qt::UserRole, static_cast<uint>(ratings[i].robots));
+    }
+    suggestionsLabel->setBuddy(suggestionList);
+    connect(suggestionList, &QListWidget::itemActivated, this, [this, startButton](QListWidgetItem* item)
+    {
+      const uint robots = item->data(Qt::UserRole).toUInt();
+      for(int i = 0; i < robotCheckBoxes.size(); ++i)
+      {
+        const QSignalBlocker blocker(robotCheckBoxes[i]);
+        robotCheckBoxes[i]->setChecked(robots & (1u << i));
+      }
+      startButton->setEnabled(robots != 0);
+      updateSuggestions();
+    });
+    layout->addWidget(suggestionList);
+    updateSuggestions();
+  }
+
   layout->addWidget(startButton);
 
   setLayout(layout);
@@ -66,3 +107,22 @@ QVector<unsigned int> ChallengeStartDialog::getRobotNumbers() const
       result.append(i + 1);
   return result;
 }
+
+void ChallengeStartDialog::updateSuggestions()
+{
+  if(!suggestionList)
+    return;
+
+  std::uint32_t selectedRobots = 0;
+  for(int i = 0; i < robotCheckBoxes.size(); ++i)
+    if(robotCheckBoxes[i]->isChecked())
+      selectedRobots |= 1u << i;
+
+  selectionLabel->setText("No robots selected.");
+  for(int i = 0; i < ratings.size(); ++i)
+  {
+    suggestionList->item(i)->setHidden((ratings[i].robots & selectedRobots) != selectedRobots);
+    if(ratings[i].robots == selectedRobots)
+      selectionLabel->setText(QString("Selected robots: rank %1 of %2 (expected score %3)").arg(i + 1).arg(ratings.size()).arg(ratings[i].expectedScore, 0, 'f', 2));
+  }
+}
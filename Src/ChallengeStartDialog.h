@@ -8,11 +8,14 @@
 
 #pragma once
 
+#include "SubsetPlanner.h"
 #include <QDialog>
 #include <QVector>
 
 class QCheckBox;
 class QComboBox;
+class QLabel;
+class QListWidget;
 class QWidget;
 
 class ChallengeStartDialog : public QDialog
@@ -21,9 +24,10 @@ public:
   /**
    * Constructor.
    * @param numOfRobots The maximum number of robots that could be used.
+   * @param ratings The ratings of the robot subsets (best first) from which suggestions are made (may be empty).
    * @param parent The Qt parent widget.
    */
-  explicit ChallengeStartDialog(int numOfRobots, QWidget* parent = nullptr);
+  ChallengeStartDialog(int numOfRobots, const QVector<SubsetPlanner::Rating>& ratings, QWidget* parent = nullptr);
 
   /**
    * Returns the name of the selected team.
@@ -38,6 +42,12 @@ public:
   QVector<unsigned int> getRobotNumbers() const;
 
 private:
+  /** Shows only the suggestions that contain all selected robots and the rank of the selected subset. */
+  void updateSuggestions();
+
+  QVector<SubsetPlanner::Rating> ratings; /**< The ratings of the robot subsets (best first). */
   QComboBox* teamComboBox = nullptr; /**< A combo box to select the team will do the challenge. */
   QVector<QCheckBox*> robotCheckBoxes; /**< A list of checkboxes to select which robots will participate in the challenge. */
+  QListWidget* suggestionList = nullptr; /**< The robot subsets ranked by their expected score (one item per rating). */
+  QLabel* selectionLabel = nullptr; /**< A label that shows the rating of the selected subset. */
 };
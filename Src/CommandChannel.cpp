@@ -0,0 +1,121 @@
+/**
+ * @file CommandChannel.cpp
+ *
+ * This file implements a class that reads commands line by line from the standard input and/or a local control socket and writes events as JSON lines.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "CommandChannel.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstdio>
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+CommandChannel::CommandChannel(bool readStandardInput, const QString& controlSocketName, QObject* parent) :
+  QObject(parent)
+{
+#ifdef __unix__
+  if(readStandardInput)
+  {
+    standardInputNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(standardInputNotifier, SIGNAL(activated(int)), this, SLOT(handleStandardInput()));
+  }
+#else
+  Q_ASSERT(!readStandardInput);
+#endif
+
+  if(!controlSocketName.isEmpty())
+  {
+    controlServer = new QLocalServer(this);
+    QLocalServer::removeServer(controlSocketName);
+    if(!controlServer->listen(controlSocketName))
+      writeError("Could not listen on control socket " + controlSocketName + ": " + controlServer->errorString(), nullptr);
+    connect(controlServer, &QLocalServer::newConnection, this, &CommandChannel::handleNewControlClients);
+  }
+}
+
+void CommandChannel::handleStandardInput()
+{
+#ifdef __unix__
+  char data[4096];
+  const ssize_t bytesRead = read(STDIN_FILENO, data, sizeof(data));
+  if(bytesRead < 0 && (errno == EINTR || errno == EAGAIN))
+    return;
+  if(bytesRead <= 0)
+  {
+    // The standard input has been closed. A readable end of file would activate the notifier forever, so it is not watched anymore
+    // and commands can only arrive via the control socket. A last command without a line break is still executed.
+    standardInputNotifier->setEnabled(false);
+    standardInputNotifier->deleteLater();
+    standardInputNotifier = nullptr;
+    handleLine(QString::fromUtf8(standardInputBuffer), nullptr);
+    standardInputBuffer.clear();
+    return;
+  }
+  standardInputBuffer.append(data, static_cast<int>(bytesRead));
+
+  int lineEnd;
+  while((lineEnd = standardInputBuffer.indexOf('\n')) >= 0)
+  {
+    const QString line = QString::fromUtf8(standardInputBuffer.left(lineEnd));
+    standardInputBuffer.remove(0, lineEnd + 1);
+    handleLine(line, nullptr);
+  }
+#endif
+}
+
+void CommandChannel::handleNewControlClients()
+{
+  while(QLocalSocket* client = controlServer->nextPendingConnection())
+  {
+    controlClients.append(client);
+    connect(client, &QLocalSocket::readyRead, this, [this, client]
+    {
+      while(client->canReadLine())
+        handleLine(QString::fromUtf8(client->readLine()), client);
+    });
+    connect(client, &QLocalSocket::disconnected, this, [this, client]
+    {
+      controlClients.removeAll(client);
+      client->deleteLater();
+    });
+  }
+}
+
+void CommandChannel::handleLine(const QString& line, QLocalSocket* client)
+{
+  const QString command = line.trimmed();
+  if(!command.isEmpty())
+    emit commandReceived(command, client);
+}
+
+void CommandChannel::writeEvent(const QJsonObject& event)
+{
+  const QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact) + '\n';
+  std::fwrite(line.constData(), 1, static_cast<std::size_t>(line.size()), stdout);
+  std::fflush(stdout);
+  for(QLocalSocket* client : controlClients)
+    client->write(line);
+}
+
+void CommandChannel::writeError(const QString& message, QLocalSocket* client)
+{
+  QJsonObject event;
+  event["event"] = "error";
+  event["message"] = message;
+  const QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact) + '\n';
+  if(client)
+    client->write(line);
+  else
+  {
+    std::fwrite(line.constData(), 1, static_cast<std::size_t>(line.size()), stdout);
+    std::fflush(stdout);
+  }
+}
@@ -0,0 +1,73 @@
+/**
+ * @file CommandChannel.h
+ *
+ * This file declares a class that reads commands line by line from the standard input and/or a local control socket and writes events as JSON lines.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QJsonObject;
+class QLocalServer;
+class QLocalSocket;
+class QSocketNotifier;
+
+class CommandChannel : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * Constructor. Begins to listen for commands.
+   * @param readStandardInput Whether commands are read from the standard input.
+   * @param controlSocketName The name of a local socket on which commands are accepted (none if empty).
+   * @param parent The Qt parent object.
+   */
+  CommandChannel(bool readStandardInput, const QString& controlSocketName, QObject* parent = nullptr);
+
+  /**
+   * Writes an event as a single JSON line to the standard output and to all control clients.
+   * @param event The event to write.
+   */
+  void writeEvent(const QJsonObject& event);
+
+  /**
+   * Writes an error as a JSON line to the source of a command.
+   * @param message The error message.
+   * @param client The control socket that should receive the error (nullptr for the standard output).
+   */
+  void writeError(const QString& message, QLocalSocket* client);
+
+signals:
+  /**
+   * This signal is emitted for each command line that has been received.
+   * @param command The command line (without surrounding whitespace, never empty).
+   * @param client The control socket from which the command was received (nullptr for the standard input).
+   */
+  void commandReceived(const QString& command, QLocalSocket* client);
+
+private slots:
+  /** Reads all complete lines from the standard input and emits them as commands. */
+  void handleStandardInput();
+
+private:
+  /** Accepts pending connections on the control socket. */
+  void handleNewControlClients();
+
+  /**
+   * Emits a command line unless it is empty.
+   * @param line The command line.
+   * @param client The source of the command line (nullptr for the standard input).
+   */
+  void handleLine(const QString& line, QLocalSocket* client);
+
+  QSocketNotifier* standardInputNotifier = nullptr; /**< The notifier that signals input on the standard input. */
+  QByteArray standardInputBuffer; /**< Input from the standard input that does not form a complete line yet. */
+  QLocalServer* controlServer = nullptr; /**< The server for the local control socket (if enabled). */
+  QVector<QLocalSocket*> controlClients; /**< The clients that are connected to the local control socket. */
+};
@@ -9,9 +9,12 @@
 #pragma once
 
 #include "Util/Vector2D.h"
+#include <cstdint>
 
 struct DetectedWhistle
 {
   bool onSameField = false; /**< Whether the whistle has been blown on the same field as the one on which the robots are. */
   Vector2D location; /**< The location where the whistle has been blown relative to the center of the field on which the robots are (in meters). */
+  std::int64_t timestamp = 0; /**< The time at which the message arrived at the tester (in nanoseconds of the monotonic clock, see \c Clock::getTime). */
+  std::int64_t queueTimestamp = 0; /**< The time at which the receiver put the whistle into the queue (only for the latency profile, 0 if it has not been queued). */
 };
@@ -0,0 +1,123 @@
+/**
+ * @file HeadlessMain.cpp
+ *
+ * This file defines the main procedure of the headless variant of the program.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "HeadlessTester.h"
+#include "Journal.h"
+#include "ScoringRules.h"
+#include "TeamList.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Runs a pass of the directional whistle challenge without a GUI.\n"
+                                   "Commands (\"start\", \"status\", \"quit\") are read line by line from the standard input and/or a local control socket.\n"
+                                   "Events are written as JSON lines to the standard output.");
+  parser.addHelpOption();
+  const QCommandLineOption teamOption("team", "The name or number of the team.", "team");
+  const QCommandLineOption robotsOption("robots", "The comma-separated jersey numbers of the participating robots.", "robots");
+  const QCommandLineOption controlSocketOption("control-socket", "The name of a local socket on which commands are accepted.", "name");
+  const QCommandLineOption noStandardInputOption("no-stdin", "Do not read commands from the standard input.");
+  const QCommandLineOption resumeOption("resume", "Resume the pass that has been interrupted at the end of the most recent journal (instead of --team and --robots).");
+  parser.addOption(teamOption);
+  parser.addOption(robotsOption);
+  parser.addOption(controlSocketOption);
+  parser.addOption(noStandardInputOption);
+  parser.addOption(resumeOption);
+  parser.process(app);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+
+  QVector<Pose2D> robotPoses;
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+
+  bool readStandardInput = !parser.isSet(noStandardInputOption);
+#ifndef __unix__
+  readStandardInput = false;
+#endif
+  if(!readStandardInput && !parser.isSet(controlSocketOption))
+  {
+    error << "Without the standard input, a control socket must be given." << endl;
+    return 2;
+  }
+
+  if(parser.isSet(resumeOption))
+  {
+    // The journal must be read before the tester creates a new one.
+    QVector<Vector2D> whistleLocations;
+    Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+    QStringList journals;
+    for(const QString& path : Journal::findJournals(Paths::getLogPath()))
+      if(!path.contains("_field"))
+        journals.append(path);
+    Journal::UnfinishedPass pass;
+    if(journals.isEmpty() || !JournalReader(journals.last()).findUnfinishedPass(pass))
+    {
+      error << "The most recent journal does not end with an interrupted pass." << endl;
+      return 2;
+    }
+    const QString teamName = TeamList::getInstance().getTeamNameByNumber(pass.teamNumber);
+    if(teamName.isEmpty() || !pass.fits(robotPoses.size(), whistleLocations.size()))
+    {
+      error << "The interrupted pass does not fit the current configuration." << endl;
+      return 2;
+    }
+
+    HeadlessTester tester(teamName, pass.robotNumbers, readStandardInput, parser.value(controlSocketOption), &pass);
+    return app.exec();
+  }
+
+  QString teamName = parser.value(teamOption);
+  bool isNumber;
+  const unsigned int teamNumber = teamName.toUInt(&isNumber);
+  if(isNumber)
+    teamName = TeamList::getInstance().getTeamNameByNumber(teamNumber);
+  if(teamName.isEmpty() || !TeamList::getInstance().getTeamNames().contains(teamName))
+  {
+    error << "Unknown team: " << parser.value(teamOption) << endl;
+    return 2;
+  }
+
+  QVector<unsigned int> robotNumbers;
+  for(const QString& part : parser.value(robotsOption).split(',', QString::SkipEmptyParts))
+  {
+    bool ok;
+    const unsigned int jerseyNumber = part.trimmed().toUInt(&ok);
+    if(!ok || jerseyNumber < 1 || static_cast<int>(jerseyNumber) > robotPoses.size() || robotNumbers.contains(jerseyNumber))
+    {
+      error << "Invalid robot number: " << part << endl;
+      return 2;
+    }
+    robotNumbers.append(jerseyNumber);
+  }
+  if(robotNumbers.isEmpty())
+  {
+    error << "At least one robot must be given with --robots." << endl;
+    return 2;
+  }
+  std::sort(robotNumbers.begin(), robotNumbers.end());
+
+  HeadlessTester tester(teamName, robotNumbers, readStandardInput, parser.value(controlSocketOption));
+
+  return app.exec();
+}
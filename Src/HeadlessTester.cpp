@@ -0,0 +1,197 @@
+/**
+ * @file HeadlessTester.cpp
+ *
+ * This file implements a class that runs a challenge pass without a GUI, controlled by commands and reporting results as JSON lines.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "HeadlessTester.h"
+#include "Capture.h"
+#include "Challenge.h"
+#include "ChallengeLog.h"
+#include "CommandChannel.h"
+#include "Journal.h"
+#include "LatencyProfile.h"
+#include "ResultJson.h"
+#include "SPLStandardMessageReceiver.h"
+#include "ScoringRules.h"
+#include "TeamList.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QThread>
+
+HeadlessTester::HeadlessTester(const QString& teamName, const QVector<unsigned int>& robotNumbers, bool readStandardInput, const QString& controlSocketName,
+                               const Journal::UnfinishedPass* resumedPass, QObject* parent) :
+  QObject(parent),
+  teamName(teamName)
+{
+  ChallengeLog() << "Started DirectionalWhistleTester (headless)";
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+  const QString suffix = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
+  captureWriter.reset(new CaptureWriter(Paths::getLogPath() + "/capture_" + suffix + ".dwc"));
+  journalWriter.reset(new JournalWriter(Paths::getLogPath() + "/journal_" + suffix + ".dwj"));
+
+  ChallengeLog() << "Started challenge pass of team " << teamName << " with robots " << robotNumbers;
+  ChallengeLog() << "Scoring rules: " << ScoringRules::toJson(ScoringRules::getConfiguredDefinition());
+  if(resumedPass)
+    ChallengeLog() << "Resumed " << resumedPass->results.size() << " attempts of the interrupted pass";
+  ChallengeLog::commit();
+
+  QVector<Pose2D> robotSetup;
+  for(unsigned int jerseyNumber : robotNumbers)
+  {
+    Q_ASSERT(jerseyNumber >= 1 && static_cast<int>(jerseyNumber) <= robotPoses.size());
+    robotSetup.append(robotPoses[jerseyNumber - 1]);
+  }
+
+  const unsigned int teamNumber = TeamList::getInstance().getTeamNumberByName(teamName);
+  receiver = new SPLStandardMessageReceiver(teamNumber);
+  receiver->setCaptureWriter(captureWriter.get());
+  receiverThread = new QThread(this);
+  receiverThread->setObjectName("Receiver");
+  receiver->moveToThread(receiverThread);
+  connect(receiverThread, &QThread::finished, receiver, &QObject::deleteLater);
+  challenge = resumedPass ? new Challenge(whistleLocations, robotSetup, resumedPass->locationOrder, this) : new Challenge(whistleLocations, robotSetup, this);
+  challenge->setWhistleQueue(&receiver->getWhistleQueue());
+  challenge->setCaptureWriter(captureWriter.get());
+  challenge->setJournalWriter(journalWriter.get());
+
+  Capture::PassStart passStart;
+  passStart.teamNumber = teamNumber;
+  passStart.robotNumbers = robotNumbers;
+  for(const Challenge::Attempt& attempt : challenge->getAttempts())
+    passStart.locationOrder.append(attempt.locationIndex);
+  captureWriter->writePassStart(Clock::getTime(), passStart);
+  journalWriter->writePassStart(Clock::getTime(), teamNumber, robotNumbers, passStart.locationOrder);
+  if(resumedPass)
+    challenge->resume(resumedPass->results);
+  connect(receiver, &SPLStandardMessageReceiver::whistleLocationsReceived, challenge, &Challenge::handleReceivedWhistles);
+  connect(challenge, &Challenge::attemptFinished, this, &HeadlessTester::handleAttemptFinished);
+  receiverThread->start(QThread::TimeCriticalPriority);
+
+  commandChannel = new CommandChannel(readStandardInput, controlSocketName, this);
+  connect(commandChannel, &CommandChannel::commandReceived, this, &HeadlessTester::handleCommand);
+
+  QJsonArray robots;
+  for(unsigned int jerseyNumber : robotNumbers)
+    robots.append(static_cast<int>(jerseyNumber));
+  QJsonArray locations;
+  for(const Challenge::Attempt& attempt : challenge->getAttempts())
+    locations.append(attempt.locationIndex + 1);
+  QJsonObject event;
+  event["event"] = "passStarted";
+  event["team"] = teamName;
+  event["robots"] = robots;
+  event["locations"] = locations;
+  if(resumedPass)
+    event["resumedAttempts"] = challenge->getNumOfFinishedAttempts();
+  commandChannel->writeEvent(event);
+}
+
+HeadlessTester::~HeadlessTester()
+{
+  delete challenge;
+  receiverThread->quit();
+  receiverThread->wait();
+}
+
+void HeadlessTester::handleCommand(const QString& command, QLocalSocket* client)
+{
+  if(command == "start")
+  {
+    if(challenge->isFinished())
+      commandChannel->writeError("The challenge pass is already finished.", client);
+    else if(challenge->isAttemptRunning())
+      commandChannel->writeError("An attempt is already running.", client);
+    else
+    {
+      const Challenge::Attempt& attempt = challenge->getAttempts()[challenge->getNumOfFinishedAttempts()];
+      challenge->startAttempt();
+
+      QJsonObject event;
+      event["event"] = "attemptStarted";
+      event["attempt"] = challenge->getNumOfFinishedAttempts() + 1;
+      event["location"] = attempt.locationIndex + 1;
+      commandChannel->writeEvent(event);
+    }
+  }
+  else if(command == "status")
+  {
+    QJsonObject event;
+    event["event"] = "status";
+    event["team"] = teamName;
+    event["finishedAttempts"] = challenge->getNumOfFinishedAttempts();
+    event["attempts"] = challenge->getAttempts().size();
+    event["attemptRunning"] = challenge->isAttemptRunning();
+    event["totalScore"] = challenge->getTotalScore();
+    event["ingress"] = ResultJson::fromCounters(receiver->getCounters());
+    commandChannel->writeEvent(event);
+  }
+  else if(command == "latency")
+  {
+    QJsonObject event;
+    event["event"] = "latency";
+    event["stages"] = ResultJson::fromLatencyProfile(LatencyProfile::getInstance());
+    commandChannel->writeEvent(event);
+  }
+  else if(command == "quit")
+  {
+    ChallengeLog() << "Aborted challenge pass of team " << teamName;
+    ChallengeLog::commit();
+    if(!challenge->isFinished())
+      journalWriter->writePassEnd(Clock::getTime(), challenge->getTotalScore(), true);
+    QJsonObject event;
+    event["event"] = "passAborted";
+    event["team"] = teamName;
+    commandChannel->writeEvent(event);
+    QCoreApplication::exit(1);
+  }
+  else
+    commandChannel->writeError("Unknown command: " + command, client);
+}
+
+void HeadlessTester::handleAttemptFinished()
+{
+  const int attemptIndex = challenge->getNumOfFinishedAttempts() - 1;
+  QJsonObject event = ResultJson::fromAttempt(attemptIndex, challenge->getAttempts()[attemptIndex]);
+  event["event"] = "attemptFinished";
+  commandChannel->writeEvent(event);
+  ChallengeLog() << "Ingress: " << receiver->getCounters().toString();
+
+  if(challenge->isFinished())
+  {
+    ChallengeLog() << "Finished challenge pass of team " << teamName << " with final score " << challenge->getTotalScore();
+    for(const QString& line : LatencyProfile::getInstance().toString().split('\n', QString::SkipEmptyParts))
+      ChallengeLog() << "Latency of " << line;
+    QString tracePath;
+    if(Tracer::isEnabled())
+    {
+      tracePath = Paths::getLogPath() + "/trace_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".json";
+      if(Tracer::write(tracePath))
+        ChallengeLog() << "Wrote trace to " << tracePath;
+      else
+        tracePath.clear();
+    }
+    ChallengeLog::commit();
+
+    QJsonObject passEvent;
+    passEvent["event"] = "passFinished";
+    passEvent["team"] = teamName;
+    passEvent["totalScore"] = challenge->getTotalScore();
+    passEvent["meanScore"] = challenge->getAggregates().getMeanScore();
+    passEvent["timeouts"] = challenge->getAggregates().numOfTimeouts;
+    passEvent["latency"] = ResultJson::fromLatencyProfile(LatencyProfile::getInstance());
+    if(!tracePath.isEmpty())
+      passEvent["trace"] = tracePath;
+    commandChannel->writeEvent(passEvent);
+    QCoreApplication::exit(0);
+  }
+}
@@ -0,0 +1,66 @@
+/**
+ * @file HeadlessTester.h
+ *
+ * This file declares a class that runs a challenge pass without a GUI, controlled by commands and reporting results as JSON lines.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class CaptureWriter;
+class Challenge;
+class CommandChannel;
+class JournalWriter;
+class SPLStandardMessageReceiver;
+class QLocalSocket;
+class QThread;
+namespace Journal { struct UnfinishedPass; }
+
+class HeadlessTester : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * Constructor. Starts a challenge pass and begins to listen for commands.
+   * @param teamName The name of the team that does the challenge pass.
+   * @param robotNumbers The jersey numbers of the robots that the team handed in.
+   * @param readStandardInput Whether commands are read from the standard input.
+   * @param controlSocketName The name of a local socket on which commands are accepted (none if empty).
+   * @param resumedPass The interrupted pass whose location order and finished attempts are restored (nullptr to start a new pass).
+   * @param parent The Qt parent object.
+   */
+  HeadlessTester(const QString& teamName, const QVector<unsigned int>& robotNumbers, bool readStandardInput, const QString& controlSocketName,
+                 const Journal::UnfinishedPass* resumedPass = nullptr, QObject* parent = nullptr);
+
+  /** Destructor. Stops the receiver thread. */
+  ~HeadlessTester() override;
+
+private:
+  /**
+   * Executes a command ("start" starts the next attempt, "status" reports the state of the pass, "quit" aborts the pass).
+   * @param command The command line.
+   * @param client The control socket from which the command was received (nullptr for the standard input).
+   */
+  void handleCommand(const QString& command, QLocalSocket* client);
+
+  /** Reports the result of the attempt that has just been finished and quits if the pass is finished. */
+  void handleAttemptFinished();
+
+  QString teamName; /**< The name of the team that does the challenge pass. */
+  QVector<Vector2D> whistleLocations; /**< The set of locations from which the whistle is blown. */
+  QVector<Pose2D> robotPoses; /**< The set of poses at which robots can be placed. */
+  Challenge* challenge = nullptr; /**< The running challenge pass. */
+  SPLStandardMessageReceiver* receiver = nullptr; /**< The receiver for SPL messages (lives in \c receiverThread). */
+  QThread* receiverThread = nullptr; /**< The thread in which messages are received. */
+  std::unique_ptr<CaptureWriter> captureWriter; /**< The capture of all received datagrams and attempts. */
+  std::unique_ptr<JournalWriter> journalWriter; /**< The result journal of the pass. */
+  CommandChannel* commandChannel = nullptr; /**< The source of commands and the destination of events. */
+};
@@ -0,0 +1,326 @@
+/**
+ * @file Journal.cpp
+ *
+ * This file implements classes that write and read result journals.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Journal.h"
+#include <QDir>
+#include <QtEndian>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+  /**
+   * Encodes a float in little endian.
+   * @param value The value.
+   * @param bytes The 4 bytes into which the value is encoded.
+   */
+  void encodeFloat(float value, uchar* bytes)
+  {
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    qToLittleEndian<quint32>(bits, bytes);
+  }
+
+  /**
+   * Decodes a little endian float.
+   * @param bytes The 4 bytes of the value.
+   * @return The value.
+   */
+  float decodeFloat(const uchar* bytes)
+  {
+    const quint32 bits = qFromLittleEndian<quint32>(bytes);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+}
+
+QStringList Journal::findJournals(const QString& directory)
+{
+  const QDir dir(directory);
+  QStringList paths;
+  for(const QString& name : dir.entryList(QStringList("journal_*.dwj"), QDir::Files, QDir::Name))
+    paths.append(dir.filePath(name));
+  return paths;
+}
+
+bool Journal::UnfinishedPass::fits(int numOfRobotPoses, int numOfWhistleLocations) const
+{
+  if(robotNumbers.isEmpty() || locationOrder.size() != numOfWhistleLocations)
+    return false;
+  for(unsigned int robotNumber : robotNumbers)
+    if(static_cast<int>(robotNumber) > numOfRobotPoses)
+      return false;
+  QVector<bool> used(numOfWhistleLocations, false);
+  for(int locationIndex : locationOrder)
+  {
+    if(locationIndex >= numOfWhistleLocations || used[locationIndex])
+      return false;
+    used[locationIndex] = true;
+  }
+  return true;
+}
+
+std::size_t Journal::getSize(ColumnType type)
+{
+  switch(type)
+  {
+    case ColumnType::uint8:
+      return 1;
+    case ColumnType::uint16:
+      return 2;
+    case ColumnType::uint32:
+    case ColumnType::float32:
+      return 4;
+    case ColumnType::int64:
+      return 8;
+  }
+  return 0;
+}
+
+const char* Journal::getName(ColumnType type)
+{
+  switch(type)
+  {
+    case ColumnType::uint8:
+      return "uint8";
+    case ColumnType::uint16:
+      return "uint16";
+    case ColumnType::uint32:
+      return "uint32";
+    case ColumnType::int64:
+      return "int64";
+    case ColumnType::float32:
+      return "float32";
+  }
+  return "";
+}
+
+void Journal::encode(const Record& record, unsigned char* bytes)
+{
+  std::memset(bytes, 0, recordSize);
+  bytes[0] = static_cast<uchar>(record.type);
+  bytes[1] = record.flags;
+  bytes[2] = record.field;
+  qToLittleEndian<quint16>(record.attempt, bytes + 4);
+  qToLittleEndian<quint16>(record.location, bytes + 6);
+  qToLittleEndian<quint16>(record.team, bytes + 8);
+  qToLittleEndian<quint32>(record.robots, bytes + 12);
+  qToLittleEndian<qint64>(record.timestamp, bytes + 16);
+  qToLittleEndian<qint64>(record.whistle.timestamp, bytes + 24);
+  qToLittleEndian<qint64>(record.whistle.queueTimestamp, bytes + 32);
+  qToLittleEndian<qint64>(record.remainingTime, bytes + 40);
+  encodeFloat(record.whistle.location.x, bytes + 48);
+  encodeFloat(record.whistle.location.y, bytes + 52);
+  encodeFloat(record.score, bytes + 56);
+  encodeFloat(record.components.onSameFieldDecision, bytes + 60);
+  encodeFloat(record.components.direction, bytes + 64);
+  encodeFloat(record.components.distance, bytes + 68);
+}
+
+void Journal::decode(const unsigned char* bytes, Record& record)
+{
+  record.type = static_cast<RecordType>(bytes[0]);
+  record.flags = bytes[1];
+  record.field = bytes[2];
+  record.attempt = qFromLittleEndian<quint16>(bytes + 4);
+  record.location = qFromLittleEndian<quint16>(bytes + 6);
+  record.team = qFromLittleEndian<quint16>(bytes + 8);
+  record.robots = qFromLittleEndian<quint32>(bytes + 12);
+  record.timestamp = qFromLittleEndian<qint64>(bytes + 16);
+  record.whistle.timestamp = qFromLittleEndian<qint64>(bytes + 24);
+  record.whistle.queueTimestamp = qFromLittleEndian<qint64>(bytes + 32);
+  record.remainingTime = qFromLittleEndian<qint64>(bytes + 40);
+  record.whistle.location.x = decodeFloat(bytes + 48);
+  record.whistle.location.y = decodeFloat(bytes + 52);
+  record.whistle.onSameField = (record.flags & onSameField) != 0;
+  record.score = decodeFloat(bytes + 56);
+  record.components.onSameFieldDecision = decodeFloat(bytes + 60);
+  record.components.direction = decodeFloat(bytes + 64);
+  record.components.distance = decodeFloat(bytes + 68);
+}
+
+JournalWriter::JournalWriter(const QString& path) :
+  writer(path)
+{
+  uchar header[Journal::headerSize] = {};
+  std::memcpy(header, Journal::magic, sizeof(Journal::magic));
+  qToLittleEndian<quint32>(Journal::version, header + 4);
+  qToLittleEndian<quint32>(static_cast<quint32>(Journal::recordSize), header + 8);
+  writer.append(QByteArray(reinterpret_cast<const char*>(header), sizeof(header)));
+}
+
+void JournalWriter::writePassStart(std::int64_t timestamp, unsigned int teamNumber, const QVector<unsigned int>& robotNumbers, const QVector<int>& locationOrder, int field)
+{
+  Q_ASSERT(teamNumber <= 0xffff && field >= 0 && field < 256);
+
+  Journal::Record record;
+  record.type = Journal::RecordType::passStart;
+  record.field = static_cast<std::uint8_t>(field);
+  record.team = static_cast<std::uint16_t>(teamNumber);
+  for(unsigned int robotNumber : robotNumbers)
+  {
+    Q_ASSERT(robotNumber >= 1 && robotNumber <= 32);
+    record.robots |= 1u << (robotNumber - 1);
+  }
+  record.timestamp = timestamp;
+  writeRecord(record);
+
+  for(int i = 0; i < locationOrder.size(); ++i)
+  {
+    Journal::Record plannedAttempt;
+    plannedAttempt.type = Journal::RecordType::plannedAttempt;
+    plannedAttempt.attempt = static_cast<std::uint16_t>(i);
+    plannedAttempt.location = static_cast<std::uint16_t>(locationOrder[i]);
+    plannedAttempt.timestamp = timestamp;
+    writeRecord(plannedAttempt);
+  }
+  writer.commit();
+}
+
+void JournalWriter::writeAttemptStart(std::int64_t timestamp, int attemptIndex, int locationIndex)
+{
+  Journal::Record record;
+  record.type = Journal::RecordType::attemptStart;
+  record.attempt = static_cast<std::uint16_t>(attemptIndex);
+  record.location = static_cast<std::uint16_t>(locationIndex);
+  record.timestamp = timestamp;
+  writeRecord(record);
+}
+
+void JournalWriter::writeAttemptResult(std::int64_t timestamp, int attemptIndex, int locationIndex, std::int64_t remainingTime,
+                                       const DetectedWhistle& whistle, const Metric::ScoreComponents& components, LogWriter::Callback committed)
+{
+  Journal::Record record;
+  record.type = Journal::RecordType::attemptResult;
+  record.attempt = static_cast<std::uint16_t>(attemptIndex);
+  record.location = static_cast<std::uint16_t>(locationIndex);
+  record.timestamp = timestamp;
+  if(remainingTime == -1)
+    record.flags = Journal::timedOut;
+  else
+  {
+    record.flags = whistle.onSameField ? Journal::onSameField : 0;
+    record.whistle = whistle;
+    record.remainingTime = remainingTime;
+    record.components = components;
+    record.score = components.getTotal();
+  }
+  writeRecord(record);
+  if(committed)
+    writer.commit(std::move(committed));
+  else
+    writer.commit();
+}
+
+void JournalWriter::writePassEnd(std::int64_t timestamp, float totalScore, bool aborted)
+{
+  Journal::Record record;
+  record.type = Journal::RecordType::passEnd;
+  record.flags = aborted ? Journal::aborted : 0;
+  record.timestamp = timestamp;
+  record.score = totalScore;
+  writeRecord(record);
+  writer.commit();
+}
+
+void JournalWriter::writeRecord(const Journal::Record& record)
+{
+  QByteArray bytes(static_cast<int>(Journal::recordSize), Qt::Uninitialized);
+  Journal::encode(record, reinterpret_cast<uchar*>(bytes.data()));
+  writer.append(bytes);
+}
+
+JournalReader::JournalReader(const QString& path) :
+  file(path)
+{
+  if(!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(Journal::headerSize))
+    return;
+
+  // Mapping avoids copying the journal. Files that cannot be mapped (e.g. on some network shares) are read instead.
+  const uchar* data = file.map(0, file.size());
+  if(data)
+    open(data, static_cast<std::size_t>(file.size()));
+  else
+  {
+    contents = file.readAll();
+    open(reinterpret_cast<const uchar*>(contents.constData()), static_cast<std::size_t>(contents.size()));
+  }
+}
+
+JournalReader::JournalReader(const unsigned char* data, std::size_t size)
+{
+  open(data, size);
+}
+
+bool JournalReader::isValid() const
+{
+  return valid;
+}
+
+std::size_t JournalReader::getNumOfRecords() const
+{
+  return numOfRecords;
+}
+
+void JournalReader::readRecord(std::size_t index, Journal::Record& record) const
+{
+  Q_ASSERT(index < numOfRecords);
+  Journal::decode(getRecordData(index), record);
+}
+
+void JournalReader::open(const unsigned char* data, std::size_t size)
+{
+  valid = size >= Journal::headerSize && std::memcmp(data, Journal::magic, sizeof(Journal::magic)) == 0 &&
+          qFromLittleEndian<quint32>(data + 4) == Journal::version && qFromLittleEndian<quint32>(data + 8) == Journal::recordSize;
+  if(!valid)
+    return;
+  records = data + Journal::headerSize;
+  numOfRecords = (size - Journal::headerSize) / Journal::recordSize;
+}
+
+bool JournalReader::findUnfinishedPass(Journal::UnfinishedPass& pass) const
+{
+  std::size_t start = numOfRecords;
+  while(start > 0 && getRecordData(start - 1)[0] != static_cast<uchar>(Journal::RecordType::passStart))
+    --start;
+  if(!start)
+    return false;
+
+  Journal::Record record;
+  readRecord(start - 1, record);
+  pass = Journal::UnfinishedPass();
+  pass.teamNumber = record.team;
+  pass.field = record.field;
+  for(unsigned int robotNumber = 1; robotNumber <= 32; ++robotNumber)
+    if(record.robots & (1u << (robotNumber - 1)))
+      pass.robotNumbers.append(robotNumber);
+  for(std::size_t i = start; i < numOfRecords; ++i)
+  {
+    readRecord(i, record);
+    switch(record.type)
+    {
+      case Journal::RecordType::plannedAttempt:
+        if(record.attempt != pass.locationOrder.size())
+          return false;
+        pass.locationOrder.append(record.location);
+        break;
+      case Journal::RecordType::attemptResult:
+        // Results are only accepted in the planned order, for the planned location.
+        if(record.attempt != pass.results.size() || record.attempt >= pass.locationOrder.size() || record.location != pass.locationOrder[record.attempt])
+          return false;
+        pass.results.append(record);
+        break;
+      case Journal::RecordType::passEnd:
+        return false;
+      default:
+        break;
+    }
+  }
+  return !pass.locationOrder.isEmpty() && pass.results.size() < pass.locationOrder.size();
+}
@@ -0,0 +1,293 @@
+/**
+ * @file Journal.h
+ *
+ * This file declares classes that write and read result journals, i.e. append-only binary files with one fixed-width
+ * record per challenge event (pass start, attempt start, attempt result, pass end). In contrast to the text log,
+ * a journal can be scanned without parsing: record i starts at headerSize + i * recordSize, and every column is at
+ * a fixed offset within a record, so that analyses can map the file and read columns directly.
+ * The journal also serves as write-ahead log of the running pass: its location order and every attempt result are
+ * on the device before the result is shown, so that an unfinished pass can be resumed after a crash.
+ *
+ * A journal file starts with the magic bytes "DWTJ", a 32 bit version number, the record size (32 bit) and
+ * 4 reserved bytes, followed by the records. The layout of a record is given by \c Journal::columns.
+ * All numbers are little endian.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "DetectedWhistle.h"
+#include "LogWriter.h"
+#include "Metric.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Journal
+{
+  constexpr char magic[4] = {'D', 'W', 'T', 'J'}; /**< The bytes at the start of every journal file. */
+  constexpr std::uint32_t version = 1; /**< The version of the format that is written. */
+  constexpr std::size_t headerSize = 16; /**< The number of bytes before the first record (so that the 64 bit columns stay aligned). */
+  constexpr std::size_t recordSize = 72; /**< The number of bytes of every record. */
+
+  /** The types of records in a journal. */
+  enum class RecordType : std::uint8_t
+  {
+    passStart = 1, /**< A challenge pass has been started (columns: team, field, robots). */
+    attemptStart = 2, /**< An attempt has been started (columns: attempt, location). */
+    attemptResult = 3, /**< An attempt has been finished (columns: attempt, location, the whistle, remaining time and score). */
+    passEnd = 4, /**< A challenge pass has been finished or aborted (columns: score, i.e. the total score). */
+    plannedAttempt = 5 /**< The location of an attempt as planned when the pass has been started (columns: attempt, location), one per attempt after the pass start. */
+  };
+
+  /** The bits of the flags column. */
+  enum Flag : std::uint8_t
+  {
+    timedOut = 1, /**< The attempt has timed out (attempt results only). */
+    onSameField = 2, /**< The robots reported the whistle on their own field (attempt results only). */
+    aborted = 4 /**< The pass has been aborted by the operator (pass ends only). */
+  };
+
+  /** A record as it is written to or read from a journal. Columns that do not belong to its type are 0. */
+  struct Record
+  {
+    RecordType type = RecordType::passStart; /**< The type of the record. */
+    std::uint8_t flags = 0; /**< A combination of \c Flag bits. */
+    std::uint8_t field = 0; /**< The field of the pass (starting at 1, 0 if there is only one). */
+    std::uint16_t attempt = 0; /**< The index of the attempt within the pass. */
+    std::uint16_t location = 0; /**< The (zero-based) index of the whistle location of the attempt. */
+    std::uint16_t team = 0; /**< The number of the team that does the pass. */
+    std::uint32_t robots = 0; /**< The jersey numbers of the participating robots (bit n - 1 for robot n). */
+    std::int64_t timestamp = 0; /**< The time of the event (in nanoseconds of the monotonic clock). */
+    DetectedWhistle whistle; /**< The whistle report that has been scored (attempt results that did not time out). */
+    std::int64_t remainingTime = -1; /**< The time (µs) that was remaining when the whistle message arrived (-1 if there is none). */
+    float score = 0.f; /**< The score of the attempt or the total score of the pass. */
+    Metric::ScoreComponents components; /**< The parts of the score of the attempt. */
+  };
+
+  /** A pass that has been started but neither finished nor aborted, as found at the end of a journal. */
+  struct UnfinishedPass
+  {
+    unsigned int teamNumber = 0; /**< The number of the team that does the pass. */
+    QVector<unsigned int> robotNumbers; /**< The jersey numbers of the participating robots (in ascending order). */
+    int field = 0; /**< The field of the pass (starting at 1, 0 if there is only one). */
+    QVector<int> locationOrder; /**< The (zero-based) location indices in the order of the attempts. */
+    QVector<Record> results; /**< The results of the finished attempts (in the order of the attempts). */
+
+    /**
+     * Returns whether the pass can be resumed with the current configuration, i.e. whether its robots exist and
+     * its location order is a permutation of the whistle locations.
+     * @param numOfRobotPoses The number of robot poses.
+     * @param numOfWhistleLocations The number of whistle locations.
+     * @return Whether the pass fits the configuration.
+     */
+    bool fits(int numOfRobotPoses, int numOfWhistleLocations) const;
+  };
+
+  /**
+   * Finds all journals in a directory.
+   * @param directory The directory.
+   * @return The paths of all files that match journal_*.dwj, sorted by name (i.e. by the time at which they have been created).
+   */
+  QStringList findJournals(const QString& directory);
+
+  /** The types of the values of a column. */
+  enum class ColumnType : std::uint8_t
+  {
+    uint8,
+    uint16,
+    uint32,
+    int64,
+    float32
+  };
+
+  /** The name, type and position of a column within a record. */
+  struct Column
+  {
+    const char* name; /**< The name of the column (as in CSV headers). */
+    ColumnType type; /**< The type of the values. */
+    std::size_t offset; /**< The offset of the value within a record. */
+  };
+
+  /** All columns of a record, in the order in which they are stored. */
+  constexpr Column columns[] =
+  {
+    {"type", ColumnType::uint8, 0},
+    {"flags", ColumnType::uint8, 1},
+    {"field", ColumnType::uint8, 2},
+    {"attempt", ColumnType::uint16, 4},
+    {"location", ColumnType::uint16, 6},
+    {"team", ColumnType::uint16, 8},
+    {"robots", ColumnType::uint32, 12},
+    {"timestamp", ColumnType::int64, 16},
+    {"whistleTimestamp", ColumnType::int64, 24},
+    {"queueTimestamp", ColumnType::int64, 32},
+    {"remainingTime", ColumnType::int64, 40},
+    {"x", ColumnType::float32, 48},
+    {"y", ColumnType::float32, 52},
+    {"score", ColumnType::float32, 56},
+    {"sameFieldScore", ColumnType::float32, 60},
+    {"directionScore", ColumnType::float32, 64},
+    {"distanceScore", ColumnType::float32, 68}
+  };
+  constexpr std::size_t numOfColumns = sizeof(columns) / sizeof(columns[0]); /**< The number of columns. */
+
+  /**
+   * Returns the size of a value of a column type.
+   * @param type The column type.
+   * @return The size in bytes.
+   */
+  std::size_t getSize(ColumnType type);
+
+  /**
+   * Returns the name of a column type (as used in the index of a columnar export).
+   * @param type The column type.
+   * @return The name of the type.
+   */
+  const char* getName(ColumnType type);
+
+  /**
+   * Encodes a record.
+   * @param record The record.
+   * @param bytes The \c recordSize bytes into which the record is encoded.
+   */
+  void encode(const Record& record, unsigned char* bytes);
+
+  /**
+   * Decodes a record.
+   * @param bytes The \c recordSize bytes of the record.
+   * @param record The decoded record.
+   */
+  void decode(const unsigned char* bytes, Record& record);
+}
+
+class JournalWriter
+{
+public:
+  /**
+   * Constructor. Creates the journal file and writes its header.
+   * @param path The path of the journal file.
+   */
+  explicit JournalWriter(const QString& path);
+
+  /**
+   * Records the start of a challenge pass and commits it without waiting (it is on the device at the latest when the first result is).
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param teamNumber The number of the team that does the pass.
+   * @param robotNumbers The jersey numbers of the participating robots.
+   * @param locationOrder The (zero-based) location indices in the order of the attempts.
+   * @param field The field of the pass (starting at 1, 0 if there is only one).
+   */
+  void writePassStart(std::int64_t timestamp, unsigned int teamNumber, const QVector<unsigned int>& robotNumbers, const QVector<int>& locationOrder, int field = 0);
+
+  /**
+   * Records the start of an attempt.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param attemptIndex The index of the attempt within the pass.
+   * @param locationIndex The (zero-based) location index of the attempt.
+   */
+  void writeAttemptStart(std::int64_t timestamp, int attemptIndex, int locationIndex);
+
+  /**
+   * Records the result of an attempt and commits it without waiting. The result should only be shown once \c committed has been called,
+   * so that it survives a crash right after it has been shown.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param attemptIndex The index of the attempt within the pass.
+   * @param locationIndex The (zero-based) location index of the attempt.
+   * @param remainingTime The time (µs) that was remaining when the whistle message arrived (-1 if the attempt has timed out).
+   * @param whistle The whistle report that has been scored (ignored if the attempt has timed out).
+   * @param components The parts of the score of the attempt.
+   * @param committed The function that is called on the writer thread once the result (and everything before it) is on the device (optional).
+   */
+  void writeAttemptResult(std::int64_t timestamp, int attemptIndex, int locationIndex, std::int64_t remainingTime,
+                          const DetectedWhistle& whistle, const Metric::ScoreComponents& components, LogWriter::Callback committed = LogWriter::Callback());
+
+  /**
+   * Records the end of a challenge pass.
+   * @param timestamp The time of the event (in nanoseconds of the monotonic clock).
+   * @param totalScore The total score of the pass (the sum of the finished attempts if it has been aborted).
+   * @param aborted Whether the pass has been aborted by the operator.
+   */
+  void writePassEnd(std::int64_t timestamp, float totalScore, bool aborted);
+
+private:
+  /**
+   * Appends a record to the journal.
+   * @param record The record.
+   */
+  void writeRecord(const Journal::Record& record);
+
+  LogWriter writer; /**< The writer that appends the records to the file in the background. */
+};
+
+class JournalReader
+{
+public:
+  /**
+   * Constructor. Maps a journal file into memory (or reads it if it cannot be mapped).
+   * @param path The path of the journal file.
+   */
+  explicit JournalReader(const QString& path);
+
+  /**
+   * Constructor. Reads a journal from memory (e.g. for benchmarks).
+   * @param data The contents of a journal file (must stay valid as long as this reader exists).
+   * @param size The size of the contents.
+   */
+  JournalReader(const unsigned char* data, std::size_t size);
+
+  /**
+   * Returns whether the file could be read and has a valid header.
+   * @return Whether the file could be read and has a valid header.
+   */
+  bool isValid() const;
+
+  /**
+   * Returns the number of complete records. A truncated record at the end (e.g. after a crash) is not counted.
+   * @return The number of records.
+   */
+  std::size_t getNumOfRecords() const;
+
+  /**
+   * Returns the encoded bytes of a record, i.e. the start of its columns.
+   * @param index The index of the record.
+   * @return The \c Journal::recordSize bytes of the record.
+   */
+  const unsigned char* getRecordData(std::size_t index) const
+  {
+    return records + index * Journal::recordSize;
+  }
+
+  /**
+   * Decodes a record.
+   * @param index The index of the record.
+   * @param record The decoded record.
+   */
+  void readRecord(std::size_t index, Journal::Record& record) const;
+
+  /**
+   * Finds the last pass of the journal if it has neither been finished nor aborted (e.g. because the program has crashed).
+   * @param pass The pass that is filled.
+   * @return Whether the last pass of the journal is unfinished.
+   */
+  bool findUnfinishedPass(Journal::UnfinishedPass& pass) const;
+
+private:
+  /**
+   * Checks the header and locates the records.
+   * @param data The contents of the journal file.
+   * @param size The size of the contents.
+   */
+  void open(const unsigned char* data, std::size_t size);
+
+  QFile file; /**< The journal file (if the journal has been read from a file). */
+  QByteArray contents; /**< The contents of the journal file if it could not be mapped. */
+  const unsigned char* records = nullptr; /**< The first record. */
+  std::size_t numOfRecords = 0; /**< The number of complete records. */
+  bool valid = false; /**< Whether the journal has a valid header. */
+};
@@ -0,0 +1,52 @@
+/**
+ * @file LatencyProfile.cpp
+ *
+ * This file implements a class that collects the latency distributions of the stages through which a whistle message passes.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "LatencyProfile.h"
+
+constexpr std::array<double, 5> LatencyProfile::percentiles;
+
+LatencyProfile& LatencyProfile::getInstance()
+{
+  static LatencyProfile instance;
+  return instance;
+}
+
+const char* LatencyProfile::getName(Stage stage)
+{
+  static const char* names[numOfStages] = {"arrival", "validation", "delivery", "scoring", "logging", "repaint"};
+  return names[stage];
+}
+
+void LatencyProfile::reset()
+{
+  for(LatencyHistogram& histogram : histograms)
+    histogram.reset();
+}
+
+QString LatencyProfile::toString() const
+{
+  QString result;
+  for(int stage = 0; stage < numOfStages; ++stage)
+  {
+    const LatencyHistogram& histogram = histograms[stage];
+    if(!histogram.getCount())
+      continue;
+    if(!result.isEmpty())
+      result += "\n";
+    result += QString(getName(static_cast<Stage>(stage))) + ": " + toString(histogram);
+  }
+  return result;
+}
+
+QString LatencyProfile::toString(const LatencyHistogram& histogram)
+{
+  QString result = "n=" + QString::number(histogram.getCount());
+  for(double percentile : percentiles)
+    result += (percentile == 100.0 ? QString(", max=") : ", p" + QString::number(percentile) + "=") + QString::number(histogram.getPercentile(percentile) / 1000.0, 'f', 1) + "us";
+  return result;
+}
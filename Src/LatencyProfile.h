@@ -0,0 +1,101 @@
+/**
+ * @file LatencyProfile.h
+ *
+ * This file declares a class that collects the latency distributions of the stages through which a whistle message passes,
+ * so that it can be told whether a late message has been delayed by the robot (or the network) or by the tester.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Util/LatencyHistogram.h"
+#include <QString>
+#include <array>
+#include <cstdint>
+
+class LatencyProfile
+{
+public:
+  /** The stages of the processing of a whistle message (in the order in which they are passed). */
+  enum Stage
+  {
+    arrival, /**< From the arrival at the network interface until the receiver reads the datagram (only with kernel timestamps). */
+    validation, /**< From reading the datagram until the whistle is in the queue (checks and capture). */
+    delivery, /**< From the queue until the challenge handles the whistle (signal delivery to the thread of the challenge). */
+    scoring, /**< The calculation of the score. */
+    logging, /**< From requesting a commit of the log until it has been synced to the device. */
+    repaint, /**< From the end of an attempt until the table is repainted (GUI only). */
+    numOfStages
+  };
+
+  /**
+   * This function returns the instance of the profile (which is shared by all passes of the process).
+   * @return A reference to the instance of the profile.
+   */
+  static LatencyProfile& getInstance();
+
+  /**
+   * Returns the name of a stage.
+   * @param stage The stage.
+   * @return The name of the stage.
+   */
+  static const char* getName(Stage stage);
+
+  /**
+   * Records the duration of a stage (may be called from any thread).
+   * @param stage The stage.
+   * @param duration The duration (ns).
+   */
+  void record(Stage stage, std::int64_t duration)
+  {
+    histograms[stage].record(duration);
+  }
+
+  /**
+   * Returns the histogram of a stage.
+   * @param stage The stage.
+   * @return The histogram of the stage.
+   */
+  LatencyHistogram& getHistogram(Stage stage)
+  {
+    return histograms[stage];
+  }
+
+  /**
+   * Returns the histogram of a stage.
+   * @param stage The stage.
+   * @return The histogram of the stage.
+   */
+  const LatencyHistogram& getHistogram(Stage stage) const
+  {
+    return histograms[stage];
+  }
+
+  /** Removes all recorded durations (e.g. at the start of a pass). */
+  void reset();
+
+  /**
+   * Returns the percentiles of all stages for which durations have been recorded as text (one line per stage).
+   * @return The percentiles (microseconds).
+   */
+  QString toString() const;
+
+  /**
+   * Returns the number of durations and the percentiles of a histogram as text.
+   * @param histogram The histogram.
+   * @return The number of durations followed by the percentiles (microseconds).
+   */
+  static QString toString(const LatencyHistogram& histogram);
+
+  static constexpr std::array<double, 5> percentiles = {{50.0, 90.0, 99.0, 99.9, 100.0}}; /**< The percentiles that are reported. */
+
+  LatencyProfile(const LatencyProfile&) = delete;
+  void operator=(const LatencyProfile&) = delete;
+
+private:
+  /** Constructor. */
+  LatencyProfile() = default;
+
+  std::array<LatencyHistogram, numOfStages> histograms; /**< The histogram of each stage. */
+};
@@ -0,0 +1,390 @@
+/**
+ * @file LogAnalyzer.cpp
+ *
+ * This file implements a class that rebuilds the challenge passes from the text logs that \c ChallengeLog writes.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "LogAnalyzer.h"
+#include "Util/ThreadPool.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  /** A cursor over the characters of a line that parses the parts of the line in place. */
+  class Scanner
+  {
+  public:
+    /**
+     * Constructor.
+     * @param begin The first character of the line.
+     * @param end The end of the line.
+     */
+    Scanner(const char* begin, const char* end) : position(begin), end(end) {}
+
+    /**
+     * Skips a literal if the line continues with it.
+     * @param literal The literal.
+     * @return Whether the line continues with the literal (otherwise, the cursor does not move).
+     */
+    bool skip(const char* literal)
+    {
+      const std::size_t length = std::strlen(literal);
+      if(static_cast<std::size_t>(end - position) < length || std::memcmp(position, literal, length))
+        return false;
+      position += length;
+      return true;
+    }
+
+    /**
+     * Parses a non-negative integer.
+     * @param value The value.
+     * @return Whether there has been at least one digit.
+     */
+    bool parseInt(int& value)
+    {
+      const char* start = position;
+      value = 0;
+      for(; position < end && *position >= '0' && *position <= '9' && value < 100000000; ++position)
+        value = value * 10 + (*position - '0');
+      return position != start;
+    }
+
+    /**
+     * Parses a floating point number as written by \c QTextStream or \c QString::number (independent of the locale).
+     * @param value The value.
+     * @return Whether there has been a number.
+     */
+    bool parseDouble(double& value)
+    {
+      const char* start = position;
+      const bool negative = position < end && *position == '-';
+      if(negative)
+        ++position;
+      double mantissa = 0.0;
+      int exponent = 0, digits = 0;
+      for(; position < end && *position >= '0' && *position <= '9'; ++position, ++digits)
+        mantissa = mantissa * 10.0 + (*position - '0');
+      if(position < end && *position == '.')
+        for(++position; position < end && *position >= '0' && *position <= '9'; ++position, ++digits, --exponent)
+          mantissa = mantissa * 10.0 + (*position - '0');
+      if(!digits)
+      {
+        position = start;
+        return false;
+      }
+      if(position < end && (*position == 'e' || *position == 'E'))
+      {
+        const char* exponentStart = position++;
+        const bool negativeExponent = position < end && *position == '-';
+        if(position < end && (*position == '-' || *position == '+'))
+          ++position;
+        int explicitExponent;
+        if(parseInt(explicitExponent))
+          exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        else
+          position = exponentStart;
+      }
+      // Dividing by an exact power of ten rounds correctly for the usual number of decimals.
+      value = exponent < 0 ? mantissa / std::pow(10.0, -exponent) : mantissa * std::pow(10.0, exponent);
+      if(negative)
+        value = -value;
+      return true;
+    }
+
+    /**
+     * Parses two floating point numbers that are separated by ", ".
+     * @param vector The vector.
+     * @return Whether there have been both numbers.
+     */
+    bool parseVector(Vector2D& vector)
+    {
+      double x, y;
+      if(!parseDouble(x) || !skip(", ") || !parseDouble(y))
+        return false;
+      vector = Vector2D(static_cast<float>(x), static_cast<float>(y));
+      return true;
+    }
+
+    /**
+     * Finds the last occurrence of a literal in the rest of the line.
+     * @param literal The literal.
+     * @return The position of the literal or nullptr if the rest of the line does not contain it.
+     */
+    const char* findLast(const char* literal) const
+    {
+      const std::size_t length = std::strlen(literal);
+      if(static_cast<std::size_t>(end - position) < length)
+        return nullptr;
+      for(const char* candidate = end - length; candidate >= position; --candidate)
+        if(!std::memcmp(candidate, literal, length))
+          return candidate;
+      return nullptr;
+    }
+
+    const char* position; /**< The next character. */
+    const char* end; /**< The end of the line. */
+  };
+
+  constexpr int maxAttemptNumber = 1000; /**< Attempt numbers above this are considered corrupt (so that they cannot allocate much memory). */
+
+  /**
+   * Returns the attempt with a given number, adding attempts to the pass if necessary.
+   * @param pass The pass.
+   * @param number The number of the attempt (starting at 1).
+   * @return The attempt or nullptr if the number is invalid.
+   */
+  LogAnalyzer::Attempt* getAttempt(LogAnalyzer::Pass& pass, int number)
+  {
+    if(number < 1 || number > maxAttemptNumber)
+      return nullptr;
+    if(pass.attempts.size() < number)
+      pass.attempts.resize(number);
+    return &pass.attempts[number - 1];
+  }
+
+  /**
+   * Sets the total score of a pass that has not been finished to the sum of the scores of its finished attempts.
+   * @param pass The pass.
+   */
+  void closeIncompletePass(LogAnalyzer::Pass& pass)
+  {
+    if(pass.status != LogAnalyzer::Pass::incomplete)
+      return;
+    pass.totalScore = 0.f;
+    for(const LogAnalyzer::Attempt& attempt : pass.attempts)
+      if(attempt.finished)
+        pass.totalScore += attempt.score;
+  }
+
+  /**
+   * Parses a line that belongs to a running pass.
+   * @param line The line after its timestamp.
+   * @param pass The pass.
+   * @param currentAttempt The index of the attempt to which indented lines belong (-1 if none).
+   * @return Whether the line ends the pass.
+   */
+  bool parsePassLine(Scanner& line, LogAnalyzer::Pass& pass, int& currentAttempt)
+  {
+    int number, location;
+    double value;
+    LogAnalyzer::Attempt* attempt;
+    if(line.skip("Started attempt "))
+    {
+      currentAttempt = -1;
+      if(line.parseInt(number) && line.skip(" from location ") && line.parseInt(location) && (attempt = getAttempt(pass, number)))
+        attempt->location = location;
+    }
+    else if(line.skip("Finished attempt "))
+    {
+      currentAttempt = -1;
+      if(line.parseInt(number) && line.skip(" from location ") && line.parseInt(location) && (attempt = getAttempt(pass, number)))
+      {
+        attempt->location = location;
+        attempt->finished = true;
+        attempt->timedOut = line.skip(" (timed out)");
+        if(attempt->timedOut)
+          attempt->remainingTime = -1.0;
+        currentAttempt = number - 1;
+      }
+    }
+    else if(line.skip("Resumed "))
+    {
+      if(line.parseInt(number) && line.skip(" attempts of the interrupted pass"))
+        pass.resumedAttempts = number;
+    }
+    else if(line.skip("Scoring rules: "))
+    {
+      QString error;
+      ScoringRules::Definition rules;
+      pass.hasRules = ScoringRules::fromJson(QByteArray(line.position, static_cast<int>(line.end - line.position)), rules, error);
+      if(pass.hasRules)
+        pass.rules = rules;
+    }
+    else if(line.skip("  "))
+    {
+      if(currentAttempt == -1)
+        return false;
+      attempt = &pass.attempts[currentAttempt];
+      if(line.skip("Remaining time: "))
+      {
+        if(line.parseDouble(value))
+          attempt->remainingTime = value;
+      }
+      else if(line.skip("Actual location: "))
+        line.parseVector(attempt->actualLocation);
+      else if(line.skip("Reported location: "))
+        line.parseVector(attempt->reportedLocation);
+      else if(line.skip("Reported field: "))
+        attempt->reportedOnSameField = line.skip("same");
+      else if(line.skip("Score: ") && line.parseDouble(value))
+        attempt->score = static_cast<float>(value);
+    }
+    else if(line.skip("Finished challenge pass of team "))
+    {
+      const char* const score = line.findLast(" with final score ");
+      line.position = score ? score : line.end;
+      if(score && line.skip(" with final score ") && line.parseDouble(value))
+      {
+        pass.status = LogAnalyzer::Pass::finished;
+        pass.totalScore = static_cast<float>(value);
+      }
+      else
+        closeIncompletePass(pass);
+      return true;
+    }
+    else if(line.skip("Aborted challenge pass of team "))
+    {
+      closeIncompletePass(pass);
+      pass.status = LogAnalyzer::Pass::aborted;
+      return true;
+    }
+    return false;
+  }
+}
+
+void LogAnalyzer::parse(const char* begin, const char* end, const QString& file, QVector<Pass>& passes)
+{
+  int currentPass = -1, currentAttempt = -1;
+  for(const char* lineBegin = begin; lineBegin < end;)
+  {
+    const char* lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', static_cast<std::size_t>(end - lineBegin)));
+    const char* const next = lineEnd ? lineEnd + 1 : end;
+    if(!lineEnd)
+      lineEnd = end;
+    if(lineEnd > lineBegin && lineEnd[-1] == '\r')
+      --lineEnd;
+
+    // Each line starts with a timestamp that is followed by ": ".
+    Scanner line(lineBegin, lineEnd);
+    const char* timestampEnd = lineBegin;
+    while(timestampEnd + 1 < lineEnd && (timestampEnd[0] != ':' || timestampEnd[1] != ' '))
+      ++timestampEnd;
+    line.position = timestampEnd + 2;
+    if(line.position > lineEnd)
+    {
+      lineBegin = next;
+      continue;
+    }
+
+    if(line.skip("Started challenge pass of team "))
+    {
+      if(currentPass != -1)
+        closeIncompletePass(passes[currentPass]);
+      currentPass = -1;
+      currentAttempt = -1;
+      const char* const robots = line.findLast(" with robots {");
+      if(robots)
+      {
+        Pass pass;
+        pass.file = file;
+        pass.startTime = QString::fromUtf8(lineBegin, static_cast<int>(timestampEnd - lineBegin));
+        pass.team = QString::fromUtf8(line.position, static_cast<int>(robots - line.position));
+        line.position = robots;
+        line.skip(" with robots {");
+        int robotNumber;
+        while(line.parseInt(robotNumber))
+        {
+          pass.robotNumbers.append(static_cast<unsigned int>(robotNumber));
+          line.skip(", ");
+        }
+        if(line.skip("}") && line.skip(" on field "))
+          line.parseInt(pass.field);
+        passes.append(pass);
+        currentPass = passes.size() - 1;
+      }
+    }
+    else if(currentPass != -1 && parsePassLine(line, passes[currentPass], currentAttempt))
+    {
+      currentPass = -1;
+      currentAttempt = -1;
+    }
+
+    lineBegin = next;
+  }
+  if(currentPass != -1)
+    closeIncompletePass(passes[currentPass]);
+}
+
+bool LogAnalyzer::parseFile(const QString& path, QVector<Pass>& passes)
+{
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+  const QString name = QFileInfo(path).fileName();
+  const qint64 size = file.size();
+  if(!size)
+    return true;
+
+  // Mapping avoids copying the log. Files that cannot be mapped (e.g. on some network shares) are read instead.
+  const uchar* data = file.map(0, size);
+  if(data)
+  {
+    parse(reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + size, name, passes);
+    return true;
+  }
+  const QByteArray contents = file.readAll();
+  parse(contents.constData(), contents.constData() + contents.size(), name, passes);
+  return contents.size() == size;
+}
+
+QVector<LogAnalyzer::Pass> LogAnalyzer::parseFiles(const QStringList& paths, ThreadPool& pool, QStringList& failedPaths)
+{
+  std::vector<QVector<Pass>> passesPerFile(static_cast<std::size_t>(paths.size()));
+  std::vector<char> succeeded(static_cast<std::size_t>(paths.size()));
+  pool.parallelFor(static_cast<std::size_t>(paths.size()), [&](unsigned, std::size_t index)
+  {
+    succeeded[index] = parseFile(paths[static_cast<int>(index)], passesPerFile[index]);
+  });
+
+  QVector<Pass> passes;
+  for(std::size_t i = 0; i < passesPerFile.size(); ++i)
+  {
+    if(!succeeded[i])
+      failedPaths.append(paths[static_cast<int>(i)]);
+    passes += passesPerFile[i];
+  }
+  return passes;
+}
+
+void LogAnalyzer::removeInterruptedPasses(QVector<Pass>& passes)
+{
+  std::vector<char> replaced(static_cast<std::size_t>(passes.size()));
+  for(int i = 0; i < passes.size(); ++i)
+  {
+    if(!passes[i].resumedAttempts)
+      continue;
+    for(int j = i - 1; j >= 0; --j)
+      if(!replaced[j] && passes[j].status == Pass::incomplete && passes[j].team == passes[i].team &&
+         passes[j].field == passes[i].field && passes[j].robotNumbers == passes[i].robotNumbers)
+      {
+        replaced[j] = true;
+        break;
+      }
+  }
+
+  int numOfKeptPasses = 0;
+  for(int i = 0; i < passes.size(); ++i)
+    if(!replaced[i])
+    {
+      if(numOfKeptPasses != i)
+        passes[numOfKeptPasses] = passes[i];
+      ++numOfKeptPasses;
+    }
+  passes.resize(numOfKeptPasses);
+}
+
+QStringList LogAnalyzer::findLogs(const QString& directory)
+{
+  const QDir dir(directory);
+  QStringList paths;
+  for(const QString& name : dir.entryList(QStringList("log_*.txt"), QDir::Files, QDir::Name))
+    paths.append(dir.filePath(name));
+  return paths;
+}
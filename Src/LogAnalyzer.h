@@ -0,0 +1,100 @@
+/**
+ * @file LogAnalyzer.h
+ *
+ * This file declares a class that rebuilds the challenge passes from the text logs that \c ChallengeLog writes,
+ * so that the scores of a tournament do not have to be collected by hand.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "ScoringRules.h"
+#include "Util/Vector2D.h"
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <cstdint>
+
+class ThreadPool;
+
+class LogAnalyzer
+{
+public:
+  /** An attempt as far as it can be rebuilt from a log. */
+  struct Attempt
+  {
+    int location = 0; /**< The number of the whistle location (starting at 1, 0 if the attempt has not been started). */
+    bool finished = false; /**< Whether the attempt has been finished. */
+    bool timedOut = false; /**< Whether the attempt has timed out. */
+    double remainingTime = -1.0; /**< The time (ms) that was remaining when the whistle message arrived (-1 if it timed out). */
+    Vector2D actualLocation; /**< The ground-truth position of the whistle. */
+    Vector2D reportedLocation; /**< The location reported by the robots. */
+    bool reportedOnSameField = false; /**< The "same field"/"other field" decision of the robots. */
+    float score = 0.f; /**< The score of the attempt. */
+  };
+
+  /** A challenge pass as far as it can be rebuilt from a log. */
+  struct Pass
+  {
+    enum Status
+    {
+      incomplete, /**< The log ends (or another pass starts) before the pass has been finished. */
+      finished, /**< The pass has been finished with a final score. */
+      aborted /**< The pass has been aborted by the operator. */
+    };
+
+    QString file; /**< The log file in which the pass has been found. */
+    QString startTime; /**< The time at which the pass has been started (as written in the log). */
+    QString team; /**< The team as written in the log (a name, or a number in logs of the tournament mode). */
+    QVector<unsigned int> robotNumbers; /**< The jersey numbers of the robots. */
+    int field = 0; /**< The field on which the pass has been done (starting at 1, 0 if the log does not say). */
+    int resumedAttempts = 0; /**< The number of attempts that have been restored from an interrupted pass (0 if the pass has not been resumed). */
+    bool hasRules = false; /**< Whether the log contains the scoring rules of the pass (logs of older versions do not). */
+    ScoringRules::Definition rules; /**< The scoring rules with which the pass has been scored (if \c hasRules is set). */
+    QVector<Attempt> attempts; /**< The attempts in the order in which they were done. */
+    Status status = incomplete; /**< Whether the pass has been finished. */
+    float totalScore = 0.f; /**< The final score (if the pass has been finished) or the sum of the scores of the finished attempts. */
+  };
+
+  /**
+   * Rebuilds the passes from the text of a log. Lines are scanned in place (nothing is allocated per line),
+   * only the passes themselves (and their scoring rules) are allocated. Lines that do not belong to a pass are ignored.
+   * @param begin The first character of the log.
+   * @param end The end of the log.
+   * @param file The name of the log file (copied into the passes).
+   * @param passes The passes of the log are appended to this list.
+   */
+  static void parse(const char* begin, const char* end, const QString& file, QVector<Pass>& passes);
+
+  /**
+   * Rebuilds the passes from a log file, which is mapped into memory.
+   * @param path The path of the log file.
+   * @param passes The passes of the log are appended to this list.
+   * @return Whether the file could be read.
+   */
+  static bool parseFile(const QString& path, QVector<Pass>& passes);
+
+  /**
+   * Rebuilds the passes from many log files on all threads of a pool.
+   * @param paths The paths of the log files.
+   * @param pool The threads that parse the files.
+   * @param failedPaths The paths of the files that could not be read are appended to this list.
+   * @return The passes of all files, in the order of the paths (and in the order of the passes within a file).
+   */
+  static QVector<Pass> parseFiles(const QStringList& paths, ThreadPool& pool, QStringList& failedPaths);
+
+  /**
+   * Removes the incomplete passes that have been resumed later. The log of a resumed pass contains the restored attempts again,
+   * so the interrupted pass would count them twice. Each resumed pass replaces the last incomplete pass before it with the same team, field and robots.
+   * @param passes The passes in the order in which they have been done (e.g. as returned by \c parseFiles).
+   */
+  static void removeInterruptedPasses(QVector<Pass>& passes);
+
+  /**
+   * Finds all logs in a directory.
+   * @param directory The directory.
+   * @return The paths of all files that match log_*.txt, sorted by name (i.e. by the time at which they have been created).
+   */
+  static QStringList findLogs(const QString& directory);
+};
@@ -0,0 +1,235 @@
+/**
+ * @file LogWriter.cpp
+ *
+ * This file implements a class that appends records to a file in a background thread and commits them to the device in groups.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "LogWriter.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include "Util/LatencyHistogram.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+#ifdef __unix__
+#include <QFile>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LogWriter::LogWriter(const QString& path, LatencyHistogram* commitLatency, Source source) :
+  source(std::move(source)),
+  commitLatency(commitLatency)
+#ifndef __unix__
+  , file(path)
+#endif
+{
+  group.reserve(ringSize);
+
+#ifdef __unix__
+  fd = open(QFile::encodeName(path).constData(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  struct stat status;
+  if(fd >= 0 && fstat(fd, &status) == 0)
+    fileSize = allocatedSize = status.st_size;
+#else
+  file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text | QIODevice::Unbuffered);
+#endif
+
+  // The writer thread tags its events with the field on which the writer has been created.
+  const int traceField = Tracer::getField();
+  thread = std::thread([this, traceField]
+  {
+    Tracer::setField(traceField);
+    run();
+  });
+}
+
+LogWriter::~LogWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopRequested = true;
+  }
+  recordsAvailable.notify_one();
+  thread.join();
+
+#ifdef __unix__
+  if(fd >= 0)
+    close(fd);
+#endif
+}
+
+void LogWriter::append(const QByteArray& record)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  spaceAvailable.wait(lock, [this]{ return ringCount < ringSize; });
+  ring[(ringHead + ringCount) % ringSize] = record;
+  ++ringCount;
+  ++appendedRecords;
+  const bool first = ringCount == 1;
+  lock.unlock();
+
+  // The writer thread only has to be woken up to start the commit interval.
+  if(first)
+    recordsAvailable.notify_one();
+}
+
+void LogWriter::commit()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!commitRequested)
+      commitRequestTime = Clock::getTime();
+    commitRequested = true;
+  }
+  recordsAvailable.notify_one();
+}
+
+void LogWriter::commit(Callback committed)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    callbacks.emplace_back(appendedRecords, std::move(committed));
+    if(!commitRequested)
+      commitRequestTime = Clock::getTime();
+    commitRequested = true;
+  }
+  recordsAvailable.notify_one();
+}
+
+void LogWriter::sync()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  const std::uint64_t target = appendedRecords;
+  if(!commitRequested)
+    commitRequestTime = Clock::getTime();
+  commitRequested = true;
+  recordsAvailable.notify_one();
+  recordsCommitted.wait(lock, [this, target]{ return committedRecords >= target; });
+}
+
+void LogWriter::notifySource(bool commitNow)
+{
+  sourcePending.store(true, std::memory_order_relaxed);
+  if(commitNow)
+    sourceCommitRequested.store(true, std::memory_order_relaxed);
+  recordsAvailable.notify_one();
+}
+
+void LogWriter::run()
+{
+  TRACE_THREAD_NAME("LogWriter");
+  std::unique_lock<std::mutex> lock(mutex);
+  while(true)
+  {
+    const auto pending = [this]{ return ringCount > 0 || !callbacks.empty() || stopRequested || sourcePending.load(std::memory_order_relaxed); };
+    // The source is notified without the mutex, so its notification may be missed and the thread must check it regularly.
+    if(source)
+      while(!recordsAvailable.wait_for(lock, std::chrono::milliseconds(commitInterval), pending));
+    else
+      recordsAvailable.wait(lock, pending);
+    // Records that arrive during the commit interval are committed together with the first one.
+    recordsAvailable.wait_for(lock, std::chrono::milliseconds(commitInterval), [this]
+    {
+      return commitRequested || stopRequested || ringCount == ringSize || sourceCommitRequested.load(std::memory_order_relaxed);
+    });
+
+    group.clear();
+    for(; ringCount > 0; --ringCount)
+    {
+      group.emplace_back();
+      group.back().swap(ring[ringHead]);
+      ringHead = (ringHead + 1) % ringSize;
+    }
+    const std::uint64_t target = appendedRecords;
+    const bool stop = stopRequested;
+    const std::int64_t requestTime = commitRequested ? commitRequestTime : 0;
+    commitRequested = false;
+    lock.unlock();
+    spaceAvailable.notify_all();
+
+    if(source)
+    {
+      // Records that the source receives after this are marked as pending again.
+      sourcePending.store(false, std::memory_order_relaxed);
+      sourceCommitRequested.store(false, std::memory_order_relaxed);
+      source(group);
+    }
+
+    if(!group.empty())
+    {
+      writeRecords(group);
+      if(commitLatency && requestTime)
+        commitLatency->record(Clock::getTime() - requestTime);
+    }
+
+    lock.lock();
+    committedRecords = target;
+    recordsCommitted.notify_all();
+    // The callbacks are ordered by their targets, but those that have been added after the group has been taken may wait for records that are still in the ring.
+    const auto firstWaiting = std::find_if(callbacks.begin(), callbacks.end(), [target](const std::pair<std::uint64_t, Callback>& callback)
+    {
+      return callback.first > target;
+    });
+    committedCallbacks.clear();
+    for(auto callback = callbacks.begin(); callback != firstWaiting; ++callback)
+      committedCallbacks.emplace_back(std::move(callback->second));
+    callbacks.erase(callbacks.begin(), firstWaiting);
+    if(!committedCallbacks.empty())
+    {
+      lock.unlock();
+      for(const Callback& callback : committedCallbacks)
+        callback();
+      lock.lock();
+    }
+    if(stop && ringCount == 0)
+      break;
+  }
+}
+
+void LogWriter::writeRecords(const std::vector<QByteArray>& records)
+{
+  TRACE_SCOPE("writeRecords", "records", static_cast<std::int64_t>(records.size()));
+  buffer.clear();
+  for(const QByteArray& record : records)
+    buffer.append(record);
+
+#ifdef __unix__
+  if(fd < 0)
+    return;
+
+#ifdef __linux__
+  // Preallocating the blocks means that a data sync does not have to allocate them (KEEP_SIZE avoids zeros at the end after a crash).
+  if(fileSize + buffer.size() > allocatedSize)
+  {
+    const std::int64_t newAllocatedSize = (fileSize + buffer.size() + preallocationSize - 1) / preallocationSize * preallocationSize;
+    if(fallocate(fd, FALLOC_FL_KEEP_SIZE, allocatedSize, newAllocatedSize - allocatedSize) == 0)
+      allocatedSize = newAllocatedSize;
+  }
+#endif
+
+  const char* data = buffer.constData();
+  std::size_t remaining = static_cast<std::size_t>(buffer.size());
+  while(remaining > 0)
+  {
+    const ssize_t written = write(fd, data, remaining);
+    if(written < 0)
+    {
+      if(errno == EINTR)
+        continue;
+      return;
+    }
+    data += written;
+    remaining -= static_cast<std::size_t>(written);
+  }
+  fileSize += buffer.size();
+  fdatasync(fd);
+#else
+  file.write(buffer);
+  file.flush();
+#endif
+}
@@ -0,0 +1,126 @@
+/**
+ * @file LogWriter.h
+ *
+ * This file declares a class that appends records to a file in a background thread and commits them to the device in groups.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#ifndef __unix__
+#include <QFile>
+#endif
+
+class LatencyHistogram;
+
+class LogWriter
+{
+public:
+  /**
+   * A function that is called by the writer thread before each group is committed and appends further records to the group.
+   * It allows other threads to hand over records through their own lock-free buffers instead of \c append.
+   */
+  using Source = std::function<void(std::vector<QByteArray>& group)>;
+
+  /** A function that is called by the writer thread once the records that precede it have been synced to the device. */
+  using Callback = std::function<void()>;
+
+  /**
+   * Constructor. Opens the file for appending and starts the writer thread.
+   * @param path The path of the file to which records are appended.
+   * @param commitLatency A histogram into which the time from each commit request until the records have been synced is recorded (optional).
+   * @param source A function that supplies further records on the writer thread (optional).
+   */
+  explicit LogWriter(const QString& path, LatencyHistogram* commitLatency = nullptr, Source source = Source());
+
+  /** Destructor. Commits all pending records and stops the writer thread. */
+  ~LogWriter();
+
+  LogWriter(const LogWriter&) = delete;
+  void operator=(const LogWriter&) = delete;
+
+  /**
+   * Appends a record to the in-memory ring. The record is committed to the device within the commit interval.
+   * This only blocks if the ring is full.
+   * @param record The bytes to append to the file.
+   */
+  void append(const QByteArray& record);
+
+  /** Requests that all records that have been appended so far are committed immediately (e.g. at an attempt boundary) without waiting for it. */
+  void commit();
+
+  /**
+   * Requests that all records that have been appended so far are committed immediately and reports when they are on the device.
+   * This does not wait, so it can be called from the event loop.
+   * @param committed The function that is called on the writer thread once the records have been synced (it must not call this writer).
+   */
+  void commit(Callback committed);
+
+  /** Commits all records that have been appended so far and waits until they have been synced to the device. */
+  void sync();
+
+  /**
+   * Tells the writer thread that the source has records. This does not lock, so it can be called from threads that must not block.
+   * If the notification gets lost in a race, the records are still committed after the commit interval.
+   * @param commitNow Whether the records should be committed without waiting for the commit interval (e.g. because the buffer of the source is filling up).
+   */
+  void notifySource(bool commitNow);
+
+private:
+  static constexpr std::size_t ringSize = 1024; /**< The maximum number of records that can be pending. */
+  static constexpr int commitInterval = 100; /**< The maximum time (ms) that a record stays pending if no commit is requested. */
+  static constexpr std::int64_t preallocationSize = 1 << 20; /**< The granularity (bytes) in which space for the file is preallocated. */
+
+  /** The main function of the writer thread. */
+  void run();
+
+  /**
+   * Writes a group of records to the file and syncs its data to the device.
+   * @param records The records to write.
+   */
+  void writeRecords(const std::vector<QByteArray>& records);
+
+  std::mutex mutex; /**< The mutex that protects the ring and the state below. */
+  std::condition_variable recordsAvailable; /**< Notifies the writer thread about new records or commit requests. */
+  std::condition_variable spaceAvailable; /**< Notifies producers that the ring is no longer full. */
+  std::condition_variable recordsCommitted; /**< Notifies waiting producers that a group has been committed. */
+  std::array<QByteArray, ringSize> ring; /**< The ring of pending records. */
+  std::size_t ringHead = 0; /**< The index of the oldest pending record in the ring. */
+  std::size_t ringCount = 0; /**< The number of pending records in the ring. */
+  std::uint64_t appendedRecords = 0; /**< The number of records that have been appended since construction. */
+  std::uint64_t committedRecords = 0; /**< The number of records that have been committed since construction. */
+  std::vector<std::pair<std::uint64_t, Callback>> callbacks; /**< The functions that wait for a commit, with the number of records that must have been committed before each is called. */
+  bool commitRequested = false; /**< Whether the pending records should be committed without waiting for the commit interval. */
+  std::int64_t commitRequestTime = 0; /**< The time at which the pending commit has been requested. */
+  bool stopRequested = false; /**< Whether the writer thread should terminate after committing the pending records. */
+  std::atomic<bool> sourcePending{false}; /**< Whether the source has records that have not been committed yet. */
+  std::atomic<bool> sourceCommitRequested{false}; /**< Whether the records of the source should be committed without waiting for the commit interval. */
+
+  Source source; /**< The function that supplies further records on the writer thread (if any). */
+
+  LatencyHistogram* commitLatency; /**< The histogram of commit latencies (nullptr if they are not recorded). */
+  std::vector<QByteArray> group; /**< The records that are currently being committed (only used by the writer thread). */
+  std::vector<Callback> committedCallbacks; /**< The functions that are called after the current group has been committed (only used by the writer thread). */
+  QByteArray buffer; /**< The concatenation of the records in the current group (only used by the writer thread). */
+#ifdef __unix__
+  int fd = -1; /**< The descriptor of the file. */
+  std::int64_t fileSize = 0; /**< The current size of the file. */
+  std::int64_t allocatedSize = 0; /**< The size up to which space has been preallocated. */
+#else
+  QFile file; /**< The file. */
+#endif
+  std::thread thread; /**< The writer thread. */
+};
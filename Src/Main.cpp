@@ -7,12 +7,22 @@
  */
 
 #include "MainWindow.h"
+#include "ScoringRules.h"
 #include <QApplication>
+#include <QMessageBox>
 
 int main(int argc, char* argv[])
 {
   QApplication app(argc, argv);
 
+  // Invalid rules must be noticed before any pass is started, not when the first attempt is scored.
+  QString error;
+  if(!ScoringRules::loadConfiguredDefinition(error))
+  {
+    QMessageBox::critical(nullptr, "Invalid Scoring Rules", error);
+    return 2;
+  }
+
   MainWindow window;
   window.show();
 
@@ -7,18 +7,30 @@
  */
 
 #include "MainWindow.h"
+#include "Capture.h"
 #include "Challenge.h"
 #include "ChallengeLog.h"
 #include "ChallengeStartDialog.h"
+#include "Journal.h"
+#include "LatencyProfile.h"
 #include "SPLStandardMessageReceiver.h"
+#include "ScoringRules.h"
 #include "TeamList.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
 #include "Util/Paths.h"
 #include "Util/Reader.h"
+#include <QDateTime>
+#include <QEvent>
 #include <QHBoxLayout>
 #include <QHeaderView>
+#include <QLabel>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QStringList>
 #include <QTableView>
+#include <QThread>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <QWidget>
 
@@ -28,12 +40,33 @@ MainWindow::MainWindow(QWidget* parent) :
   ChallengeLog() << "Started DirectionWhistleTester";
   Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
   Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+  // The suggestions for the start dialog are loaded from the cache or calculated while the user does not need them yet.
+  subsetRatingsFuture = std::async(std::launch::async, &SubsetPlanner::plan, robotPoses, whistleLocations, ScoringRules::getConfiguredDefinition());
+  // A pass that has been interrupted by a crash is at the end of the most recent journal (which must be read before the new one is created).
+  Journal::UnfinishedPass unfinishedPass;
+  QStringList journals;
+  for(const QString& path : Journal::findJournals(Paths::getLogPath()))
+    if(!path.contains("_field"))
+      journals.append(path);
+  const bool resumable = !journals.isEmpty() && JournalReader(journals.last()).findUnfinishedPass(unfinishedPass) &&
+                         unfinishedPass.fits(robotPoses.size(), whistleLocations.size()) &&
+                         !TeamList::getInstance().getTeamNameByNumber(unfinishedPass.teamNumber).isEmpty();
+  const QString suffix = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
+  captureWriter.reset(new CaptureWriter(Paths::getLogPath() + "/capture_" + suffix + ".dwc"));
+  journalWriter.reset(new JournalWriter(Paths::getLogPath() + "/journal_" + suffix + ".dwj"));
 
   auto* centralWidget = new QWidget(this);
 
   challengeStartButton = new QPushButton("&Start Challenge...", this);
   attemptStartButton = new QPushButton("Start &Attempt", this);
   attemptStartButton->setEnabled(false);
+  latencyButton = new QPushButton("Show &Latency", this);
+
+  ingressLabel = new QLabel(this);
+  ingressLabel->setTextFormat(Qt::PlainText);
+  auto* ingressTimer = new QTimer(this);
+  connect(ingressTimer, &QTimer::timeout, this, &MainWindow::updateIngressLabel);
+  ingressTimer->start(1000);
 
   challengeView = new QTableView(this);
   challengeView->setCornerButtonEnabled(false);
@@ -43,6 +76,7 @@ MainWindow::MainWindow(QWidget* parent) :
   challengeView->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Minimum);
   challengeView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   challengeView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+  challengeView->viewport()->installEventFilter(this);
 
   connect(challengeStartButton, &QPushButton::clicked, this, [this]
   {
@@ -58,36 +92,13 @@ MainWindow::MainWindow(QWidget* parent) :
       }
     }
 
-    ChallengeStartDialog dialog(robotPoses.size(), this);
+    if(subsetRatingsFuture.valid())
+      subsetRatings = subsetRatingsFuture.get();
+    ChallengeStartDialog dialog(robotPoses.size(), subsetRatings, this);
     if(dialog.exec() != QDialog::Accepted)
       return;
 
-    delete receiver;
-    delete challenge;
-
-    ChallengeLog() << "Started challenge pass of team " << dialog.getTeamName() << " with robots " << dialog.getRobotNumbers();
-
-    QVector<Pose2D> robotSetup;
-    for(unsigned int jerseyNumber : dialog.getRobotNumbers())
-      robotSetup.append(robotPoses[jerseyNumber - 1]);
-
-    receiver = new SPLStandardMessageReceiver(TeamList::getInstance().getTeamNumberByName(dialog.getTeamName()), this);
-    challenge = new Challenge(whistleLocations, robotSetup, this);
-    challengeView->setModel(challenge);
-    challengeView->setFixedSize(challengeView->horizontalHeader()->length() + challengeView->verticalHeader()->width(),
-                                challengeView->verticalHeader()->length() + challengeView->horizontalHeader()->height());
-
-    const QString teamName = dialog.getTeamName();
-    connect(receiver, &SPLStandardMessageReceiver::whistleLocationReceived, challenge, &Challenge::handleWhistleLocation);
-    connect(attemptStartButton, &QPushButton::clicked, challenge, &Challenge::startAttempt);
-    connect(challenge, &Challenge::attemptFinished, this, [this, teamName]
-    {
-      if(!challenge->isFinished())
-        attemptStartButton->setEnabled(true);
-      else
-        ChallengeLog() << "Finished challenge pass of team " << teamName << " with final score " << challenge->getTotalScore();
-    });
-    attemptStartButton->setEnabled(true);
+    startPass(dialog.getTeamName(), dialog.getRobotNumbers());
   });
 
   connect(attemptStartButton, &QPushButton::clicked, this, [this]
@@ -95,15 +106,178 @@ MainWindow::MainWindow(QWidget* parent) :
     attemptStartButton->setEnabled(false);
   });
 
+  connect(latencyButton, &QPushButton::clicked, this, [this]
+  {
+    const QString percentiles = LatencyProfile::getInstance().toString();
+    QMessageBox::information(this, "Latency", percentiles.isEmpty() ? "No whistle messages have been handled yet." : percentiles);
+  });
+
   auto* buttonLayout = new QVBoxLayout;
   buttonLayout->setSpacing(20);
   buttonLayout->addWidget(challengeStartButton);
   buttonLayout->addWidget(attemptStartButton);
   buttonLayout->addStretch();
+  buttonLayout->addWidget(ingressLabel);
+  buttonLayout->addWidget(latencyButton);
 
   auto* layout = new QHBoxLayout(centralWidget);
   layout->addLayout(buttonLayout);
   layout->addWidget(challengeView);
 
   setCentralWidget(centralWidget);
+
+  if(resumable)
+    QTimer::singleShot(0, this, [this, unfinishedPass]
+    {
+      const QString teamName = TeamList::getInstance().getTeamNameByNumber(unfinishedPass.teamNumber);
+      const QString question = QString("The pass of team %1 has been interrupted after %2 of %3 attempts.\nDo you want to resume it?")
+                               .arg(teamName).arg(unfinishedPass.results.size()).arg(unfinishedPass.locationOrder.size());
+      if(QMessageBox::question(this, "Resume Pass", question, QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+        startPass(teamName, unfinishedPass.robotNumbers, &unfinishedPass);
+    });
+}
+
+MainWindow::~MainWindow()
+{
+  delete challenge;
+  challenge = nullptr;
+  stopReceiver();
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event)
+{
+  if(event->type() == QEvent::Paint && watched == challengeView->viewport())
+  {
+    TRACE_INSTANT("repaint");
+    // The model coalesces changes, so this includes the time until the table is told about the new score.
+    if(attemptFinishTime)
+    {
+      LatencyProfile::getInstance().record(LatencyProfile::repaint, Clock::getTime() - attemptFinishTime);
+      attemptFinishTime = 0;
+    }
+  }
+  return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::startPass(const QString& teamName, const QVector<unsigned int>& robotNumbers, const Journal::UnfinishedPass* resumedPass)
+{
+  if(challenge && !challenge->isFinished())
+    journalWriter->writePassEnd(Clock::getTime(), challenge->getTotalScore(), true);
+  delete challenge;
+  stopReceiver();
+
+  ChallengeLog() << "Started challenge pass of team " << teamName << " with robots " << robotNumbers;
+  ChallengeLog() << "Scoring rules: " << ScoringRules::toJson(ScoringRules::getConfiguredDefinition());
+  if(resumedPass)
+    ChallengeLog() << "Resumed " << resumedPass->results.size() << " attempts of the interrupted pass";
+  ChallengeLog::commit();
+
+  QVector<Pose2D> robotSetup;
+  for(unsigned int jerseyNumber : robotNumbers)
+    robotSetup.append(robotPoses[jerseyNumber - 1]);
+
+  const unsigned int teamNumber = TeamList::getInstance().getTeamNumberByName(teamName);
+  receiver = new SPLStandardMessageReceiver(teamNumber);
+  receiver->setCaptureWriter(captureWriter.get());
+  LatencyProfile::getInstance().reset();
+  if(Tracer::isEnabled())
+    Tracer::clear();
+  lastIngress.fill(0);
+  lastQueueFull = 0;
+  lastCaptureDropped = 0;
+  receiverThread = new QThread(this);
+  receiverThread->setObjectName("Receiver");
+  receiver->moveToThread(receiverThread);
+  connect(receiverThread, &QThread::finished, receiver, &QObject::deleteLater);
+  challenge = resumedPass ? new Challenge(whistleLocations, robotSetup, resumedPass->locationOrder, this) : new Challenge(whistleLocations, robotSetup, this);
+  challenge->setWhistleQueue(&receiver->getWhistleQueue());
+  challenge->setCaptureWriter(captureWriter.get());
+  challenge->setJournalWriter(journalWriter.get());
+
+  Capture::PassStart passStart;
+  passStart.teamNumber = teamNumber;
+  passStart.robotNumbers = robotNumbers;
+  for(const Challenge::Attempt& attempt : challenge->getAttempts())
+    passStart.locationOrder.append(attempt.locationIndex);
+  captureWriter->writePassStart(Clock::getTime(), passStart);
+  journalWriter->writePassStart(Clock::getTime(), teamNumber, robotNumbers, passStart.locationOrder);
+  if(resumedPass)
+    challenge->resume(resumedPass->results);
+  challengeView->setModel(challenge);
+  challengeView->setFixedSize(challengeView->horizontalHeader()->length() + challengeView->verticalHeader()->width(),
+                              challengeView->verticalHeader()->length() + challengeView->horizontalHeader()->height());
+
+  connect(receiver, &SPLStandardMessageReceiver::whistleLocationsReceived, challenge, &Challenge::handleReceivedWhistles);
+  connect(attemptStartButton, &QPushButton::clicked, challenge, &Challenge::startAttempt);
+  connect(challenge, &Challenge::attemptFinished, this, [this, teamName]
+  {
+    attemptFinishTime = Clock::getTime();
+    ChallengeLog() << "Ingress: " << receiver->getCounters().toString();
+    if(!challenge->isFinished())
+      attemptStartButton->setEnabled(true);
+    else
+    {
+      ChallengeLog() << "Finished challenge pass of team " << teamName << " with final score " << challenge->getTotalScore();
+      for(const QString& line : LatencyProfile::getInstance().toString().split('\n', QString::SkipEmptyParts))
+        ChallengeLog() << "Latency of " << line;
+      if(Tracer::isEnabled())
+      {
+        const QString tracePath = Paths::getLogPath() + "/trace_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".json";
+        if(Tracer::write(tracePath))
+          ChallengeLog() << "Wrote trace to " << tracePath;
+      }
+      ChallengeLog::commit();
+    }
+  });
+  attemptStartButton->setEnabled(!challenge->isFinished());
+  receiverThread->start(QThread::TimeCriticalPriority);
+}
+
+void MainWindow::stopReceiver()
+{
+  if(!receiverThread)
+    return;
+
+  receiverThread->quit();
+  receiverThread->wait();
+  delete receiverThread;
+  receiverThread = nullptr;
+  receiver = nullptr;
+}
+
+void MainWindow::updateIngressLabel()
+{
+  if(!receiver)
+  {
+    ingressLabel->clear();
+    return;
+  }
+
+  TRACE_SCOPE("updateIngressLabel");
+  // The timer fires once per second, so the differences are rates per second.
+  const SPLStandardMessageReceiver::Counters& counters = receiver->getCounters();
+  std::uint64_t received = 0;
+  std::uint64_t whistles = 0;
+  QString drops;
+  for(int verdict = 0; verdict < SPLStandardMessageReceiver::numOfVerdicts; ++verdict)
+  {
+    const std::uint64_t count = counters.get(static_cast<SPLStandardMessageReceiver::Verdict>(verdict));
+    const std::uint64_t rate = count - lastIngress[verdict];
+    lastIngress[verdict] = count;
+    received += rate;
+    if(verdict == SPLStandardMessageReceiver::valid)
+      whistles = rate;
+    else if(verdict != SPLStandardMessageReceiver::otherVersion && rate)
+      drops += QString("\n") + SPLStandardMessageReceiver::getName(static_cast<SPLStandardMessageReceiver::Verdict>(verdict)) + ": " + QString::number(rate) + "/s";
+  }
+  const std::uint64_t queueFull = counters.getQueueFull();
+  if(queueFull != lastQueueFull)
+    drops += "\nqueueFull: " + QString::number(queueFull - lastQueueFull) + "/s";
+  lastQueueFull = queueFull;
+  const std::uint64_t captureDropped = counters.getCaptureDropped();
+  if(captureDropped != lastCaptureDropped)
+    drops += "\ncaptureDropped: " + QString::number(captureDropped - lastCaptureDropped) + "/s";
+  lastCaptureDropped = captureDropped;
+
+  ingressLabel->setText("Received: " + QString::number(received) + "/s\nWhistles: " + QString::number(whistles) + "/s" + drops);
 }
@@ -8,15 +8,25 @@
 
 #pragma once
 
+#include "SPLStandardMessageReceiver.h"
+#include "SubsetPlanner.h"
 #include "Util/Pose2D.h"
 #include "Util/Vector2D.h"
 #include <QMainWindow>
 #include <QVector>
+#include <array>
+#include <cstdint>
+#include <future>
+#include <memory>
 
+class CaptureWriter;
 class Challenge;
-class SPLStandardMessageReceiver;
+class JournalWriter;
+class QLabel;
 class QPushButton;
 class QTableView;
+class QThread;
+namespace Journal { struct UnfinishedPass; }
 
 class MainWindow : public QMainWindow
 {
@@ -28,12 +38,49 @@ public:
    */
   explicit MainWindow(QWidget* parent = nullptr);
 
+  /** Destructor. Stops the receiver thread. */
+  ~MainWindow() override;
+
+protected:
+  /**
+   * Measures the time until the table is repainted after an attempt has been finished.
+   * @param watched The object to which the event is sent.
+   * @param event The event.
+   * @return Whether the event has been handled (always false).
+   */
+  bool eventFilter(QObject* watched, QEvent* event) override;
+
 private:
+  /**
+   * Starts a challenge pass (aborting the running one, if any).
+   * @param teamName The name of the team.
+   * @param robotNumbers The jersey numbers of the participating robots.
+   * @param resumedPass The interrupted pass whose location order and finished attempts are restored (nullptr to start a new pass).
+   */
+  void startPass(const QString& teamName, const QVector<unsigned int>& robotNumbers, const Journal::UnfinishedPass* resumedPass = nullptr);
+
+  /** Stops the receiver thread (if it is running). The receiver is deleted in its thread. */
+  void stopReceiver();
+
+  /** Updates the label that displays the rates at which datagrams are received and dropped by the current receiver. */
+  void updateIngressLabel();
+
   QPushButton* challengeStartButton = nullptr; /**< A button that starts a challenge pass. */
   QPushButton* attemptStartButton = nullptr; /**< A button that starts an attempt within a challenge pass. */
+  QPushButton* latencyButton = nullptr; /**< A button that shows the latency percentiles of all stages. */
   QTableView* challengeView = nullptr; /**< A table view that displays the results of the challenge. */
+  QLabel* ingressLabel = nullptr; /**< A label that displays the rates at which datagrams are received and dropped. */
   Challenge* challenge = nullptr; /**< The currently running challenge pass. */
-  SPLStandardMessageReceiver* receiver = nullptr; /**< The receiver for SPL messages for the currently running challenge pass. */
+  SPLStandardMessageReceiver* receiver = nullptr; /**< The receiver for SPL messages for the currently running challenge pass (lives in \c receiverThread). */
+  QThread* receiverThread = nullptr; /**< The thread in which messages are received so that they are not delayed by the GUI. */
+  std::array<std::uint64_t, SPLStandardMessageReceiver::numOfVerdicts> lastIngress = {}; /**< The counters of the receiver at the previous update of the ingress label. */
+  std::int64_t attemptFinishTime = 0; /**< The time at which the last attempt has been finished if the table has not been repainted since (0 otherwise). */
+  std::uint64_t lastQueueFull = 0; /**< The number of whistles dropped due to a full queue at the previous update of the ingress label. */
+  std::uint64_t lastCaptureDropped = 0; /**< The number of datagrams missing from the capture at the previous update of the ingress label. */
+  std::unique_ptr<CaptureWriter> captureWriter; /**< The capture of all received datagrams and attempts of this program run. */
+  std::unique_ptr<JournalWriter> journalWriter; /**< The result journal of all passes of this program run. */
   QVector<Vector2D> whistleLocations; /**< The set of locations from which the whistle is blown. */
   QVector<Pose2D> robotPoses; /**< The set of poses at which robots can be placed. */
+  std::future<QVector<SubsetPlanner::Rating>> subsetRatingsFuture; /**< The ratings of the robot subsets while they are calculated in the background. */
+  QVector<SubsetPlanner::Rating> subsetRatings; /**< The ratings of the robot subsets (once they have been taken from the future). */
 };
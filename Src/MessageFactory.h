@@ -0,0 +1,87 @@
+/**
+ * @file MessageFactory.h
+ *
+ * This file defines functions that create valid and deliberately malformed SPL standard messages for stress tests and benchmarks.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "SPLStandardMessage.h"
+#include <QByteArray>
+#include <cstddef>
+#include <random>
+
+class MessageFactory
+{
+public:
+  /** The kinds of messages that can be created (each malformed kind fails a different check of the receiver). */
+  enum Kind
+  {
+    valid, /**< A whistle message for the tester (version 255). */
+    otherVersion, /**< A well-formed message that is not meant for the tester (regular SPL version). */
+    badSize, /**< A datagram that is shorter than the message header. */
+    badHeader, /**< A message with a wrong header. */
+    badPlayerNum, /**< A message with a player number outside of [1, 5]. */
+    wrongTeamNum, /**< A message with the number of another team. */
+    badNumOfDataBytes, /**< A message that claims more data bytes than it contains. */
+    numOfKinds
+  };
+
+  /**
+   * Returns the name of a kind of message.
+   * @param kind The kind of message.
+   * @return The name of the kind of message.
+   */
+  static const char* getName(Kind kind)
+  {
+    static const char* names[numOfKinds] = {"valid", "otherVersion", "badSize", "badHeader", "badPlayerNum", "wrongTeamNum", "badNumOfDataBytes"};
+    return names[kind];
+  }
+
+  /**
+   * Creates a datagram of a given kind.
+   * @param kind The kind of message to create.
+   * @param teamNumber The number of the team that the receiver expects.
+   * @param random The random number generator that varies the player number, the field decision and the location.
+   * @return The raw datagram.
+   */
+  static QByteArray create(Kind kind, unsigned int teamNumber, std::mt19937& random)
+  {
+    SPLStandardMessage message;
+    message.version = 255;
+    message.playerNum = static_cast<uint8_t>(std::uniform_int_distribution<int>(1, 5)(random));
+    message.teamNum = static_cast<uint8_t>(teamNumber);
+    message.fallen = static_cast<uint8_t>(std::uniform_int_distribution<int>(0, 1)(random));
+    message.pose[0] = std::uniform_real_distribution<float>(-10000.f, 10000.f)(random);
+    message.pose[1] = std::uniform_real_distribution<float>(-15000.f, 15000.f)(random);
+    std::size_t size = offsetof(SPLStandardMessage, data);
+
+    switch(kind)
+    {
+      case otherVersion:
+        message.version = SPL_STANDARD_MESSAGE_STRUCT_VERSION;
+        break;
+      case badSize:
+        size = offsetof(SPLStandardMessage, data) / 2;
+        break;
+      case badHeader:
+        message.header[0] = 'X';
+        break;
+      case badPlayerNum:
+        message.playerNum = std::uniform_int_distribution<int>(0, 1)(random) ? 0 : 6;
+        break;
+      case wrongTeamNum:
+        message.teamNum = static_cast<uint8_t>((teamNumber + 1) % 100);
+        break;
+      case badNumOfDataBytes:
+        message.numOfDataBytes = 100;
+        break;
+      default:
+        break;
+    }
+
+    return QByteArray(reinterpret_cast<const char*>(&message), static_cast<int>(size));
+  }
+};
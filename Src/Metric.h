@@ -8,7 +8,9 @@
 
 #pragma once
 
+#include "DetectedWhistle.h"
 #include "Util/Angle.h"
+#include "Util/KdTree.h"
 #include "Util/Pose2D.h"
 #include "Util/Vector2D.h"
 #include <QVector>
@@ -18,6 +20,45 @@
 class Metric
 {
 public:
+  static constexpr int kdTreeThreshold = 32; /**< The number of robots from which on a k-d tree is used to determine reference poses for many locations. */
+
+  /** The thresholds and the field geometry of the scoring. The defaults are the official rules, which all functions without rules use. */
+  struct Rules
+  {
+    float minDirectionDeviation = 5.f; /**< The deviation (degrees) up to which the direction score is 1. */
+    float maxDirectionDeviation = 30.f; /**< The deviation (degrees) from which on the direction score is 0 (must be larger than the minimum). */
+    float minDistanceDeviation = 5.f; /**< The deviation (percent) up to which the distance score is 1. */
+    float maxDistanceDeviation = 30.f; /**< The deviation (percent) from which on the distance score is 0 (must be larger than the minimum). */
+    float fieldHalfLength = 5.2f; /**< Half the length (m) of the area that counts as "same field". */
+    float fieldHalfWidth = 3.7f; /**< Half the width (m) of the area that counts as "same field". */
+  };
+
+  /** The quantities that only depend on the robot setup and the actual whistle location (and can therefore be calculated before a report arrives). */
+  struct ReferenceGeometry
+  {
+    Vector2D referenceLocation; /**< The location of the robot that is closest to the actual whistle location. */
+    float actualAngle = 0.f; /**< The angle from the reference location to the actual whistle location. */
+    float actualDistance = 0.f; /**< The distance from the reference location to the actual whistle location. */
+    bool isActuallyOnSameField = false; /**< Whether the actual whistle location is on the same field as the robots. */
+  };
+
+  /** The parts of the score of a single attempt. */
+  struct ScoreComponents
+  {
+    float onSameFieldDecision = 0.f; /**< The score resulting from the "same field"/"other field" decision. */
+    float direction = 0.f; /**< The score resulting from the direction quality. */
+    float distance = 0.f; /**< The score resulting from the distance quality. */
+
+    /**
+     * Returns the overall score.
+     * @return The sum of the components.
+     */
+    float getTotal() const
+    {
+      return onSameFieldDecision + direction + distance;
+    }
+  };
+
   /**
    * This function calculates the overall score for a single attempt.
    * @param robotSetup The poses of the used robots on the field.
@@ -27,10 +68,126 @@ public:
    */
   static float calculateScore(const QVector<Pose2D>& robotSetup, const Vector2D& actualWhistleLocation, const DetectedWhistle& whistle)
   {
-    const Pose2D& referencePose = determineReferencePose(robotSetup, actualWhistleLocation);
-    return calculateOnSameFieldDecisionScore(actualWhistleLocation, whistle) +
-           calculateDirectionScore(referencePose, actualWhistleLocation, whistle) +
-           calculateDistanceScore(referencePose, actualWhistleLocation, whistle);
+    return calculateScore(robotSetup, actualWhistleLocation, whistle, Rules());
+  }
+
+  /**
+   * This function calculates the overall score for a single attempt with other rules than the official ones.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param actualWhistleLocation The ground-truth position of the whistle in field coordinates.
+   * @param whistle The whistle reported by the robots.
+   * @param rules The thresholds and the field geometry.
+   * @return The numeric score for this attempt.
+   */
+  static float calculateScore(const QVector<Pose2D>& robotSetup, const Vector2D& actualWhistleLocation, const DetectedWhistle& whistle, const Rules& rules)
+  {
+    return calculateScoreComponents(calculateReferenceGeometry(determineReferencePose(robotSetup, actualWhistleLocation), actualWhistleLocation, rules), whistle, rules).getTotal();
+  }
+
+  /**
+   * This function calculates the overall score for a single attempt from precalculated reference geometry.
+   * The result is exactly the same as the one of the other overload.
+   * @param geometry The reference geometry of the actual whistle location.
+   * @param whistle The whistle reported by the robots.
+   * @return The numeric score for this attempt.
+   */
+  static float calculateScore(const ReferenceGeometry& geometry, const DetectedWhistle& whistle)
+  {
+    return calculateScoreComponents(geometry, whistle).getTotal();
+  }
+
+  /**
+   * This function calculates the parts of the score for a single attempt from precalculated reference geometry.
+   * @param geometry The reference geometry of the actual whistle location.
+   * @param whistle The whistle reported by the robots.
+   * @return The parts of the score for this attempt.
+   */
+  static ScoreComponents calculateScoreComponents(const ReferenceGeometry& geometry, const DetectedWhistle& whistle)
+  {
+    return calculateScoreComponents(geometry, whistle, Rules());
+  }
+
+  /**
+   * This function calculates the parts of the score for a single attempt from precalculated reference geometry with other rules than the official ones.
+   * @param geometry The reference geometry of the actual whistle location (calculated with the same rules).
+   * @param whistle The whistle reported by the robots.
+   * @param rules The thresholds and the field geometry.
+   * @return The parts of the score for this attempt.
+   */
+  static ScoreComponents calculateScoreComponents(const ReferenceGeometry& geometry, const DetectedWhistle& whistle, const Rules& rules)
+  {
+    ScoreComponents components;
+    components.onSameFieldDecision = calculateOnSameFieldDecisionScore(geometry, whistle);
+    components.direction = calculateDirectionScore(geometry, whistle, rules);
+    components.distance = calculateDistanceScore(geometry, whistle, rules);
+    return components;
+  }
+
+  /**
+   * This function determines whether a location counts as being on the same field as the robots.
+   * @param location The location in field coordinates.
+   * @param rules The rules that define the field geometry.
+   * @return Whether the location is on the same field.
+   */
+  static bool isOnSameField(const Vector2D& location, const Rules& rules)
+  {
+    return std::abs(location.x) < rules.fieldHalfLength && std::abs(location.y) < rules.fieldHalfWidth;
+  }
+
+  /**
+   * This function calculates the reference geometry for each of a list of whistle locations.
+   * For large robot setups, the reference poses are determined with a k-d tree instead of a linear search.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param actualWhistleLocations The ground-truth positions of the whistles in field coordinates.
+   * @return The reference geometry for each whistle location.
+   */
+  static QVector<ReferenceGeometry> calculateReferenceGeometries(const QVector<Pose2D>& robotSetup, const QVector<Vector2D>& actualWhistleLocations)
+  {
+    return calculateReferenceGeometries(robotSetup, actualWhistleLocations, Rules());
+  }
+
+  /**
+   * This function calculates the reference geometry for each of a list of whistle locations with other rules than the official ones.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param actualWhistleLocations The ground-truth positions of the whistles in field coordinates.
+   * @param rules The rules that define the field geometry.
+   * @return The reference geometry for each whistle location.
+   */
+  static QVector<ReferenceGeometry> calculateReferenceGeometries(const QVector<Pose2D>& robotSetup, const QVector<Vector2D>& actualWhistleLocations, const Rules& rules)
+  {
+    QVector<ReferenceGeometry> geometries;
+    geometries.reserve(actualWhistleLocations.size());
+    if(robotSetup.size() >= kdTreeThreshold)
+    {
+      QVector<Vector2D> robotLocations;
+      robotLocations.reserve(robotSetup.size());
+      for(const Pose2D& pose : robotSetup)
+        robotLocations.append(pose.translation);
+      const KdTree kdTree(robotLocations);
+      for(const Vector2D& actualWhistleLocation : actualWhistleLocations)
+        geometries.append(calculateReferenceGeometry(robotSetup[kdTree.findNearest(actualWhistleLocation)], actualWhistleLocation, rules));
+    }
+    else
+      for(const Vector2D& actualWhistleLocation : actualWhistleLocations)
+        geometries.append(calculateReferenceGeometry(determineReferencePose(robotSetup, actualWhistleLocation), actualWhistleLocation, rules));
+    return geometries;
+  }
+
+  /**
+   * This function calculates the reference geometry of a whistle location as seen from a given robot.
+   * @param referencePose The reference pose for the score calculation in field coordinates.
+   * @param actualWhistleLocation The ground-truth position of the whistle in field coordinates.
+   * @param rules The rules that define the field geometry.
+   * @return The reference geometry.
+   */
+  static ReferenceGeometry calculateReferenceGeometry(const Pose2D& referencePose, const Vector2D& actualWhistleLocation, const Rules& rules)
+  {
+    ReferenceGeometry geometry;
+    geometry.referenceLocation = referencePose.translation;
+    geometry.actualAngle = (actualWhistleLocation - referencePose.translation).angle();
+    geometry.actualDistance = (actualWhistleLocation - referencePose.translation).norm();
+    geometry.isActuallyOnSameField = isOnSameField(actualWhistleLocation, rules);
+    return geometry;
   }
 
 private:
@@ -47,47 +204,40 @@ private:
 
   /**
    * This function calculates the score resulting from the "same field"/"other field" decision.
-   * @param actualWhistleLocation The ground-truth position of the whistle in field coordinates.
+   * @param geometry The reference geometry of the actual whistle location.
    * @param whistle The whistle reported by the robots.
    * @param 1 if the decision is correct, 0 if it is wrong.
    */
-  static float calculateOnSameFieldDecisionScore(const Vector2D& actualWhistleLocation, const DetectedWhistle& whistle)
+  static float calculateOnSameFieldDecisionScore(const ReferenceGeometry& geometry, const DetectedWhistle& whistle)
   {
-    const bool isActuallyOnSameField = std::abs(actualWhistleLocation.x) < 5.2f && std::abs(actualWhistleLocation.y) < 3.7f;
-    return (isActuallyOnSameField == whistle.onSameField) ? 1.f : 0.f;
+    return (geometry.isActuallyOnSameField == whistle.onSameField) ? 1.f : 0.f;
   }
 
   /**
    * This function calculates the score resulting from the direction quality.
-   * @param referencePose The reference pose for the score calculation in field coordinates.
-   * @param actualWhistleLocation The ground-truth position of the whistle in field coordinates.
+   * @param geometry The reference geometry of the actual whistle location.
    * @param whistle The whistle reported by the robots.
+   * @param rules The thresholds of the direction deviation.
    * @return A number in [0, 1] that represents how close the reported direction is to the actual direction.
    */
-  static float calculateDirectionScore(const Pose2D& referencePose, const Vector2D& actualWhistleLocation, const DetectedWhistle& whistle)
+  static float calculateDirectionScore(const ReferenceGeometry& geometry, const DetectedWhistle& whistle, const Rules& rules)
   {
-    static constexpr float minDeviation = 5.f, maxDeviation = 30.f;
-
-    const float actualAngle = (actualWhistleLocation - referencePose.translation).angle();
-    const float reportedAngle = (whistle.location - referencePose.translation).angle();
-    const float deviation = std::abs(Angle::normalize(actualAngle - reportedAngle)) * 180.f / Angle::pi;
-    return 1.f - std::max(0.f, std::min((deviation - minDeviation) / (maxDeviation - minDeviation), 1.f));
+    const float reportedAngle = (whistle.location - geometry.referenceLocation).angle();
+    const float deviation = std::abs(Angle::normalize(geometry.actualAngle - reportedAngle)) * 180.f / Angle::pi;
+    return 1.f - std::max(0.f, std::min((deviation - rules.minDirectionDeviation) / (rules.maxDirectionDeviation - rules.minDirectionDeviation), 1.f));
   }
 
   /**
    * This function calculates the score resulting from the distance quality.
-   * @param referencePose The reference pose for the score calculation in field coordinates.
-   * @param actualWhistleLocation The ground-truth position of the whistle in field coordinates.
+   * @param geometry The reference geometry of the actual whistle location.
    * @param whistle The whistle reported by the robots.
+   * @param rules The thresholds of the distance deviation.
    * @param A number in [0, 1] that represents how close reported distance is to the actual distance.
    */
-  static float calculateDistanceScore(const Pose2D& referencePose, const Vector2D& actualWhistleLocation, const DetectedWhistle& whistle)
+  static float calculateDistanceScore(const ReferenceGeometry& geometry, const DetectedWhistle& whistle, const Rules& rules)
   {
-    static constexpr float minDeviation = 5.f, maxDeviation = 30.f;
-
-    const float actualDistance = (actualWhistleLocation - referencePose.translation).norm();
-    const float reportedDistance = (whistle.location - referencePose.translation).norm();
-    const float deviation = std::abs(reportedDistance - actualDistance) / actualDistance * 100.f;
-    return 1.f - std::max(0.f, std::min((deviation - minDeviation) / (maxDeviation - minDeviation), 1.f));
+    const float reportedDistance = (whistle.location - geometry.referenceLocation).norm();
+    const float deviation = std::abs(reportedDistance - geometry.actualDistance) / geometry.actualDistance * 100.f;
+    return 1.f - std::max(0.f, std::min((deviation - rules.minDistanceDeviation) / (rules.maxDistanceDeviation - rules.minDistanceDeviation), 1.f));
   }
 };
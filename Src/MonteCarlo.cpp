@@ -0,0 +1,130 @@
+/**
+ * @file MonteCarlo.cpp
+ *
+ * This file implements a class that estimates the distribution of the score at each whistle location for a robot subset.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "MonteCarlo.h"
+#include "DetectedWhistle.h"
+#include "Util/Angle.h"
+#include "Util/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+constexpr std::array<float, 5> MonteCarlo::percentiles;
+constexpr int MonteCarlo::binsPerPoint;
+constexpr std::uint64_t MonteCarlo::trialsPerTask;
+
+namespace
+{
+  /**
+   * Mixes a value into a well distributed 64 bit number (the finalizer of SplitMix64), so that neighboring tasks get unrelated random streams.
+   * @param value The value.
+   * @return The mixed value.
+   */
+  std::uint64_t mix(std::uint64_t value)
+  {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+  }
+}
+
+MonteCarlo::MonteCarlo(const QVector<Vector2D>& whistleLocations, const NoiseModel& model, const ScoringRules::Definition& rules) :
+  whistleLocations(whistleLocations),
+  model(model),
+  rules(rules),
+  numOfBins(static_cast<int>(std::ceil((rules.onSameFieldDecisionWeight + rules.directionWeight + rules.distanceWeight) * binsPerPoint)) + 1)
+{}
+
+QVector<MonteCarlo::LocationResult> MonteCarlo::run(const QVector<Pose2D>& robotSetup, std::uint64_t trialsPerLocation, std::uint64_t seed, ThreadPool& pool) const
+{
+  // The errors are drawn around the closest robot, even if the rules judge the reports from the best one.
+  const QVector<Metric::ReferenceGeometry> geometries = Metric::calculateReferenceGeometries(robotSetup, whistleLocations, rules);
+  const ScoringRules scoringRules(rules, robotSetup, whistleLocations);
+  const std::size_t numOfLocations = static_cast<std::size_t>(whistleLocations.size());
+  const std::size_t tasksPerLocation = static_cast<std::size_t>((trialsPerLocation + trialsPerTask - 1) / trialsPerTask);
+
+  // Histograms are only added up, so each thread has its own. The sums are kept per task and added in a fixed order,
+  // so that the rounding does not depend on which thread ran which task.
+  std::vector<std::vector<std::uint64_t>> histograms(pool.getNumOfThreads(), std::vector<std::uint64_t>(numOfLocations * numOfBins));
+  std::vector<double> sums(numOfLocations * tasksPerLocation), squaredSums(numOfLocations * tasksPerLocation);
+  const float bearingError = model.bearingError * Angle::pi / 180.f;
+
+  pool.parallelFor(numOfLocations * tasksPerLocation, [&](unsigned thread, std::size_t task)
+  {
+    const std::size_t location = task / tasksPerLocation;
+    const std::uint64_t firstTrial = (task % tasksPerLocation) * trialsPerTask;
+    const std::uint64_t numOfTrials = std::min(trialsPerTask, trialsPerLocation - firstTrial);
+    const Metric::ReferenceGeometry& geometry = geometries[static_cast<int>(location)];
+    std::uint64_t* histogram = histograms[thread].data() + location * numOfBins;
+
+    std::mt19937_64 random(mix(mix(mix(seed) ^ location) ^ firstTrial));
+    std::uniform_real_distribution<float> uniform;
+    std::normal_distribution<float> normal;
+    double sum = 0.0, squaredSum = 0.0;
+    DetectedWhistle whistle;
+    for(std::uint64_t i = 0; i < numOfTrials; ++i)
+    {
+      // The random numbers are drawn in separate statements, so that their order does not depend on the compiler.
+      float score = 0.f;
+      if(uniform(random) >= model.dropoutRate)
+      {
+        const float bearing = geometry.actualAngle + normal(random) * bearingError;
+        const float distance = geometry.actualDistance * std::max(0.f, 1.f + normal(random) * model.rangeError);
+        whistle.location = Vector2D(geometry.referenceLocation.x + distance * std::cos(bearing), geometry.referenceLocation.y + distance * std::sin(bearing));
+        whistle.onSameField = geometry.isActuallyOnSameField != (uniform(random) < model.falseSameFieldRate);
+        score = scoringRules.calculateScoreComponents(static_cast<int>(location), whistle).getTotal();
+      }
+      sum += score;
+      squaredSum += static_cast<double>(score) * score;
+      ++histogram[std::max(0, std::min(static_cast<int>(score * binsPerPoint + 0.5f), numOfBins - 1))];
+    }
+    sums[task] = sum;
+    squaredSums[task] = squaredSum;
+  });
+
+  QVector<LocationResult> results(static_cast<int>(numOfLocations));
+  std::vector<std::uint64_t> histogram(numOfBins);
+  for(std::size_t location = 0; location < numOfLocations; ++location)
+  {
+    LocationResult& result = results[static_cast<int>(location)];
+    result.trials = trialsPerLocation;
+    double sum = 0.0, squaredSum = 0.0;
+    for(std::size_t task = location * tasksPerLocation; task < (location + 1) * tasksPerLocation; ++task)
+    {
+      sum += sums[task];
+      squaredSum += squaredSums[task];
+    }
+    result.meanScore = trialsPerLocation ? sum / trialsPerLocation : 0.0;
+    result.stdDevScore = trialsPerLocation ? std::sqrt(std::max(0.0, squaredSum / trialsPerLocation - result.meanScore * result.meanScore)) : 0.0;
+
+    std::fill(histogram.begin(), histogram.end(), 0);
+    for(const std::vector<std::uint64_t>& threadHistograms : histograms)
+      for(int bin = 0; bin < numOfBins; ++bin)
+        histogram[bin] += threadHistograms[location * numOfBins + bin];
+    for(std::size_t i = 0; i < percentiles.size(); ++i)
+    {
+      // The percentile is the smallest score for which at least the given share of trials is not higher.
+      const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(percentiles[i] / 100.0 * trialsPerLocation)));
+      std::uint64_t count = 0;
+      int bin = 0;
+      while(bin < numOfBins - 1 && (count += histogram[bin]) < rank)
+        ++bin;
+      result.scorePercentiles[i] = static_cast<float>(bin) / binsPerPoint;
+    }
+  }
+  return results;
+}
+
+QVector<MonteCarlo::LocationResult> MonteCarlo::run(const QVector<Pose2D>& robotSetup, std::uint64_t trialsPerLocation, std::uint64_t seed) const
+{
+  // A pool with a single thread starts no threads and runs all tasks on the caller.
+  ThreadPool pool(1);
+  return run(robotSetup, trialsPerLocation, seed, pool);
+}
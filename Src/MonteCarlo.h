@@ -0,0 +1,80 @@
+/**
+ * @file MonteCarlo.h
+ *
+ * This file declares a class that estimates the distribution of the score at each whistle location for a robot subset
+ * by scoring many whistle reports that are drawn from a noise model.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "ScoringRules.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QVector>
+#include <array>
+#include <cstdint>
+
+class ThreadPool;
+
+class MonteCarlo
+{
+public:
+  /** A model of the errors in the whistle reports of a team. */
+  struct NoiseModel
+  {
+    float bearingError = 10.f; /**< The standard deviation (degrees) of the reported direction as seen from the reference robot. */
+    float rangeError = 0.2f; /**< The standard deviation of the reported distance relative to the actual distance. */
+    float falseSameFieldRate = 0.05f; /**< The probability of a wrong "same field"/"other field" decision. */
+    float dropoutRate = 0.05f; /**< The probability that no report arrives in time (which scores 0). */
+  };
+
+  static constexpr std::array<float, 5> percentiles = {{5.f, 25.f, 50.f, 75.f, 95.f}}; /**< The percentiles that are estimated for each location. */
+  static constexpr int binsPerPoint = 1024; /**< The resolution of the score histograms (the percentiles are exact up to this fraction of a point). */
+  static constexpr std::uint64_t trialsPerTask = 1 << 16; /**< The number of trials that a thread draws from one random stream. */
+
+  /** The estimated score distribution at a whistle location. */
+  struct LocationResult
+  {
+    std::uint64_t trials = 0; /**< The number of trials. */
+    double meanScore = 0.0; /**< The expected score. */
+    double stdDevScore = 0.0; /**< The standard deviation of the score. */
+    std::array<float, percentiles.size()> scorePercentiles; /**< The score at each of the \c percentiles. */
+  };
+
+  /**
+   * Constructor.
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param model The model of the errors.
+   * @param rules The rules with which the reports are scored.
+   */
+  MonteCarlo(const QVector<Vector2D>& whistleLocations, const NoiseModel& model, const ScoringRules::Definition& rules);
+
+  /**
+   * Runs the trials for a robot subset on all threads of a pool. Each task of trials draws from its own random stream that only
+   * depends on the seed, the location and the task, so the results do not depend on the number of threads or on the scheduling.
+   * @param robotSetup The poses of the robots of the subset.
+   * @param trialsPerLocation The number of trials per whistle location.
+   * @param seed The seed of the random streams.
+   * @param pool The threads that run the trials.
+   * @return The result for each whistle location.
+   */
+  QVector<LocationResult> run(const QVector<Pose2D>& robotSetup, std::uint64_t trialsPerLocation, std::uint64_t seed, ThreadPool& pool) const;
+
+  /**
+   * Runs the trials for a robot subset on the calling thread (e.g. when the subsets themselves are distributed to threads).
+   * The results are the same as the ones of the other overload.
+   * @param robotSetup The poses of the robots of the subset.
+   * @param trialsPerLocation The number of trials per whistle location.
+   * @param seed The seed of the random streams.
+   * @return The result for each whistle location.
+   */
+  QVector<LocationResult> run(const QVector<Pose2D>& robotSetup, std::uint64_t trialsPerLocation, std::uint64_t seed) const;
+
+private:
+  QVector<Vector2D> whistleLocations; /**< The set of locations from which the whistle is blown. */
+  NoiseModel model; /**< The model of the errors. */
+  ScoringRules::Definition rules; /**< The rules with which the reports are scored. */
+  int numOfBins; /**< The number of bins of a score histogram (scores are in [0, sum of the weights]). */
+};
@@ -0,0 +1,70 @@
+/**
+ * @file PassSimulator.cpp
+ *
+ * This file implements a class that runs complete challenge passes against a statistical model of a team in virtual time.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "PassSimulator.h"
+#include "ScoringRules.h"
+#include "TimeSource.h"
+
+PassSimulator::PassSimulator(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotSetup, const TeamModel& model) :
+  whistleLocations(whistleLocations),
+  robotSetup(robotSetup),
+  referenceGeometries(Metric::calculateReferenceGeometries(robotSetup, whistleLocations, ScoringRules::getConfiguredDefinition())),
+  model(model)
+{}
+
+PassSimulator::PassResult PassSimulator::simulate(unsigned int seed) const
+{
+  // The time source must outlive the timers of the challenge.
+  VirtualTimeSource timeSource;
+  Challenge challenge(whistleLocations, robotSetup, Challenge::createLocationOrder(whistleLocations.size(), seed));
+  challenge.setTimeSource(timeSource);
+  std::mt19937 random(seed);
+
+  while(!challenge.isFinished())
+  {
+    timeSource.advanceTo(timeSource.getTime() + static_cast<std::int64_t>(pauseBetweenAttempts) * 1000000);
+    const int locationIndex = challenge.getAttempts()[challenge.getNumOfFinishedAttempts()].locationIndex;
+    challenge.startAttempt();
+
+    // A message that arrives too late is handed over after the attempt has timed out, just like in a real pass.
+    DetectedWhistle whistle;
+    if(respond(locationIndex, timeSource.getTime(), random, whistle))
+    {
+      timeSource.advanceTo(whistle.timestamp);
+      challenge.handleWhistleLocation(whistle);
+    }
+    while(challenge.isAttemptRunning() && timeSource.advanceToNextTimer());
+  }
+  while(timeSource.advanceToNextTimer());
+
+  PassResult result;
+  result.seed = seed;
+  result.attempts = challenge.getAttempts();
+  result.aggregates = challenge.getAggregates();
+  result.duration = timeSource.getTime();
+  return result;
+}
+
+bool PassSimulator::respond(int locationIndex, std::int64_t whistleTime, std::mt19937& random, DetectedWhistle& whistle) const
+{
+  if(std::uniform_real_distribution<float>()(random) >= model.responseProbability)
+    return false;
+
+  // The random numbers are drawn in separate statements, so that their order does not depend on the compiler.
+  const float responseTime = model.meanResponseTime > 0.f ? std::exponential_distribution<float>(1.f / model.meanResponseTime)(random) : 0.f;
+  whistle.timestamp = whistleTime + static_cast<std::int64_t>(responseTime * 1000000.f);
+  whistle.onSameField = referenceGeometries[locationIndex].isActuallyOnSameField != (std::uniform_real_distribution<float>()(random) < model.wrongFieldProbability);
+  whistle.location = whistleLocations[locationIndex];
+  if(model.locationNoise > 0.f)
+  {
+    std::normal_distribution<float> noise(0.f, model.locationNoise);
+    whistle.location.x += noise(random);
+    whistle.location.y += noise(random);
+  }
+  return true;
+}
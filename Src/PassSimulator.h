@@ -0,0 +1,73 @@
+/**
+ * @file PassSimulator.h
+ *
+ * This file declares a class that runs complete challenge passes against a statistical model of a team in virtual time,
+ * so that thousands of passes (including timeouts) take milliseconds instead of hours.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Challenge.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QVector>
+#include <cstdint>
+#include <random>
+
+class PassSimulator
+{
+public:
+  /** A statistical model of how the robots of a team respond to a whistle. */
+  struct TeamModel
+  {
+    float responseProbability = 0.9f; /**< The probability that a whistle message is sent at all. */
+    float meanResponseTime = 1500.f; /**< The mean time (ms) from the whistle until the message arrives (exponentially distributed, so some arrive too late). */
+    float locationNoise = 0.5f; /**< The standard deviation (m) of each coordinate of the reported location. */
+    float wrongFieldProbability = 0.05f; /**< The probability that the robots decide for the wrong field. */
+  };
+
+  /** The result of a simulated challenge pass. */
+  struct PassResult
+  {
+    unsigned int seed = 0; /**< The seed from which the pass has been simulated. */
+    QVector<Challenge::Attempt> attempts; /**< The attempts in the order in which they were done. */
+    Challenge::Aggregates aggregates; /**< The aggregates over all attempts. */
+    std::int64_t duration = 0; /**< The virtual duration of the pass (ns). */
+  };
+
+  static constexpr int pauseBetweenAttempts = 10000; /**< The virtual time (ms) between the end of an attempt and the start of the next one. */
+
+  /**
+   * Constructor.
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param robotSetup The set of poses of the robots that participate in the passes.
+   * @param model The model of the team.
+   */
+  PassSimulator(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotSetup, const TeamModel& model);
+
+  /**
+   * Simulates a complete challenge pass. The same seed always results in the same order of whistle locations and (with the same standard library)
+   * in the same responses. The log should be disabled (see \c ChallengeLog::setEnabled) because the pass is logged like a real one.
+   * @param seed The seed of the order of whistle locations and of the responses.
+   * @return The result of the pass.
+   */
+  PassResult simulate(unsigned int seed) const;
+
+private:
+  /**
+   * Draws the response of the team to a whistle.
+   * @param locationIndex The index of the location from which the whistle is blown.
+   * @param whistleTime The time at which the whistle is blown (ns).
+   * @param random The random number generator of the pass.
+   * @param whistle The whistle message (with the time at which it arrives).
+   * @return Whether a message is sent.
+   */
+  bool respond(int locationIndex, std::int64_t whistleTime, std::mt19937& random, DetectedWhistle& whistle) const;
+
+  QVector<Vector2D> whistleLocations; /**< The set of locations from which the whistle is blown. */
+  QVector<Pose2D> robotSetup; /**< The set of poses of the robots that participate in the passes. */
+  QVector<Metric::ReferenceGeometry> referenceGeometries; /**< The reference geometry of each whistle location (for the correct field decision under the configured rules, with which the challenge scores). */
+  TeamModel model; /**< The model of the team. */
+};
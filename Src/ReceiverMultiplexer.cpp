@@ -0,0 +1,124 @@
+/**
+ * @file ReceiverMultiplexer.cpp
+ *
+ * This file implements a class that watches the sockets of many SPL standard message receivers with a single epoll loop (Linux only).
+ *
+ * @author Arne Hasselbring
+ */
+
+#ifdef __linux__
+
+#include "ReceiverMultiplexer.h"
+#include "SPLStandardMessageReceiver.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+constexpr unsigned int ReceiverMultiplexer::batchesPerTurn;
+
+ReceiverMultiplexer::ReceiverMultiplexer()
+{
+  epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+  wakeDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  if(epollDescriptor < 0 || wakeDescriptor < 0 || epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, wakeDescriptor, &event) != 0)
+  {
+    if(epollDescriptor >= 0)
+      close(epollDescriptor);
+    if(wakeDescriptor >= 0)
+      close(wakeDescriptor);
+    epollDescriptor = wakeDescriptor = -1;
+    return;
+  }
+
+  thread = std::thread(&ReceiverMultiplexer::run, this);
+  // Like the receiver threads, the loop should not have to wait for the GUI or the log writer.
+  sched_param parameters = {};
+  parameters.sched_priority = sched_get_priority_min(SCHED_RR);
+  pthread_setschedparam(thread.native_handle(), SCHED_RR, &parameters);
+}
+
+ReceiverMultiplexer::~ReceiverMultiplexer()
+{
+  if(!isRunning())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopRequested = true;
+  }
+  const std::uint64_t one = 1;
+  while(write(wakeDescriptor, &one, sizeof(one)) < 0 && errno == EINTR);
+  thread.join();
+  close(wakeDescriptor);
+  close(epollDescriptor);
+}
+
+bool ReceiverMultiplexer::add(SPLStandardMessageReceiver* receiver)
+{
+  if(!isRunning() || receiver->getBackend() != SPLStandardMessageReceiver::Backend::multiplexed)
+    return false;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  // Level-triggered, so that a receiver that has not drained its socket in its turn is reported again.
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.ptr = receiver;
+  if(epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, receiver->getSocketDescriptor(), &event) != 0)
+    return false;
+  receivers.push_back(receiver);
+  return true;
+}
+
+void ReceiverMultiplexer::remove(SPLStandardMessageReceiver* receiver)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  const auto it = std::find(receivers.begin(), receivers.end(), receiver);
+  if(it == receivers.end())
+    return;
+  epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, receiver->getSocketDescriptor(), nullptr);
+  receivers.erase(it);
+  // The loop does not pick the receiver again, but it may still be in its turn.
+  receiverReleased.wait(lock, [this, receiver]{ return activeReceiver != receiver; });
+}
+
+void ReceiverMultiplexer::run()
+{
+  TRACE_THREAD_NAME("ReceiverMultiplexer");
+  epoll_event events[maxEvents];
+  while(true)
+  {
+    const int numOfEvents = epoll_wait(epollDescriptor, events, maxEvents, -1);
+    if(numOfEvents < 0 && errno != EINTR)
+      break;
+
+    // Each ready receiver handles a bounded amount of messages per turn, so that a flood on one port does not delay the others.
+    // The mutex is only held to pick the receiver, so that adding or removing other receivers never waits for a turn.
+    std::unique_lock<std::mutex> lock(mutex);
+    for(int i = 0; i < numOfEvents && !stopRequested; ++i)
+    {
+      SPLStandardMessageReceiver* receiver = static_cast<SPLStandardMessageReceiver*>(events[i].data.ptr);
+      // The receiver may have been removed after the events were taken from the kernel.
+      if(!receiver || std::find(receivers.begin(), receivers.end(), receiver) == receivers.end())
+        continue;
+      activeReceiver = receiver;
+      lock.unlock();
+      receiver->receivePending(batchesPerTurn);
+      lock.lock();
+      activeReceiver = nullptr;
+      receiverReleased.notify_all();
+    }
+    if(stopRequested)
+      break;
+  }
+}
+
+#endif
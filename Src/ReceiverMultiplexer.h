@@ -0,0 +1,78 @@
+/**
+ * @file ReceiverMultiplexer.h
+ *
+ * This file declares a class that watches the sockets of many SPL standard message receivers with a single epoll loop (Linux only).
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#ifdef __linux__
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SPLStandardMessageReceiver;
+
+class ReceiverMultiplexer
+{
+public:
+  static constexpr unsigned int batchesPerTurn = 1; /**< The number of batches that a receiver may handle before the other ready receivers get their turn. */
+
+  /** Constructor. Creates the epoll instance and starts the thread that runs the loop. */
+  ReceiverMultiplexer();
+
+  /** Destructor. Stops the loop (the receivers are not deleted). */
+  ~ReceiverMultiplexer();
+
+  ReceiverMultiplexer(const ReceiverMultiplexer&) = delete;
+  void operator=(const ReceiverMultiplexer&) = delete;
+
+  /**
+   * Returns whether the epoll instance and the thread could be created.
+   * @return Whether the multiplexer is running.
+   */
+  bool isRunning() const
+  {
+    return epollDescriptor >= 0;
+  }
+
+  /**
+   * Starts watching the socket of a receiver. Its messages are received in the thread of the multiplexer.
+   * @param receiver A receiver that uses \c SPLStandardMessageReceiver::Backend::multiplexed.
+   * @return Whether the socket could be added.
+   */
+  bool add(SPLStandardMessageReceiver* receiver);
+
+  /**
+   * Stops watching the socket of a receiver. When this returns, the receiver is not used by the multiplexer anymore and can be deleted
+   * (if it is receiving messages right now, this waits until it is done).
+   * @param receiver The receiver.
+   */
+  void remove(SPLStandardMessageReceiver* receiver);
+
+private:
+  static constexpr int maxEvents = 64; /**< The maximum number of events that are taken from the kernel at once. */
+
+  /** The main function of the multiplexer thread. */
+  void run();
+
+  int epollDescriptor = -1; /**< The epoll instance. */
+  int wakeDescriptor = -1; /**< An eventfd that wakes up the loop when it should stop. */
+  bool stopRequested = false; /**< Whether the loop should stop (protected by \c mutex). */
+  std::mutex mutex; /**< Protects \c stopRequested, \c receivers and \c activeReceiver (but is not held while a receiver receives messages). */
+  std::condition_variable receiverReleased; /**< Notified when the loop is done with \c activeReceiver. */
+  std::vector<SPLStandardMessageReceiver*> receivers; /**< The receivers whose sockets are watched. */
+  SPLStandardMessageReceiver* activeReceiver = nullptr; /**< The receiver that is receiving messages right now (protected by \c mutex). */
+  std::thread thread; /**< The thread that runs the loop. */
+};
+
+#else
+
+/** A placeholder on platforms without epoll (it is never instantiated there). */
+class ReceiverMultiplexer {};
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * @file ReplayEngine.cpp
+ *
+ * This file implements a class that feeds captures back through the message validation and the scoring of challenge passes.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ReplayEngine.h"
+#include "Capture.h"
+#include "SPLStandardMessage.h"
+#include "SPLStandardMessageReceiver.h"
+#include "TimeSource.h"
+#include "Util/Clock.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <thread>
+
+ReplayEngine::ReplayEngine(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotPoses) :
+  whistleLocations(whistleLocations),
+  robotPoses(robotPoses)
+{}
+
+void ReplayEngine::setSpeed(double speed)
+{
+  this->speed = speed;
+}
+
+bool ReplayEngine::replay(const QString& path, QVector<PassResult>& results) const
+{
+  CaptureReader reader(path);
+  if(!reader.isValid())
+    return false;
+
+  // The timers of a challenge run in the time of the capture, so a replay does not depend on the speed at which it runs (and needs no event loop).
+  std::unique_ptr<VirtualTimeSource> timeSource;
+  std::unique_ptr<Challenge> challenge;
+  PassResult result;
+  auto finishPass = [&challenge, &result, &results]
+  {
+    if(!challenge)
+      return;
+    result.attempts = challenge->getAttempts();
+    result.numOfFinishedAttempts = challenge->getNumOfFinishedAttempts();
+    result.totalScore = challenge->getTotalScore();
+    results.append(result);
+    challenge.reset();
+  };
+
+  const std::int64_t replayStartTime = Clock::getTime();
+  std::int64_t captureStartTime = 0;
+  bool first = true;
+  auto apply = [&](const Capture::Record& record)
+  {
+    if(first)
+    {
+      captureStartTime = record.timestamp;
+      first = false;
+    }
+    else if(speed > 0.0)
+    {
+      const std::int64_t dueTime = replayStartTime + static_cast<std::int64_t>((record.timestamp - captureStartTime) / speed);
+      const std::int64_t waitTime = dueTime - Clock::getTime();
+      if(waitTime > 0)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(waitTime));
+    }
+    if(timeSource)
+      timeSource->advanceTo(std::max(timeSource->getTime(), record.timestamp));
+
+    switch(record.type)
+    {
+      case Capture::RecordType::passStart:
+      {
+        finishPass();
+        Capture::PassStart passStart;
+        if(!Capture::decodePassStart(record, passStart))
+          break;
+        QVector<Pose2D> robotSetup;
+        for(unsigned int jerseyNumber : passStart.robotNumbers)
+          if(jerseyNumber >= 1 && static_cast<int>(jerseyNumber) <= robotPoses.size())
+            robotSetup.append(robotPoses[jerseyNumber - 1]);
+        bool validOrder = !robotSetup.isEmpty();
+        for(int locationIndex : passStart.locationOrder)
+          validOrder &= locationIndex < whistleLocations.size();
+        if(!validOrder)
+          break;
+        result = PassResult();
+        result.teamNumber = passStart.teamNumber;
+        result.robotNumbers = passStart.robotNumbers;
+        timeSource.reset(new VirtualTimeSource(record.timestamp));
+        challenge.reset(new Challenge(whistleLocations, robotSetup, passStart.locationOrder));
+        challenge->setTimeSource(*timeSource);
+        break;
+      }
+      case Capture::RecordType::attemptStart:
+      {
+        int attemptIndex;
+        if(challenge && Capture::decodeAttempt(record, attemptIndex) && !challenge->isAttemptRunning() &&
+           attemptIndex == challenge->getNumOfFinishedAttempts() && !challenge->isFinished())
+          challenge->startAttemptAt(record.timestamp);
+        break;
+      }
+      case Capture::RecordType::attemptStop:
+        if(challenge)
+          challenge->expireAttempt();
+        break;
+      case Capture::RecordType::datagram:
+      {
+        if(!challenge || record.size > sizeof(SPLStandardMessage))
+          break;
+        SPLStandardMessage message;
+        std::memcpy(&message, record.payload, record.size);
+        DetectedWhistle whistle;
+        if(SPLStandardMessageReceiver::decodeMessage(message, record.size, result.teamNumber, whistle) == SPLStandardMessageReceiver::valid)
+        {
+          whistle.timestamp = record.timestamp;
+          challenge->handleWhistleLocation(whistle);
+        }
+        break;
+      }
+    }
+  };
+
+  // The capture writer commits datagrams and markers from different threads, so the records in the file are only roughly ordered by time.
+  // They are applied in the order of their timestamps (the order in the file for equal timestamps) once no earlier record can follow anymore.
+  std::multimap<std::int64_t, Capture::Record> pendingRecords;
+  Capture::Record record;
+  while(reader.readRecord(record))
+  {
+    pendingRecords.emplace(record.timestamp, record);
+    while(pendingRecords.begin()->first < record.timestamp - reorderWindow)
+    {
+      apply(pendingRecords.begin()->second);
+      pendingRecords.erase(pendingRecords.begin());
+    }
+  }
+  for(const auto& pendingRecord : pendingRecords)
+    apply(pendingRecord.second);
+  finishPass();
+  return true;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file ReplayEngine.h
+ *
+ * This file declares a class that feeds captures back through the message validation and the scoring of challenge passes.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Challenge.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QString>
+#include <QVector>
+#include <cstdint>
+
+class ReplayEngine
+{
+public:
+  /** The result of a replayed challenge pass. */
+  struct PassResult
+  {
+    unsigned int teamNumber = 0; /**< The number of the team that did the pass. */
+    QVector<unsigned int> robotNumbers; /**< The jersey numbers of the participating robots. */
+    QVector<Challenge::Attempt> attempts; /**< The replayed attempts in the order in which they were done. */
+    int numOfFinishedAttempts = 0; /**< The number of attempts that were finished in the capture. */
+    float totalScore = 0.f; /**< The total score of the replayed pass. */
+  };
+
+  /**
+   * Constructor.
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param robotPoses The set of poses at which robots can be placed.
+   */
+  ReplayEngine(const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotPoses);
+
+  /**
+   * Sets the speed of the replay.
+   * @param speed The factor by which the replay is faster than real time (a value <= 0 means as fast as possible).
+   */
+  void setSpeed(double speed);
+
+  /**
+   * Replays a capture file.
+   * @param path The path of the capture file.
+   * @param results The results of all passes in the capture are appended to this list.
+   * @return Whether the file is a valid capture.
+   */
+  bool replay(const QString& path, QVector<PassResult>& results) const;
+
+private:
+  /**
+   * The maximum time (ns) by which a record may be written before a record with an earlier timestamp.
+   * The capture writer commits datagrams within a few commit intervals, so this leaves a wide margin.
+   */
+  static constexpr std::int64_t reorderWindow = 2000000000;
+
+  QVector<Vector2D> whistleLocations; /**< The set of locations from which the whistle is blown. */
+  QVector<Pose2D> robotPoses; /**< The set of poses at which robots can be placed. */
+  double speed = 1.0; /**< The factor by which the replay is faster than real time (<= 0 means as fast as possible). */
+};
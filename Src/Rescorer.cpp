@@ -0,0 +1,152 @@
+/**
+ * @file Rescorer.cpp
+ *
+ * This file implements a class that scores recorded attempts again with other thresholds of the metric.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Rescorer.h"
+#include "Util/ThreadPool.h"
+#include <algorithm>
+#include <limits>
+
+Rescorer::Rescorer(const QVector<Pose2D>& robotPoses) :
+  robotPoses(robotPoses)
+{}
+
+bool Rescorer::addPass(const QString& team, const QVector<unsigned int>& robotNumbers, const QVector<Attempt>& attempts)
+{
+  if(robotNumbers.isEmpty())
+    return false;
+  for(unsigned int jerseyNumber : robotNumbers)
+    if(jerseyNumber < 1 || static_cast<int>(jerseyNumber) > robotPoses.size())
+      return false;
+
+  auto groupIndex = groupIndices.find(robotNumbers);
+  if(groupIndex == groupIndices.end())
+  {
+    groups.emplace_back();
+    for(unsigned int jerseyNumber : robotNumbers)
+      groups.back().robotSetup.append(robotPoses[jerseyNumber - 1]);
+    groupIndex = groupIndices.insert(robotNumbers, static_cast<int>(groups.size()) - 1);
+  }
+
+  int teamIndex = teams.indexOf(team);
+  if(teamIndex < 0)
+  {
+    teamIndex = teams.size();
+    teams.append(team);
+  }
+  const int passIndex = static_cast<int>(passTeams.size());
+  passTeams.push_back(teamIndex);
+
+  // The reports of a pass are kept in the order of its attempts, so that its score is summed up like in the challenge.
+  Group& group = groups[*groupIndex];
+  for(const Attempt& attempt : attempts)
+  {
+    if(attempt.timedOut)
+      continue;
+    group.reports.reportedX.push_back(attempt.reportedLocation.x);
+    group.reports.reportedY.push_back(attempt.reportedLocation.y);
+    group.reports.reportedOnSameField.push_back(attempt.reportedOnSameField ? 1 : 0);
+    group.reports.actualX.push_back(attempt.actualLocation.x);
+    group.reports.actualY.push_back(attempt.actualLocation.y);
+    group.passes.push_back(passIndex);
+  }
+  numOfAttempts += attempts.size();
+  return true;
+}
+
+const QStringList& Rescorer::getTeams() const
+{
+  return teams;
+}
+
+int Rescorer::getNumOfPasses() const
+{
+  return static_cast<int>(passTeams.size());
+}
+
+int Rescorer::getNumOfAttempts() const
+{
+  return numOfAttempts;
+}
+
+Rescorer::Result Rescorer::score(const ScoringRules::Definition& rules) const
+{
+  BatchMetric::Scores scores;
+  std::vector<float> passScores;
+  Result result;
+  score(rules, scores, passScores, result);
+  return result;
+}
+
+QVector<Rescorer::Result> Rescorer::sweep(const QVector<ScoringRules::Definition>& ruleSets, ThreadPool& pool) const
+{
+  QVector<Result> results(ruleSets.size());
+  std::vector<BatchMetric::Scores> scores(pool.getNumOfThreads());
+  std::vector<std::vector<float>> passScores(pool.getNumOfThreads());
+  pool.parallelFor(static_cast<std::size_t>(ruleSets.size()), [&](unsigned thread, std::size_t task)
+  {
+    const int index = static_cast<int>(task);
+    score(ruleSets[index], scores[thread], passScores[thread], results[index]);
+  });
+  return results;
+}
+
+int Rescorer::countRankChanges(const Result& result, const Result& baseline)
+{
+  Q_ASSERT(result.ranks.size() == baseline.ranks.size());
+  int numOfChanges = 0;
+  for(int i = 0; i < result.ranks.size(); ++i)
+    if(result.ranks[i] != baseline.ranks[i])
+      ++numOfChanges;
+  return numOfChanges;
+}
+
+QVector<ScoringRules::Definition> Rescorer::createGrid(const ScoringRules::Definition& baseRules, const QVector<float>& minDeviations, const QVector<float>& maxDeviations,
+                                                       const QVector<float>& fieldHalfLengths, const QVector<float>& fieldHalfWidths)
+{
+  QVector<ScoringRules::Definition> grid;
+  ScoringRules::Definition rules = baseRules;
+  for(float minDeviation : minDeviations)
+    for(float maxDeviation : maxDeviations)
+    {
+      if(minDeviation >= maxDeviation)
+        continue;
+      for(float fieldHalfLength : fieldHalfLengths)
+        for(float fieldHalfWidth : fieldHalfWidths)
+        {
+          rules.minDirectionDeviation = rules.minDistanceDeviation = minDeviation;
+          rules.maxDirectionDeviation = rules.maxDistanceDeviation = maxDeviation;
+          rules.fieldHalfLength = fieldHalfLength;
+          rules.fieldHalfWidth = fieldHalfWidth;
+          grid.append(rules);
+        }
+    }
+  return grid;
+}
+
+void Rescorer::score(const ScoringRules::Definition& rules, BatchMetric::Scores& scores, std::vector<float>& passScores, Result& result) const
+{
+  passScores.assign(passTeams.size(), 0.f);
+  for(const Group& group : groups)
+  {
+    ScoringRules::calculateScores(rules, group.robotSetup, group.reports, scores);
+    for(std::size_t i = 0; i < group.passes.size(); ++i)
+      passScores[group.passes[i]] += scores.total[i];
+  }
+
+  result.rules = rules;
+  result.bestScores.fill(std::numeric_limits<float>::lowest(), teams.size());
+  for(std::size_t i = 0; i < passTeams.size(); ++i)
+    result.bestScores[passTeams[i]] = std::max(result.bestScores[passTeams[i]], passScores[i]);
+
+  // A team is ranked behind all teams with a higher best score.
+  QVector<float> sortedScores = result.bestScores;
+  std::sort(sortedScores.begin(), sortedScores.end(), [](float a, float b) { return a > b; });
+  result.ranks.resize(teams.size());
+  for(int i = 0; i < teams.size(); ++i)
+    result.ranks[i] = 1 + static_cast<int>(std::lower_bound(sortedScores.begin(), sortedScores.end(), result.bestScores[i], [](float a, float b) { return a > b; }) - sortedScores.begin());
+}
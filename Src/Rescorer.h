@@ -0,0 +1,136 @@
+/**
+ * @file Rescorer.h
+ *
+ * This file declares a class that scores recorded attempts again with other thresholds of the metric
+ * and ranks the teams as they would have been ranked under these thresholds.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "BatchMetric.h"
+#include "ScoringRules.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+class ThreadPool;
+
+class Rescorer
+{
+public:
+  /** A recorded attempt. */
+  struct Attempt
+  {
+    Vector2D actualLocation; /**< The ground-truth position of the whistle. */
+    Vector2D reportedLocation; /**< The location reported by the robots (only if the attempt did not time out). */
+    bool reportedOnSameField = false; /**< The "same field"/"other field" decision of the robots (only if the attempt did not time out). */
+    bool timedOut = false; /**< Whether the attempt has timed out (which scores 0 under all thresholds). */
+  };
+
+  /** The standings under one set of thresholds. */
+  struct Result
+  {
+    ScoringRules::Definition rules; /**< The rules with the thresholds and the field geometry. */
+    QVector<float> bestScores; /**< The highest score of a pass of each team (in the order of \c getTeams). */
+    QVector<int> ranks; /**< The rank of each team by its best pass (starting at 1, teams with the same best score share a rank). */
+  };
+
+  /**
+   * Constructor.
+   * @param robotPoses The set of poses at which robots can be placed.
+   */
+  explicit Rescorer(const QVector<Pose2D>& robotPoses);
+
+  /**
+   * Adds a finished pass. Passes with the same robots are scored together in one batch.
+   * @param team The name of the team.
+   * @param robotNumbers The jersey numbers of the robots.
+   * @param attempts The attempts of the pass.
+   * @return Whether the pass has been added (false if a jersey number has no pose).
+   */
+  bool addPass(const QString& team, const QVector<unsigned int>& robotNumbers, const QVector<Attempt>& attempts);
+
+  /**
+   * Returns the teams that have done at least one of the added passes.
+   * @return The names of the teams in the order in which their first pass has been added.
+   */
+  const QStringList& getTeams() const;
+
+  /**
+   * Returns the number of added passes.
+   * @return The number of passes.
+   */
+  int getNumOfPasses() const;
+
+  /**
+   * Returns the number of attempts of all added passes.
+   * @return The number of attempts.
+   */
+  int getNumOfAttempts() const;
+
+  /**
+   * Scores all passes with one set of thresholds on the calling thread.
+   * @param rules The rules with the thresholds and the field geometry.
+   * @return The standings.
+   */
+  Result score(const ScoringRules::Definition& rules) const;
+
+  /**
+   * Scores all passes with each of many sets of thresholds on all threads of a pool. The results are the same as the ones of \c score.
+   * @param ruleSets The rules with each set of thresholds and field geometry.
+   * @param pool The threads that score the passes.
+   * @return The standings under each set of thresholds (in the order of the sets).
+   */
+  QVector<Result> sweep(const QVector<ScoringRules::Definition>& ruleSets, ThreadPool& pool) const;
+
+  /**
+   * Returns the number of teams whose rank differs between two results.
+   * @param result The standings under some thresholds.
+   * @param baseline The standings to which they are compared (e.g. under the thresholds of the rules).
+   * @return The number of teams with another rank.
+   */
+  static int countRankChanges(const Result& result, const Result& baseline);
+
+  /**
+   * Creates all combinations of the given values of each threshold. Combinations whose minimum deviation is not
+   * smaller than their maximum deviation are left out.
+   * @param baseRules The rules from which the weights and the choice of the reference robot are taken.
+   * @param minDeviations The values of the minimum deviation.
+   * @param maxDeviations The values of the maximum deviation.
+   * @param fieldHalfLengths The values of half the length of the "same field" area.
+   * @param fieldHalfWidths The values of half the width of the "same field" area.
+   * @return The rules with each set of thresholds.
+   */
+  static QVector<ScoringRules::Definition> createGrid(const ScoringRules::Definition& baseRules, const QVector<float>& minDeviations, const QVector<float>& maxDeviations,
+                                                      const QVector<float>& fieldHalfLengths, const QVector<float>& fieldHalfWidths);
+
+private:
+  /** The reports of all passes that have been done with the same robots. */
+  struct Group
+  {
+    QVector<Pose2D> robotSetup; /**< The poses of the robots. */
+    BatchMetric::Reports reports; /**< The reports of all attempts that did not time out. */
+    std::vector<int> passes; /**< The index of the pass of each report. */
+  };
+
+  /**
+   * Scores all passes with one set of thresholds.
+   * @param rules The rules with the thresholds and the field geometry.
+   * @param scores A buffer for the scores of a group.
+   * @param passScores A buffer for the score of each pass.
+   * @param result The standings.
+   */
+  void score(const ScoringRules::Definition& rules, BatchMetric::Scores& scores, std::vector<float>& passScores, Result& result) const;
+
+  QVector<Pose2D> robotPoses; /**< The set of poses at which robots can be placed. */
+  QStringList teams; /**< The names of the teams. */
+  std::vector<int> passTeams; /**< The index of the team of each pass. */
+  std::vector<Group> groups; /**< The reports, grouped by robots. */
+  QMap<QVector<unsigned int>, int> groupIndices; /**< The index of the group of each set of robots. */
+  int numOfAttempts = 0; /**< The number of attempts of all passes. */
+};
@@ -0,0 +1,145 @@
+/**
+ * @file ResultJson.h
+ *
+ * This file defines functions that convert results of challenge passes to JSON.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Challenge.h"
+#include "LatencyProfile.h"
+#include "LogAnalyzer.h"
+#include "SPLStandardMessageReceiver.h"
+#include <QJsonArray>
+#include <QJsonObject>
+
+class ResultJson
+{
+public:
+  /**
+   * This function converts an attempt to a JSON object.
+   * @param attemptIndex The index of the attempt within its pass.
+   * @param attempt The attempt.
+   * @return A JSON object with the (one-based) attempt and location numbers, the remaining time (ms), the reported whistle and the score.
+   */
+  static QJsonObject fromAttempt(int attemptIndex, const Challenge::Attempt& attempt)
+  {
+    const bool timedOut = attempt.remainingTime == -1;
+
+    QJsonObject object;
+    object["attempt"] = attemptIndex + 1;
+    object["location"] = attempt.locationIndex + 1;
+    object["timedOut"] = timedOut;
+    if(!timedOut)
+    {
+      QJsonObject reportedLocation;
+      reportedLocation["x"] = attempt.whistle.location.x;
+      reportedLocation["y"] = attempt.whistle.location.y;
+      object["remainingTime"] = attempt.remainingTime / 1000.0;
+      object["reportedLocation"] = reportedLocation;
+      object["reportedField"] = attempt.whistle.onSameField ? "same" : "other";
+    }
+    object["score"] = attempt.score;
+    return object;
+  }
+
+  /**
+   * This function converts the counters of a receiver to a JSON object.
+   * @param counters The counters.
+   * @return A JSON object with the number of received datagrams, the number per verdict, the number of whistles dropped due to a full queue and the number of datagrams missing from the capture.
+   */
+  static QJsonObject fromCounters(const SPLStandardMessageReceiver::Counters& counters)
+  {
+    QJsonObject object;
+    object["received"] = static_cast<double>(counters.getReceived());
+    for(int verdict = 0; verdict < SPLStandardMessageReceiver::numOfVerdicts; ++verdict)
+      object[SPLStandardMessageReceiver::getName(static_cast<SPLStandardMessageReceiver::Verdict>(verdict))] = static_cast<double>(counters.get(static_cast<SPLStandardMessageReceiver::Verdict>(verdict)));
+    object["queueFull"] = static_cast<double>(counters.getQueueFull());
+    object["captureDropped"] = static_cast<double>(counters.getCaptureDropped());
+    return object;
+  }
+
+  /**
+   * This function converts the latency profile to a JSON object.
+   * @param profile The latency profile.
+   * @return A JSON object with the number of samples and the percentiles (microseconds) of each stage for which samples have been recorded.
+   */
+  static QJsonObject fromLatencyProfile(const LatencyProfile& profile)
+  {
+    QJsonObject object;
+    for(int stage = 0; stage < LatencyProfile::numOfStages; ++stage)
+    {
+      const LatencyHistogram& histogram = profile.getHistogram(static_cast<LatencyProfile::Stage>(stage));
+      if(histogram.getCount())
+        object[LatencyProfile::getName(static_cast<LatencyProfile::Stage>(stage))] = fromLatencyHistogram(histogram);
+    }
+    return object;
+  }
+
+  /**
+   * This function converts a latency histogram to a JSON object.
+   * @param histogram The histogram.
+   * @return A JSON object with the number of samples and the percentiles (microseconds).
+   */
+  static QJsonObject fromLatencyHistogram(const LatencyHistogram& histogram)
+  {
+    QJsonObject object;
+    object["count"] = static_cast<double>(histogram.getCount());
+    for(double percentile : LatencyProfile::percentiles)
+      object[percentile == 100.0 ? QString("max") : "p" + QString::number(percentile)] = histogram.getPercentile(percentile) / 1000.0;
+    return object;
+  }
+
+  /**
+   * This function converts a pass that has been rebuilt from a log to a JSON object.
+   * @param pass The pass.
+   * @return A JSON object with the log file, the start time, the team, the robots, the field (if known), the status,
+   *         the total score and the attempts (in the same format as \c fromAttempt plus the actual location).
+   */
+  static QJsonObject fromLoggedPass(const LogAnalyzer::Pass& pass)
+  {
+    static const char* statusNames[] = {"incomplete", "finished", "aborted"};
+
+    QJsonArray robots;
+    for(unsigned int jerseyNumber : pass.robotNumbers)
+      robots.append(static_cast<int>(jerseyNumber));
+    QJsonArray attempts;
+    for(int i = 0; i < pass.attempts.size(); ++i)
+    {
+      const LogAnalyzer::Attempt& attempt = pass.attempts[i];
+      QJsonObject object;
+      object["attempt"] = i + 1;
+      object["location"] = attempt.location;
+      object["finished"] = attempt.finished;
+      object["timedOut"] = attempt.timedOut;
+      if(attempt.finished && !attempt.timedOut)
+      {
+        QJsonObject actualLocation, reportedLocation;
+        actualLocation["x"] = attempt.actualLocation.x;
+        actualLocation["y"] = attempt.actualLocation.y;
+        reportedLocation["x"] = attempt.reportedLocation.x;
+        reportedLocation["y"] = attempt.reportedLocation.y;
+        object["remainingTime"] = attempt.remainingTime;
+        object["actualLocation"] = actualLocation;
+        object["reportedLocation"] = reportedLocation;
+        object["reportedField"] = attempt.reportedOnSameField ? "same" : "other";
+      }
+      object["score"] = attempt.score;
+      attempts.append(object);
+    }
+
+    QJsonObject object;
+    object["file"] = pass.file;
+    object["startTime"] = pass.startTime;
+    object["team"] = pass.team;
+    object["robots"] = robots;
+    if(pass.field)
+      object["field"] = pass.field;
+    object["status"] = statusNames[pass.status];
+    object["totalScore"] = pass.totalScore;
+    object["attempts"] = attempts;
+    return object;
+  }
+};
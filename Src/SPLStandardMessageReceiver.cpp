@@ -7,64 +7,214 @@
  */
 
 #include "SPLStandardMessageReceiver.h"
+#include "BatchedDatagramReceiver.h"
+#include "Capture.h"
+#include "LatencyProfile.h"
 #include "SPLStandardMessage.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include <QSocketNotifier>
 #include <QUdpSocket>
-#include <cstddef>
+#include <algorithm>
 #include <cstring>
 
-SPLStandardMessageReceiver::SPLStandardMessageReceiver(unsigned int teamNumber, QObject* parent) :
+SPLStandardMessageReceiver::SPLStandardMessageReceiver(unsigned int teamNumber, QObject* parent, Backend backend) :
   QObject(parent),
-  teamNumber(teamNumber)
+  teamNumber(teamNumber),
+  captureWriter(nullptr),
+  traceField(Tracer::getField())
 {
   Q_ASSERT(teamNumber < 100);
 
+  const quint16 port = static_cast<quint16>(10000 + teamNumber);
+
+#ifdef __linux__
+  if(backend != Backend::qt)
+  {
+    batchedReceiver.reset(new BatchedDatagramReceiver(port));
+    if(batchedReceiver->isOpen() && backend == Backend::multiplexed)
+    {
+      multiplexed = true;
+      return;
+    }
+    if(batchedReceiver->isOpen())
+    {
+      batchedNotifier = new QSocketNotifier(batchedReceiver->getSocketDescriptor(), QSocketNotifier::Read, this);
+      connect(batchedNotifier, SIGNAL(activated(int)), this, SLOT(handleReceivedBatches()));
+      return;
+    }
+    batchedReceiver.reset();
+  }
+#else
+  static_cast<void>(backend);
+#endif
+
   socket = new QUdpSocket(this);
-  socket->bind(QHostAddress::Any, static_cast<quint16>(10000 + teamNumber), QAbstractSocket::ReuseAddressHint);
+  socket->bind(QHostAddress::Any, port, QAbstractSocket::ReuseAddressHint);
   connect(socket, &QUdpSocket::readyRead, this, &SPLStandardMessageReceiver::handleReceivedMessages);
 }
 
+SPLStandardMessageReceiver::~SPLStandardMessageReceiver() = default;
+
+SPLStandardMessageReceiver::Backend SPLStandardMessageReceiver::getBackend() const
+{
+  return multiplexed ? Backend::multiplexed : batchedReceiver ? Backend::batched : Backend::qt;
+}
+
+bool SPLStandardMessageReceiver::isOpen() const
+{
+#ifdef __linux__
+  if(batchedReceiver)
+    return batchedReceiver->isOpen();
+#endif
+  return socket->state() == QAbstractSocket::BoundState;
+}
+
+int SPLStandardMessageReceiver::getSocketDescriptor() const
+{
+#ifdef __linux__
+  return batchedReceiver ? batchedReceiver->getSocketDescriptor() : -1;
+#else
+  return -1;
+#endif
+}
+
 void SPLStandardMessageReceiver::handleReceivedMessages()
 {
+  TRACE_FIELD(traceField);
+  bool enqueued = false;
   while(socket->hasPendingDatagrams())
   {
     SPLStandardMessage message;
     const quint64 actualSize = std::max<qint64>(0, socket->readDatagram(reinterpret_cast<char*>(&message), sizeof(SPLStandardMessage)));
+    const std::int64_t timestamp = Clock::getTime();
+    enqueued |= handleDatagram(message, actualSize, timestamp, timestamp);
+  }
+  if(enqueued)
+    emit whistleLocationsReceived();
+}
 
-    // The usual sanity checks for an SPL standard message.
-    if(actualSize < offsetof(SPLStandardMessage, data) || actualSize > sizeof(SPLStandardMessage))
-    {
-      qDebug().nospace() << "Receiving SPLStandardMessage failed!";
-      break;
-    }
-    if(std::strncmp(message.header, SPL_STANDARD_MESSAGE_STRUCT_HEADER, sizeof(message.header)) != 0)
-    {
-      qDebug().nospace() << "SPLStandardMessage: Header mismatch!";
-      break;
-    }
-    // A different version number does not indicate an error because it may be a message that is meant for other robots.
-    // Still, it should be ignored.
-    if(message.version != specialSPLStandardMessageVersion)
-      break;
-    if(message.playerNum < 1 || message.playerNum > 5)
-    {
-      qDebug().nospace() << "SPLStandardMessage: Player number must be in [1, 5] (is " << message.playerNum << ")!";
-      break;
-    }
-    if(message.teamNum != teamNumber)
+void SPLStandardMessageReceiver::handleReceivedBatches()
+{
+  while(receivePending(1));
+}
+
+bool SPLStandardMessageReceiver::receivePending(unsigned int maxBatches)
+{
+#ifdef __linux__
+  TRACE_FIELD(traceField);
+  bool enqueued = false;
+  unsigned int received = 0;
+  for(unsigned int batch = 0; batch < maxBatches; ++batch)
+  {
+    received = batchedReceiver->receiveBatch();
+    const std::int64_t timestamp = Clock::getTime();
+    TRACE_INSTANT("receiveBatch", "datagrams", received);
+    for(unsigned int i = 0; i < received; ++i)
     {
-      qDebug().nospace() << "SPLStandardMessage: Team number must be the correct one for this port (should be " << teamNumber << ", is " << message.teamNum << ")!";
-      break;
+      const std::int64_t arrivalTime = batchedReceiver->getTimestamp(i) ? batchedReceiver->getTimestamp(i) : timestamp;
+      enqueued |= handleDatagram(batchedReceiver->getMessage(i), batchedReceiver->getSize(i), arrivalTime, timestamp);
     }
-    if(message.numOfDataBytes > SPL_STANDARD_MESSAGE_DATA_SIZE || offsetof(SPLStandardMessage, data) + message.numOfDataBytes > actualSize)
-    {
-      qDebug().nospace() << "SPLStandardMessage: Illegal number of data bytes (is " << message.numOfDataBytes << ")!";
+    if(received < BatchedDatagramReceiver::batchSize)
       break;
-    }
+  }
+  if(enqueued)
+    emit whistleLocationsReceived();
+  return received == BatchedDatagramReceiver::batchSize;
+#else
+  static_cast<void>(maxBatches);
+  return false;
+#endif
+}
 
-    DetectedWhistle whistle;
-    whistle.onSameField = message.fallen != 0;
-    whistle.location = Vector2D(message.pose[0] / 1000.f, message.pose[1] / 1000.f);
+bool SPLStandardMessageReceiver::handleDatagram(const SPLStandardMessage& message, std::size_t actualSize, std::int64_t arrivalTime, std::int64_t readTime)
+{
+  // Every path that reads from the socket comes through here, so all of them record, count and skip invalid messages alike.
+  // An invalid message must not prevent the following ones from being handled.
+  CaptureWriter* writer = captureWriter.load(std::memory_order_acquire);
+  if(writer && !writer->writeDatagram(arrivalTime, reinterpret_cast<const char*>(&message), actualSize))
+    counters.countCaptureDropped();
+  DetectedWhistle whistle;
+  whistle.timestamp = arrivalTime;
+  const Verdict verdict = decodeMessage(message, actualSize, teamNumber, whistle);
+  counters.count(verdict);
+  TRACE_INSTANT(getName(verdict), "size", static_cast<std::int64_t>(actualSize));
+  if(verdict != valid)
+    return false;
+  if(arrivalTime != readTime)
+    LatencyProfile::getInstance().record(LatencyProfile::arrival, readTime - arrivalTime);
+  return enqueueWhistle(whistle, readTime);
+}
 
-    emit whistleLocationReceived(whistle);
-  }
+void SPLStandardMessageReceiver::setCaptureWriter(CaptureWriter* writer)
+{
+  captureWriter.store(writer, std::memory_order_release);
+}
+
+SPLStandardMessageReceiver::Verdict SPLStandardMessageReceiver::decodeMessage(const SPLStandardMessage& message, std::size_t actualSize, unsigned int teamNumber, DetectedWhistle& whistle)
+{
+  // The usual sanity checks for an SPL standard message.
+  if(actualSize < offsetof(SPLStandardMessage, data) || actualSize > sizeof(SPLStandardMessage))
+    return badSize;
+  if(std::strncmp(message.header, SPL_STANDARD_MESSAGE_STRUCT_HEADER, sizeof(message.header)) != 0)
+    return badHeader;
+  // A different version number does not indicate an error because it may be a message that is meant for other robots.
+  // Still, it should be ignored.
+  if(message.version != specialSPLStandardMessageVersion)
+    return otherVersion;
+  if(message.playerNum < 1 || message.playerNum > 5)
+    return badPlayerNum;
+  if(message.teamNum != teamNumber)
+    return wrongTeamNum;
+  if(message.numOfDataBytes > SPL_STANDARD_MESSAGE_DATA_SIZE || offsetof(SPLStandardMessage, data) + message.numOfDataBytes > actualSize)
+    return badNumOfDataBytes;
+
+  whistle.onSameField = message.fallen != 0;
+  whistle.location = Vector2D(message.pose[0] / 1000.f, message.pose[1] / 1000.f);
+  return valid;
+}
+
+const char* SPLStandardMessageReceiver::getName(Verdict verdict)
+{
+  static const char* names[numOfVerdicts] = {"valid", "badSize", "badHeader", "otherVersion", "badPlayerNum", "wrongTeamNum", "badNumOfDataBytes"};
+  return names[verdict];
+}
+
+SPLStandardMessageReceiver::Counters::Counters() :
+  queueFull(0),
+  captureDropped(0)
+{
+  for(std::atomic<std::uint64_t>& counter : verdicts)
+    counter.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t SPLStandardMessageReceiver::Counters::getReceived() const
+{
+  std::uint64_t received = 0;
+  for(const std::atomic<std::uint64_t>& counter : verdicts)
+    received += counter.load(std::memory_order_relaxed);
+  return received;
+}
+
+QString SPLStandardMessageReceiver::Counters::toString() const
+{
+  QString result = "received " + QString::number(getReceived());
+  for(int verdict = 0; verdict < numOfVerdicts; ++verdict)
+    if(get(static_cast<Verdict>(verdict)) || verdict == valid)
+      result += QString(", ") + getName(static_cast<Verdict>(verdict)) + " " + QString::number(get(static_cast<Verdict>(verdict)));
+  if(getQueueFull())
+    result += ", queueFull " + QString::number(getQueueFull());
+  if(getCaptureDropped())
+    result += ", captureDropped " + QString::number(getCaptureDropped());
+  return result;
+}
+
+bool SPLStandardMessageReceiver::enqueueWhistle(DetectedWhistle& whistle, std::int64_t readTime)
+{
+  whistle.queueTimestamp = Clock::getTime();
+  LatencyProfile::getInstance().record(LatencyProfile::validation, whistle.queueTimestamp - readTime);
+  if(whistleQueue.push(whistle))
+    return true;
+  counters.countQueueFull();
+  return false;
 }
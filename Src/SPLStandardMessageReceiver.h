@@ -9,35 +9,249 @@
 #pragma once
 
 #include "DetectedWhistle.h"
+#include "Util/SPSCQueue.h"
 #include <QObject>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 
+class BatchedDatagramReceiver;
+class CaptureWriter;
+class QSocketNotifier;
 class QUdpSocket;
+struct SPLStandardMessage;
 
 class SPLStandardMessageReceiver : public QObject
 {
   Q_OBJECT
 public:
+  using WhistleQueue = SPSCQueue<DetectedWhistle, 256>; /**< The queue through which whistles are handed over to the thread that evaluates them. */
+
+  static constexpr std::uint8_t specialSPLStandardMessageVersion = 255; /**< Messages meant for the tester must have this special version number. */
+
+  /** The result of checking a received message (one for each check, in the order in which they are applied). */
+  enum Verdict
+  {
+    valid, /**< The message is a valid whistle message for the tester. */
+    badSize, /**< The datagram is too short or too long to be an SPL standard message. */
+    badHeader, /**< The message does not start with the SPL standard message header. */
+    otherVersion, /**< The message is not meant for the tester (e.g. regular team communication). */
+    badPlayerNum, /**< The player number is not in [1, 5]. */
+    wrongTeamNum, /**< The team number does not match the port. */
+    badNumOfDataBytes, /**< The number of data bytes exceeds the message. */
+    numOfVerdicts
+  };
+
+  /**
+   * Returns the name of a verdict.
+   * @param verdict The verdict.
+   * @return The name of the verdict.
+   */
+  static const char* getName(Verdict verdict);
+
+  /** Counters of all received datagrams by verdict. They are written by the receiver thread only and can be read from any thread. */
+  class Counters
+  {
+  public:
+    /** Constructor. */
+    Counters();
+
+    /**
+     * Counts a received datagram.
+     * @param verdict The result of checking it.
+     */
+    void count(Verdict verdict)
+    {
+      increment(verdicts[verdict]);
+    }
+
+    /** Counts a valid whistle message that has been dropped because the whistle queue was full. */
+    void countQueueFull()
+    {
+      increment(queueFull);
+    }
+
+    /** Counts a datagram that could not be recorded because the ring of the capture was full. */
+    void countCaptureDropped()
+    {
+      increment(captureDropped);
+    }
+
+    /**
+     * Returns the number of datagrams with a verdict.
+     * @param verdict The verdict.
+     * @return The number of datagrams with this verdict.
+     */
+    std::uint64_t get(Verdict verdict) const
+    {
+      return verdicts[verdict].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of valid whistle messages that have been dropped because the whistle queue was full.
+     * @return The number of dropped whistle messages.
+     */
+    std::uint64_t getQueueFull() const
+    {
+      return queueFull.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of datagrams that are missing from the capture because its ring was full.
+     * @return The number of datagrams that have not been recorded.
+     */
+    std::uint64_t getCaptureDropped() const
+    {
+      return captureDropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of all received datagrams.
+     * @return The sum of the counters of all verdicts.
+     */
+    std::uint64_t getReceived() const;
+
+    /**
+     * Returns a summary of all counters for the log.
+     * @return The number of received datagrams followed by the non-zero counters.
+     */
+    QString toString() const;
+
+  private:
+    /**
+     * Increments a counter. Since there is only one writer, this does not need an atomic read-modify-write operation.
+     * @param counter The counter.
+     */
+    static void increment(std::atomic<std::uint64_t>& counter)
+    {
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<std::uint64_t>, numOfVerdicts> verdicts; /**< The number of datagrams per verdict. */
+    std::atomic<std::uint64_t> queueFull; /**< The number of valid whistle messages that did not fit into the whistle queue. */
+    std::atomic<std::uint64_t> captureDropped; /**< The number of datagrams that did not fit into the ring of the capture. */
+  };
+
+  /** The implementation that is used to read datagrams from the socket. */
+  enum class Backend
+  {
+    automatic, /**< Use the batched backend if it is available, otherwise Qt. */
+    qt, /**< Read one datagram at a time via \c QUdpSocket. */
+    batched, /**< Read batches of datagrams via recvmmsg (Linux only, falls back to Qt elsewhere). */
+    multiplexed /**< Like \c batched, but the socket is watched by a \c ReceiverMultiplexer that calls \c receivePending (Linux only, falls back to Qt elsewhere). */
+  };
+
   /**
    * Constructor. Creates and binds a socket and registers a message handler.
    * @param teamNumber The number of the team for which to receive messages.
    * @param parent The Qt parent object.
+   * @param backend The implementation that is used to read datagrams from the socket.
    */
-  explicit SPLStandardMessageReceiver(unsigned int teamNumber, QObject* parent = nullptr);
+  explicit SPLStandardMessageReceiver(unsigned int teamNumber, QObject* parent = nullptr, Backend backend = Backend::automatic);
+
+  /** Destructor. */
+  ~SPLStandardMessageReceiver() override;
+
+  /**
+   * Returns the implementation that is actually used to read datagrams from the socket.
+   * @return Either \c Backend::qt, \c Backend::batched or \c Backend::multiplexed.
+   */
+  Backend getBackend() const;
 
-signals:
   /**
-   * This signal is emitted when a (complete and formally correct) whistle location has been received.
-   * @param whistle The whistle reported by the robots.
+   * Returns whether the socket could be bound to the port of the team.
+   * @return Whether messages can be received.
    */
-  void whistleLocationReceived(const DetectedWhistle& whistle);
+  bool isOpen() const;
+
+  /**
+   * Returns the native descriptor of the socket (for the multiplexed backend).
+   * @return The native descriptor of the socket or -1 if the Qt backend is used.
+   */
+  int getSocketDescriptor() const;
+
+  /**
+   * Receives pending messages, checks them and emits a signal if whistles have been appended to the queue.
+   * This is used by the multiplexed backend and may be called from any thread, but not concurrently.
+   * @param maxBatches The maximum number of batches to receive (so that other sockets get their turn if a team floods its port).
+   * @return Whether the socket may still have pending messages.
+   */
+  bool receivePending(unsigned int maxBatches);
+
+  /**
+   * Returns the queue of received whistles. The receiver is its only producer, so there must be at most one consumer.
+   * @return The queue of received whistles.
+   */
+  WhistleQueue& getWhistleQueue()
+  {
+    return whistleQueue;
+  }
+
+  /**
+   * Returns the counters of all datagrams that have been received.
+   * @return The counters.
+   */
+  const Counters& getCounters() const
+  {
+    return counters;
+  }
+
+  /**
+   * Sets the capture into which all received datagrams are recorded. This may be called while messages are received in another thread,
+   * but the previous writer must not be deleted before the receiver has stopped receiving.
+   * @param writer The capture writer (nullptr to disable recording).
+   */
+  void setCaptureWriter(CaptureWriter* writer);
+
+  /**
+   * Checks a received message and converts it to a whistle.
+   * @param message The buffer into which the message has been received.
+   * @param actualSize The number of bytes that have actually been received.
+   * @param teamNumber The number of the team for which messages are accepted.
+   * @param whistle The whistle that is filled from the message if it is valid (except for its timestamp).
+   * @return \c valid if the message is a valid message for the tester, otherwise the check that failed.
+   */
+  static Verdict decodeMessage(const SPLStandardMessage& message, std::size_t actualSize, unsigned int teamNumber, DetectedWhistle& whistle);
+
+signals:
+  /** This signal is emitted when (complete and formally correct) whistle locations have been appended to the whistle queue. */
+  void whistleLocationsReceived();
 
 private slots:
   /** Handles all received messages, checks them and emits signals for them. */
   void handleReceivedMessages();
 
+  /** Receives batches of messages until the socket is drained, checks them and emits signals for them. */
+  void handleReceivedBatches();
+
 private:
-  static constexpr std::uint8_t specialSPLStandardMessageVersion = 255; /**< Messages meant for the tester must have this special version number. */
+  /**
+   * Records, checks and counts a single received datagram and appends it to the whistle queue if it is a valid whistle message.
+   * @param message The buffer into which the message has been received.
+   * @param actualSize The number of bytes that have actually been received.
+   * @param arrivalTime The time at which the datagram arrived (the kernel timestamp if there is one).
+   * @param readTime The time at which the datagram has been read from the socket.
+   * @return Whether a whistle has been appended to the queue.
+   */
+  bool handleDatagram(const SPLStandardMessage& message, std::size_t actualSize, std::int64_t arrivalTime, std::int64_t readTime);
+
+  /**
+   * Appends a whistle to the whistle queue.
+   * @param whistle The whistle reported by the robots (its queue timestamp is set).
+   * @param readTime The time at which the datagram has been read from the socket (for the latency profile).
+   * @return Whether the whistle could be appended.
+   */
+  bool enqueueWhistle(DetectedWhistle& whistle, std::int64_t readTime);
 
-  QUdpSocket* socket; /**< The socket which receives messages. */
+  QUdpSocket* socket = nullptr; /**< The socket which receives messages (if the Qt backend is used). */
+  std::unique_ptr<BatchedDatagramReceiver> batchedReceiver; /**< The socket and buffers which receive messages (if the batched backend is used). */
+  QSocketNotifier* batchedNotifier = nullptr; /**< The notifier that signals pending datagrams for the batched backend. */
+  bool multiplexed = false; /**< Whether the socket is watched by a \c ReceiverMultiplexer instead of \c batchedNotifier. */
   unsigned int teamNumber; /**< The number of the team for which to receive messages. */
+  WhistleQueue whistleQueue; /**< The queue of received whistles. */
+  Counters counters; /**< The counters of all received datagrams. */
+  std::atomic<CaptureWriter*> captureWriter; /**< The capture into which all received datagrams are recorded (if any). */
+  int traceField; /**< The field with which the trace events of this receiver are tagged (the one that was set when it was created). */
 };
@@ -0,0 +1,65 @@
+/**
+ * @file ScoreSurface.cpp
+ *
+ * This file implements a class that calculates the score for every reported location on a grid over the field.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ScoreSurface.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+constexpr int ScoreSurface::tileSize;
+
+void ScoreSurface::calculate(const QVector<Pose2D>& robotSetup, const Vector2D& actualWhistleLocation, const Grid& grid, const ScoringRules::Definition& rules,
+                             std::vector<float>& scores, unsigned numOfThreads)
+{
+  scores.resize(static_cast<std::size_t>(grid.width) * grid.height);
+
+  const int tilesPerRow = (grid.width + tileSize - 1) / tileSize;
+  const int numOfTiles = tilesPerRow * ((grid.height + tileSize - 1) / tileSize);
+  const bool isActuallyOnSameField = Metric::isOnSameField(actualWhistleLocation, rules);
+
+  // Threads take the next tile from a shared counter, so that tiles that take longer do not stall the others.
+  std::atomic<int> nextTile(0);
+  auto work = [&]
+  {
+    BatchMetric::Reports reports;
+    BatchMetric::Scores tileScores;
+    for(int tile = nextTile++; tile < numOfTiles; tile = nextTile++)
+    {
+      const int column0 = (tile % tilesPerRow) * tileSize, row0 = (tile / tilesPerRow) * tileSize;
+      const int columns = std::min(tileSize, grid.width - column0), rows = std::min(tileSize, grid.height - row0);
+
+      reports.resize(static_cast<std::size_t>(columns) * rows);
+      std::size_t i = 0;
+      for(int row = row0; row < row0 + rows; ++row)
+        for(int column = column0; column < column0 + columns; ++column, ++i)
+        {
+          const Vector2D location = grid.getLocation(column, row);
+          reports.reportedX[i] = location.x;
+          reports.reportedY[i] = location.y;
+          reports.reportedOnSameField[i] = isActuallyOnSameField ? 1 : 0;
+          reports.actualX[i] = actualWhistleLocation.x;
+          reports.actualY[i] = actualWhistleLocation.y;
+        }
+      ScoringRules::calculateScores(rules, robotSetup, reports, tileScores);
+
+      for(int row = 0; row < rows; ++row)
+        std::copy(tileScores.total.begin() + row * columns, tileScores.total.begin() + (row + 1) * columns,
+                  scores.begin() + static_cast<std::size_t>(row0 + row) * grid.width + column0);
+    }
+  };
+
+  if(!numOfThreads)
+    numOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  numOfThreads = std::min(numOfThreads, static_cast<unsigned>(std::max(1, numOfTiles)));
+  std::vector<std::thread> threads;
+  for(unsigned i = 1; i < numOfThreads; ++i)
+    threads.emplace_back(work);
+  work();
+  for(std::thread& thread : threads)
+    thread.join();
+}
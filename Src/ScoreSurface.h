@@ -0,0 +1,56 @@
+/**
+ * @file ScoreSurface.h
+ *
+ * This file declares a class that calculates the score for every reported location on a grid over the field.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "ScoringRules.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QVector>
+#include <vector>
+
+class ScoreSurface
+{
+public:
+  static constexpr int tileSize = 64; /**< The edge length (cells) of the tiles that are distributed to the threads. */
+
+  /** A regular grid of reported locations. Cell (0, 0) is at the minimum corner and rows are stored consecutively. */
+  struct Grid
+  {
+    float minX = 0.f; /**< The x coordinate of the center of the first column (in meters). */
+    float minY = 0.f; /**< The y coordinate of the center of the first row (in meters). */
+    float resolution = 0.01f; /**< The distance between neighboring cells (in meters). */
+    int width = 0; /**< The number of columns. */
+    int height = 0; /**< The number of rows. */
+
+    /**
+     * Returns the location of the center of a cell.
+     * @param column The column of the cell.
+     * @param row The row of the cell.
+     * @return The location in field coordinates.
+     */
+    Vector2D getLocation(int column, int row) const
+    {
+      return Vector2D(minX + column * resolution, minY + row * resolution);
+    }
+  };
+
+  /**
+   * Calculates the score of every cell of a grid as if it was the reported location of a whistle.
+   * The "same field"/"other field" decision is assumed to be correct, i.e. the scores are at least the weight of the decision
+   * (in [1, 3] with the official rules). The grid is split into tiles that are processed by multiple threads.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param actualWhistleLocation The ground-truth position of the whistle in field coordinates.
+   * @param grid The grid of reported locations.
+   * @param rules The rules with which the reports are scored.
+   * @param scores The scores, which are resized to the number of cells.
+   * @param numOfThreads The number of threads to use (0 for one per core).
+   */
+  static void calculate(const QVector<Pose2D>& robotSetup, const Vector2D& actualWhistleLocation, const Grid& grid, const ScoringRules::Definition& rules,
+                        std::vector<float>& scores, unsigned numOfThreads = 0);
+};
@@ -0,0 +1,274 @@
+/**
+ * @file ScoringRules.cpp
+ *
+ * This file implements a class that scores whistle reports with rules that are read from the configuration.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ScoringRules.h"
+#include "Util/Paths.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace
+{
+  /**
+   * Reads a number from a JSON object if it is there.
+   * @param object The JSON object.
+   * @param key The key of the number.
+   * @param value The number (unchanged if the key does not exist).
+   * @return Whether the key does not exist or its value is a number.
+   */
+  bool readNumber(const QJsonObject& object, const QString& key, float& value)
+  {
+    if(!object.contains(key))
+      return true;
+    if(!object[key].isDouble())
+      return false;
+    value = static_cast<float>(object[key].toDouble());
+    return true;
+  }
+
+  /**
+   * Reads a section of the rules if it is there.
+   * @param rules The JSON object of the rules.
+   * @param key The key of the section.
+   * @param section The section (unchanged if the key does not exist).
+   * @return Whether the key does not exist or its value is an object.
+   */
+  bool readSection(const QJsonObject& rules, const QString& key, QJsonObject& section)
+  {
+    if(!rules.contains(key))
+      return true;
+    if(!rules[key].isObject())
+      return false;
+    section = rules[key].toObject();
+    return true;
+  }
+
+  /**
+   * Multiplies the components of batch scores by their weights.
+   * @param definition The rules that contain the weights.
+   * @param scores The scores, whose totals are updated.
+   */
+  void weigh(const ScoringRules::Definition& definition, BatchMetric::Scores& scores)
+  {
+    if(definition.onSameFieldDecisionWeight == 1.f && definition.directionWeight == 1.f && definition.distanceWeight == 1.f)
+      return;
+    for(std::size_t i = 0; i < scores.total.size(); ++i)
+    {
+      scores.onSameFieldDecision[i] *= definition.onSameFieldDecisionWeight;
+      scores.direction[i] *= definition.directionWeight;
+      scores.distance[i] *= definition.distanceWeight;
+      scores.total[i] = scores.onSameFieldDecision[i] + scores.direction[i] + scores.distance[i];
+    }
+  }
+}
+
+bool ScoringRules::read(const QString& path, Definition& definition, QString& error)
+{
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    error = "The file could not be opened.";
+    return false;
+  }
+  return fromJson(file.readAll(), definition, error);
+}
+
+bool ScoringRules::fromJson(const QByteArray& json, Definition& definition, QString& error)
+{
+  QJsonParseError parseError;
+  const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+  if(!document.isObject())
+  {
+    error = parseError.error != QJsonParseError::NoError ? parseError.errorString() : "The rules must be a JSON object.";
+    return false;
+  }
+
+  const QJsonObject rules = document.object();
+  QJsonObject weights, direction, distance, field;
+  if(!readSection(rules, "weights", weights) || !readSection(rules, "direction", direction) ||
+     !readSection(rules, "distance", distance) || !readSection(rules, "field", field))
+  {
+    error = "The weights, direction, distance and field must be JSON objects.";
+    return false;
+  }
+  if(!readNumber(weights, "onSameFieldDecision", definition.onSameFieldDecisionWeight) || !readNumber(weights, "direction", definition.directionWeight) ||
+     !readNumber(weights, "distance", definition.distanceWeight) ||
+     !readNumber(direction, "minDeviation", definition.minDirectionDeviation) || !readNumber(direction, "maxDeviation", definition.maxDirectionDeviation) ||
+     !readNumber(distance, "minDeviation", definition.minDistanceDeviation) || !readNumber(distance, "maxDeviation", definition.maxDistanceDeviation) ||
+     !readNumber(field, "halfLength", definition.fieldHalfLength) || !readNumber(field, "halfWidth", definition.fieldHalfWidth))
+  {
+    error = "All weights, deviations and field sizes must be numbers.";
+    return false;
+  }
+  if(definition.onSameFieldDecisionWeight < 0.f || definition.directionWeight < 0.f || definition.distanceWeight < 0.f)
+  {
+    error = "The weights must not be negative.";
+    return false;
+  }
+  if(definition.minDirectionDeviation >= definition.maxDirectionDeviation || definition.minDistanceDeviation >= definition.maxDistanceDeviation)
+  {
+    error = "Each minimum deviation must be smaller than the maximum deviation.";
+    return false;
+  }
+  if(definition.fieldHalfLength <= 0.f || definition.fieldHalfWidth <= 0.f)
+  {
+    error = "The field sizes must be positive.";
+    return false;
+  }
+
+  // A value that is not a string becomes empty and is rejected below.
+  const QString referenceRobot = rules.contains("referenceRobot") ? rules["referenceRobot"].toString() : QString("closest");
+  if(referenceRobot == "closest")
+    definition.referencePolicy = ReferencePolicy::closestRobot;
+  else if(referenceRobot == "best")
+    definition.referencePolicy = ReferencePolicy::bestRobot;
+  else
+  {
+    error = "The reference robot must be \"closest\" or \"best\".";
+    return false;
+  }
+  return true;
+}
+
+QByteArray ScoringRules::toJson(const Definition& definition)
+{
+  QJsonObject weights;
+  weights["onSameFieldDecision"] = definition.onSameFieldDecisionWeight;
+  weights["direction"] = definition.directionWeight;
+  weights["distance"] = definition.distanceWeight;
+  QJsonObject direction;
+  direction["minDeviation"] = definition.minDirectionDeviation;
+  direction["maxDeviation"] = definition.maxDirectionDeviation;
+  QJsonObject distance;
+  distance["minDeviation"] = definition.minDistanceDeviation;
+  distance["maxDeviation"] = definition.maxDistanceDeviation;
+  QJsonObject field;
+  field["halfLength"] = definition.fieldHalfLength;
+  field["halfWidth"] = definition.fieldHalfWidth;
+
+  QJsonObject rules;
+  rules["weights"] = weights;
+  rules["direction"] = direction;
+  rules["distance"] = distance;
+  rules["field"] = field;
+  rules["referenceRobot"] = definition.referencePolicy == ReferencePolicy::bestRobot ? "best" : "closest";
+  return QJsonDocument(rules).toJson(QJsonDocument::Compact);
+}
+
+bool ScoringRules::loadConfiguredDefinition(QString& error)
+{
+  const QString path = Paths::getConfigPath() + "/scoringRules.json";
+  Definition definition;
+  if(QFile::exists(path) && !read(path, definition, error))
+  {
+    error = path + ": " + error;
+    return false;
+  }
+  configuredDefinition() = definition;
+  return true;
+}
+
+const ScoringRules::Definition& ScoringRules::getConfiguredDefinition()
+{
+  return configuredDefinition();
+}
+
+ScoringRules::Definition& ScoringRules::configuredDefinition()
+{
+  static Definition definition;
+  return definition;
+}
+
+void ScoringRules::calculateScores(const Definition& definition, const QVector<Pose2D>& robotSetup, const BatchMetric::Reports& reports, BatchMetric::Scores& scores)
+{
+  Q_ASSERT(!robotSetup.isEmpty());
+
+  if(definition.referencePolicy == ReferencePolicy::closestRobot)
+  {
+    BatchMetric::calculateScores(robotSetup, reports, scores, definition);
+    weigh(definition, scores);
+    return;
+  }
+
+  // Each robot is scored as the only (and thus closest) robot and the first one with the highest score is the reference.
+  BatchMetric::calculateScores(QVector<Pose2D>(1, robotSetup[0]), reports, scores, definition);
+  weigh(definition, scores);
+  BatchMetric::Scores robotScores;
+  for(int robot = 1; robot < robotSetup.size(); ++robot)
+  {
+    BatchMetric::calculateScores(QVector<Pose2D>(1, robotSetup[robot]), reports, robotScores, definition);
+    weigh(definition, robotScores);
+    for(std::size_t i = 0; i < scores.total.size(); ++i)
+      if(robotScores.total[i] > scores.total[i])
+      {
+        scores.onSameFieldDecision[i] = robotScores.onSameFieldDecision[i];
+        scores.direction[i] = robotScores.direction[i];
+        scores.distance[i] = robotScores.distance[i];
+        scores.total[i] = robotScores.total[i];
+      }
+  }
+}
+
+ScoringRules::ScoringRules(const Definition& definition, const QVector<Pose2D>& robotSetup, const QVector<Vector2D>& whistleLocations) :
+  definition(definition)
+{
+  Q_ASSERT(!robotSetup.isEmpty());
+
+  if(definition.referencePolicy == ReferencePolicy::closestRobot)
+  {
+    numOfReferences = 1;
+    geometries = Metric::calculateReferenceGeometries(robotSetup, whistleLocations, definition);
+  }
+  else
+  {
+    // Every robot is a reference candidate, so its geometry is calculated like the one of the closest robot in Metric.
+    numOfReferences = robotSetup.size();
+    geometries.reserve(whistleLocations.size() * robotSetup.size());
+    for(const Vector2D& whistleLocation : whistleLocations)
+      for(const Pose2D& pose : robotSetup)
+        geometries.append(Metric::calculateReferenceGeometry(pose, whistleLocation, definition));
+  }
+
+  const bool weighted = definition.onSameFieldDecisionWeight != 1.f || definition.directionWeight != 1.f || definition.distanceWeight != 1.f;
+  if(definition.referencePolicy == ReferencePolicy::closestRobot)
+    kernel = weighted ? &evaluate<ReferencePolicy::closestRobot, true> : &evaluate<ReferencePolicy::closestRobot, false>;
+  else
+    kernel = weighted ? &evaluate<ReferencePolicy::bestRobot, true> : &evaluate<ReferencePolicy::bestRobot, false>;
+}
+
+template<bool weighted>
+Metric::ScoreComponents ScoringRules::calculateWeightedComponents(const ScoringRules& rules, const Metric::ReferenceGeometry& geometry, const DetectedWhistle& whistle)
+{
+  // The thresholds and the field geometry are applied by Metric, so that both always score alike.
+  Metric::ScoreComponents components = Metric::calculateScoreComponents(geometry, whistle, rules.definition);
+  if(weighted)
+  {
+    components.onSameFieldDecision *= rules.definition.onSameFieldDecisionWeight;
+    components.direction *= rules.definition.directionWeight;
+    components.distance *= rules.definition.distanceWeight;
+  }
+  return components;
+}
+
+template<ScoringRules::ReferencePolicy policy, bool weighted>
+Metric::ScoreComponents ScoringRules::evaluate(const ScoringRules& rules, int locationIndex, const DetectedWhistle& whistle)
+{
+  if(policy == ReferencePolicy::closestRobot)
+    return calculateWeightedComponents<weighted>(rules, rules.geometries[locationIndex], whistle);
+
+  // The first robot with the highest score is the reference.
+  const Metric::ReferenceGeometry* geometry = rules.geometries.constData() + locationIndex * rules.numOfReferences;
+  Metric::ScoreComponents best = calculateWeightedComponents<weighted>(rules, geometry[0], whistle);
+  for(int i = 1; i < rules.numOfReferences; ++i)
+  {
+    const Metric::ScoreComponents components = calculateWeightedComponents<weighted>(rules, geometry[i], whistle);
+    if(components.getTotal() > best.getTotal())
+      best = components;
+  }
+  return best;
+}
@@ -0,0 +1,146 @@
+/**
+ * @file ScoringRules.h
+ *
+ * This file declares a class that scores whistle reports with rules that are read from the configuration
+ * (weights of the score components, thresholds, field geometry and the choice of the reference robot) instead of
+ * the fixed rules of \c Metric. For each robot setup, the rules are compiled into the reference geometry of every
+ * whistle location and a kernel that is specialized for the shape of the rules.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "BatchMetric.h"
+#include "DetectedWhistle.h"
+#include "Metric.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class ScoringRules
+{
+public:
+  /** The ways in which the robot from which the reported direction and distance are judged is chosen. */
+  enum class ReferencePolicy
+  {
+    closestRobot, /**< The robot that is closest to the actual whistle location (the rules of \c Metric). */
+    bestRobot /**< The robot from which the report gets the highest score. */
+  };
+
+  /** The rules as they are configured (the thresholds and the field geometry are the ones of \c Metric::Rules). */
+  struct Definition : Metric::Rules
+  {
+    float onSameFieldDecisionWeight = 1.f; /**< The factor of the score of the "same field"/"other field" decision. */
+    float directionWeight = 1.f; /**< The factor of the score of the direction quality. */
+    float distanceWeight = 1.f; /**< The factor of the score of the distance quality. */
+    ReferencePolicy referencePolicy = ReferencePolicy::closestRobot; /**< How the reference robot is chosen. */
+  };
+
+  /**
+   * Reads rules from a JSON file. Values that are not in the file keep the rules of \c Metric.
+   * @param path The path of the JSON file.
+   * @param definition The rules.
+   * @param error Set to a description of the problem if the file is invalid.
+   * @return Whether the file could be read and contains valid rules.
+   */
+  static bool read(const QString& path, Definition& definition, QString& error);
+
+  /**
+   * Reads rules from JSON text (e.g. as written to the log by \c toJson). Values that are not in the text keep the rules of \c Metric.
+   * @param json The JSON text.
+   * @param definition The rules.
+   * @param error Set to a description of the problem if the text does not contain valid rules.
+   * @return Whether the text contains valid rules.
+   */
+  static bool fromJson(const QByteArray& json, Definition& definition, QString& error);
+
+  /**
+   * Converts rules to the format of Config/scoringRules.json (with all values, so that it identifies the rules, e.g. as part of a cache key).
+   * @param definition The rules.
+   * @return The compact JSON text of the rules.
+   */
+  static QByteArray toJson(const Definition& definition);
+
+  /**
+   * Reads the rules from Config/scoringRules.json (if there is such a file), so that they are returned by \c getConfiguredDefinition.
+   * This must be called at startup, before any pass is scored, so that invalid rules stop the program before they could produce wrong results.
+   * @param error Set to the path of the file and a description of the problem if the rules are invalid.
+   * @return Whether there is no such file or it contains valid rules (the official rules are kept otherwise).
+   */
+  static bool loadConfiguredDefinition(QString& error);
+
+  /**
+   * Returns the rules that have been read by \c loadConfiguredDefinition (the rules of \c Metric if there is no such file or it has not been read).
+   * @return The configured rules.
+   */
+  static const Definition& getConfiguredDefinition();
+
+  /**
+   * Calculates the scores for a batch of whistle reports with the kernels of \c BatchMetric (for bulk computations).
+   * The results match the ones of \c calculateScoreComponents up to \c BatchMetric::tolerance per component.
+   * @param definition The rules.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param reports The reports and their ground-truth locations.
+   * @param scores The weighted scores (as seen from the reference robot), which are resized to the number of reports.
+   */
+  static void calculateScores(const Definition& definition, const QVector<Pose2D>& robotSetup, const BatchMetric::Reports& reports, BatchMetric::Scores& scores);
+
+  /**
+   * Constructor. Compiles the rules for a robot setup.
+   * @param definition The rules.
+   * @param robotSetup The poses of the used robots on the field.
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   */
+  ScoringRules(const Definition& definition, const QVector<Pose2D>& robotSetup, const QVector<Vector2D>& whistleLocations);
+
+  /**
+   * Calculates the parts of the score of a report. With the rules of \c Metric, the result is exactly the same as the one of \c Metric.
+   * @param locationIndex The index of the actual whistle location.
+   * @param whistle The whistle reported by the robots.
+   * @return The parts of the score (already weighted).
+   */
+  Metric::ScoreComponents calculateScoreComponents(int locationIndex, const DetectedWhistle& whistle) const
+  {
+    return kernel(*this, locationIndex, whistle);
+  }
+
+private:
+  /**
+   * Returns the storage of the configured rules.
+   * @return The rules that \c getConfiguredDefinition returns.
+   */
+  static Definition& configuredDefinition();
+
+  using Kernel = Metric::ScoreComponents (*)(const ScoringRules& rules, int locationIndex, const DetectedWhistle& whistle); /**< A specialized scoring function. */
+
+  /**
+   * Calculates the parts of the score of a report as seen from one reference robot with the thresholds of the rules and weighs them.
+   * @tparam weighted Whether the components are multiplied by their weights (all weights are 1 otherwise).
+   * @param rules The compiled rules.
+   * @param geometry The reference geometry of the actual whistle location.
+   * @param whistle The whistle reported by the robots.
+   * @return The parts of the score.
+   */
+  template<bool weighted>
+  static Metric::ScoreComponents calculateWeightedComponents(const ScoringRules& rules, const Metric::ReferenceGeometry& geometry, const DetectedWhistle& whistle);
+
+  /**
+   * The kernel for a shape of rules.
+   * @tparam policy How the reference robot is chosen.
+   * @tparam weighted Whether the components are multiplied by their weights.
+   * @param rules The compiled rules.
+   * @param locationIndex The index of the actual whistle location.
+   * @param whistle The whistle reported by the robots.
+   * @return The parts of the score.
+   */
+  template<ReferencePolicy policy, bool weighted>
+  static Metric::ScoreComponents evaluate(const ScoringRules& rules, int locationIndex, const DetectedWhistle& whistle);
+
+  Definition definition; /**< The rules. */
+  int numOfReferences; /**< The number of reference geometries per whistle location (1 or the number of robots). */
+  QVector<Metric::ReferenceGeometry> geometries; /**< The reference geometries of each whistle location (\c numOfReferences in a row). */
+  Kernel kernel; /**< The kernel that is specialized for the shape of the rules. */
+};
@@ -0,0 +1,233 @@
+/**
+ * @file SessionManager.cpp
+ *
+ * This file implements a class that runs independent challenge passes on several fields at once.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "SessionManager.h"
+#include "Capture.h"
+#include "Challenge.h"
+#include "ChallengeLog.h"
+#include "Journal.h"
+#include "LogWriter.h"
+#include "ReceiverMultiplexer.h"
+#include "SPLStandardMessageReceiver.h"
+#include "ScoringRules.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include "Util/LatencyHistogram.h"
+#include <QDateTime>
+#include <QMetaObject>
+#include <QStringList>
+#include <QThread>
+
+SessionManager::SessionManager(int numOfFields, const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotPoses, const QString& logPath, QObject* parent) :
+  QObject(parent),
+  whistleLocations(whistleLocations),
+  robotPoses(robotPoses),
+  logPath(logPath),
+  sessionStart(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss")),
+  fields(static_cast<std::size_t>(numOfFields))
+{
+#ifdef __linux__
+  multiplexer.reset(new ReceiverMultiplexer);
+  if(multiplexer->isRunning())
+    return;
+  multiplexer.reset();
+#endif
+  receiverThread = new QThread(this);
+  receiverThread->setObjectName("Receiver");
+  receiverThread->start(QThread::TimeCriticalPriority);
+}
+
+SessionManager::~SessionManager()
+{
+  for(int i = 0; i < getNumOfFields(); ++i)
+    stopPass(i);
+  if(receiverThread)
+  {
+    receiverThread->quit();
+    receiverThread->wait();
+  }
+}
+
+int SessionManager::getNumOfFields() const
+{
+  return static_cast<int>(fields.size());
+}
+
+bool SessionManager::startPass(int field, unsigned int teamNumber, const QVector<unsigned int>& robotNumbers, QString& error, const Journal::UnfinishedPass* resumedPass)
+{
+  Q_ASSERT(field >= 0 && field < getNumOfFields());
+  // Everything that is created for the pass tags its trace events with the field.
+  TRACE_FIELD(field);
+  Field& state = fields[field];
+  if(state.challenge)
+  {
+    error = "A pass is already running on field " + QString::number(field + 1) + ".";
+    return false;
+  }
+  for(int i = 0; i < getNumOfFields(); ++i)
+    if(fields[i].challenge && fields[i].teamNumber == teamNumber)
+    {
+      error = "The team is already doing a pass on field " + QString::number(i + 1) + ".";
+      return false;
+    }
+  QVector<Pose2D> robotSetup;
+  for(unsigned int jerseyNumber : robotNumbers)
+  {
+    if(jerseyNumber < 1 || static_cast<int>(jerseyNumber) > robotPoses.size())
+    {
+      error = "Invalid robot number: " + QString::number(jerseyNumber);
+      return false;
+    }
+    robotSetup.append(robotPoses[jerseyNumber - 1]);
+  }
+  if(robotSetup.isEmpty())
+  {
+    error = "At least one robot is needed.";
+    return false;
+  }
+
+  // The trace of the pass only contains what happened since its start.
+  if(Tracer::isEnabled())
+    Tracer::clear(field);
+
+  // The port is opened before any file of the field is created, so that a pass that cannot start leaves nothing behind.
+  const SPLStandardMessageReceiver::Backend backend = multiplexer ? SPLStandardMessageReceiver::Backend::multiplexed : SPLStandardMessageReceiver::Backend::automatic;
+  SPLStandardMessageReceiver* receiver = new SPLStandardMessageReceiver(teamNumber, nullptr, backend);
+#ifdef __linux__
+  const bool opened = multiplexer ? multiplexer->add(receiver) : receiver->isOpen();
+#else
+  const bool opened = receiver->isOpen();
+#endif
+  if(!opened)
+  {
+    delete receiver;
+    error = "The port of team " + QString::number(teamNumber) + " could not be opened.";
+    return false;
+  }
+  if(!multiplexer)
+    receiver->moveToThread(receiverThread);
+
+  if(!logPath.isEmpty() && !state.logWriter)
+  {
+    const QString suffix = sessionStart + "_field" + QString::number(field + 1);
+    // Each field has its own histogram, so that a slow device or a busy writer on one field can be told apart from the others.
+    state.commitLatency.reset(new LatencyHistogram);
+    state.logWriter.reset(new LogWriter(logPath + "/log_" + suffix + ".txt", state.commitLatency.get()));
+    state.captureWriter.reset(new CaptureWriter(logPath + "/capture_" + suffix + ".dwc"));
+    state.journalWriter.reset(new JournalWriter(logPath + "/journal_" + suffix + ".dwj"));
+  }
+
+  if(state.commitLatency)
+    state.commitLatency->reset();
+  state.teamNumber = teamNumber;
+  state.receiver = receiver;
+  state.receiver->setCaptureWriter(state.captureWriter.get());
+
+  state.challenge = resumedPass ? new Challenge(whistleLocations, robotSetup, resumedPass->locationOrder, this) : new Challenge(whistleLocations, robotSetup, this);
+  state.challenge->setWhistleQueue(&state.receiver->getWhistleQueue());
+  state.challenge->setCaptureWriter(state.captureWriter.get());
+  state.challenge->setJournalWriter(state.journalWriter.get());
+  state.challenge->setLogWriter(state.logWriter.get());
+  connect(state.receiver, &SPLStandardMessageReceiver::whistleLocationsReceived, state.challenge, &Challenge::handleReceivedWhistles);
+  connect(state.challenge, &Challenge::attemptFinished, this, [this, field]
+  {
+    ChallengeLog(fields[field].logWriter.get()) << "Ingress: " << fields[field].receiver->getCounters().toString();
+    emit attemptFinished(field);
+  });
+
+  ChallengeLog(state.logWriter.get()) << "Started challenge pass of team " << teamNumber << " with robots " << robotNumbers << " on field " << (field + 1);
+  ChallengeLog(state.logWriter.get()) << "Scoring rules: " << ScoringRules::toJson(ScoringRules::getConfiguredDefinition());
+  if(resumedPass)
+    ChallengeLog(state.logWriter.get()) << "Resumed " << resumedPass->results.size() << " attempts of the interrupted pass";
+  ChallengeLog::commit(state.logWriter.get());
+  if(state.captureWriter)
+  {
+    Capture::PassStart passStart;
+    passStart.teamNumber = teamNumber;
+    passStart.robotNumbers = robotNumbers;
+    for(const Challenge::Attempt& attempt : state.challenge->getAttempts())
+      passStart.locationOrder.append(attempt.locationIndex);
+    state.captureWriter->writePassStart(Clock::getTime(), passStart);
+  }
+  if(state.journalWriter)
+  {
+    QVector<int> locationOrder;
+    for(const Challenge::Attempt& attempt : state.challenge->getAttempts())
+      locationOrder.append(attempt.locationIndex);
+    state.journalWriter->writePassStart(Clock::getTime(), teamNumber, robotNumbers, locationOrder, field + 1);
+  }
+  if(resumedPass)
+    state.challenge->resume(resumedPass->results);
+  return true;
+}
+
+bool SessionManager::findInterruptedPass(int field, Journal::UnfinishedPass& pass) const
+{
+  if(logPath.isEmpty())
+    return false;
+  const QString suffix = "_field" + QString::number(field + 1) + ".dwj";
+  QStringList journals;
+  for(const QString& path : Journal::findJournals(logPath))
+    if(path.endsWith(suffix) && !path.endsWith(sessionStart + suffix))
+      journals.append(path);
+  return !journals.isEmpty() && JournalReader(journals.last()).findUnfinishedPass(pass) && pass.fits(robotPoses.size(), whistleLocations.size());
+}
+
+void SessionManager::stopPass(int field)
+{
+  Q_ASSERT(field >= 0 && field < getNumOfFields());
+  Field& state = fields[field];
+  if(!state.challenge)
+    return;
+
+#ifdef __linux__
+  if(multiplexer)
+    multiplexer->remove(state.receiver);
+#endif
+  ChallengeLog(state.logWriter.get()) << "Ingress: " << state.receiver->getCounters().toString();
+  // Finished passes have already been ended by the challenge.
+  if(state.journalWriter && !state.challenge->isFinished())
+    state.journalWriter->writePassEnd(Clock::getTime(), state.challenge->getTotalScore(), true);
+  delete state.challenge;
+  state.challenge = nullptr;
+  // The events of an aborted pass would otherwise be kept until the next pass on this field starts.
+  if(Tracer::isEnabled())
+    Tracer::clear(field);
+  // Without a multiplexer, the receiver must be deleted in its own thread.
+  if(multiplexer)
+    delete state.receiver;
+  else
+    QMetaObject::invokeMethod(state.receiver, "deleteLater");
+  state.receiver = nullptr;
+  ChallengeLog::commit(state.logWriter.get());
+}
+
+Challenge* SessionManager::getChallenge(int field) const
+{
+  return fields[field].challenge;
+}
+
+unsigned int SessionManager::getTeamNumber(int field) const
+{
+  return fields[field].teamNumber;
+}
+
+const SPLStandardMessageReceiver* SessionManager::getReceiver(int field) const
+{
+  return fields[field].receiver;
+}
+
+LogWriter* SessionManager::getLogWriter(int field) const
+{
+  return fields[field].logWriter.get();
+}
+
+const LatencyHistogram* SessionManager::getCommitLatency(int field) const
+{
+  return fields[field].commitLatency.get();
+}
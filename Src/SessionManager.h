@@ -0,0 +1,140 @@
+/**
+ * @file SessionManager.h
+ *
+ * This file declares a class that runs independent challenge passes on several fields at once.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+class CaptureWriter;
+class Challenge;
+class JournalWriter;
+class LatencyHistogram;
+class LogWriter;
+class QThread;
+class ReceiverMultiplexer;
+class SPLStandardMessageReceiver;
+namespace Journal { struct UnfinishedPass; }
+
+class SessionManager : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * Constructor. On Linux, the sockets of all fields are watched by a single epoll loop; elsewhere, they share one receiver thread.
+   * @param numOfFields The number of fields on which passes can run.
+   * @param whistleLocations The set of locations from which the whistle is blown (the same for all fields).
+   * @param robotPoses The set of poses at which robots can be placed (the same for all fields).
+   * @param logPath The directory in which each field writes its own log file, capture and journal (empty to record nothing).
+   * @param parent The Qt parent object.
+   */
+  SessionManager(int numOfFields, const QVector<Vector2D>& whistleLocations, const QVector<Pose2D>& robotPoses, const QString& logPath, QObject* parent = nullptr);
+
+  /** Destructor. Stops all passes. */
+  ~SessionManager() override;
+
+  /**
+   * Returns the number of fields.
+   * @return The number of fields.
+   */
+  int getNumOfFields() const;
+
+  /**
+   * Starts a challenge pass on a field (the previous pass on this field must have been stopped).
+   * @param field The index of the field.
+   * @param teamNumber The number of the team (whose port must not be used on another field).
+   * @param robotNumbers The jersey numbers of the robots that the team handed in.
+   * @param error Set to a description of the problem if the pass could not be started.
+   * @param resumedPass The interrupted pass whose location order and finished attempts are restored (nullptr to start a new pass).
+   * @return Whether the pass has been started.
+   */
+  bool startPass(int field, unsigned int teamNumber, const QVector<unsigned int>& robotNumbers, QString& error, const Journal::UnfinishedPass* resumedPass = nullptr);
+
+  /**
+   * Finds the pass that has been interrupted on a field in a previous session (e.g. by a crash), i.e. an unfinished pass
+   * at the end of the most recent journal of the field that has not been written by this session.
+   * @param field The index of the field.
+   * @param pass The interrupted pass.
+   * @return Whether there is an interrupted pass that fits the configuration of this session.
+   */
+  bool findInterruptedPass(int field, Journal::UnfinishedPass& pass) const;
+
+  /**
+   * Stops the pass on a field (if there is one) and closes its port.
+   * @param field The index of the field.
+   */
+  void stopPass(int field);
+
+  /**
+   * Returns the pass that runs on a field.
+   * @param field The index of the field.
+   * @return The challenge pass or nullptr if there is none.
+   */
+  Challenge* getChallenge(int field) const;
+
+  /**
+   * Returns the team that does the pass on a field.
+   * @param field The index of the field.
+   * @return The number of the team (only valid if there is a pass).
+   */
+  unsigned int getTeamNumber(int field) const;
+
+  /**
+   * Returns the receiver for the port of the team that does the pass on a field.
+   * @param field The index of the field.
+   * @return The receiver or nullptr if there is no pass.
+   */
+  const SPLStandardMessageReceiver* getReceiver(int field) const;
+
+  /**
+   * Returns the log file of a field.
+   * @param field The index of the field.
+   * @return The writer of the log file of the field (nullptr if nothing is recorded).
+   */
+  LogWriter* getLogWriter(int field) const;
+
+  /**
+   * Returns the latencies of the commits of the log file of a field (since the start of its current or last pass).
+   * @param field The index of the field.
+   * @return The histogram of the commit latencies of the field (nullptr if nothing is recorded).
+   */
+  const LatencyHistogram* getCommitLatency(int field) const;
+
+signals:
+  /**
+   * This signal is emitted when an attempt on a field is finished.
+   * @param field The index of the field.
+   */
+  void attemptFinished(int field);
+
+private:
+  /** The state of a single field. */
+  struct Field
+  {
+    unsigned int teamNumber = 0; /**< The number of the team that does the pass. */
+    Challenge* challenge = nullptr; /**< The running challenge pass (nullptr if there is none). */
+    SPLStandardMessageReceiver* receiver = nullptr; /**< The receiver for the port of the team. */
+    std::unique_ptr<LatencyHistogram> commitLatency; /**< The latencies of the commits of the log file of this field (if recording). */
+    std::unique_ptr<LogWriter> logWriter; /**< The log file of this field (if recording). */
+    std::unique_ptr<CaptureWriter> captureWriter; /**< The capture of this field (if recording). */
+    std::unique_ptr<JournalWriter> journalWriter; /**< The result journal of this field (if recording). */
+  };
+
+  const QVector<Vector2D>& whistleLocations; /**< The set of locations from which the whistle is blown. */
+  QVector<Pose2D> robotPoses; /**< The set of poses at which robots can be placed. */
+  QString logPath; /**< The directory in which each field writes its own log file, capture and journal (empty to record nothing). */
+  QString sessionStart; /**< The time at which the session has been started (as part of file names). */
+  std::vector<Field> fields; /**< The state of each field. */
+  std::unique_ptr<ReceiverMultiplexer> multiplexer; /**< The epoll loop that watches all sockets (Linux only). */
+  QThread* receiverThread = nullptr; /**< The thread in which all receivers live if there is no multiplexer. */
+};
@@ -0,0 +1,170 @@
+/**
+ * @file SubsetPlanner.cpp
+ *
+ * This file implements a class that rates every subset of the robot poses by how well it covers the whistle locations.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "SubsetPlanner.h"
+#include "Metric.h"
+#include "Util/Paths.h"
+#include "Util/ThreadPool.h"
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+
+constexpr std::uint64_t SubsetPlanner::trialsPerLocation;
+constexpr int SubsetPlanner::version;
+
+QVector<SubsetPlanner::Rating> SubsetPlanner::plan(const QVector<Pose2D>& robotPoses, const QVector<Vector2D>& whistleLocations, const ScoringRules::Definition& rules)
+{
+  const QString path = getCachePath(robotPoses, whistleLocations, rules);
+  QVector<Rating> ratings;
+  if(readCache(path, ratings))
+    return ratings;
+  ratings = calculate(robotPoses, whistleLocations, rules);
+  writeCache(path, ratings);
+  return ratings;
+}
+
+QVector<SubsetPlanner::Rating> SubsetPlanner::calculate(const QVector<Pose2D>& robotPoses, const QVector<Vector2D>& whistleLocations, const ScoringRules::Definition& rules)
+{
+  Q_ASSERT(robotPoses.size() <= 16);
+  QVector<Rating> ratings((1 << robotPoses.size()) - 1);
+  if(ratings.isEmpty() || whistleLocations.isEmpty())
+    return QVector<Rating>();
+
+  // All subsets use the same random streams, so that differences between them are not hidden by noise.
+  const MonteCarlo monteCarlo(whistleLocations, MonteCarlo::NoiseModel(), rules);
+  Rating* const data = ratings.data();
+  ThreadPool pool;
+  pool.parallelFor(static_cast<std::size_t>(ratings.size()), [&](unsigned, std::size_t index)
+  {
+    Rating& rating = data[index];
+    rating.robots = static_cast<std::uint32_t>(index + 1);
+    QVector<Pose2D> robotSetup;
+    for(int i = 0; i < robotPoses.size(); ++i)
+      if(rating.robots & (1u << i))
+        robotSetup.append(robotPoses[i]);
+
+    std::uint32_t referenceRobots = 0;
+    float distanceSum = 0.f;
+    for(const Metric::ReferenceGeometry& geometry : Metric::calculateReferenceGeometries(robotSetup, whistleLocations, rules))
+    {
+      for(int i = 0; i < robotSetup.size(); ++i)
+        if(robotSetup[i].translation.x == geometry.referenceLocation.x && robotSetup[i].translation.y == geometry.referenceLocation.y)
+        {
+          referenceRobots |= 1u << i;
+          break;
+        }
+      distanceSum += geometry.actualDistance;
+    }
+    int numOfReferenceRobots = 0;
+    for(; referenceRobots; referenceRobots &= referenceRobots - 1)
+      ++numOfReferenceRobots;
+    rating.coverage = static_cast<float>(numOfReferenceRobots) / robotSetup.size();
+    rating.meanReferenceDistance = distanceSum / whistleLocations.size();
+
+    double expectedScore = 0.0;
+    for(const MonteCarlo::LocationResult& result : monteCarlo.run(robotSetup, trialsPerLocation, 0))
+      expectedScore += result.meanScore;
+    rating.expectedScore = static_cast<float>(expectedScore);
+  });
+
+  std::stable_sort(ratings.begin(), ratings.end(), [](const Rating& a, const Rating& b) { return a.expectedScore > b.expectedScore; });
+  return ratings;
+}
+
+QString SubsetPlanner::getCachePath(const QVector<Pose2D>& robotPoses, const QVector<Vector2D>& whistleLocations, const ScoringRules::Definition& rules)
+{
+  QByteArray key;
+  QDataStream stream(&key, QIODevice::WriteOnly);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  const MonteCarlo::NoiseModel model;
+  stream << version << static_cast<quint64>(trialsPerLocation)
+         << model.bearingError << model.rangeError << model.falseSameFieldRate << model.dropoutRate;
+  stream << robotPoses.size();
+  for(const Pose2D& pose : robotPoses)
+    stream << pose.rotation << pose.translation.x << pose.translation.y;
+  stream << whistleLocations.size();
+  for(const Vector2D& location : whistleLocations)
+    stream << location.x << location.y;
+  // Ratings under other scoring rules must not be taken from the cache.
+  stream << ScoringRules::toJson(rules);
+  return Paths::getCachePath() + "/subsets_" + QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex().left(16) + ".json";
+}
+
+QVector<unsigned int> SubsetPlanner::getRobotNumbers(std::uint32_t robots)
+{
+  QVector<unsigned int> robotNumbers;
+  for(unsigned int i = 0; i < 32; ++i)
+    if(robots & (1u << i))
+      robotNumbers.append(i + 1);
+  return robotNumbers;
+}
+
+bool SubsetPlanner::readCache(const QString& path, QVector<Rating>& ratings)
+{
+  QFile file(path);
+  if(!file.open(QIODevice::ReadOnly))
+    return false;
+  const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+  if(!document.isArray())
+    return false;
+
+  ratings.clear();
+  for(const QJsonValue& value : document.array())
+  {
+    const QJsonObject object = value.toObject();
+    Rating rating;
+    for(const QJsonValue& robot : object["robots"].toArray())
+    {
+      const int jerseyNumber = robot.toInt();
+      if(jerseyNumber < 1 || jerseyNumber > 32)
+        return false;
+      rating.robots |= 1u << (jerseyNumber - 1);
+    }
+    if(!rating.robots)
+      return false;
+    rating.coverage = static_cast<float>(object["coverage"].toDouble());
+    rating.meanReferenceDistance = static_cast<float>(object["meanReferenceDistance"].toDouble());
+    rating.expectedScore = static_cast<float>(object["expectedScore"].toDouble());
+    ratings.append(rating);
+  }
+  return !ratings.isEmpty();
+}
+
+bool SubsetPlanner::writeCache(const QString& path, const QVector<Rating>& ratings)
+{
+  if(!QDir().mkpath(Paths::getCachePath()))
+    return false;
+
+  QJsonArray array;
+  for(const Rating& rating : ratings)
+  {
+    QJsonArray robots;
+    for(unsigned int jerseyNumber : getRobotNumbers(rating.robots))
+      robots.append(static_cast<int>(jerseyNumber));
+    QJsonObject object;
+    object["robots"] = robots;
+    object["coverage"] = rating.coverage;
+    object["meanReferenceDistance"] = rating.meanReferenceDistance;
+    object["expectedScore"] = rating.expectedScore;
+    array.append(object);
+  }
+
+  // The file is replaced atomically, so that another instance never reads a partial cache.
+  QSaveFile file(path);
+  if(!file.open(QIODevice::WriteOnly))
+    return false;
+  file.write(QJsonDocument(array).toJson());
+  return file.commit();
+}
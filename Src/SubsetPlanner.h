@@ -0,0 +1,86 @@
+/**
+ * @file SubsetPlanner.h
+ *
+ * This file declares a class that rates every subset of the robot poses by how well it covers the whistle locations,
+ * so that the start dialog can suggest which robots to use.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "MonteCarlo.h"
+#include "ScoringRules.h"
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QString>
+#include <QVector>
+#include <cstdint>
+
+class SubsetPlanner
+{
+public:
+  static constexpr std::uint64_t trialsPerLocation = 8192; /**< The number of Monte Carlo trials per whistle location and subset. */
+  static constexpr int version = 2; /**< The version of the ratings (part of the cache key, so that it must be increased when the rating changes). */
+
+  /** The rating of a robot subset. */
+  struct Rating
+  {
+    std::uint32_t robots = 0; /**< The subset as a bit mask (bit i is set if the robot with jersey number i + 1 participates). */
+    float coverage = 0.f; /**< The share of the robots in the subset that are the reference robot of at least one whistle location. */
+    float meanReferenceDistance = 0.f; /**< The mean distance (m) from the whistle locations to their reference robots. */
+    float expectedScore = 0.f; /**< The expected total score of a pass under the default noise model. */
+  };
+
+  /**
+   * Rates all non-empty subsets of the robot poses. The ratings are loaded from the cache if the configuration is the same,
+   * otherwise they are calculated on all cores and stored in the cache.
+   * @param robotPoses The poses of all robots (at most 16).
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param rules The scoring rules under which the subsets are rated.
+   * @return The ratings of all subsets, the best (highest expected score) first.
+   */
+  static QVector<Rating> plan(const QVector<Pose2D>& robotPoses, const QVector<Vector2D>& whistleLocations, const ScoringRules::Definition& rules);
+
+  /**
+   * Rates all non-empty subsets of the robot poses on all cores (without the cache).
+   * @param robotPoses The poses of all robots (at most 16).
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param rules The scoring rules under which the subsets are rated.
+   * @return The ratings of all subsets, the best (highest expected score) first.
+   */
+  static QVector<Rating> calculate(const QVector<Pose2D>& robotPoses, const QVector<Vector2D>& whistleLocations, const ScoringRules::Definition& rules);
+
+  /**
+   * Returns the path of the cache file for a configuration, which contains a hash of everything that the ratings depend on.
+   * @param robotPoses The poses of all robots.
+   * @param whistleLocations The set of locations from which the whistle is blown.
+   * @param rules The scoring rules under which the subsets are rated.
+   * @return The path of the cache file.
+   */
+  static QString getCachePath(const QVector<Pose2D>& robotPoses, const QVector<Vector2D>& whistleLocations, const ScoringRules::Definition& rules);
+
+  /**
+   * Converts a subset to the jersey numbers of its robots.
+   * @param robots The subset as a bit mask.
+   * @return The jersey numbers in ascending order.
+   */
+  static QVector<unsigned int> getRobotNumbers(std::uint32_t robots);
+
+private:
+  /**
+   * Reads ratings from a cache file.
+   * @param path The path of the cache file.
+   * @param ratings The ratings.
+   * @return Whether the file could be read.
+   */
+  static bool readCache(const QString& path, QVector<Rating>& ratings);
+
+  /**
+   * Writes ratings to a cache file.
+   * @param path The path of the cache file.
+   * @param ratings The ratings.
+   * @return Whether the file could be written.
+   */
+  static bool writeCache(const QString& path, const QVector<Rating>& ratings);
+};
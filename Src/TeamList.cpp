@@ -43,6 +43,11 @@ unsigned int TeamList::getTeamNumberByName(const QString& name) const
   return teams[name];
 }
 
+QString TeamList::getTeamNameByNumber(unsigned int number) const
+{
+  return teams.key(number);
+}
+
 TeamList& TeamList::getInstance()
 {
   static TeamList instance;
@@ -33,6 +33,13 @@ public:
    */
   unsigned int getTeamNumberByName(const QString& name) const;
 
+  /**
+   * This method returns the name of a team with a given number.
+   * @param number The number of the team to get the name for.
+   * @return The name of that team (empty if there is no such team).
+   */
+  QString getTeamNameByNumber(unsigned int number) const;
+
   TeamList(const TeamList&) = delete;
   void operator=(const TeamList&) = delete;
 
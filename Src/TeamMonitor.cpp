@@ -0,0 +1,155 @@
+/**
+ * @file TeamMonitor.cpp
+ *
+ * This file implements a class that listens on the ports of all teams and keeps track of the whistle messages that they send (Linux only).
+ *
+ * @author Arne Hasselbring
+ */
+
+#ifdef __linux__
+
+#include "TeamMonitor.h"
+#include "SPLStandardMessageReceiver.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+constexpr unsigned int TeamMonitor::numOfTeams;
+constexpr unsigned int TeamMonitor::ringSize;
+
+TeamMonitor::TeamMonitor()
+{
+  epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+  wakeDescriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if(epollDescriptor < 0 || wakeDescriptor < 0)
+    return;
+
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u32 = numOfTeams;
+  epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, wakeDescriptor, &event);
+  for(unsigned int teamNumber = 0; teamNumber < numOfTeams; ++teamNumber)
+  {
+    Team& team = teams[teamNumber];
+    team.socket = BatchedDatagramReceiver::openSocket(static_cast<std::uint16_t>(10000 + teamNumber));
+    if(team.socket < 0)
+      continue;
+    event.data.u32 = teamNumber;
+    if(epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, team.socket, &event) != 0)
+    {
+      close(team.socket);
+      team.socket = -1;
+    }
+  }
+
+  thread = std::thread(&TeamMonitor::run, this);
+}
+
+TeamMonitor::~TeamMonitor()
+{
+  if(thread.joinable())
+  {
+    const std::uint64_t one = 1;
+    while(write(wakeDescriptor, &one, sizeof(one)) < 0 && errno == EINTR);
+    thread.join();
+  }
+  for(const Team& team : teams)
+    if(team.socket >= 0)
+      close(team.socket);
+  if(wakeDescriptor >= 0)
+    close(wakeDescriptor);
+  if(epollDescriptor >= 0)
+    close(epollDescriptor);
+}
+
+unsigned int TeamMonitor::getNumOfOpenPorts() const
+{
+  unsigned int numOfOpenPorts = 0;
+  for(const Team& team : teams)
+    if(team.socket >= 0)
+      ++numOfOpenPorts;
+  return numOfOpenPorts;
+}
+
+TeamMonitor::Statistics TeamMonitor::getStatistics(unsigned int teamNumber) const
+{
+  Q_ASSERT(teamNumber < numOfTeams);
+  std::lock_guard<std::mutex> lock(mutex);
+  return teams[teamNumber].statistics;
+}
+
+void TeamMonitor::getRecentWhistles(unsigned int teamNumber, std::vector<Report>& reports) const
+{
+  Q_ASSERT(teamNumber < numOfTeams);
+  std::lock_guard<std::mutex> lock(mutex);
+  const Team& team = teams[teamNumber];
+  const unsigned int count = static_cast<unsigned int>(std::min<std::uint64_t>(team.statistics.whistleMessages, ringSize));
+  reports.clear();
+  for(unsigned int i = 0; i < count; ++i)
+    reports.push_back(team.recentWhistles[(team.nextWhistle + ringSize - count + i) % ringSize]);
+}
+
+void TeamMonitor::run()
+{
+  TRACE_THREAD_NAME("TeamMonitor");
+  epoll_event events[32];
+  while(true)
+  {
+    const int numOfEvents = epoll_wait(epollDescriptor, events, 32, -1);
+    if(numOfEvents < 0 && errno != EINTR)
+      break;
+    for(int i = 0; i < numOfEvents; ++i)
+    {
+      // The eventfd only becomes readable when the monitor is destroyed.
+      if(events[i].data.u32 == numOfTeams)
+        return;
+      receive(events[i].data.u32);
+    }
+  }
+}
+
+void TeamMonitor::receive(unsigned int teamNumber)
+{
+  Team& team = teams[teamNumber];
+  // Only one batch per wakeup, so that a team that floods its port does not hide the others (the socket is reported again if it is not drained).
+  const unsigned int received = buffers.receiveBatch(team.socket);
+  if(!received)
+    return;
+
+  const std::int64_t timestamp = Clock::getTime();
+  std::lock_guard<std::mutex> lock(mutex);
+  for(unsigned int i = 0; i < received; ++i)
+  {
+    const SPLStandardMessage& message = buffers.getMessage(i);
+    const std::size_t size = buffers.getSize(i);
+    const std::int64_t arrivalTime = buffers.getTimestamp(i) ? buffers.getTimestamp(i) : timestamp;
+    ++team.statistics.datagrams;
+    team.statistics.lastDatagram = arrivalTime;
+
+    // Regular team communication is only counted. Checking it completely would only produce warnings.
+    if(size < offsetof(SPLStandardMessage, version) + sizeof(message.version) ||
+       std::strncmp(message.header, SPL_STANDARD_MESSAGE_STRUCT_HEADER, sizeof(message.header)) != 0 || message.version != SPLStandardMessageReceiver::specialSPLStandardMessageVersion)
+      continue;
+
+    Report& report = team.recentWhistles[team.nextWhistle];
+    if(SPLStandardMessageReceiver::decodeMessage(message, size, teamNumber, report.whistle) != SPLStandardMessageReceiver::valid)
+    {
+      ++team.statistics.invalidWhistleMessages;
+      continue;
+    }
+    report.playerNumber = message.playerNum;
+    report.whistle.timestamp = arrivalTime;
+    team.nextWhistle = (team.nextWhistle + 1) % ringSize;
+    ++team.statistics.whistleMessages;
+    team.statistics.lastWhistleMessage = arrivalTime;
+  }
+}
+
+#endif
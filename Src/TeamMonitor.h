@@ -0,0 +1,109 @@
+/**
+ * @file TeamMonitor.h
+ *
+ * This file declares a class that listens on the ports of all teams and keeps track of the whistle messages that they send (Linux only).
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#ifdef __linux__
+
+#include "BatchedDatagramReceiver.h"
+#include "DetectedWhistle.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TeamMonitor
+{
+public:
+  static constexpr unsigned int numOfTeams = 100; /**< The number of team ports (10000 to 10099). */
+  static constexpr unsigned int ringSize = 16; /**< The number of recent whistle messages that are kept per team. */
+
+  /** A whistle message that has been received on the port of a team. */
+  struct Report
+  {
+    unsigned int playerNumber = 0; /**< The player number of the sender. */
+    DetectedWhistle whistle; /**< The reported whistle (including its arrival time). */
+  };
+
+  /** Counters for the traffic on the port of a team. */
+  struct Statistics
+  {
+    std::uint64_t datagrams = 0; /**< The number of datagrams (of any kind). */
+    std::uint64_t whistleMessages = 0; /**< The number of valid whistle messages (version 255). */
+    std::uint64_t invalidWhistleMessages = 0; /**< The number of messages with version 255 that are malformed or carry another team number. */
+    std::int64_t lastDatagram = 0; /**< The arrival time of the last datagram (in nanoseconds of the monotonic clock, 0 if none). */
+    std::int64_t lastWhistleMessage = 0; /**< The arrival time of the last valid whistle message (in nanoseconds of the monotonic clock, 0 if none). */
+  };
+
+  /**
+   * Constructor. Opens a socket for each team port and starts the thread that watches all of them with a single epoll instance.
+   * The sockets share their ports with the receivers of running passes. Since a unicast datagram is only delivered to one of the sockets
+   * (the one that has been bound last, i.e. the receiver), the monitor only sees broadcast traffic on ports on which a pass runs.
+   */
+  TeamMonitor();
+
+  /** Destructor. Stops the thread and closes the sockets. */
+  ~TeamMonitor();
+
+  TeamMonitor(const TeamMonitor&) = delete;
+  void operator=(const TeamMonitor&) = delete;
+
+  /**
+   * Returns the number of team ports that could be opened.
+   * @return The number of team ports that are monitored.
+   */
+  unsigned int getNumOfOpenPorts() const;
+
+  /**
+   * Returns the counters of a team.
+   * @param teamNumber The number of the team.
+   * @return A copy of the counters.
+   */
+  Statistics getStatistics(unsigned int teamNumber) const;
+
+  /**
+   * Returns the most recent whistle messages of a team.
+   * @param teamNumber The number of the team.
+   * @param reports The reports, which are replaced by the recent ones (oldest first, at most \c ringSize).
+   */
+  void getRecentWhistles(unsigned int teamNumber, std::vector<Report>& reports) const;
+
+private:
+  /** The state of a team port. */
+  struct Team
+  {
+    int socket = -1; /**< The native descriptor of the socket (-1 if it could not be opened). */
+    Statistics statistics; /**< The counters. */
+    std::array<Report, ringSize> recentWhistles; /**< The ring of recent whistle messages. */
+    unsigned int nextWhistle = 0; /**< The index in the ring to which the next whistle message is written. */
+  };
+
+  /** The main function of the monitor thread. */
+  void run();
+
+  /**
+   * Receives and classifies all pending datagrams of a team.
+   * @param teamNumber The number of the team.
+   */
+  void receive(unsigned int teamNumber);
+
+  int epollDescriptor = -1; /**< The epoll instance. */
+  int wakeDescriptor = -1; /**< An eventfd that wakes up the loop when it should stop. */
+  mutable std::mutex mutex; /**< Protects the counters and rings of all teams. */
+  std::array<Team, numOfTeams> teams; /**< The state of each team port. */
+  BatchedDatagramReceiver buffers; /**< The buffers into which all sockets are read (only used by the monitor thread). */
+  std::thread thread; /**< The thread that runs the loop. */
+};
+
+#else
+
+/** A placeholder on platforms without epoll (it is never instantiated there). */
+class TeamMonitor {};
+
+#endif
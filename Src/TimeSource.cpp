@@ -0,0 +1,131 @@
+/**
+ * @file TimeSource.cpp
+ *
+ * This file implements the clock and the timers that a challenge pass uses.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "TimeSource.h"
+#include "Util/Clock.h"
+#include <QTimer>
+#include <QtGlobal>
+#include <algorithm>
+
+SystemTimeSource& SystemTimeSource::getInstance()
+{
+  static SystemTimeSource instance;
+  return instance;
+}
+
+std::int64_t SystemTimeSource::getTime() const
+{
+  return Clock::getTime();
+}
+
+Timer* SystemTimeSource::createTimer(QObject* parent)
+{
+  return new SystemTimer(parent);
+}
+
+SystemTimeSource::SystemTimer::SystemTimer(QObject* parent) :
+  Timer(parent)
+{
+  timer = new QTimer(this);
+  timer->setSingleShot(true);
+  timer->setTimerType(Qt::PreciseTimer);
+  connect(timer, &QTimer::timeout, this, &Timer::timeout);
+}
+
+void SystemTimeSource::SystemTimer::start(int interval)
+{
+  timer->start(interval);
+}
+
+void SystemTimeSource::SystemTimer::stop()
+{
+  timer->stop();
+}
+
+bool SystemTimeSource::SystemTimer::isActive() const
+{
+  return timer->isActive();
+}
+
+VirtualTimeSource::VirtualTimeSource(std::int64_t startTime) :
+  time(startTime)
+{}
+
+VirtualTimeSource::~VirtualTimeSource()
+{
+  Q_ASSERT(timers.empty());
+}
+
+std::int64_t VirtualTimeSource::getTime() const
+{
+  return time;
+}
+
+Timer* VirtualTimeSource::createTimer(QObject* parent)
+{
+  return new VirtualTimer(*this, parent);
+}
+
+void VirtualTimeSource::advanceTo(std::int64_t time)
+{
+  Q_ASSERT(time >= this->time);
+  // A timer that is started by a handler is taken into account if it expires before the target time.
+  for(VirtualTimer* timer = getNextTimer(); timer && timer->deadline <= time; timer = getNextTimer())
+  {
+    this->time = timer->deadline;
+    timer->deadline = -1;
+    emit timer->timeout();
+  }
+  this->time = time;
+}
+
+bool VirtualTimeSource::advanceToNextTimer()
+{
+  const VirtualTimer* timer = getNextTimer();
+  if(!timer)
+    return false;
+  advanceTo(timer->deadline);
+  return true;
+}
+
+VirtualTimeSource::VirtualTimer* VirtualTimeSource::getNextTimer() const
+{
+  VirtualTimer* next = nullptr;
+  for(VirtualTimer* timer : timers)
+    if(timer->deadline != -1 && (!next || timer->deadline < next->deadline || (timer->deadline == next->deadline && timer->sequenceNumber < next->sequenceNumber)))
+      next = timer;
+  return next;
+}
+
+VirtualTimeSource::VirtualTimer::VirtualTimer(VirtualTimeSource& source, QObject* parent) :
+  Timer(parent),
+  source(source)
+{
+  source.timers.push_back(this);
+}
+
+VirtualTimeSource::VirtualTimer::~VirtualTimer()
+{
+  source.timers.erase(std::find(source.timers.begin(), source.timers.end(), this));
+}
+
+void VirtualTimeSource::VirtualTimer::start(int interval)
+{
+  deadline = source.time + static_cast<std::int64_t>(interval) * 1000000;
+  sequenceNumber = source.nextSequenceNumber++;
+}
+
+void VirtualTimeSource::VirtualTimer::stop()
+{
+  deadline = -1;
+}
+
+bool VirtualTimeSource::VirtualTimer::isActive() const
+{
+  return deadline != -1;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file TimeSource.h
+ *
+ * This file declares the clock and the timers that a challenge pass uses, so that passes can either run in real time
+ * or be simulated in virtual time (in which the time only advances when the simulation says so).
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <QObject>
+#include <cstdint>
+#include <vector>
+
+class QTimer;
+
+/** A single-shot timer of a time source. */
+class Timer : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * Constructor.
+   * @param parent The Qt parent object.
+   */
+  explicit Timer(QObject* parent = nullptr) : QObject(parent) {}
+
+  /**
+   * Starts (or restarts) the timer.
+   * @param interval The time (ms) after which the timer expires.
+   */
+  virtual void start(int interval) = 0;
+
+  /** Stops the timer (if it is running). */
+  virtual void stop() = 0;
+
+  /**
+   * Returns whether the timer is running.
+   * @return Whether the timer is running.
+   */
+  virtual bool isActive() const = 0;
+
+signals:
+  /** This signal is emitted when the timer expires. */
+  void timeout();
+};
+
+class TimeSource
+{
+public:
+  /** Virtual destructor for polymorphism. */
+  virtual ~TimeSource() = default;
+
+  /**
+   * Returns the current time.
+   * @return The current time (in nanoseconds, see \c Clock::getTime).
+   */
+  virtual std::int64_t getTime() const = 0;
+
+  /**
+   * Creates a single-shot timer that runs in the time of this source.
+   * @param parent The Qt parent object of the timer.
+   * @return The timer.
+   */
+  virtual Timer* createTimer(QObject* parent) = 0;
+};
+
+/** The time source of the real world, i.e. the monotonic clock and Qt timers. */
+class SystemTimeSource : public TimeSource
+{
+public:
+  /**
+   * This function returns the instance of the system time source.
+   * @return A reference to the instance of the system time source.
+   */
+  static SystemTimeSource& getInstance();
+
+  std::int64_t getTime() const override;
+
+  Timer* createTimer(QObject* parent) override;
+
+private:
+  /** A timer that wraps a precise Qt timer. */
+  class SystemTimer : public Timer
+  {
+  public:
+    /**
+     * Constructor.
+     * @param parent The Qt parent object.
+     */
+    explicit SystemTimer(QObject* parent);
+
+    void start(int interval) override;
+
+    void stop() override;
+
+    bool isActive() const override;
+
+  private:
+    QTimer* timer; /**< The Qt timer. */
+  };
+
+  /** Constructor. */
+  SystemTimeSource() = default;
+};
+
+/**
+ * A time source whose time only advances when it is told to. Expired timers are handled in the order of their deadlines
+ * (and in the order in which they have been started if the deadlines are equal), so that a simulation is deterministic.
+ * It must only be used by one thread.
+ */
+class VirtualTimeSource : public TimeSource
+{
+public:
+  /**
+   * Constructor.
+   * @param startTime The initial time (ns).
+   */
+  explicit VirtualTimeSource(std::int64_t startTime = 0);
+
+  /** Destructor. The timers of this source must have been deleted before. */
+  ~VirtualTimeSource() override;
+
+  std::int64_t getTime() const override;
+
+  Timer* createTimer(QObject* parent) override;
+
+  /**
+   * Advances the time, firing all timers whose deadlines are reached (each at its deadline).
+   * @param time The new time (ns), which must not be in the past.
+   */
+  void advanceTo(std::int64_t time);
+
+  /**
+   * Advances the time to the earliest deadline of all running timers and fires the timers that expire at it.
+   * @return Whether there has been a running timer.
+   */
+  bool advanceToNextTimer();
+
+private:
+  /** A timer that expires when the virtual time reaches its deadline. */
+  class VirtualTimer : public Timer
+  {
+  public:
+    /**
+     * Constructor. Registers the timer at its time source.
+     * @param source The time source.
+     * @param parent The Qt parent object.
+     */
+    VirtualTimer(VirtualTimeSource& source, QObject* parent);
+
+    /** Destructor. Unregisters the timer. */
+    ~VirtualTimer() override;
+
+    void start(int interval) override;
+
+    void stop() override;
+
+    bool isActive() const override;
+
+  private:
+    friend class VirtualTimeSource;
+
+    VirtualTimeSource& source; /**< The time source. */
+    std::int64_t deadline = -1; /**< The time at which the timer expires (-1 if it is not running). */
+    std::uint64_t sequenceNumber = 0; /**< The order in which timers have been started (to break ties between equal deadlines). */
+  };
+
+  /**
+   * Returns the running timer that expires next.
+   * @return The timer or nullptr if no timer is running.
+   */
+  VirtualTimer* getNextTimer() const;
+
+  std::int64_t time; /**< The current virtual time (ns). */
+  std::uint64_t nextSequenceNumber = 0; /**< The sequence number of the next started timer. */
+  std::vector<VirtualTimer*> timers; /**< All timers of this source (there are only a few, so they are searched linearly). */
+};
@@ -0,0 +1,303 @@
+/**
+ * @file HeatmapMain.cpp
+ *
+ * This file defines the main procedure of a program that renders the score surfaces of all whistle locations and robot subsets.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ScoreSurface.h"
+#include "ScoringRules.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+  constexpr float margin = 1.f; /**< The distance (m) by which the grid extends beyond the robots and whistle locations. */
+
+  /**
+   * Maps a score to a color (dark blue if only the field decision is correct, via green to yellow for the full score).
+   * @param score A score in [minScore, maxScore].
+   * @param minScore The score if only the field decision is correct (1 with the official rules).
+   * @param maxScore The full score (3 with the official rules).
+   * @return The color.
+   */
+  QRgb getColor(float score, float minScore, float maxScore)
+  {
+    static const int stops[][3] = {{68, 1, 84}, {59, 82, 139}, {33, 145, 140}, {94, 201, 98}, {253, 231, 37}};
+    const float position = maxScore > minScore ? std::max(0.f, std::min((score - minScore) / (maxScore - minScore), 1.f)) * 4.f : 4.f;
+    const int index = std::min(static_cast<int>(position), 3);
+    const float ratio = position - index;
+    int color[3];
+    for(int i = 0; i < 3; ++i)
+      color[i] = static_cast<int>(stops[index][i] + (stops[index + 1][i] - stops[index][i]) * ratio + 0.5f);
+    return qRgb(color[0], color[1], color[2]);
+  }
+
+  /**
+   * Draws a square marker into an image.
+   * @param image The image (whose top row is the maximum y coordinate of the grid).
+   * @param grid The grid that the image shows.
+   * @param location The location of the marker in field coordinates.
+   * @param color The color of the marker.
+   */
+  void drawMarker(QImage& image, const ScoreSurface::Grid& grid, const Vector2D& location, QRgb color)
+  {
+    const int column = static_cast<int>(std::round((location.x - grid.minX) / grid.resolution));
+    const int row = grid.height - 1 - static_cast<int>(std::round((location.y - grid.minY) / grid.resolution));
+    const int radius = std::max(2, static_cast<int>(0.05f / grid.resolution));
+    for(int y = std::max(0, row - radius); y <= std::min(grid.height - 1, row + radius); ++y)
+      for(int x = std::max(0, column - radius); x <= std::min(grid.width - 1, column + radius); ++x)
+        image.setPixel(x, y, color);
+  }
+
+  /**
+   * Writes a score surface as PNG image.
+   * @param path The path of the image.
+   * @param grid The grid of the surface.
+   * @param scores The scores of the cells.
+   * @param robotSetup The poses of the robots (which are marked in white).
+   * @param actualWhistleLocation The location of the whistle (which is marked in red).
+   * @param rules The rules with which the surface has been scored (which determine the range of the colors).
+   * @return Whether the image could be written.
+   */
+  bool writeImage(const QString& path, const ScoreSurface::Grid& grid, const std::vector<float>& scores, const QVector<Pose2D>& robotSetup, const Vector2D& actualWhistleLocation,
+                  const ScoringRules::Definition& rules)
+  {
+    const float minScore = rules.onSameFieldDecisionWeight;
+    const float maxScore = minScore + rules.directionWeight + rules.distanceWeight;
+    QImage image(grid.width, grid.height, QImage::Format_RGB32);
+    for(int row = 0; row < grid.height; ++row)
+    {
+      QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(grid.height - 1 - row));
+      const float* rowScores = &scores[static_cast<std::size_t>(row) * grid.width];
+      for(int column = 0; column < grid.width; ++column)
+        line[column] = getColor(rowScores[column], minScore, maxScore);
+    }
+    for(const Pose2D& pose : robotSetup)
+      drawMarker(image, grid, pose.translation, qRgb(255, 255, 255));
+    drawMarker(image, grid, actualWhistleLocation, qRgb(255, 0, 0));
+    return image.save(path, "PNG");
+  }
+
+  /**
+   * Writes a score surface as raw little endian 32 bit floats (row by row, starting at the minimum corner).
+   * @param path The path of the raster.
+   * @param scores The scores of the cells.
+   * @return Whether the raster could be written.
+   */
+  bool writeRaster(const QString& path, const std::vector<float>& scores)
+  {
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      return false;
+    QByteArray data(static_cast<int>(scores.size() * sizeof(float)), Qt::Uninitialized);
+    uchar* bytes = reinterpret_cast<uchar*>(data.data());
+    for(float score : scores)
+    {
+      quint32 bits;
+      std::memcpy(&bits, &score, sizeof(bits));
+      qToLittleEndian<quint32>(bits, bytes);
+      bytes += sizeof(bits);
+    }
+    return file.write(data) == data.size();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Calculates the score of every possible reported location for each whistle location and robot subset under the configured scoring rules\n"
+                                   "and writes the surfaces as PNG images and/or raw float rasters, together with an index (surfaces.json).");
+  parser.addHelpOption();
+  const QCommandLineOption robotsOption("robots", "The comma-separated jersey numbers of a robot subset (can be given multiple times; default: all subsets).", "robots");
+  const QCommandLineOption resolutionOption("resolution", "The size of a cell in meters (default: 0.01).", "meters", "0.01");
+  const QCommandLineOption formatOption("format", "The output format: png, raw or both (default: png).", "format", "png");
+  const QCommandLineOption threadsOption("threads", "The number of threads (default: one per core).", "threads", "0");
+  const QCommandLineOption outputOption("output", "The directory to which the surfaces are written (default: Heatmaps).", "directory", "Heatmaps");
+  parser.addOption(robotsOption);
+  parser.addOption(resolutionOption);
+  parser.addOption(formatOption);
+  parser.addOption(threadsOption);
+  parser.addOption(outputOption);
+  parser.process(app);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+  const ScoringRules::Definition& rules = ScoringRules::getConfiguredDefinition();
+
+  bool ok;
+  const float resolution = parser.value(resolutionOption).toFloat(&ok);
+  if(!ok || resolution <= 0.f)
+  {
+    error << "Invalid resolution: " << parser.value(resolutionOption) << endl;
+    return 2;
+  }
+  const QString format = parser.value(formatOption);
+  if(format != "png" && format != "raw" && format != "both")
+  {
+    error << "Invalid format: " << format << endl;
+    return 2;
+  }
+  const unsigned numOfThreads = parser.value(threadsOption).toUInt(&ok);
+  if(!ok)
+  {
+    error << "Invalid number of threads: " << parser.value(threadsOption) << endl;
+    return 2;
+  }
+
+  QVector<Pose2D> robotPoses;
+  QVector<Vector2D> whistleLocations;
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+
+  QVector<QVector<unsigned int>> subsets;
+  for(const QString& value : parser.values(robotsOption))
+  {
+    QVector<unsigned int> robotNumbers;
+    for(const QString& part : value.split(',', QString::SkipEmptyParts))
+    {
+      const unsigned int jerseyNumber = part.trimmed().toUInt(&ok);
+      if(!ok || jerseyNumber < 1 || static_cast<int>(jerseyNumber) > robotPoses.size() || robotNumbers.contains(jerseyNumber))
+      {
+        error << "Invalid robot number: " << part << endl;
+        return 2;
+      }
+      robotNumbers.append(jerseyNumber);
+    }
+    if(robotNumbers.isEmpty())
+    {
+      error << "Empty robot subset." << endl;
+      return 2;
+    }
+    std::sort(robotNumbers.begin(), robotNumbers.end());
+    subsets.append(robotNumbers);
+  }
+  if(subsets.isEmpty())
+    for(unsigned int mask = 1; mask < (1u << robotPoses.size()); ++mask)
+    {
+      QVector<unsigned int> robotNumbers;
+      for(int i = 0; i < robotPoses.size(); ++i)
+        if(mask & (1u << i))
+          robotNumbers.append(i + 1);
+      subsets.append(robotNumbers);
+    }
+
+  // A single grid that covers all robots and whistle locations, so that all surfaces can be compared directly.
+  float minX = robotPoses[0].translation.x, maxX = minX, minY = robotPoses[0].translation.y, maxY = minY;
+  for(const Pose2D& pose : robotPoses)
+  {
+    minX = std::min(minX, pose.translation.x);
+    maxX = std::max(maxX, pose.translation.x);
+    minY = std::min(minY, pose.translation.y);
+    maxY = std::max(maxY, pose.translation.y);
+  }
+  for(const Vector2D& location : whistleLocations)
+  {
+    minX = std::min(minX, location.x);
+    maxX = std::max(maxX, location.x);
+    minY = std::min(minY, location.y);
+    maxY = std::max(maxY, location.y);
+  }
+  ScoreSurface::Grid grid;
+  grid.minX = minX - margin;
+  grid.minY = minY - margin;
+  grid.resolution = resolution;
+  grid.width = static_cast<int>(std::ceil((maxX - minX + 2.f * margin) / resolution)) + 1;
+  grid.height = static_cast<int>(std::ceil((maxY - minY + 2.f * margin) / resolution)) + 1;
+
+  QDir outputDirectory(parser.value(outputOption));
+  if(!outputDirectory.mkpath("."))
+  {
+    error << "Could not create the output directory: " << outputDirectory.path() << endl;
+    return 1;
+  }
+
+  QJsonArray surfaces;
+  std::vector<float> scores;
+  QElapsedTimer timer;
+  timer.start();
+  for(const QVector<unsigned int>& robotNumbers : subsets)
+  {
+    QVector<Pose2D> robotSetup;
+    QStringList robotNames;
+    QJsonArray robots;
+    for(unsigned int jerseyNumber : robotNumbers)
+    {
+      robotSetup.append(robotPoses[jerseyNumber - 1]);
+      robotNames.append(QString::number(jerseyNumber));
+      robots.append(static_cast<int>(jerseyNumber));
+    }
+
+    for(int i = 0; i < whistleLocations.size(); ++i)
+    {
+      ScoreSurface::calculate(robotSetup, whistleLocations[i], grid, rules, scores, numOfThreads);
+
+      const QString baseName = "location" + QString::number(i + 1) + "_robots" + robotNames.join('-');
+      QJsonObject surface;
+      surface["location"] = i + 1;
+      surface["robots"] = robots;
+      if(format != "raw")
+      {
+        if(!writeImage(outputDirectory.filePath(baseName + ".png"), grid, scores, robotSetup, whistleLocations[i], rules))
+        {
+          error << "Could not write " << baseName << ".png" << endl;
+          return 1;
+        }
+        surface["image"] = baseName + ".png";
+      }
+      if(format != "png")
+      {
+        if(!writeRaster(outputDirectory.filePath(baseName + ".f32"), scores))
+        {
+          error << "Could not write " << baseName << ".f32" << endl;
+          return 1;
+        }
+        surface["raster"] = baseName + ".f32";
+      }
+      surfaces.append(surface);
+    }
+  }
+
+  QJsonObject gridObject;
+  gridObject["minX"] = grid.minX;
+  gridObject["minY"] = grid.minY;
+  gridObject["resolution"] = grid.resolution;
+  gridObject["width"] = grid.width;
+  gridObject["height"] = grid.height;
+  QJsonObject index;
+  index["grid"] = gridObject;
+  index["surfaces"] = surfaces;
+  QFile indexFile(outputDirectory.filePath("surfaces.json"));
+  if(!indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || indexFile.write(QJsonDocument(index).toJson()) < 0)
+  {
+    error << "Could not write the index." << endl;
+    return 1;
+  }
+
+  error << surfaces.size() << " surfaces of " << grid.width << "x" << grid.height << " cells in " << timer.elapsed() << " ms" << endl;
+  return 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file JournalConverterMain.cpp
+ *
+ * This file defines the main procedure of a program that converts result journals into CSV files or into
+ * columnar files (one raw file per column and a JSON index) that analysis tools can map directly.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Journal.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtEndian>
+#include <cstring>
+
+namespace
+{
+  /**
+   * Appends the value of a column of a record to a CSV line.
+   * @param bytes The encoded bytes of the value.
+   * @param type The type of the column.
+   * @param line The line.
+   */
+  void appendValue(const uchar* bytes, Journal::ColumnType type, QByteArray& line)
+  {
+    switch(type)
+    {
+      case Journal::ColumnType::uint8:
+        line += QByteArray::number(bytes[0]);
+        break;
+      case Journal::ColumnType::uint16:
+        line += QByteArray::number(qFromLittleEndian<quint16>(bytes));
+        break;
+      case Journal::ColumnType::uint32:
+        line += QByteArray::number(qFromLittleEndian<quint32>(bytes));
+        break;
+      case Journal::ColumnType::int64:
+        line += QByteArray::number(qFromLittleEndian<qint64>(bytes));
+        break;
+      case Journal::ColumnType::float32:
+      {
+        const quint32 bits = qFromLittleEndian<quint32>(bytes);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        line += QByteArray::number(value, 'g', 9);
+        break;
+      }
+    }
+  }
+
+  /**
+   * Writes a journal as CSV with a header line and one line per record.
+   * @param reader The journal.
+   * @param device The device to which the CSV is written.
+   * @return Whether everything could be written.
+   */
+  bool writeCsv(const JournalReader& reader, QIODevice& device)
+  {
+    QByteArray line;
+    for(const Journal::Column& column : Journal::columns)
+    {
+      if(!line.isEmpty())
+        line += ',';
+      line += column.name;
+    }
+    line += '\n';
+    if(device.write(line) != line.size())
+      return false;
+
+    for(std::size_t i = 0; i < reader.getNumOfRecords(); ++i)
+    {
+      line.clear();
+      const uchar* record = reader.getRecordData(i);
+      for(std::size_t j = 0; j < Journal::numOfColumns; ++j)
+      {
+        if(j)
+          line += ',';
+        appendValue(record + Journal::columns[j].offset, Journal::columns[j].type, line);
+      }
+      line += '\n';
+      if(device.write(line) != line.size())
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * Writes a journal as one file per column, each containing the little endian values of all records
+   * without any separators, and an index (columns.json) that lists the files, their types and the number of rows.
+   * @param reader The journal.
+   * @param directory The directory into which the files are written (it is created if necessary).
+   * @return Whether everything could be written.
+   */
+  bool writeColumns(const JournalReader& reader, const QString& directory)
+  {
+    const QDir dir(directory);
+    if(!dir.mkpath("."))
+      return false;
+
+    QJsonArray columns;
+    for(const Journal::Column& column : Journal::columns)
+    {
+      const std::size_t size = Journal::getSize(column.type);
+      QByteArray values(static_cast<int>(reader.getNumOfRecords() * size), Qt::Uninitialized);
+      for(std::size_t i = 0; i < reader.getNumOfRecords(); ++i)
+        std::memcpy(values.data() + i * size, reader.getRecordData(i) + column.offset, size);
+
+      const QString name = QString(column.name) + ".bin";
+      QSaveFile file(dir.filePath(name));
+      if(!file.open(QIODevice::WriteOnly) || file.write(values) != values.size() || !file.commit())
+        return false;
+
+      QJsonObject object;
+      object["name"] = column.name;
+      object["type"] = Journal::getName(column.type);
+      object["file"] = name;
+      columns.append(object);
+    }
+
+    QJsonObject index;
+    index["version"] = static_cast<int>(Journal::version);
+    index["rows"] = static_cast<qint64>(reader.getNumOfRecords());
+    index["columns"] = columns;
+    QSaveFile file(dir.filePath("columns.json"));
+    const QByteArray json = QJsonDocument(index).toJson();
+    return file.open(QIODevice::WriteOnly) && file.write(json) == json.size() && file.commit();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Converts a result journal into a CSV file or into columnar files.");
+  parser.addHelpOption();
+  const QCommandLineOption formatOption("format", "The output format: csv or columns (default: csv).", "format", "csv");
+  const QCommandLineOption outputOption("output", "The CSV file (default: standard output) or the directory for the columns (required).", "path");
+  parser.addOption(formatOption);
+  parser.addOption(outputOption);
+  parser.addPositionalArgument("journal", "The journal file (journal_*.dwj).", "journal");
+  parser.process(app);
+
+  QTextStream error(stderr);
+  const QString format = parser.value(formatOption);
+  if(format != "csv" && format != "columns")
+  {
+    error << "Invalid format: " << format << endl;
+    return 2;
+  }
+  if(parser.positionalArguments().size() != 1 || (format == "columns" && !parser.isSet(outputOption)))
+    parser.showHelp(2);
+
+  const QString path = parser.positionalArguments().first();
+  const JournalReader reader(path);
+  if(!reader.isValid())
+  {
+    error << "Could not read " << path << endl;
+    return 1;
+  }
+
+  bool written;
+  if(format == "columns")
+    written = writeColumns(reader, parser.value(outputOption));
+  else if(parser.isSet(outputOption))
+  {
+    QSaveFile file(parser.value(outputOption));
+    written = file.open(QIODevice::WriteOnly) && writeCsv(reader, file) && file.commit();
+  }
+  else
+  {
+    QFile file;
+    written = file.open(stdout, QIODevice::WriteOnly) && writeCsv(reader, file);
+  }
+  if(!written)
+  {
+    error << "Could not write " << (parser.isSet(outputOption) ? parser.value(outputOption) : QString("the output")) << endl;
+    return 1;
+  }
+
+  error << "Converted " << reader.getNumOfRecords() << " records." << endl;
+  return 0;
+}
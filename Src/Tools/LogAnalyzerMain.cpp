@@ -0,0 +1,224 @@
+/**
+ * @file LogAnalyzerMain.cpp
+ *
+ * This file defines the main procedure of a program that rebuilds all challenge passes from the logs of a tournament
+ * and prints the standings and statistics per team.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "LogAnalyzer.h"
+#include "Metric.h"
+#include "ResultJson.h"
+#include "ScoringRules.h"
+#include "TeamList.h"
+#include "Util/Paths.h"
+#include "Util/ThreadPool.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QTextStream>
+#include <algorithm>
+
+namespace
+{
+  /** The statistics of a team over all of its passes. */
+  struct TeamStatistics
+  {
+    QString team; /**< The name of the team. */
+    int finishedPasses = 0; /**< The number of finished passes. */
+    int abortedPasses = 0; /**< The number of aborted passes. */
+    int incompletePasses = 0; /**< The number of passes that have neither been finished nor aborted. */
+    float bestScore = 0.f; /**< The highest final score of a finished pass. */
+    double scoreSum = 0.0; /**< The sum of the final scores of the finished passes. */
+    int attempts = 0; /**< The number of finished attempts (in all passes). */
+    int timeouts = 0; /**< The number of attempts that timed out. */
+    double attemptScoreSum = 0.0; /**< The sum of the scores of the finished attempts. */
+    double remainingTimeSum = 0.0; /**< The sum of the remaining times (ms) of the attempts that did not time out. */
+    int fieldDecisions = 0; /**< The number of attempts with a reported location. */
+    int correctFieldDecisions = 0; /**< The number of attempts with a correct "same field"/"other field" decision. */
+
+    /**
+     * Converts the statistics to JSON.
+     * @param rank The rank of the team (starting at 1).
+     * @return The statistics as JSON object.
+     */
+    QJsonObject toJson(int rank) const
+    {
+      QJsonObject object;
+      object["rank"] = rank;
+      object["team"] = team;
+      object["bestScore"] = bestScore;
+      object["meanScore"] = finishedPasses ? scoreSum / finishedPasses : 0.0;
+      object["finishedPasses"] = finishedPasses;
+      object["abortedPasses"] = abortedPasses;
+      object["incompletePasses"] = incompletePasses;
+      object["attempts"] = attempts;
+      object["timeouts"] = timeouts;
+      object["meanAttemptScore"] = attempts ? attemptScoreSum / attempts : 0.0;
+      object["meanRemainingTime"] = attempts > timeouts ? remainingTimeSum / (attempts - timeouts) : 0.0;
+      object["fieldDecisionAccuracy"] = fieldDecisions ? static_cast<double>(correctFieldDecisions) / fieldDecisions : 0.0;
+      return object;
+    }
+  };
+
+  /**
+   * Returns the name of the team of a pass. Logs of the tournament mode contain team numbers when a pass is started.
+   * @param pass The pass.
+   * @return The name of the team.
+   */
+  QString getTeamName(const LogAnalyzer::Pass& pass)
+  {
+    bool isNumber;
+    const unsigned int number = pass.team.toUInt(&isNumber);
+    if(isNumber)
+    {
+      const QString name = TeamList::getInstance().getTeamNameByNumber(number);
+      if(!name.isEmpty())
+        return name;
+    }
+    return pass.team;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Rebuilds all challenge passes from log files and prints the standings and statistics per team.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("logs", "Log files or directories with log_*.txt files (default: the log directory).", "[logs...]");
+  const QCommandLineOption formatOption("format", "The output format: text or json (default: text).", "format", "text");
+  const QCommandLineOption passesOption("passes", "Also print every pass (as JSON lines, before the standings).");
+  const QCommandLineOption threadsOption("threads", "The number of threads (default: one per core).", "threads", "0");
+  parser.addOption(formatOption);
+  parser.addOption(passesOption);
+  parser.addOption(threadsOption);
+  parser.process(app);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+
+  const QString format = parser.value(formatOption);
+  if(format != "text" && format != "json")
+  {
+    error << "Invalid format: " << format << endl;
+    return 2;
+  }
+  bool ok;
+  const unsigned numOfThreads = parser.value(threadsOption).toUInt(&ok);
+  if(!ok)
+  {
+    error << "Invalid number of threads: " << parser.value(threadsOption) << endl;
+    return 2;
+  }
+
+  QStringList arguments = parser.positionalArguments();
+  if(arguments.isEmpty())
+    arguments.append(Paths::getLogPath());
+  QStringList paths;
+  for(const QString& argument : arguments)
+    paths += QFileInfo(argument).isDir() ? LogAnalyzer::findLogs(argument) : QStringList(argument);
+
+  QElapsedTimer timer;
+  timer.start();
+  ThreadPool pool(numOfThreads);
+  QStringList failedPaths;
+  QVector<LogAnalyzer::Pass> passes = LogAnalyzer::parseFiles(paths, pool, failedPaths);
+  LogAnalyzer::removeInterruptedPasses(passes);
+  const double seconds = timer.nsecsElapsed() / 1e9;
+  for(const QString& path : failedPaths)
+    error << "Could not read " << path << endl;
+
+  QMap<QString, TeamStatistics> teams;
+  for(const LogAnalyzer::Pass& pass : passes)
+  {
+    TeamStatistics& statistics = teams[getTeamName(pass)];
+    statistics.team = getTeamName(pass);
+    switch(pass.status)
+    {
+      case LogAnalyzer::Pass::finished:
+        statistics.bestScore = statistics.finishedPasses ? std::max(statistics.bestScore, pass.totalScore) : pass.totalScore;
+        statistics.scoreSum += pass.totalScore;
+        ++statistics.finishedPasses;
+        break;
+      case LogAnalyzer::Pass::aborted:
+        ++statistics.abortedPasses;
+        break;
+      case LogAnalyzer::Pass::incomplete:
+        ++statistics.incompletePasses;
+        break;
+    }
+    for(const LogAnalyzer::Attempt& attempt : pass.attempts)
+    {
+      if(!attempt.finished)
+        continue;
+      ++statistics.attempts;
+      statistics.attemptScoreSum += attempt.score;
+      if(attempt.timedOut)
+      {
+        ++statistics.timeouts;
+        continue;
+      }
+      statistics.remainingTimeSum += attempt.remainingTime;
+      // Logs of older versions do not contain the rules, so they are judged with the configured ones.
+      const bool isActuallyOnSameField = Metric::isOnSameField(attempt.actualLocation, pass.hasRules ? pass.rules : ScoringRules::getConfiguredDefinition());
+      ++statistics.fieldDecisions;
+      if(attempt.reportedOnSameField == isActuallyOnSameField)
+        ++statistics.correctFieldDecisions;
+    }
+  }
+
+  // Teams are ranked by their best finished pass, teams without a finished pass come last.
+  QVector<TeamStatistics> standings;
+  for(const TeamStatistics& statistics : teams)
+    standings.append(statistics);
+  std::stable_sort(standings.begin(), standings.end(), [](const TeamStatistics& a, const TeamStatistics& b)
+  {
+    if((a.finishedPasses > 0) != (b.finishedPasses > 0))
+      return a.finishedPasses > 0;
+    return a.bestScore > b.bestScore;
+  });
+
+  QTextStream out(stdout);
+  if(parser.isSet(passesOption))
+    for(const LogAnalyzer::Pass& pass : passes)
+    {
+      QJsonObject object = ResultJson::fromLoggedPass(pass);
+      object["team"] = getTeamName(pass);
+      out << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+    }
+  if(format == "json")
+    for(int i = 0; i < standings.size(); ++i)
+      out << QJsonDocument(standings[i].toJson(i + 1)).toJson(QJsonDocument::Compact) << '\n';
+  else
+  {
+    out << QString("%1  %2  %3  %4  %5  %6  %7  %8  %9\n").arg("Rank", 4).arg("Team", -24).arg("Best", 6).arg("Mean", 6).arg("Passes", 8)
+                                                          .arg("Attempts", 8).arg("Timeouts", 8).arg("Field", 6).arg("Remaining");
+    for(int i = 0; i < standings.size(); ++i)
+    {
+      const QJsonObject object = standings[i].toJson(i + 1);
+      out << QString("%1  %2  %3  %4  %5  %6  %7  %8  %9\n").arg(i + 1, 4).arg(standings[i].team.left(24), -24)
+                                                            .arg(standings[i].bestScore, 6, 'f', 3).arg(object["meanScore"].toDouble(), 6, 'f', 3)
+                                                            .arg(QString("%1/%2/%3").arg(standings[i].finishedPasses).arg(standings[i].abortedPasses).arg(standings[i].incompletePasses), 8)
+                                                            .arg(standings[i].attempts, 8).arg(standings[i].timeouts, 8)
+                                                            .arg(QString::number(qRound(object["fieldDecisionAccuracy"].toDouble() * 100.0)) + "%", 6)
+                                                            .arg(QString::number(object["meanRemainingTime"].toDouble(), 'f', 1) + "ms");
+    }
+  }
+  out.flush();
+
+  error << "Parsed " << passes.size() << " passes from " << paths.size() << " logs in " << seconds * 1000.0 << " ms." << endl;
+  return failedPaths.isEmpty() ? 0 : 1;
+}
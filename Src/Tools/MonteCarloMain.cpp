@@ -0,0 +1,209 @@
+/**
+ * @file MonteCarloMain.cpp
+ *
+ * This file defines the main procedure of a program that estimates the score distribution at each whistle location
+ * for robot subsets under a noise model, in order to choose the robots to hand in and to check that the locations are fair.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "MonteCarlo.h"
+#include "ScoringRules.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include "Util/ThreadPool.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+
+namespace
+{
+  /** The results of a robot subset. */
+  struct SubsetResult
+  {
+    QVector<unsigned int> robotNumbers; /**< The jersey numbers of the robots. */
+    QVector<MonteCarlo::LocationResult> locations; /**< The result at each whistle location. */
+    double expectedScore = 0.0; /**< The expected total score of a pass (one attempt per location). */
+  };
+
+  /**
+   * Parses a floating point option that must lie in a range.
+   * @param parser The command line parser.
+   * @param option The option.
+   * @param min The smallest valid value.
+   * @param max The largest valid value.
+   * @param value Set to the value of the option.
+   * @return Whether the value is valid.
+   */
+  bool parseFloat(const QCommandLineParser& parser, const QCommandLineOption& option, float min, float max, float& value)
+  {
+    bool ok;
+    value = parser.value(option).toFloat(&ok);
+    return ok && value >= min && value <= max;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Estimates the expected score and score percentiles at each whistle location for robot subsets\n"
+                                   "by scoring reports with random errors under the configured scoring rules\n"
+                                   "and prints one JSON line per subset (best subset first).");
+  parser.addHelpOption();
+  const QCommandLineOption robotsOption("robots", "The comma-separated jersey numbers of a robot subset (can be given multiple times; default: all subsets).", "robots");
+  const QCommandLineOption trialsOption("trials", "The number of trials per whistle location and subset (default: 1000000).", "count", "1000000");
+  const QCommandLineOption seedOption("seed", "The seed of the random streams (default: 0).", "seed", "0");
+  const QCommandLineOption bearingErrorOption("bearing-error", "The standard deviation (degrees) of the reported direction (default: 10).", "degrees", "10");
+  const QCommandLineOption rangeErrorOption("range-error", "The standard deviation of the reported distance relative to the actual one (default: 0.2).", "fraction", "0.2");
+  const QCommandLineOption falseSameFieldOption("false-same-field-rate", "The probability of a wrong field decision (default: 0.05).", "probability", "0.05");
+  const QCommandLineOption dropoutOption("dropout-rate", "The probability that no report arrives in time (default: 0.05).", "probability", "0.05");
+  const QCommandLineOption threadsOption("threads", "The number of threads (default: one per core).", "threads", "0");
+  parser.addOption(robotsOption);
+  parser.addOption(trialsOption);
+  parser.addOption(seedOption);
+  parser.addOption(bearingErrorOption);
+  parser.addOption(rangeErrorOption);
+  parser.addOption(falseSameFieldOption);
+  parser.addOption(dropoutOption);
+  parser.addOption(threadsOption);
+  parser.process(app);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+
+  bool ok;
+  const qulonglong trials = parser.value(trialsOption).toULongLong(&ok);
+  if(!ok || !trials)
+  {
+    error << "Invalid number of trials: " << parser.value(trialsOption) << endl;
+    return 2;
+  }
+  const qulonglong seed = parser.value(seedOption).toULongLong(&ok);
+  if(!ok)
+  {
+    error << "Invalid seed: " << parser.value(seedOption) << endl;
+    return 2;
+  }
+  MonteCarlo::NoiseModel model;
+  if(!parseFloat(parser, bearingErrorOption, 0.f, 360.f, model.bearingError) ||
+     !parseFloat(parser, rangeErrorOption, 0.f, 100.f, model.rangeError) ||
+     !parseFloat(parser, falseSameFieldOption, 0.f, 1.f, model.falseSameFieldRate) ||
+     !parseFloat(parser, dropoutOption, 0.f, 1.f, model.dropoutRate))
+  {
+    error << "Invalid noise model." << endl;
+    return 2;
+  }
+  const unsigned numOfThreads = parser.value(threadsOption).toUInt(&ok);
+  if(!ok)
+  {
+    error << "Invalid number of threads: " << parser.value(threadsOption) << endl;
+    return 2;
+  }
+
+  QVector<Pose2D> robotPoses;
+  QVector<Vector2D> whistleLocations;
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+
+  QVector<QVector<unsigned int>> subsets;
+  for(const QString& value : parser.values(robotsOption))
+  {
+    QVector<unsigned int> robotNumbers;
+    for(const QString& part : value.split(',', QString::SkipEmptyParts))
+    {
+      const unsigned int jerseyNumber = part.trimmed().toUInt(&ok);
+      if(!ok || jerseyNumber < 1 || static_cast<int>(jerseyNumber) > robotPoses.size() || robotNumbers.contains(jerseyNumber))
+      {
+        error << "Invalid robot number: " << part << endl;
+        return 2;
+      }
+      robotNumbers.append(jerseyNumber);
+    }
+    if(robotNumbers.isEmpty())
+    {
+      error << "Empty robot subset." << endl;
+      return 2;
+    }
+    std::sort(robotNumbers.begin(), robotNumbers.end());
+    subsets.append(robotNumbers);
+  }
+  if(subsets.isEmpty())
+    for(unsigned int mask = 1; mask < (1u << robotPoses.size()); ++mask)
+    {
+      QVector<unsigned int> robotNumbers;
+      for(int i = 0; i < robotPoses.size(); ++i)
+        if(mask & (1u << i))
+          robotNumbers.append(i + 1);
+      subsets.append(robotNumbers);
+    }
+
+  const MonteCarlo monteCarlo(whistleLocations, model, ScoringRules::getConfiguredDefinition());
+  ThreadPool pool(numOfThreads);
+  QVector<SubsetResult> results;
+  QElapsedTimer timer;
+  timer.start();
+  for(const QVector<unsigned int>& robotNumbers : subsets)
+  {
+    QVector<Pose2D> robotSetup;
+    for(unsigned int jerseyNumber : robotNumbers)
+      robotSetup.append(robotPoses[jerseyNumber - 1]);
+
+    SubsetResult result;
+    result.robotNumbers = robotNumbers;
+    result.locations = monteCarlo.run(robotSetup, trials, seed, pool);
+    for(const MonteCarlo::LocationResult& location : result.locations)
+      result.expectedScore += location.meanScore;
+    results.append(result);
+  }
+  const double seconds = timer.nsecsElapsed() / 1e9;
+
+  std::stable_sort(results.begin(), results.end(), [](const SubsetResult& a, const SubsetResult& b) { return a.expectedScore > b.expectedScore; });
+  QTextStream out(stdout);
+  for(const SubsetResult& result : results)
+  {
+    QJsonArray robots;
+    for(unsigned int jerseyNumber : result.robotNumbers)
+      robots.append(static_cast<int>(jerseyNumber));
+    QJsonArray locations;
+    double minMean = 0.0, maxMean = 0.0;
+    for(int i = 0; i < result.locations.size(); ++i)
+    {
+      const MonteCarlo::LocationResult& location = result.locations[i];
+      QJsonObject object;
+      object["location"] = i + 1;
+      object["x"] = whistleLocations[i].x;
+      object["y"] = whistleLocations[i].y;
+      object["meanScore"] = location.meanScore;
+      object["stdDevScore"] = location.stdDevScore;
+      for(std::size_t j = 0; j < MonteCarlo::percentiles.size(); ++j)
+        object["p" + QString::number(MonteCarlo::percentiles[j])] = location.scorePercentiles[j];
+      locations.append(object);
+      minMean = i ? std::min(minMean, location.meanScore) : location.meanScore;
+      maxMean = i ? std::max(maxMean, location.meanScore) : location.meanScore;
+    }
+    QJsonObject object;
+    object["robots"] = robots;
+    object["expectedScore"] = result.expectedScore;
+    object["locationSpread"] = maxMean - minMean;
+    object["locations"] = locations;
+    out << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+  }
+  out.flush();
+
+  error << "Scored " << static_cast<double>(trials) * whistleLocations.size() * subsets.size() << " trials in " << seconds << " s on " << pool.getNumOfThreads() << " threads." << endl;
+  return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file ReplayMain.cpp
+ *
+ * This file defines the main procedure of a program that replays captures and prints the resulting scores.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ChallengeLog.h"
+#include "ReplayEngine.h"
+#include "ResultJson.h"
+#include "ScoringRules.h"
+#include "TeamList.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  ChallengeLog::setEnabled(false);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Replays captures of challenge passes and prints the results as JSON lines.");
+  parser.addHelpOption();
+  const QCommandLineOption speedOption("speed", "The factor by which the replay is faster than real time (default: 1).", "factor", "1");
+  const QCommandLineOption fastOption("fast", "Replay as fast as possible.");
+  parser.addOption(speedOption);
+  parser.addOption(fastOption);
+  parser.addPositionalArgument("captures", "The capture files to replay.", "captures...");
+  parser.process(app);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+
+  bool ok;
+  const double speed = parser.isSet(fastOption) ? 0.0 : parser.value(speedOption).toDouble(&ok);
+  if(!parser.isSet(fastOption) && (!ok || speed <= 0.0))
+  {
+    error << "Invalid speed: " << parser.value(speedOption) << endl;
+    return 2;
+  }
+  if(parser.positionalArguments().isEmpty())
+    parser.showHelp(2);
+
+  QVector<Pose2D> robotPoses;
+  QVector<Vector2D> whistleLocations;
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+
+  ReplayEngine engine(whistleLocations, robotPoses);
+  engine.setSpeed(speed);
+
+  QTextStream out(stdout);
+  int exitCode = 0;
+  for(const QString& path : parser.positionalArguments())
+  {
+    QVector<ReplayEngine::PassResult> results;
+    if(!engine.replay(path, results))
+    {
+      error << "Invalid capture: " << path << endl;
+      exitCode = 1;
+      continue;
+    }
+
+    for(const ReplayEngine::PassResult& result : results)
+    {
+      QJsonArray robots;
+      for(unsigned int jerseyNumber : result.robotNumbers)
+        robots.append(static_cast<int>(jerseyNumber));
+      QJsonArray attempts;
+      for(int i = 0; i < result.numOfFinishedAttempts; ++i)
+        attempts.append(ResultJson::fromAttempt(i, result.attempts[i]));
+
+      QJsonObject pass;
+      pass["capture"] = path;
+      pass["team"] = TeamList::getInstance().getTeamNameByNumber(result.teamNumber);
+      pass["teamNumber"] = static_cast<int>(result.teamNumber);
+      pass["robots"] = robots;
+      pass["attempts"] = attempts;
+      pass["complete"] = result.numOfFinishedAttempts == result.attempts.size();
+      pass["totalScore"] = result.totalScore;
+      out << QJsonDocument(pass).toJson(QJsonDocument::Compact) << '\n';
+    }
+  }
+  out.flush();
+
+  return exitCode;
+}
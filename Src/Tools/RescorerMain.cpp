@@ -0,0 +1,285 @@
+/**
+ * @file RescorerMain.cpp
+ *
+ * This file defines the main procedure of a program that scores the recorded passes of a tournament again with a grid
+ * of other thresholds of the metric and prints how the standings would have changed.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ChallengeLog.h"
+#include "LogAnalyzer.h"
+#include "ReplayEngine.h"
+#include "Rescorer.h"
+#include "ScoringRules.h"
+#include "TeamList.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include "Util/ThreadPool.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+  /**
+   * Parses the values of a threshold, either as a list (e.g. "5,7.5,10") or as a range with a step (e.g. "5:10:2.5").
+   * @param text The text of the option.
+   * @param values The values.
+   * @return Whether the text is valid.
+   */
+  bool parseValues(const QString& text, QVector<float>& values)
+  {
+    values.clear();
+    bool ok = true;
+    const QStringList range = text.split(':');
+    if(range.size() == 3)
+    {
+      const float first = range[0].toFloat(&ok), last = ok ? range[1].toFloat(&ok) : 0.f, step = ok ? range[2].toFloat(&ok) : 0.f;
+      if(!ok || step <= 0.f || last < first)
+        return false;
+      // The values are calculated from the start, so that the last one is not missed due to accumulated rounding errors.
+      for(int i = 0; first + i * step <= last + step * 1e-3f; ++i)
+        values.append(first + i * step);
+      return true;
+    }
+    for(const QString& value : text.split(','))
+    {
+      values.append(value.toFloat(&ok));
+      if(!ok)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * Returns the name of a team that has been recorded by number if it is known.
+   * @param team The team as recorded (a name, or a number in logs of the tournament mode).
+   * @return The name of the team.
+   */
+  QString getTeamName(const QString& team)
+  {
+    bool isNumber;
+    const unsigned int number = team.toUInt(&isNumber);
+    if(isNumber)
+    {
+      const QString name = TeamList::getInstance().getTeamNameByNumber(number);
+      if(!name.isEmpty())
+        return name;
+    }
+    return team;
+  }
+
+  /**
+   * Converts the swept thresholds to JSON.
+   * @param rules The thresholds and the field geometry (the direction and distance thresholds are swept together).
+   * @return The thresholds as JSON object.
+   */
+  QJsonObject toJson(const Metric::Rules& rules)
+  {
+    QJsonObject object;
+    object["minDeviation"] = rules.minDirectionDeviation;
+    object["maxDeviation"] = rules.maxDirectionDeviation;
+    object["fieldHalfLength"] = rules.fieldHalfLength;
+    object["fieldHalfWidth"] = rules.fieldHalfWidth;
+    return object;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  ChallengeLog::setEnabled(false);
+
+  // The rules are needed for the defaults of the options, so invalid rules are reported before the command line is parsed.
+  QTextStream error(stderr);
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+  const ScoringRules::Definition& defaults = ScoringRules::getConfiguredDefinition();
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Scores the recorded passes again with a grid of thresholds of the configured scoring rules and prints how the ranks of the teams change.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("recordings", "Log files, captures (*.dwc) or directories with log_*.txt files (default: the log directory).", "[recordings...]");
+  const QCommandLineOption minDeviationOption("min-deviation", "The deviations (degrees or percent) up to which the direction/distance score is 1 (a list a,b,... or a range first:last:step).",
+                                              "values", QString::number(defaults.minDirectionDeviation));
+  const QCommandLineOption maxDeviationOption("max-deviation", "The deviations (degrees or percent) from which on the direction/distance score is 0.",
+                                              "values", QString::number(defaults.maxDirectionDeviation));
+  const QCommandLineOption fieldHalfLengthOption("field-half-length", "Half the lengths (m) of the area that counts as \"same field\".", "values", QString::number(defaults.fieldHalfLength));
+  const QCommandLineOption fieldHalfWidthOption("field-half-width", "Half the widths (m) of the area that counts as \"same field\".", "values", QString::number(defaults.fieldHalfWidth));
+  const QCommandLineOption formatOption("format", "The output format: text or json (default: text).", "format", "text");
+  const QCommandLineOption threadsOption("threads", "The number of threads (default: one per core).", "threads", "0");
+  parser.addOption(minDeviationOption);
+  parser.addOption(maxDeviationOption);
+  parser.addOption(fieldHalfLengthOption);
+  parser.addOption(fieldHalfWidthOption);
+  parser.addOption(formatOption);
+  parser.addOption(threadsOption);
+  parser.process(app);
+
+  const QString format = parser.value(formatOption);
+  if(format != "text" && format != "json")
+  {
+    error << "Invalid format: " << format << endl;
+    return 2;
+  }
+  bool ok;
+  const unsigned numOfThreads = parser.value(threadsOption).toUInt(&ok);
+  if(!ok)
+  {
+    error << "Invalid number of threads: " << parser.value(threadsOption) << endl;
+    return 2;
+  }
+  QVector<float> minDeviations, maxDeviations, fieldHalfLengths, fieldHalfWidths;
+  for(const auto& option : {std::make_pair(&minDeviationOption, &minDeviations), std::make_pair(&maxDeviationOption, &maxDeviations),
+                            std::make_pair(&fieldHalfLengthOption, &fieldHalfLengths), std::make_pair(&fieldHalfWidthOption, &fieldHalfWidths)})
+    if(!parseValues(parser.value(*option.first), *option.second))
+    {
+      error << "Invalid values of --" << option.first->names().first() << ": " << parser.value(*option.first) << endl;
+      return 2;
+    }
+  const QVector<ScoringRules::Definition> ruleSets = Rescorer::createGrid(defaults, minDeviations, maxDeviations, fieldHalfLengths, fieldHalfWidths);
+  if(ruleSets.isEmpty())
+  {
+    error << "No set of thresholds has a minimum deviation below its maximum deviation." << endl;
+    return 2;
+  }
+
+  QStringList arguments = parser.positionalArguments();
+  if(arguments.isEmpty())
+    arguments.append(Paths::getLogPath());
+  QStringList logPaths, capturePaths;
+  for(const QString& argument : arguments)
+    if(QFileInfo(argument).isDir())
+      logPaths += LogAnalyzer::findLogs(argument);
+    else if(argument.endsWith(".dwc"))
+      capturePaths.append(argument);
+    else
+      logPaths.append(argument);
+
+  QVector<Pose2D> robotPoses;
+  QVector<Vector2D> whistleLocations;
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+
+  // Only finished passes enter the standings, like in the log analyzer.
+  ThreadPool pool(numOfThreads);
+  Rescorer rescorer(robotPoses);
+  int numOfSkippedPasses = 0;
+  QStringList failedPaths;
+  for(const LogAnalyzer::Pass& pass : LogAnalyzer::parseFiles(logPaths, pool, failedPaths))
+  {
+    if(pass.status != LogAnalyzer::Pass::finished)
+      continue;
+    QVector<Rescorer::Attempt> attempts;
+    for(const LogAnalyzer::Attempt& loggedAttempt : pass.attempts)
+    {
+      Rescorer::Attempt attempt;
+      attempt.actualLocation = loggedAttempt.actualLocation;
+      attempt.reportedLocation = loggedAttempt.reportedLocation;
+      attempt.reportedOnSameField = loggedAttempt.reportedOnSameField;
+      attempt.timedOut = loggedAttempt.timedOut;
+      attempts.append(attempt);
+    }
+    if(!rescorer.addPass(getTeamName(pass.team), pass.robotNumbers, attempts))
+      ++numOfSkippedPasses;
+  }
+
+  ReplayEngine engine(whistleLocations, robotPoses);
+  engine.setSpeed(0.0);
+  for(const QString& path : capturePaths)
+  {
+    QVector<ReplayEngine::PassResult> results;
+    if(!engine.replay(path, results))
+    {
+      failedPaths.append(path);
+      continue;
+    }
+    for(const ReplayEngine::PassResult& result : results)
+    {
+      if(result.numOfFinishedAttempts != result.attempts.size())
+        continue;
+      QVector<Rescorer::Attempt> attempts;
+      for(const Challenge::Attempt& replayedAttempt : result.attempts)
+      {
+        Rescorer::Attempt attempt;
+        attempt.actualLocation = whistleLocations[replayedAttempt.locationIndex];
+        attempt.reportedLocation = replayedAttempt.whistle.location;
+        attempt.reportedOnSameField = replayedAttempt.whistle.onSameField;
+        attempt.timedOut = replayedAttempt.remainingTime == -1;
+        attempts.append(attempt);
+      }
+      if(!rescorer.addPass(getTeamName(QString::number(result.teamNumber)), result.robotNumbers, attempts))
+        ++numOfSkippedPasses;
+    }
+  }
+  for(const QString& path : failedPaths)
+    error << "Could not read " << path << endl;
+  if(numOfSkippedPasses)
+    error << "Skipped " << numOfSkippedPasses << " passes with robots that are not configured." << endl;
+
+  QElapsedTimer timer;
+  timer.start();
+  const Rescorer::Result baseline = rescorer.score(defaults);
+  const QVector<Rescorer::Result> results = rescorer.sweep(ruleSets, pool);
+  const double seconds = timer.nsecsElapsed() / 1e9;
+
+  QTextStream out(stdout);
+  const QStringList& teams = rescorer.getTeams();
+  if(format == "text")
+    out << QString("%1  %2  %3  %4  %5  %6\n").arg("MinDev", 6).arg("MaxDev", 6).arg("Length", 6).arg("Width", 6).arg("Changes", 7).arg("Ranks (rules -> these thresholds)");
+  for(const Rescorer::Result& result : results)
+  {
+    // Teams are listed by their rank under the thresholds of the rules.
+    QVector<int> changedTeams;
+    for(int i = 0; i < teams.size(); ++i)
+      if(result.ranks[i] != baseline.ranks[i])
+        changedTeams.append(i);
+    std::stable_sort(changedTeams.begin(), changedTeams.end(), [&baseline](int a, int b) { return baseline.ranks[a] < baseline.ranks[b]; });
+
+    if(format == "json")
+    {
+      QJsonArray changes;
+      for(int i : changedTeams)
+      {
+        QJsonObject change;
+        change["team"] = teams[i];
+        change["baselineRank"] = baseline.ranks[i];
+        change["rank"] = result.ranks[i];
+        change["baselineScore"] = baseline.bestScores[i];
+        change["score"] = result.bestScores[i];
+        changes.append(change);
+      }
+      QJsonObject object;
+      object["parameters"] = toJson(result.rules);
+      object["rankChanges"] = changedTeams.size();
+      object["changes"] = changes;
+      out << QJsonDocument(object).toJson(QJsonDocument::Compact) << '\n';
+    }
+    else
+    {
+      QStringList changes;
+      for(int i : changedTeams)
+        changes.append(QString("%1 %2->%3").arg(teams[i]).arg(baseline.ranks[i]).arg(result.ranks[i]));
+      out << QString("%1  %2  %3  %4  %5  %6\n").arg(result.rules.minDirectionDeviation, 6, 'g', 4).arg(result.rules.maxDirectionDeviation, 6, 'g', 4)
+                                                .arg(result.rules.fieldHalfLength, 6, 'g', 4).arg(result.rules.fieldHalfWidth, 6, 'g', 4)
+                                                .arg(changedTeams.size(), 7).arg(changes.join(", "));
+    }
+  }
+  out.flush();
+
+  error << "Rescored " << rescorer.getNumOfPasses() << " passes (" << rescorer.getNumOfAttempts() << " attempts) of " << teams.size() << " teams with "
+        << ruleSets.size() << " sets of thresholds in " << seconds * 1000.0 << " ms." << endl;
+  return failedPaths.isEmpty() ? 0 : 1;
+}
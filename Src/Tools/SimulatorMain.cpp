@@ -0,0 +1,167 @@
+/**
+ * @file SimulatorMain.cpp
+ *
+ * This file defines the main procedure of a program that simulates many challenge passes in virtual time
+ * and prints the distribution of their scores.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ChallengeLog.h"
+#include "PassSimulator.h"
+#include "ResultJson.h"
+#include "ScoringRules.h"
+#include "Util/Clock.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  /**
+   * Parses a floating point option that must lie in a range.
+   * @param parser The command line parser.
+   * @param option The option.
+   * @param min The smallest valid value.
+   * @param max The largest valid value.
+   * @param value Set to the value of the option.
+   * @return Whether the value is valid.
+   */
+  bool parseFloat(const QCommandLineParser& parser, const QCommandLineOption& option, float min, float max, float& value)
+  {
+    bool ok;
+    value = parser.value(option).toFloat(&ok);
+    return ok && value >= min && value <= max;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+  ChallengeLog::setEnabled(false);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Simulates challenge passes of a modeled team in virtual time and prints the results as JSON lines.");
+  parser.addHelpOption();
+  const QCommandLineOption robotsOption("robots", "The comma-separated jersey numbers of the robots.", "numbers");
+  const QCommandLineOption passesOption("passes", "The number of passes (default: 1000).", "count", "1000");
+  const QCommandLineOption seedOption("seed", "The seed of the first pass, the others use the following seeds (default: 0).", "seed", "0");
+  const QCommandLineOption responseProbabilityOption("response-probability", "The probability that the robots send a message (default: 0.9).", "probability", "0.9");
+  const QCommandLineOption responseTimeOption("response-time", "The mean time (ms) until the message arrives (default: 1500).", "ms", "1500");
+  const QCommandLineOption locationNoiseOption("location-noise", "The standard deviation (m) of the reported coordinates (default: 0.5).", "m", "0.5");
+  const QCommandLineOption wrongFieldOption("wrong-field-probability", "The probability of a wrong field decision (default: 0.05).", "probability", "0.05");
+  const QCommandLineOption passesOutputOption("print-passes", "Print every pass (with its attempts) in addition to the summary.");
+  parser.addOption(robotsOption);
+  parser.addOption(passesOption);
+  parser.addOption(seedOption);
+  parser.addOption(responseProbabilityOption);
+  parser.addOption(responseTimeOption);
+  parser.addOption(locationNoiseOption);
+  parser.addOption(wrongFieldOption);
+  parser.addOption(passesOutputOption);
+  parser.process(app);
+
+  QVector<Pose2D> robotPoses;
+  QVector<Vector2D> whistleLocations;
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+
+  bool ok = parser.isSet(robotsOption);
+  QVector<Pose2D> robotSetup;
+  for(const QString& number : parser.value(robotsOption).split(',', QString::SkipEmptyParts))
+  {
+    const int jerseyNumber = number.toInt(&ok);
+    if(!ok || jerseyNumber < 1 || jerseyNumber > robotPoses.size())
+    {
+      ok = false;
+      break;
+    }
+    robotSetup.append(robotPoses[jerseyNumber - 1]);
+  }
+  if(!ok || robotSetup.isEmpty())
+  {
+    error << "Invalid robots: " << parser.value(robotsOption) << endl;
+    return 2;
+  }
+  const int numOfPasses = parser.value(passesOption).toInt(&ok);
+  if(!ok || numOfPasses < 1)
+  {
+    error << "Invalid number of passes: " << parser.value(passesOption) << endl;
+    return 2;
+  }
+  const unsigned int firstSeed = parser.value(seedOption).toUInt(&ok);
+  if(!ok)
+  {
+    error << "Invalid seed: " << parser.value(seedOption) << endl;
+    return 2;
+  }
+  PassSimulator::TeamModel model;
+  if(!parseFloat(parser, responseProbabilityOption, 0.f, 1.f, model.responseProbability) ||
+     !parseFloat(parser, responseTimeOption, 0.f, 1e6f, model.meanResponseTime) ||
+     !parseFloat(parser, locationNoiseOption, 0.f, 100.f, model.locationNoise) ||
+     !parseFloat(parser, wrongFieldOption, 0.f, 1.f, model.wrongFieldProbability))
+  {
+    error << "Invalid team model." << endl;
+    return 2;
+  }
+
+  const PassSimulator simulator(whistleLocations, robotSetup, model);
+  QTextStream out(stdout);
+  const std::int64_t startTime = Clock::getTime();
+  double sum = 0.0, squaredSum = 0.0, timeouts = 0.0, virtualTime = 0.0;
+  float minScore = 0.f, maxScore = 0.f;
+  for(int i = 0; i < numOfPasses; ++i)
+  {
+    const PassSimulator::PassResult result = simulator.simulate(firstSeed + static_cast<unsigned int>(i));
+    const float score = result.aggregates.totalScore;
+    sum += score;
+    squaredSum += static_cast<double>(score) * score;
+    timeouts += result.aggregates.numOfTimeouts;
+    virtualTime += result.duration / 1e9;
+    minScore = i ? std::min(minScore, score) : score;
+    maxScore = i ? std::max(maxScore, score) : score;
+
+    if(parser.isSet(passesOutputOption))
+    {
+      QJsonArray attempts;
+      for(int j = 0; j < result.attempts.size(); ++j)
+        attempts.append(ResultJson::fromAttempt(j, result.attempts[j]));
+      QJsonObject pass;
+      pass["seed"] = static_cast<double>(result.seed);
+      pass["attempts"] = attempts;
+      pass["totalScore"] = score;
+      out << QJsonDocument(pass).toJson(QJsonDocument::Compact) << '\n';
+    }
+  }
+
+  const double mean = sum / numOfPasses;
+  QJsonObject summary;
+  summary["passes"] = numOfPasses;
+  summary["meanScore"] = mean;
+  summary["stdDevScore"] = std::sqrt(std::max(0.0, squaredSum / numOfPasses - mean * mean));
+  summary["minScore"] = minScore;
+  summary["maxScore"] = maxScore;
+  summary["meanTimeouts"] = timeouts / numOfPasses;
+  summary["virtualTime"] = virtualTime;
+  summary["wallTime"] = (Clock::getTime() - startTime) / 1e9;
+  out << QJsonDocument(summary).toJson(QJsonDocument::Compact) << '\n';
+  out.flush();
+  return 0;
+}
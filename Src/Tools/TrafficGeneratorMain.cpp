@@ -0,0 +1,245 @@
+/**
+ * @file TrafficGeneratorMain.cpp
+ *
+ * This file defines the main procedure of a program that floods a team port with valid and malformed
+ * SPL standard messages and (optionally) measures the rate that the receiver absorbs without losses.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "MessageFactory.h"
+#include "SPLStandardMessageReceiver.h"
+#include "Util/Clock.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QUdpSocket>
+#include <QVector>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <utility>
+
+namespace
+{
+  constexpr float whistleMarker = 12345.f; /**< The x coordinate (mm) that identifies the whistle packet at the end of each step. */
+  constexpr int poolSize = 4096; /**< The number of pregenerated datagrams that are sent cyclically. */
+
+  /** Counts of sent datagrams per kind. */
+  using Counts = std::array<long long, MessageFactory::numOfKinds>;
+
+  /**
+   * Parses a traffic mix specification.
+   * @param specification A comma-separated list of kind=weight pairs.
+   * @param weights The relative weights of the kinds of messages (unmentioned kinds get 0).
+   * @return Whether the specification is valid.
+   */
+  bool parseMix(const QString& specification, std::array<double, MessageFactory::numOfKinds>& weights)
+  {
+    weights.fill(0.0);
+    for(const QString& part : specification.split(',', QString::SkipEmptyParts))
+    {
+      const QStringList pair = part.split('=');
+      bool ok = pair.size() == 2;
+      const double weight = ok ? pair[1].toDouble(&ok) : 0.0;
+      if(!ok || weight < 0.0)
+        return false;
+      int kind = 0;
+      while(kind < MessageFactory::numOfKinds && pair[0].trimmed() != MessageFactory::getName(static_cast<MessageFactory::Kind>(kind)))
+        ++kind;
+      if(kind == MessageFactory::numOfKinds)
+        return false;
+      weights[kind] = weight;
+    }
+    return std::any_of(weights.begin(), weights.end(), [](double weight){ return weight > 0.0; });
+  }
+
+  /**
+   * Sends traffic with a given rate and mix. The last datagram is always a valid whistle packet that is marked with \c whistleMarker.
+   * @param socket The socket through which the datagrams are sent.
+   * @param target The address to which the datagrams are sent.
+   * @param port The port to which the datagrams are sent.
+   * @param pool The pregenerated datagrams and their kinds.
+   * @param rate The number of datagrams per second.
+   * @param duration The duration (s).
+   * @param whistlePacket The marked whistle packet.
+   * @param counts The number of sent datagrams per kind.
+   * @return The number of datagrams that could not be sent.
+   */
+  long long sendTraffic(QUdpSocket& socket, const QHostAddress& target, quint16 port, const QVector<std::pair<MessageFactory::Kind, QByteArray>>& pool,
+                        double rate, double duration, const QByteArray& whistlePacket, Counts& counts)
+  {
+    counts.fill(0);
+    long long sendErrors = 0;
+    const long long total = std::max(1LL, static_cast<long long>(rate * duration));
+    const std::int64_t startTime = Clock::getTime();
+    for(long long i = 0; i < total; ++i)
+    {
+      const std::int64_t dueTime = startTime + static_cast<std::int64_t>(i * 1e9 / rate);
+      std::int64_t now;
+      while((now = Clock::getTime()) < dueTime)
+        if(dueTime - now > 200000)
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+      const bool last = i == total - 1;
+      const MessageFactory::Kind kind = last ? MessageFactory::valid : pool[i % pool.size()].first;
+      const QByteArray& datagram = last ? whistlePacket : pool[i % pool.size()].second;
+      if(socket.writeDatagram(datagram, target, port) == datagram.size())
+        ++counts[kind];
+      else
+        ++sendErrors;
+    }
+    return sendErrors;
+  }
+
+  /**
+   * Prints the number of sent datagrams per kind.
+   * @param out The stream to print to.
+   * @param counts The number of sent datagrams per kind.
+   */
+  void printCounts(QTextStream& out, const Counts& counts)
+  {
+    for(int kind = 0; kind < MessageFactory::numOfKinds; ++kind)
+      out << " " << MessageFactory::getName(static_cast<MessageFactory::Kind>(kind)) << "=" << counts[kind];
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Sends valid and malformed SPL standard messages to a team port.\n"
+                                   "With --measure, an in-process receiver is used and the rate is doubled until it loses messages.");
+  parser.addHelpOption();
+  const QCommandLineOption teamOption("team", "The team number (default: 99).", "number", "99");
+  const QCommandLineOption targetOption("target", "The address to send to (default: 127.0.0.1).", "address", "127.0.0.1");
+  const QCommandLineOption rateOption("rate", "The number of datagrams per second (the start rate with --measure, default: 1000).", "rate", "1000");
+  const QCommandLineOption maxRateOption("max-rate", "The highest rate that is tried with --measure (default: 1000000).", "rate", "1000000");
+  const QCommandLineOption durationOption("duration", "The duration (per step with --measure) in seconds (default: 2).", "seconds", "2");
+  const QCommandLineOption mixOption("mix", "The relative weights of the kinds of messages "
+                                     "(valid, otherVersion, badSize, badHeader, badPlayerNum, wrongTeamNum, badNumOfDataBytes).",
+                                     "kind=weight,...", "valid=1,otherVersion=4,badSize=1,badHeader=1,badPlayerNum=1,wrongTeamNum=1,badNumOfDataBytes=1");
+  const QCommandLineOption seedOption("seed", "The seed of the random number generator (default: 0).", "seed", "0");
+  const QCommandLineOption measureOption("measure", "Measure the sustained rate of an in-process receiver.");
+  parser.addOptions({teamOption, targetOption, rateOption, maxRateOption, durationOption, mixOption, seedOption, measureOption});
+  parser.process(app);
+
+  QTextStream out(stdout);
+  QTextStream error(stderr);
+
+  bool ok;
+  const unsigned int teamNumber = parser.value(teamOption).toUInt(&ok);
+  if(!ok || teamNumber >= 100)
+  {
+    error << "Invalid team number: " << parser.value(teamOption) << endl;
+    return 2;
+  }
+  const quint16 port = static_cast<quint16>(10000 + teamNumber);
+  const QHostAddress target(parser.value(targetOption));
+  const double rate = parser.value(rateOption).toDouble();
+  const double maxRate = parser.value(maxRateOption).toDouble();
+  const double duration = parser.value(durationOption).toDouble();
+  std::array<double, MessageFactory::numOfKinds> weights;
+  if(target.isNull() || rate <= 0.0 || maxRate < rate || duration <= 0.0 || !parseMix(parser.value(mixOption), weights))
+  {
+    error << "Invalid arguments." << endl;
+    return 2;
+  }
+
+  std::mt19937 random(parser.value(seedOption).toUInt());
+  std::discrete_distribution<int> kindDistribution(weights.begin(), weights.end());
+  QVector<std::pair<MessageFactory::Kind, QByteArray>> pool;
+  for(int i = 0; i < poolSize; ++i)
+  {
+    const auto kind = static_cast<MessageFactory::Kind>(kindDistribution(random));
+    pool.append(std::make_pair(kind, MessageFactory::create(kind, teamNumber, random)));
+  }
+  SPLStandardMessage whistleMessage;
+  std::memcpy(&whistleMessage, MessageFactory::create(MessageFactory::valid, teamNumber, random).constData(), offsetof(SPLStandardMessage, data));
+  whistleMessage.pose[0] = whistleMarker;
+  const QByteArray whistlePacket(reinterpret_cast<const char*>(&whistleMessage), offsetof(SPLStandardMessage, data));
+
+  QUdpSocket socket;
+  Counts counts;
+
+  if(!parser.isSet(measureOption))
+  {
+    const long long sendErrors = sendTraffic(socket, target, port, pool, rate, duration, whistlePacket, counts);
+    out << "Sent:";
+    printCounts(out, counts);
+    out << " sendErrors=" << sendErrors << endl;
+    return 0;
+  }
+
+  auto* receiver = new SPLStandardMessageReceiver(teamNumber);
+  QThread receiverThread;
+  receiver->moveToThread(&receiverThread);
+  QObject::connect(&receiverThread, &QThread::finished, receiver, &QObject::deleteLater);
+  receiverThread.start(QThread::TimeCriticalPriority);
+
+  // The whistle queue is drained continuously by a thread of its own, so that losses are caused by the receiver and not by this tool.
+  std::atomic<long long> drained(0);
+  std::atomic<bool> whistleReceived(false);
+  std::atomic<bool> stopConsumer(false);
+  std::thread consumer([receiver, &drained, &whistleReceived, &stopConsumer]
+  {
+    DetectedWhistle whistle;
+    while(!stopConsumer.load(std::memory_order_relaxed))
+    {
+      if(!receiver->getWhistleQueue().pop(whistle))
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        continue;
+      }
+      drained.fetch_add(1, std::memory_order_relaxed);
+      if(whistle.location.x == whistleMarker / 1000.f)
+        whistleReceived.store(true, std::memory_order_relaxed);
+    }
+  });
+
+  out << "Backend: " << (receiver->getBackend() == SPLStandardMessageReceiver::Backend::batched ? "batched" : "qt") << endl;
+  const SPLStandardMessageReceiver::Counters& counters = receiver->getCounters();
+  double sustainedRate = 0.0;
+  for(double stepRate = rate; stepRate <= maxRate; stepRate *= 2.0)
+  {
+    const std::uint64_t validBefore = counters.get(SPLStandardMessageReceiver::valid);
+    const std::uint64_t queueFullBefore = counters.getQueueFull();
+    const long long drainedBefore = drained.load(std::memory_order_relaxed);
+    whistleReceived.store(false, std::memory_order_relaxed);
+    const long long sendErrors = sendTraffic(socket, target, port, pool, stepRate, duration, whistlePacket, counts);
+
+    // Give the receiver some time to process what is still queued in the socket.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // Whistles are lost either before they reach the receiver (i.e. in the socket) or in it because the whistle queue is full.
+    const long long received = static_cast<long long>(counters.get(SPLStandardMessageReceiver::valid) - validBefore);
+    const long long queueFull = static_cast<long long>(counters.getQueueFull() - queueFullBefore);
+    const long long socketLost = counts[MessageFactory::valid] - received;
+    const long long lost = socketLost + queueFull;
+    out << "Rate " << stepRate << "/s:";
+    printCounts(out, counts);
+    out << " sendErrors=" << sendErrors << " received=" << received << " socketLost=" << socketLost << " queueFull=" << queueFull
+        << " delivered=" << (drained.load(std::memory_order_relaxed) - drainedBefore) << " lost=" << lost
+        << " whistle=" << (whistleReceived.load(std::memory_order_relaxed) ? "received" : "missed") << endl;
+    if(lost > 0 || !whistleReceived.load(std::memory_order_relaxed) || sendErrors > 0)
+      break;
+    sustainedRate = stepRate;
+  }
+  out << "Sustained rate: " << sustainedRate << " datagrams/s" << endl;
+
+  stopConsumer.store(true, std::memory_order_relaxed);
+  consumer.join();
+  receiverThread.quit();
+  receiverThread.wait();
+  return sustainedRate > 0.0 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file TournamentMain.cpp
+ *
+ * This file defines the main procedure of the program that runs challenge passes on several fields at once without a GUI.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "ScoringRules.h"
+#include "TournamentTester.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+int main(int argc, char* argv[])
+{
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Runs passes of the directional whistle challenge on several fields at once without a GUI.\n"
+                                   "Commands (\"pass <field> <robots> <team>\", \"resume <field>\", \"start <field>\", \"stop <field>\", \"status\", \"quit\") are read line by line\n"
+                                   "from the standard input and/or a local control socket. Events are written as JSON lines to the standard output.");
+  parser.addHelpOption();
+  const QCommandLineOption fieldsOption("fields", "The number of fields (default: 2).", "fields", "2");
+  const QCommandLineOption controlSocketOption("control-socket", "The name of a local socket on which commands are accepted.", "name");
+  const QCommandLineOption noStandardInputOption("no-stdin", "Do not read commands from the standard input.");
+  parser.addOption(fieldsOption);
+  parser.addOption(controlSocketOption);
+  parser.addOption(noStandardInputOption);
+  parser.process(app);
+
+  QTextStream error(stderr);
+
+  QString rulesError;
+  if(!ScoringRules::loadConfiguredDefinition(rulesError))
+  {
+    error << "Invalid scoring rules: " << rulesError << endl;
+    return 2;
+  }
+
+  bool ok;
+  const int numOfFields = parser.value(fieldsOption).toInt(&ok);
+  if(!ok || numOfFields < 1 || numOfFields > 100)
+  {
+    error << "Invalid number of fields: " << parser.value(fieldsOption) << endl;
+    return 2;
+  }
+
+  bool readStandardInput = !parser.isSet(noStandardInputOption);
+#ifndef __unix__
+  readStandardInput = false;
+#endif
+  if(!readStandardInput && !parser.isSet(controlSocketOption))
+  {
+    error << "Without the standard input, a control socket must be given." << endl;
+    return 2;
+  }
+
+  TournamentTester tester(numOfFields, readStandardInput, parser.value(controlSocketOption));
+
+  return app.exec();
+}
@@ -0,0 +1,344 @@
+/**
+ * @file TournamentTester.cpp
+ *
+ * This file implements a class that runs challenge passes on several fields at once without a GUI, controlled by commands and reporting results as JSON lines.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "TournamentTester.h"
+#include "Challenge.h"
+#include "ChallengeLog.h"
+#include "CommandChannel.h"
+#include "Journal.h"
+#include "LatencyProfile.h"
+#include "ResultJson.h"
+#include "SessionManager.h"
+#include "TeamList.h"
+#include "TeamMonitor.h"
+#include "Tracer.h"
+#include "Util/Clock.h"
+#include "Util/Paths.h"
+#include "Util/Reader.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTimer>
+#include <algorithm>
+
+TournamentTester::TournamentTester(int numOfFields, bool readStandardInput, const QString& controlSocketName, QObject* parent) :
+  QObject(parent)
+{
+  ChallengeLog() << "Started DirectionalWhistleTester (tournament, " << numOfFields << " fields)";
+  Reader::readPose2DList(Paths::getConfigPath() + "/robotPoses.json", robotPoses);
+  Reader::readVector2DList(Paths::getConfigPath() + "/whistleLocations.json", whistleLocations);
+
+#ifdef __linux__
+  // The monitor must bind the team ports before the receivers of passes do, so that the receivers get the unicast datagrams.
+  teamMonitor.reset(new TeamMonitor);
+#endif
+  sessionManager = new SessionManager(numOfFields, whistleLocations, robotPoses, Paths::getLogPath(), this);
+  connect(sessionManager, &SessionManager::attemptFinished, this, &TournamentTester::handleAttemptFinished);
+
+  commandChannel = new CommandChannel(readStandardInput, controlSocketName, this);
+  connect(commandChannel, &CommandChannel::commandReceived, this, &TournamentTester::handleCommand);
+}
+
+TournamentTester::~TournamentTester() = default;
+
+void TournamentTester::handleCommand(const QString& command, QLocalSocket* client)
+{
+  const QStringList arguments = command.split(' ', QString::SkipEmptyParts);
+  if(arguments[0] == "pass" && arguments.size() >= 4)
+  {
+    const int field = parseField(arguments[1], client);
+    if(field < 0)
+      return;
+
+    QVector<unsigned int> robotNumbers;
+    for(const QString& part : arguments[2].split(',', QString::SkipEmptyParts))
+    {
+      bool ok;
+      const unsigned int jerseyNumber = part.toUInt(&ok);
+      if(!ok || robotNumbers.contains(jerseyNumber))
+      {
+        commandChannel->writeError("Invalid robot number: " + part, client);
+        return;
+      }
+      robotNumbers.append(jerseyNumber);
+    }
+    std::sort(robotNumbers.begin(), robotNumbers.end());
+
+    QString teamName = QStringList(arguments.mid(3)).join(' ');
+    bool isNumber;
+    const unsigned int teamNumber = teamName.toUInt(&isNumber);
+    if(isNumber)
+      teamName = TeamList::getInstance().getTeamNameByNumber(teamNumber);
+    if(teamName.isEmpty() || !TeamList::getInstance().getTeamNames().contains(teamName))
+    {
+      commandChannel->writeError("Unknown team: " + QStringList(arguments.mid(3)).join(' '), client);
+      return;
+    }
+
+    QString error;
+    if(!sessionManager->startPass(field, TeamList::getInstance().getTeamNumberByName(teamName), robotNumbers, error))
+    {
+      commandChannel->writeError(error, client);
+      return;
+    }
+
+    QJsonArray robots;
+    for(unsigned int jerseyNumber : robotNumbers)
+      robots.append(static_cast<int>(jerseyNumber));
+    QJsonArray locations;
+    for(const Challenge::Attempt& attempt : sessionManager->getChallenge(field)->getAttempts())
+      locations.append(attempt.locationIndex + 1);
+    QJsonObject event;
+    event["event"] = "passStarted";
+    event["field"] = field + 1;
+    event["team"] = teamName;
+    event["robots"] = robots;
+    event["locations"] = locations;
+    commandChannel->writeEvent(event);
+  }
+  else if(arguments[0] == "resume" && arguments.size() == 2)
+  {
+    const int field = parseField(arguments[1], client);
+    if(field < 0)
+      return;
+
+    Journal::UnfinishedPass pass;
+    if(!sessionManager->findInterruptedPass(field, pass))
+    {
+      commandChannel->writeError("There is no interrupted pass on field " + arguments[1] + ".", client);
+      return;
+    }
+    QString error;
+    if(!sessionManager->startPass(field, pass.teamNumber, pass.robotNumbers, error, &pass))
+    {
+      commandChannel->writeError(error, client);
+      return;
+    }
+
+    QJsonArray robots;
+    for(unsigned int jerseyNumber : pass.robotNumbers)
+      robots.append(static_cast<int>(jerseyNumber));
+    QJsonArray locations;
+    for(int locationIndex : pass.locationOrder)
+      locations.append(locationIndex + 1);
+    QJsonObject event;
+    event["event"] = "passStarted";
+    event["field"] = field + 1;
+    event["team"] = TeamList::getInstance().getTeamNameByNumber(pass.teamNumber);
+    event["robots"] = robots;
+    event["locations"] = locations;
+    event["resumedAttempts"] = pass.results.size();
+    event["totalScore"] = sessionManager->getChallenge(field)->getTotalScore();
+    commandChannel->writeEvent(event);
+  }
+  else if(arguments[0] == "start" && arguments.size() == 2)
+  {
+    const int field = parseField(arguments[1], client);
+    if(field < 0)
+      return;
+    Challenge* challenge = sessionManager->getChallenge(field);
+    if(!challenge)
+      commandChannel->writeError("There is no pass on field " + arguments[1] + ".", client);
+    else if(challenge->isFinished())
+      commandChannel->writeError("The challenge pass on field " + arguments[1] + " is already finished.", client);
+    else if(challenge->isAttemptRunning())
+      commandChannel->writeError("An attempt is already running on field " + arguments[1] + ".", client);
+    else
+    {
+      const Challenge::Attempt& attempt = challenge->getAttempts()[challenge->getNumOfFinishedAttempts()];
+      challenge->startAttempt();
+
+      QJsonObject event;
+      event["event"] = "attemptStarted";
+      event["field"] = field + 1;
+      event["attempt"] = challenge->getNumOfFinishedAttempts() + 1;
+      event["location"] = attempt.locationIndex + 1;
+      commandChannel->writeEvent(event);
+    }
+  }
+  else if(arguments[0] == "stop" && arguments.size() == 2)
+  {
+    const int field = parseField(arguments[1], client);
+    if(field < 0)
+      return;
+    if(!sessionManager->getChallenge(field))
+    {
+      commandChannel->writeError("There is no pass on field " + arguments[1] + ".", client);
+      return;
+    }
+    const QString teamName = TeamList::getInstance().getTeamNameByNumber(sessionManager->getTeamNumber(field));
+    ChallengeLog(sessionManager->getLogWriter(field)) << "Aborted challenge pass of team " << teamName;
+    sessionManager->stopPass(field);
+
+    QJsonObject event;
+    event["event"] = "passAborted";
+    event["field"] = field + 1;
+    event["team"] = teamName;
+    commandChannel->writeEvent(event);
+  }
+  else if(arguments[0] == "status" && arguments.size() == 1)
+  {
+    QJsonArray fields;
+    for(int i = 0; i < sessionManager->getNumOfFields(); ++i)
+    {
+      QJsonObject field;
+      field["field"] = i + 1;
+      if(const Challenge* challenge = sessionManager->getChallenge(i))
+      {
+        field["team"] = TeamList::getInstance().getTeamNameByNumber(sessionManager->getTeamNumber(i));
+        field["finishedAttempts"] = challenge->getNumOfFinishedAttempts();
+        field["attempts"] = challenge->getAttempts().size();
+        field["attemptRunning"] = challenge->isAttemptRunning();
+        field["totalScore"] = challenge->getTotalScore();
+        field["ingress"] = ResultJson::fromCounters(sessionManager->getReceiver(i)->getCounters());
+      }
+      fields.append(field);
+    }
+    QJsonObject event;
+    event["event"] = "status";
+    event["fields"] = fields;
+    commandChannel->writeEvent(event);
+  }
+  else if(arguments[0] == "latency" && arguments.size() == 1)
+  {
+    QJsonObject event;
+    event["event"] = "latency";
+    event["stages"] = ResultJson::fromLatencyProfile(LatencyProfile::getInstance());
+    QJsonArray fields;
+    for(int i = 0; i < sessionManager->getNumOfFields(); ++i)
+    {
+      const LatencyHistogram* commitLatency = sessionManager->getCommitLatency(i);
+      if(!commitLatency || !commitLatency->getCount())
+        continue;
+      QJsonObject field;
+      field["field"] = i + 1;
+      field["logging"] = ResultJson::fromLatencyHistogram(*commitLatency);
+      fields.append(field);
+    }
+    event["fields"] = fields;
+    commandChannel->writeEvent(event);
+  }
+  else if(arguments[0] == "monitor" && arguments.size() == 1)
+  {
+#ifdef __linux__
+    const std::int64_t now = Clock::getTime();
+    QJsonArray teams;
+    std::vector<TeamMonitor::Report> reports;
+    for(unsigned int teamNumber = 0; teamNumber < TeamMonitor::numOfTeams; ++teamNumber)
+    {
+      const TeamMonitor::Statistics statistics = teamMonitor->getStatistics(teamNumber);
+      if(!statistics.datagrams)
+        continue;
+
+      QJsonArray recentWhistles;
+      teamMonitor->getRecentWhistles(teamNumber, reports);
+      for(const TeamMonitor::Report& report : reports)
+      {
+        QJsonObject whistle;
+        whistle["player"] = static_cast<int>(report.playerNumber);
+        whistle["x"] = report.whistle.location.x;
+        whistle["y"] = report.whistle.location.y;
+        whistle["reportedField"] = report.whistle.onSameField ? "same" : "other";
+        whistle["age"] = (now - report.whistle.timestamp) / 1000000.0;
+        recentWhistles.append(whistle);
+      }
+      QJsonObject team;
+      team["team"] = TeamList::getInstance().getTeamNameByNumber(teamNumber);
+      team["teamNumber"] = static_cast<int>(teamNumber);
+      team["datagrams"] = static_cast<double>(statistics.datagrams);
+      team["whistleMessages"] = static_cast<double>(statistics.whistleMessages);
+      team["invalidWhistleMessages"] = static_cast<double>(statistics.invalidWhistleMessages);
+      team["lastDatagramAge"] = (now - statistics.lastDatagram) / 1000000.0;
+      if(statistics.whistleMessages)
+        team["lastWhistleMessageAge"] = (now - statistics.lastWhistleMessage) / 1000000.0;
+      team["recentWhistles"] = recentWhistles;
+      teams.append(team);
+    }
+    QJsonObject event;
+    event["event"] = "monitor";
+    event["ports"] = static_cast<int>(teamMonitor->getNumOfOpenPorts());
+    event["teams"] = teams;
+    commandChannel->writeEvent(event);
+#else
+    commandChannel->writeError("Monitoring is only available on Linux.", client);
+#endif
+  }
+  else if(arguments[0] == "quit" && arguments.size() == 1)
+  {
+    for(int i = 0; i < sessionManager->getNumOfFields(); ++i)
+      if(sessionManager->getChallenge(i))
+      {
+        ChallengeLog(sessionManager->getLogWriter(i)) << "Aborted challenge pass of team " << TeamList::getInstance().getTeamNameByNumber(sessionManager->getTeamNumber(i));
+        sessionManager->stopPass(i);
+      }
+    QCoreApplication::exit(0);
+  }
+  else
+    commandChannel->writeError("Unknown command: " + command, client);
+}
+
+int TournamentTester::parseField(const QString& argument, QLocalSocket* client)
+{
+  bool ok;
+  const int field = argument.toInt(&ok) - 1;
+  if(!ok || field < 0 || field >= sessionManager->getNumOfFields())
+  {
+    commandChannel->writeError("Invalid field: " + argument, client);
+    return -1;
+  }
+  return field;
+}
+
+void TournamentTester::handleAttemptFinished(int field)
+{
+  Challenge* challenge = sessionManager->getChallenge(field);
+  const int attemptIndex = challenge->getNumOfFinishedAttempts() - 1;
+  QJsonObject event = ResultJson::fromAttempt(attemptIndex, challenge->getAttempts()[attemptIndex]);
+  event["event"] = "attemptFinished";
+  event["field"] = field + 1;
+  commandChannel->writeEvent(event);
+
+  if(challenge->isFinished())
+  {
+    const QString teamName = TeamList::getInstance().getTeamNameByNumber(sessionManager->getTeamNumber(field));
+    ChallengeLog(sessionManager->getLogWriter(field)) << "Finished challenge pass of team " << teamName << " with final score " << challenge->getTotalScore();
+    for(const QString& line : LatencyProfile::getInstance().toString().split('\n', QString::SkipEmptyParts))
+      ChallengeLog(sessionManager->getLogWriter(field)) << "Latency of " << line << " (all fields)";
+    const LatencyHistogram* commitLatency = sessionManager->getCommitLatency(field);
+    if(commitLatency && commitLatency->getCount())
+      ChallengeLog(sessionManager->getLogWriter(field)) << "Latency of logging: " << LatencyProfile::toString(*commitLatency) << " (this field)";
+    QString tracePath;
+    if(Tracer::isEnabled())
+    {
+      tracePath = Paths::getLogPath() + "/trace_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + "_field" + QString::number(field + 1) + ".json";
+      if(Tracer::write(tracePath, field))
+        ChallengeLog(sessionManager->getLogWriter(field)) << "Wrote trace to " << tracePath;
+      else
+        tracePath.clear();
+    }
+
+    QJsonObject passEvent;
+    passEvent["event"] = "passFinished";
+    passEvent["field"] = field + 1;
+    passEvent["team"] = teamName;
+    passEvent["totalScore"] = challenge->getTotalScore();
+    passEvent["meanScore"] = challenge->getAggregates().getMeanScore();
+    passEvent["timeouts"] = challenge->getAggregates().numOfTimeouts;
+    if(!tracePath.isEmpty())
+      passEvent["trace"] = tracePath;
+    commandChannel->writeEvent(passEvent);
+    // The field is free for the next team (stopping the pass deletes the challenge, so this must happen after the signal has been handled).
+    QTimer::singleShot(0, this, [this, field, challenge]
+    {
+      if(sessionManager->getChallenge(field) == challenge)
+        sessionManager->stopPass(field);
+    });
+  }
+}
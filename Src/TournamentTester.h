@@ -0,0 +1,69 @@
+/**
+ * @file TournamentTester.h
+ *
+ * This file declares a class that runs challenge passes on several fields at once without a GUI, controlled by commands and reporting results as JSON lines.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Util/Pose2D.h"
+#include "Util/Vector2D.h"
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class CommandChannel;
+class SessionManager;
+class TeamMonitor;
+class QLocalSocket;
+
+class TournamentTester : public QObject
+{
+  Q_OBJECT
+public:
+  /**
+   * Constructor. Begins to listen for commands.
+   * @param numOfFields The number of fields on which passes can run.
+   * @param readStandardInput Whether commands are read from the standard input.
+   * @param controlSocketName The name of a local socket on which commands are accepted (none if empty).
+   * @param parent The Qt parent object.
+   */
+  TournamentTester(int numOfFields, bool readStandardInput, const QString& controlSocketName, QObject* parent = nullptr);
+
+  /** Destructor. */
+  ~TournamentTester() override;
+
+private:
+  /**
+   * Executes a command:
+   * "pass <field> <robots> <team>" starts a pass, "start <field>" starts the next attempt on a field,
+   * "stop <field>" aborts the pass on a field, "status" reports the state of all fields,
+   * "monitor" reports which teams are sending (whistle) messages on their ports and "quit" aborts all passes.
+   * @param command The command line.
+   * @param client The control socket from which the command was received (nullptr for the standard input).
+   */
+  void handleCommand(const QString& command, QLocalSocket* client);
+
+  /**
+   * Parses the field argument of a command.
+   * @param argument The argument (one-based).
+   * @param client The source of the command, which receives an error if the field is invalid.
+   * @return The zero-based index of the field or -1 if it is invalid.
+   */
+  int parseField(const QString& argument, QLocalSocket* client);
+
+  /**
+   * Reports the result of the attempt that has just been finished on a field and ends the pass if it is finished.
+   * @param field The index of the field.
+   */
+  void handleAttemptFinished(int field);
+
+  QVector<Vector2D> whistleLocations; /**< The set of locations from which the whistle is blown. */
+  QVector<Pose2D> robotPoses; /**< The set of poses at which robots can be placed. */
+  SessionManager* sessionManager = nullptr; /**< The passes on all fields. */
+  CommandChannel* commandChannel = nullptr; /**< The source of commands and the destination of events. */
+  std::unique_ptr<TeamMonitor> teamMonitor; /**< The listener on all team ports (Linux only). */
+};
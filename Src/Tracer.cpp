@@ -0,0 +1,263 @@
+/**
+ * @file Tracer.cpp
+ *
+ * This file implements a class that records a timeline of spans and instants in per-thread buffers and writes it
+ * in the trace event format of Chrome.
+ *
+ * @author Arne Hasselbring
+ */
+
+#include "Tracer.h"
+#ifdef DWT_TRACING
+#include "Util/SPSCQueue.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+  /** A recorded span or instant. */
+  struct Event
+  {
+    const char* name = nullptr; /**< The name of the event. */
+    const char* argumentName = nullptr; /**< The name of the argument of the event (nullptr if there is none). */
+    std::int64_t argument = 0; /**< The value of the argument. */
+    std::int64_t timestamp = 0; /**< The time at which the event has started (ns). */
+    std::int64_t duration = -1; /**< The duration of the event (ns, -1 for instants). */
+    int field = -1; /**< The field on which the event has happened (-1 if it does not belong to a field). */
+  };
+
+  /** The events of a single thread (which is the producer, while the writer of the trace is the consumer). */
+  struct ThreadBuffer
+  {
+    int id = 0; /**< The number of the thread in the trace. */
+    QString name; /**< The name of the thread in the trace (protected by the mutex of the registry). */
+    SPSCQueue<Event, Tracer::bufferSize> events; /**< The events that have not been written yet. */
+    std::atomic<std::uint64_t> droppedEvents{0}; /**< The number of events that did not fit into the buffer. */
+    std::vector<Event> retainedEvents; /**< The events that have been taken from the queue but belong to a field whose trace has not been written yet (protected by the mutex of the registry). */
+  };
+
+  /** The buffers of all threads that have ever recorded an event. They are kept after their threads have finished, so that their events can still be written. */
+  struct Registry
+  {
+    std::mutex mutex; /**< The mutex that protects the list and serializes the consumers. */
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; /**< The buffers of all threads. */
+  };
+
+  /**
+   * Returns the registry of all thread buffers.
+   * @return The registry.
+   */
+  Registry& getRegistry()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  thread_local int currentField = -1; /**< The field with which the events of this thread are tagged. */
+
+  /**
+   * Returns the buffer of the calling thread (which is created on the first call).
+   * @return The buffer of the calling thread.
+   */
+  ThreadBuffer& getThreadBuffer()
+  {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if(!buffer)
+    {
+      Registry& registry = getRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      registry.buffers.emplace_back(new ThreadBuffer);
+      buffer = registry.buffers.back().get();
+      buffer->id = static_cast<int>(registry.buffers.size());
+      // Threads that are managed by Qt may already have a name.
+      QThread* thread = QThread::currentThread();
+      if(QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        buffer->name = "Main";
+      else if(!thread->objectName().isEmpty())
+        buffer->name = thread->objectName();
+      else
+        buffer->name = "Thread " + QString::number(buffer->id);
+    }
+    return *buffer;
+  }
+
+  /**
+   * Formats a time in microseconds with nanosecond resolution.
+   * @param time The time (ns, not negative).
+   * @return The formatted time (us).
+   */
+  QByteArray toMicroseconds(std::int64_t time)
+  {
+    return QByteArray::number(static_cast<qlonglong>(time / 1000)) + "." + QByteArray::number(static_cast<qlonglong>(time % 1000)).rightJustified(3, '0');
+  }
+
+  /**
+   * Appends an event to the buffer of the calling thread.
+   * @param event The event (which is tagged with the field of the calling thread).
+   */
+  void record(Event& event)
+  {
+    event.field = currentField;
+    ThreadBuffer& buffer = getThreadBuffer();
+    if(!buffer.events.push(event))
+      buffer.droppedEvents.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Moves all events from the queue of a thread to its retained events (the mutex of the registry must be locked).
+   * @param buffer The buffer of the thread.
+   */
+  void retainEvents(ThreadBuffer& buffer)
+  {
+    Event event;
+    while(buffer.events.pop(event))
+      buffer.retainedEvents.push_back(event);
+  }
+
+  /**
+   * Returns whether an event is part of the trace of a field.
+   * @param event The event.
+   * @param field The index of the field (-1 for the trace of all fields).
+   * @return Whether the event belongs to the field or to no field at all.
+   */
+  bool isPartOf(const Event& event, int field)
+  {
+    return field < 0 || event.field < 0 || event.field == field;
+  }
+}
+
+int Tracer::getField()
+{
+  return currentField;
+}
+
+void Tracer::setField(int field)
+{
+  currentField = field;
+}
+
+void Tracer::setThreadName(const QString& name)
+{
+  ThreadBuffer& buffer = getThreadBuffer();
+  std::lock_guard<std::mutex> lock(getRegistry().mutex);
+  buffer.name = name;
+}
+
+void Tracer::instant(const char* name, const char* argumentName, std::int64_t argument)
+{
+  Event event;
+  event.name = name;
+  event.argumentName = argumentName;
+  event.argument = argument;
+  event.timestamp = Clock::getTime();
+  record(event);
+}
+
+void Tracer::span(const char* name, std::int64_t start, std::int64_t end, const char* argumentName, std::int64_t argument)
+{
+  Event event;
+  event.name = name;
+  event.argumentName = argumentName;
+  event.argument = argument;
+  event.timestamp = start;
+  event.duration = end - start;
+  record(event);
+}
+
+void Tracer::clear(int field)
+{
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for(const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+  {
+    retainEvents(*buffer);
+    buffer->retainedEvents.erase(std::remove_if(buffer->retainedEvents.begin(), buffer->retainedEvents.end(), [field](const Event& event){ return isPartOf(event, field); }),
+                                 buffer->retainedEvents.end());
+    if(field < 0)
+      buffer->droppedEvents.store(0, std::memory_order_relaxed);
+  }
+}
+
+bool Tracer::write(const QString& path, int field)
+{
+  QFile file(path);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  Registry& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  const QByteArray processId = QByteArray::number(QCoreApplication::applicationPid());
+  QByteArray line;
+  bool first = true;
+  file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for(const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+  {
+    const QByteArray threadId = QByteArray::number(buffer->id);
+
+    // The metadata event names the thread; dropped events (of any field) are reported there as well, so that a truncated timeline is recognized.
+    QJsonObject arguments;
+    arguments["name"] = buffer->name;
+    const std::uint64_t droppedEvents = buffer->droppedEvents.exchange(0, std::memory_order_relaxed);
+    if(droppedEvents)
+      arguments["droppedEvents"] = static_cast<double>(droppedEvents);
+    line = (first ? "" : ",\n") + QByteArray("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":") + processId + ",\"tid\":" + threadId +
+           ",\"args\":" + QJsonDocument(arguments).toJson(QJsonDocument::Compact) + "}";
+    file.write(line);
+    first = false;
+
+    // The events of other fields are kept for their own traces.
+    retainEvents(*buffer);
+    std::vector<Event> otherEvents;
+    for(const Event& event : buffer->retainedEvents)
+    {
+      if(!isPartOf(event, field))
+      {
+        otherEvents.push_back(event);
+        continue;
+      }
+      line = ",\n{\"name\":\"" + QByteArray(event.name) + "\",\"ph\":\"" + (event.duration < 0 ? "i\",\"s\":\"t" : "X") + "\",\"ts\":" + toMicroseconds(event.timestamp);
+      if(event.duration >= 0)
+        line += ",\"dur\":" + toMicroseconds(event.duration);
+      line += ",\"pid\":" + processId + ",\"tid\":" + threadId;
+      if(event.argumentName)
+        line += ",\"args\":{\"" + QByteArray(event.argumentName) + "\":" + QByteArray::number(static_cast<qlonglong>(event.argument)) + "}";
+      line += "}";
+      file.write(line);
+    }
+    buffer->retainedEvents.swap(otherEvents);
+  }
+  file.write("\n]}\n");
+  return true;
+}
+
+#else
+
+int Tracer::getField()
+{
+  return -1;
+}
+
+void Tracer::setField(int) {}
+
+void Tracer::setThreadName(const QString&) {}
+
+void Tracer::instant(const char*, const char*, std::int64_t) {}
+
+void Tracer::span(const char*, std::int64_t, std::int64_t, const char*, std::int64_t) {}
+
+void Tracer::clear(int) {}
+
+bool Tracer::write(const QString&, int)
+{
+  return false;
+}
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * @file Tracer.h
+ *
+ * This file declares a class that records a timeline of spans and instants in per-thread buffers and writes it
+ * in the trace event format of Chrome (which can be opened in chrome://tracing or https://ui.perfetto.dev).
+ * Tracing is only compiled in if \c DWT_TRACING is defined; otherwise, the macros expand to nothing.
+ * Events can be tagged with the field on which they happen, so that the trace of a field only contains its own events.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Util/Clock.h"
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+
+class Tracer
+{
+public:
+  static constexpr std::size_t bufferSize = 1 << 16; /**< The number of events that each thread can buffer until the trace is written. */
+
+  /**
+   * Returns whether tracing has been compiled in.
+   * @return Whether events are recorded.
+   */
+  static constexpr bool isEnabled()
+  {
+#ifdef DWT_TRACING
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Sets the name under which the calling thread is shown in the trace.
+   * @param name The name of the thread.
+   */
+  static void setThreadName(const QString& name);
+
+  /**
+   * Returns the field with which the events of the calling thread are tagged.
+   * @return The index of the field (-1 if the events do not belong to a field or tracing has not been compiled in).
+   */
+  static int getField();
+
+  /**
+   * Sets the field with which the following events of the calling thread are tagged.
+   * @param field The index of the field (-1 if the events do not belong to a field).
+   */
+  static void setField(int field);
+
+  /**
+   * Records an event without a duration in the buffer of the calling thread.
+   * @param name The name of the event (must be a string literal).
+   * @param argumentName The name of the argument of the event (must be a string literal, nullptr if there is none).
+   * @param argument The value of the argument.
+   */
+  static void instant(const char* name, const char* argumentName = nullptr, std::int64_t argument = 0);
+
+  /**
+   * Records an event with a duration in the buffer of the calling thread.
+   * @param name The name of the event (must be a string literal).
+   * @param start The time at which the span has started (in nanoseconds of the monotonic clock).
+   * @param end The time at which the span has ended (in nanoseconds of the monotonic clock).
+   * @param argumentName The name of the argument of the event (must be a string literal, nullptr if there is none).
+   * @param argument The value of the argument.
+   */
+  static void span(const char* name, std::int64_t start, std::int64_t end, const char* argumentName = nullptr, std::int64_t argument = 0);
+
+  /**
+   * Discards buffered events (e.g. at the start of a pass).
+   * @param field The index of the field whose events are discarded together with those that do not belong to any field (-1 for all events).
+   */
+  static void clear(int field = -1);
+
+  /**
+   * Writes buffered events of all threads to a file and removes them from the buffers. The events of other fields are kept.
+   * @param path The path of the JSON file.
+   * @param field The index of the field whose events are written together with those that do not belong to any field (-1 for all events).
+   * @return Whether the file has been written (false if tracing has not been compiled in).
+   */
+  static bool write(const QString& path, int field = -1);
+
+  /** An object that tags the events of the calling thread with a field from its construction until its destruction. */
+  class FieldScope
+  {
+  public:
+    /**
+     * Constructor. Starts tagging events with the field.
+     * @param field The index of the field.
+     */
+    explicit FieldScope(int field) :
+      previousField(getField())
+    {
+      setField(field);
+    }
+
+    /** Destructor. Restores the previous tag. */
+    ~FieldScope()
+    {
+      setField(previousField);
+    }
+
+    FieldScope(const FieldScope&) = delete;
+    void operator=(const FieldScope&) = delete;
+
+  private:
+    int previousField; /**< The field with which the events were tagged before. */
+  };
+
+  /** An object that records a span from its construction until its destruction. */
+  class Scope
+  {
+  public:
+    /**
+     * Constructor. Starts the span.
+     * @param name The name of the span (must be a string literal).
+     * @param argumentName The name of the argument of the span (must be a string literal, nullptr if there is none).
+     * @param argument The value of the argument.
+     */
+    explicit Scope(const char* name, const char* argumentName = nullptr, std::int64_t argument = 0) :
+      name(name), argumentName(argumentName), argument(argument), start(Clock::getTime())
+    {}
+
+    /** Destructor. Records the span. */
+    ~Scope()
+    {
+      span(name, start, Clock::getTime(), argumentName, argument);
+    }
+
+    Scope(const Scope&) = delete;
+    void operator=(const Scope&) = delete;
+
+  private:
+    const char* name; /**< The name of the span. */
+    const char* argumentName; /**< The name of the argument of the span. */
+    std::int64_t argument; /**< The value of the argument. */
+    std::int64_t start; /**< The time at which the span has started. */
+  };
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef DWT_TRACING
+/** Records a span from this line until the end of the enclosing block (the arguments are those of \c Tracer::Scope). */
+#define TRACE_SCOPE(...) Tracer::Scope TRACE_CONCAT(traceScope, __LINE__)(__VA_ARGS__)
+/** Records a span whose start and end have already been measured (the arguments are those of \c Tracer::span). */
+#define TRACE_SPAN(...) Tracer::span(__VA_ARGS__)
+/** Records an instant (the arguments are those of \c Tracer::instant). */
+#define TRACE_INSTANT(...) Tracer::instant(__VA_ARGS__)
+/** Names the calling thread in the trace. */
+#define TRACE_THREAD_NAME(name) Tracer::setThreadName(name)
+/** Tags the events of the calling thread with a field from this line until the end of the enclosing block. */
+#define TRACE_FIELD(field) Tracer::FieldScope TRACE_CONCAT(traceField, __LINE__)(field)
+#else
+#define TRACE_SCOPE(...) static_cast<void>(0)
+#define TRACE_SPAN(...) static_cast<void>(0)
+#define TRACE_INSTANT(...) static_cast<void>(0)
+#define TRACE_THREAD_NAME(name) static_cast<void>(0)
+#define TRACE_FIELD(field) static_cast<void>(field)
+#endif
@@ -0,0 +1,47 @@
+/**
+ * @file Clock.h
+ *
+ * This file defines a function that reads a monotonic clock.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <cstdint>
+#ifdef __unix__
+#include <time.h>
+#else
+#include <chrono>
+#endif
+
+namespace Clock
+{
+  /**
+   * Returns the current time of a monotonic clock (\c CLOCK_MONOTONIC on Unices).
+   * @return The current time of a monotonic clock (in nanoseconds since an unspecified point in the past).
+   */
+  inline std::int64_t getTime()
+  {
+#ifdef __unix__
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+#ifdef __unix__
+  /**
+   * Returns the offset that converts a \c CLOCK_REALTIME timestamp (e.g. from the kernel) to the monotonic clock.
+   * @return The offset that must be added to a \c CLOCK_REALTIME timestamp (in nanoseconds).
+   */
+  inline std::int64_t getRealtimeToMonotonicOffset()
+  {
+    timespec realtime;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    return getTime() - (static_cast<std::int64_t>(realtime.tv_sec) * 1000000000 + realtime.tv_nsec);
+  }
+#endif
+}
@@ -0,0 +1,113 @@
+/**
+ * @file KdTree.h
+ *
+ * This file declares a 2D k-d tree that finds the nearest of a set of points.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include "Vector2D.h"
+#include <QVector>
+#include <algorithm>
+#include <limits>
+
+class KdTree
+{
+public:
+  /**
+   * Constructor. Builds the tree (in O(n log n)).
+   * @param points The points in which is searched.
+   */
+  explicit KdTree(const QVector<Vector2D>& points) :
+    points(points),
+    order(points.size())
+  {
+    for(int i = 0; i < order.size(); ++i)
+      order[i] = i;
+    build(0, order.size(), 0);
+  }
+
+  /**
+   * Finds the point that is nearest to a location.
+   * Among equally near points, the one with the lowest index is returned (like a linear search with \c std::min_element).
+   * @param location The location.
+   * @return The index of the nearest point (-1 if there are no points).
+   */
+  int findNearest(const Vector2D& location) const
+  {
+    int nearest = -1;
+    float nearestSquaredDistance = std::numeric_limits<float>::infinity();
+    search(0, order.size(), 0, location, nearest, nearestSquaredDistance);
+    return nearest;
+  }
+
+private:
+  /**
+   * Returns a coordinate of a point.
+   * @param point The point.
+   * @param axis 0 for x, 1 for y.
+   * @return The coordinate.
+   */
+  static float get(const Vector2D& point, int axis)
+  {
+    return axis ? point.y : point.x;
+  }
+
+  /**
+   * Arranges a range of the order so that its median splits it along the axis of its depth.
+   * @param begin The first index of the range.
+   * @param end The index after the last one of the range.
+   * @param depth The depth of the range in the tree.
+   */
+  void build(int begin, int end, int depth)
+  {
+    if(end - begin <= 1)
+      return;
+    const int axis = depth % 2, middle = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [this, axis](int a, int b) { return get(points[a], axis) < get(points[b], axis); });
+    build(begin, middle, depth + 1);
+    build(middle + 1, end, depth + 1);
+  }
+
+  /**
+   * Searches a range of the tree for a nearer point.
+   * @param begin The first index of the range.
+   * @param end The index after the last one of the range.
+   * @param depth The depth of the range in the tree.
+   * @param location The location.
+   * @param nearest The index of the nearest point so far.
+   * @param nearestSquaredDistance The squared distance to the nearest point so far.
+   */
+  void search(int begin, int end, int depth, const Vector2D& location, int& nearest, float& nearestSquaredDistance) const
+  {
+    if(begin >= end)
+      return;
+    const int axis = depth % 2, middle = (begin + end) / 2, index = order[middle];
+    const float squaredDistance = (points[index] - location).squaredNorm();
+    if(squaredDistance < nearestSquaredDistance || (squaredDistance == nearestSquaredDistance && index < nearest))
+    {
+      nearest = index;
+      nearestSquaredDistance = squaredDistance;
+    }
+
+    // The other side can only contain an equally near point if the splitting line is not farther away (ties must be visited for the lowest index).
+    const float offset = get(location, axis) - get(points[index], axis);
+    const bool nearSideIsLeft = offset < 0.f;
+    if(nearSideIsLeft)
+      search(begin, middle, depth + 1, location, nearest, nearestSquaredDistance);
+    else
+      search(middle + 1, end, depth + 1, location, nearest, nearestSquaredDistance);
+    if(offset * offset <= nearestSquaredDistance)
+    {
+      if(nearSideIsLeft)
+        search(middle + 1, end, depth + 1, location, nearest, nearestSquaredDistance);
+      else
+        search(begin, middle, depth + 1, location, nearest, nearestSquaredDistance);
+    }
+  }
+
+  QVector<Vector2D> points; /**< The points in which is searched. */
+  QVector<int> order; /**< The indices of the points, arranged as implicit tree (the root of each range is at its middle). */
+};
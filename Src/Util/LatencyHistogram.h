@@ -0,0 +1,139 @@
+/**
+ * @file LatencyHistogram.h
+ *
+ * This file defines a histogram of durations with logarithmic buckets that are subdivided linearly (like an HDR histogram).
+ * The relative error of a reported percentile is below 1.6% over the whole range and recording is lock-free.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class LatencyHistogram
+{
+public:
+  static constexpr int subBucketBits = 7; /**< The number of bits of a value that are resolved exactly (i.e. each power of two is divided into 64 sub-buckets). */
+  static constexpr int maxValueBits = 40; /**< Values up to 2^40 ns (about 18 minutes) are resolved, larger ones are counted as the maximum. */
+
+  /** Constructor. */
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  void operator=(const LatencyHistogram&) = delete;
+
+  /**
+   * Records a value (may be called by several threads at once).
+   * @param value The value (ns), negative values are counted as 0.
+   */
+  void record(std::int64_t value)
+  {
+    counts[getIndex(value < 0 ? 0 : static_cast<std::uint64_t>(value))].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Removes all recorded values (values that are recorded at the same time may get lost). */
+  void reset()
+  {
+    for(std::atomic<std::uint64_t>& count : counts)
+      count.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the number of recorded values.
+   * @return The number of recorded values.
+   */
+  std::uint64_t getCount() const
+  {
+    std::uint64_t total = 0;
+    for(const std::atomic<std::uint64_t>& count : counts)
+      total += count.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  /**
+   * Returns a percentile of the recorded values.
+   * @param percentile The percentile in [0, 100] (100 returns the maximum).
+   * @return The largest value that is equivalent to the percentile (ns), 0 if nothing has been recorded.
+   */
+  std::int64_t getPercentile(double percentile) const
+  {
+    std::array<std::uint64_t, numOfCounts> snapshot;
+    std::uint64_t total = 0;
+    for(std::size_t i = 0; i < numOfCounts; ++i)
+      total += snapshot[i] = counts[i].load(std::memory_order_relaxed);
+    if(!total)
+      return 0;
+
+    // The rank is rounded up, so that the maximum is only reached by the 100th percentile if it is rare.
+    const double exactRank = percentile / 100.0 * static_cast<double>(total);
+    std::uint64_t rank = static_cast<std::uint64_t>(exactRank);
+    if(static_cast<double>(rank) < exactRank || !rank)
+      ++rank;
+    if(rank > total)
+      rank = total;
+
+    std::uint64_t cumulative = 0;
+    for(std::size_t i = 0; i < numOfCounts; ++i)
+    {
+      cumulative += snapshot[i];
+      if(cumulative >= rank)
+        return static_cast<std::int64_t>(getValue(i + 1) - 1);
+    }
+    return static_cast<std::int64_t>(getValue(numOfCounts) - 1);
+  }
+
+private:
+  static constexpr int subBucketHalfCount = 1 << (subBucketBits - 1); /**< The number of sub-buckets that each bucket except for the first one adds. */
+  static constexpr std::size_t numOfCounts = static_cast<std::size_t>((maxValueBits - subBucketBits + 2) * subBucketHalfCount); /**< The number of counters. */
+
+  /**
+   * Returns the index of the counter of a value.
+   * @param value The value.
+   * @return The index of the counter.
+   */
+  static std::size_t getIndex(std::uint64_t value)
+  {
+    const int bucket = getHighestBit(value | ((1u << subBucketBits) - 1)) - (subBucketBits - 1);
+    const std::size_t index = static_cast<std::size_t>(bucket * subBucketHalfCount) + static_cast<std::size_t>(value >> bucket);
+    return index < numOfCounts ? index : numOfCounts - 1;
+  }
+
+  /**
+   * Returns the smallest value that is counted by a counter.
+   * @param index The index of the counter (may be \c numOfCounts to get the upper bound of the last counter).
+   * @return The smallest value of the counter.
+   */
+  static std::uint64_t getValue(std::size_t index)
+  {
+    if(index < static_cast<std::size_t>(2 * subBucketHalfCount))
+      return index;
+    const int bucket = static_cast<int>(index / subBucketHalfCount) - 1;
+    return static_cast<std::uint64_t>(index - static_cast<std::size_t>(bucket * subBucketHalfCount)) << bucket;
+  }
+
+  /**
+   * Returns the position of the highest bit that is set in a value.
+   * @param value The value (must not be 0).
+   * @return The position of the highest set bit (0 for the least significant one).
+   */
+  static int getHighestBit(std::uint64_t value)
+  {
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while(value >>= 1)
+      ++bit;
+    return bit;
+#endif
+  }
+
+  std::array<std::atomic<std::uint64_t>, numOfCounts> counts; /**< The number of recorded values per counter. */
+};
@@ -30,4 +30,13 @@ public:
   {
     return QCoreApplication::applicationDirPath() + "/../Logs";
   }
+
+  /**
+   * Returns the path to the directory in which results that can be recalculated are stored.
+   * @return The path to the directory in which results that can be recalculated are stored.
+   */
+  static QString getCachePath()
+  {
+    return QCoreApplication::applicationDirPath() + "/../Cache";
+  }
 };
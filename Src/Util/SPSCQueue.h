@@ -0,0 +1,73 @@
+/**
+ * @file SPSCQueue.h
+ *
+ * This file defines a lock-free queue with a fixed capacity for one producer thread and one consumer thread.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+template<typename T, std::size_t capacity>
+class SPSCQueue
+{
+public:
+  /**
+   * Appends an element to the queue (may only be called by the producer thread).
+   * @param element The element to append.
+   * @return Whether the element has been appended (false if the queue is full).
+   */
+  bool push(const T& element)
+  {
+    const std::size_t currentTail = tail.load(std::memory_order_relaxed);
+    const std::size_t nextTail = increment(currentTail);
+    if(nextTail == head.load(std::memory_order_acquire))
+      return false;
+    buffer[currentTail] = element;
+    tail.store(nextTail, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest element from the queue (may only be called by the consumer thread).
+   * @param element The element that is replaced by the removed one.
+   * @return Whether an element has been removed (false if the queue is empty).
+   */
+  bool pop(T& element)
+  {
+    const std::size_t currentHead = head.load(std::memory_order_relaxed);
+    if(currentHead == tail.load(std::memory_order_acquire))
+      return false;
+    element = buffer[currentHead];
+    head.store(increment(currentHead), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Returns whether the queue is empty (the result may be outdated immediately if the other thread modifies the queue).
+   * @return Whether the queue is empty.
+   */
+  bool empty() const
+  {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+  }
+
+private:
+  /**
+   * Advances an index in the ring buffer.
+   * @param index The index to advance.
+   * @return The next index.
+   */
+  static std::size_t increment(std::size_t index)
+  {
+    return index + 1 == capacity + 1 ? 0 : index + 1;
+  }
+
+  std::array<T, capacity + 1> buffer; /**< The ring buffer (one slot is always free to distinguish a full from an empty queue). */
+  alignas(64) std::atomic<std::size_t> head{0}; /**< The index of the oldest element (written by the consumer). */
+  alignas(64) std::atomic<std::size_t> tail{0}; /**< The index after the newest element (written by the producer). */
+};
@@ -0,0 +1,200 @@
+/**
+ * @file ThreadPool.h
+ *
+ * This file defines a pool of worker threads that processes a range of tasks with work stealing:
+ * each thread starts with its own contiguous part of the range and takes half of the remaining part
+ * of another thread when it runs out of tasks, so that threads that are slower do not stall the others.
+ *
+ * @author Arne Hasselbring
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+  /**
+   * Constructor. Starts the worker threads.
+   * @param numOfThreads The number of threads that process tasks, including the calling thread (0 for one per core).
+   */
+  explicit ThreadPool(unsigned numOfThreads = 0) :
+    workers(std::max(1u, numOfThreads ? numOfThreads : std::thread::hardware_concurrency()))
+  {
+    for(std::size_t i = 0; i < workers.size(); ++i)
+      workers[i].reset(new Worker);
+    for(unsigned i = 1; i < getNumOfThreads(); ++i)
+      threads.emplace_back([this, i] { run(i); });
+  }
+
+  /** Destructor. Stops the worker threads. */
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    jobStarted.notify_all();
+    for(std::thread& thread : threads)
+      thread.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * Returns the number of threads that process tasks (including the calling thread).
+   * @return The number of threads.
+   */
+  unsigned getNumOfThreads() const
+  {
+    return static_cast<unsigned>(workers.size());
+  }
+
+  /**
+   * Calls a function for each task of a range and returns when all of them are done. The calling thread works on the tasks, too.
+   * It must not be called by multiple threads at once or from within a task.
+   * @param numOfTasks The number of tasks.
+   * @param function The function that processes a task. It gets the index of the thread (in [0, \c getNumOfThreads()[,
+   *                 e.g. for per-thread buffers) and the index of the task.
+   */
+  void parallelFor(std::size_t numOfTasks, const std::function<void(unsigned, std::size_t)>& function)
+  {
+    const std::size_t numOfWorkers = workers.size();
+    for(std::size_t i = 0; i < numOfWorkers; ++i)
+    {
+      std::lock_guard<std::mutex> lock(workers[i]->mutex);
+      workers[i]->begin = numOfTasks * i / numOfWorkers;
+      workers[i]->end = numOfTasks * (i + 1) / numOfWorkers;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &function;
+      ++generation;
+      numOfBusyThreads = getNumOfThreads() - 1;
+    }
+    jobStarted.notify_all();
+
+    process(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this] { return numOfBusyThreads == 0; });
+    job = nullptr;
+  }
+
+private:
+  /** The part of the range of tasks that a thread still has to process. */
+  struct Worker
+  {
+    std::mutex mutex; /**< The mutex that protects the range (it is only contended when another thread steals). */
+    std::size_t begin = 0; /**< The first task that has not been taken yet. */
+    std::size_t end = 0; /**< The end of the range. */
+  };
+
+  /**
+   * The main loop of a worker thread.
+   * @param index The index of the thread.
+   */
+  void run(unsigned index)
+  {
+    unsigned lastGeneration = 0;
+    while(true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobStarted.wait(lock, [this, lastGeneration] { return stopping || generation != lastGeneration; });
+        if(stopping)
+          return;
+        lastGeneration = generation;
+      }
+
+      process(index);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if(--numOfBusyThreads == 0)
+        jobFinished.notify_one();
+    }
+  }
+
+  /**
+   * Processes the tasks of a thread and steals from the others until no tasks are left.
+   * @param index The index of the thread.
+   */
+  void process(unsigned index)
+  {
+    Worker& own = *workers[index];
+    while(true)
+    {
+      bool hasTask;
+      std::size_t task = 0;
+      {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        hasTask = own.begin < own.end;
+        if(hasTask)
+          task = own.begin++;
+      }
+      if(hasTask)
+        (*job)(index, task);
+      else if(!steal(index))
+        return;
+    }
+  }
+
+  /**
+   * Moves the second half of the remaining tasks of the thread with the most remaining tasks to a thread that has run out of tasks.
+   * @param index The index of the thread that has run out of tasks.
+   * @return Whether tasks have been stolen (false if no thread has tasks left).
+   */
+  bool steal(unsigned index)
+  {
+    while(true)
+    {
+      std::size_t victim = workers.size(), mostRemaining = 0;
+      for(std::size_t i = 0; i < workers.size(); ++i)
+        if(i != index)
+        {
+          std::lock_guard<std::mutex> lock(workers[i]->mutex);
+          if(workers[i]->end - workers[i]->begin > mostRemaining)
+          {
+            mostRemaining = workers[i]->end - workers[i]->begin;
+            victim = i;
+          }
+        }
+      if(victim == workers.size())
+        return false;
+
+      // The victim may have taken more tasks since it was inspected, so its range is checked again.
+      std::size_t begin, end;
+      {
+        std::lock_guard<std::mutex> lock(workers[victim]->mutex);
+        if(workers[victim]->begin == workers[victim]->end)
+          continue;
+        end = workers[victim]->end;
+        begin = workers[victim]->begin + (end - workers[victim]->begin) / 2;
+        workers[victim]->end = begin;
+      }
+      std::lock_guard<std::mutex> lock(workers[index]->mutex);
+      workers[index]->begin = begin;
+      workers[index]->end = end;
+      return true;
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers; /**< The remaining tasks of each thread (index 0 is the calling thread). */
+  std::vector<std::thread> threads; /**< The worker threads (without the calling thread). */
+  std::mutex mutex; /**< The mutex that protects the job state. */
+  std::condition_variable jobStarted; /**< Notifies the worker threads about a new job (or that they should stop). */
+  std::condition_variable jobFinished; /**< Notifies the calling thread that all worker threads are done. */
+  const std::function<void(unsigned, std::size_t)>* job = nullptr; /**< The function of the current job. */
+  unsigned generation = 0; /**< The number of jobs that have been started. */
+  unsigned numOfBusyThreads = 0; /**< The number of worker threads that are still working on the current job. */
+  bool stopping = false; /**< Whether the worker threads should stop. */
+};